@@ -1,29 +1,21 @@
 #!/bin/bash
 
 should_clean="$1"
+benchmark="benchmarks/ciphers"
 
 mkdir -p results
 
-echo "Running benchmarks..." > results/benchmarks_results.txt
-echo "====================" >> results/benchmarks_results.txt
-echo "" >> results/benchmarks_results.txt
+echo "Building: $benchmark"
+(cd "$benchmark" && make release -j) > /dev/null 2>&1
 
-for benchmark in benchmarks/*/; do
-    if [ -d "$benchmark" ]; then
-        name=$(basename "$benchmark")
-        echo "Processing: $name"
-        
-        echo "Benchmark: $name" >> results/benchmarks_results.txt
-        echo "------------------------" >> results/benchmarks_results.txt
-        
-        (cd "$benchmark" && make -j) > /dev/null 2>&1
-        (cd "$benchmark" && ./bin/"$name") >> results/benchmarks_results.txt 2>&1
-        if [ -n "$should_clean" ]; then
-            (cd "$benchmark" && make clean) > /dev/null 2>&1
-        fi
+echo "Running: $benchmark"
+"$benchmark"/bin/ciphers \
+    --csv results/benchmarks_results.csv \
+    --json results/benchmarks_results.json \
+    "${@:2}" > results/benchmarks_results.txt
 
-        echo "" >> results/benchmarks_results.txt
-    fi
-done
+if [ -n "$should_clean" ]; then
+    (cd "$benchmark" && make clean) > /dev/null 2>&1
+fi
 
-echo "All benchmarks completed. Check results/benchmarks_results.txt"
\ No newline at end of file
+echo "All benchmarks completed. Check results/benchmarks_results.{txt,csv,json}"
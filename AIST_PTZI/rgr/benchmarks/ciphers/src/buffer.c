@@ -0,0 +1,92 @@
+#define _DEFAULT_SOURCE
+
+#include "buffer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define HUGE_PAGE ((size_t)2 << 20)
+
+// In front of the buffer: what buffer_free unmaps. One page, so the buffer
+// keeps the alignment of the mapping
+typedef struct {
+    void* mapping;
+    size_t size;
+} Header;
+
+static size_t round_up(size_t size, size_t granule)
+{
+    return (size + granule - 1) / granule * granule;
+}
+
+static size_t page_size(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+void* buffer_alloc(size_t size, int huge_pages)
+{
+    size_t page = page_size();
+    int huge = huge_pages && size >= HUGE_PAGE;
+    size_t capacity = round_up(size > 0 ? size : 1, huge ? HUGE_PAGE : page);
+    size_t mapping_size = page + capacity + (huge ? HUGE_PAGE : 0);
+    uint8_t* buffer;
+    void* mapping;
+
+#ifdef _WIN32
+    (void)huge;
+    mapping = VirtualAlloc(NULL, mapping_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!mapping) {
+        fprintf(stderr, "Memory allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    buffer = (uint8_t*)mapping + page;
+#else
+    mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        perror("Memory allocation error");
+        exit(EXIT_FAILURE);
+    }
+    buffer = (uint8_t*)mapping + page;
+    if (huge) {
+        buffer = (uint8_t*)round_up((uintptr_t)buffer, HUGE_PAGE);
+#ifdef MADV_HUGEPAGE
+        madvise(buffer, capacity, MADV_HUGEPAGE);
+#endif
+    }
+#endif
+
+    Header* header = (Header*)(buffer - sizeof(Header));
+    header->mapping = mapping;
+    header->size = mapping_size;
+    memset(buffer, 0, capacity);
+    return buffer;
+}
+
+void buffer_free(void* buffer)
+{
+    if (!buffer) {
+        return;
+    }
+    Header* header = (Header*)((uint8_t*)buffer - sizeof(Header));
+#ifdef _WIN32
+    VirtualFree(header->mapping, 0, MEM_RELEASE);
+#else
+    munmap(header->mapping, header->size);
+#endif
+}
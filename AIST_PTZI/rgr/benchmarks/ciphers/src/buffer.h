@@ -0,0 +1,14 @@
+#ifndef BENCH_BUFFER_H
+#define BENCH_BUFFER_H
+
+#include <stddef.h>
+
+// Zeroed, page-aligned (so 64-byte aligned) memory straight from the OS,
+// with every page written before the call returns, so no measurement takes a
+// first-touch fault. With huge_pages, buffers of 2 MiB and more start on a
+// 2 MiB boundary and are advised as transparent huge pages (Linux only).
+// Exits the program if there is no memory.
+void* buffer_alloc(size_t size, int huge_pages);
+void buffer_free(void* buffer);
+
+#endif
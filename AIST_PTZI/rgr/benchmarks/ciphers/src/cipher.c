@@ -0,0 +1,11 @@
+#include "cipher.h"
+
+// Batch variants split one message between n sessions. The first n - 1
+// segments get an equal number of whole blocks, so every session but the
+// last sees only full blocks, and the last also takes the remainder; with
+// fewer than n blocks the first segments are empty
+size_t segment_size(size_t size, int n, int i, size_t block)
+{
+    size_t segment = size / n / block * block;
+    return i + 1 < n ? segment : size - segment * (n - 1);
+}
@@ -0,0 +1,43 @@
+#ifndef BENCH_CIPHER_H
+#define BENCH_CIPHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Key and IV buffers passed to init are this long, ciphers use a prefix
+#define BENCH_KEY_BYTES 32
+#define BENCH_IV_BYTES 24
+
+// One measured variant of a cipher, e.g. a SIMD kernel or a batch API
+typedef struct {
+    const char* name;
+    // Instances set up by one init call; init is reported per instance
+    int instances;
+    // Size of the state passed to init and process, allocated 64-byte aligned
+    size_t state_size;
+    // Optional, 0 if the CPU cannot run this variant
+    int (*available)(void);
+    // Optional, called once before the thread is pinned (e.g. to start workers)
+    void (*prepare)(void);
+    // Key and IV setup of all instances
+    void (*init)(void* state, const uint8_t* key, const uint8_t* iv);
+    // out = in ^ keystream, continuing the stream
+    void (*process)(void* state, const uint8_t* in, uint8_t* out, size_t size);
+} BenchCipher;
+
+// Variants of each cipher, terminated by an entry with name == NULL
+extern const BenchCipher SALSA20_CIPHERS[];
+extern const BenchCipher HC128_CIPHERS[];
+extern const BenchCipher RABBIT_CIPHERS[];
+extern const BenchCipher SOSEMANUK_CIPHERS[];
+extern const BenchCipher CHACHA20_CIPHERS[];
+extern const BenchCipher POLY1305_CIPHERS[];
+extern const BenchCipher AES_CIPHERS[];
+// C++, see cipher_salsa_rounds.cpp
+extern const BenchCipher SALSA_ROUNDS_CIPHERS[];
+
+// Length of segment i when size bytes are split between n instances,
+// whole blocks of block bytes except for the last segment
+size_t segment_size(size_t size, int n, int i, size_t block);
+
+#endif
@@ -0,0 +1,122 @@
+#include "cipher.h"
+#include "aes/aes.h"
+
+#include <string.h>
+
+// AES-CTR with the 96-bit IV and 32-bit block counter of GCM
+typedef struct {
+    aes_ctx ctx;
+    uint8_t counter[16];
+} Ctr;
+
+static void init_ctr(Ctr* ctr, const uint8_t* key, const uint8_t* iv, int key_bits)
+{
+    aes_keysetup(&ctr->ctx, key, key_bits);
+    memcpy(ctr->counter, iv, 12);
+    memset(ctr->counter + 12, 0, 4);
+}
+
+static void init_128(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    init_ctr((Ctr*)state, key, iv, 128);
+}
+
+static void init_256(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    init_ctr((Ctr*)state, key, iv, 256);
+}
+
+static void process_lanes(void* state, const uint8_t* in, uint8_t* out, size_t size, int lanes)
+{
+    Ctr* ctr = (Ctr*)state;
+
+    aes_set_lanes(lanes);
+    aes_ctr_encrypt(&ctr->ctx, ctr->counter, in, out, size);
+}
+
+static void process_portable(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 0);
+}
+
+static void process_aesni(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 8);
+}
+
+static void process_vaes(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 16);
+}
+
+// The MAC alone: process absorbs the input and leaves out untouched.
+// GHASH takes PCLMULQDQ whenever the AES kernels are enabled
+static void init_ghash(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    (void)iv;
+    ghash_init((ghash_ctx*)state, key);
+}
+
+static void process_ghash_portable(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    (void)out;
+    aes_set_lanes(0);
+    ghash_update((ghash_ctx*)state, in, size);
+}
+
+static void process_ghash_pclmul(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    (void)out;
+    aes_set_lanes(16);
+    ghash_update((ghash_ctx*)state, in, size);
+}
+
+// AES-128-GCM as the AEAD in practice_1_refinement does it: CTR encryption
+// followed by GHASH over the ciphertext; init derives H per key
+typedef struct {
+    Ctr ctr;
+    ghash_ctx mac;
+} Gcm;
+
+static void init_gcm(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    Gcm* gcm = (Gcm*)state;
+    uint8_t h[16] = { 0 };
+
+    init_ctr(&gcm->ctr, key, iv, 128);
+    aes_encrypt_block(&gcm->ctr.ctx, h, h);
+    ghash_init(&gcm->mac, h);
+    // block 0 masks the tag, block 1 starts the message
+    gcm->ctr.counter[15] = 1;
+}
+
+static void process_gcm(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Gcm* gcm = (Gcm*)state;
+
+    aes_set_lanes(16);
+    aes_ctr_encrypt(&gcm->ctr.ctx, gcm->ctr.counter, in, out, size);
+    ghash_update(&gcm->mac, out, size);
+}
+
+static int supports(int lanes)
+{
+    aes_set_lanes(lanes);
+    return aes_lanes() == lanes;
+}
+
+static int available_aesni(void) { return supports(8); }
+static int available_vaes(void) { return supports(16); }
+
+const BenchCipher AES_CIPHERS[] = {
+    { "aes128-portable", 1, sizeof(Ctr), NULL, NULL, init_128, process_portable },
+    { "aes128-aesni", 1, sizeof(Ctr), available_aesni, NULL, init_128, process_aesni },
+    { "aes128-vaes", 1, sizeof(Ctr), available_vaes, NULL, init_128, process_vaes },
+    { "aes256-portable", 1, sizeof(Ctr), NULL, NULL, init_256, process_portable },
+    { "aes256-aesni", 1, sizeof(Ctr), available_aesni, NULL, init_256, process_aesni },
+    { "aes256-vaes", 1, sizeof(Ctr), available_vaes, NULL, init_256, process_vaes },
+    { "ghash-portable", 1, sizeof(ghash_ctx), NULL, NULL, init_ghash, process_ghash_portable },
+    { "ghash-pclmul", 1, sizeof(ghash_ctx), available_aesni, NULL, init_ghash, process_ghash_pclmul },
+    { "aes128-gcm", 1, sizeof(Gcm), NULL, NULL, init_gcm, process_gcm },
+    { NULL, 0, 0, NULL, NULL, NULL, NULL },
+};
@@ -0,0 +1,121 @@
+#include "cipher.h"
+#include "chacha20/chacha20.h"
+
+#include <string.h>
+
+static void init(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    ECRYPT_keysetup((ECRYPT_ctx*)state, key, 256, 64);
+    ECRYPT_ivsetup((ECRYPT_ctx*)state, iv);
+}
+
+// Includes the HChaCha20 subkey derivation per IV
+static void init_x(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    ECRYPT_keysetup((ECRYPT_ctx*)state, key, 256, 192);
+    ECRYPT_ivsetup((ECRYPT_ctx*)state, iv);
+}
+
+static void process_lanes(void* state, const uint8_t* in, uint8_t* out, size_t size, int lanes)
+{
+    chacha20_set_lanes(lanes);
+    ECRYPT_encrypt_bytes64((ECRYPT_ctx*)state, in, out, size);
+}
+
+static void process_scalar(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 0);
+}
+
+static void process_x4(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 4);
+}
+
+static void process_x8(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 8);
+}
+
+static void process_x16(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 16);
+}
+
+// A server's sessions: one key, a different IV per session, the buffer as
+// one message per session
+#define SESSIONS 64
+
+typedef struct {
+    ECRYPT_ctx ctx[SESSIONS];
+} Sessions;
+
+static void init_sessions(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    Sessions* sessions = (Sessions*)state;
+    uint8_t session_iv[BENCH_IV_BYTES];
+
+    memcpy(session_iv, iv, sizeof(session_iv));
+    for (int i = 0; i < SESSIONS; i++) {
+        session_iv[0] = iv[0] ^ (uint8_t)i;
+        ECRYPT_keysetup(&sessions->ctx[i], key, 256, 64);
+        ECRYPT_ivsetup(&sessions->ctx[i], session_iv);
+    }
+}
+
+// One call per session
+static void process_sessions(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Sessions* sessions = (Sessions*)state;
+
+    chacha20_set_lanes(16);
+    for (int i = 0; i < SESSIONS; i++) {
+        size_t length = segment_size(size, SESSIONS, i, ECRYPT_BLOCKLENGTH);
+        ECRYPT_encrypt_bytes64(&sessions->ctx[i], in, out, length);
+        in += length;
+        out += length;
+    }
+}
+
+// All sessions in one chacha20_encrypt_batch call
+static void process_batch(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Sessions* sessions = (Sessions*)state;
+    ECRYPT_ctx* ctx[SESSIONS];
+    const u8* input[SESSIONS];
+    u8* output[SESSIONS];
+    u32 length[SESSIONS];
+
+    for (int i = 0; i < SESSIONS; i++) {
+        ctx[i] = &sessions->ctx[i];
+        input[i] = in;
+        output[i] = out;
+        length[i] = (u32)segment_size(size, SESSIONS, i, ECRYPT_BLOCKLENGTH);
+        in += length[i];
+        out += length[i];
+    }
+
+    chacha20_set_lanes(16);
+    chacha20_encrypt_batch(ctx, input, output, length, SESSIONS);
+}
+
+static int supports(int lanes)
+{
+    chacha20_set_lanes(lanes);
+    return chacha20_lanes() == lanes;
+}
+
+static int available_x4(void) { return supports(4); }
+static int available_x8(void) { return supports(8); }
+static int available_x16(void) { return supports(16); }
+
+const BenchCipher CHACHA20_CIPHERS[] = {
+    { "chacha20-scalar", 1, sizeof(ECRYPT_ctx), NULL, NULL, init, process_scalar },
+    { "chacha20-x4", 1, sizeof(ECRYPT_ctx), available_x4, NULL, init, process_x4 },
+    { "chacha20-x8", 1, sizeof(ECRYPT_ctx), available_x8, NULL, init, process_x8 },
+    { "chacha20-x16", 1, sizeof(ECRYPT_ctx), available_x16, NULL, init, process_x16 },
+    { "xchacha20", 1, sizeof(ECRYPT_ctx), NULL, NULL, init_x, process_x16 },
+    { "chacha20-sessions", SESSIONS, sizeof(Sessions), NULL, NULL, init_sessions, process_sessions },
+    { "chacha20-batch", SESSIONS, sizeof(Sessions), NULL, NULL, init_sessions, process_batch },
+    { NULL, 0, 0, NULL, NULL, NULL, NULL },
+};
@@ -0,0 +1,59 @@
+#include "cipher.h"
+#include "hc-128/ecrypt-sync.h"
+
+#define BATCH 8
+
+typedef struct {
+    ECRYPT_ctx ctx[BATCH];
+} Batch;
+
+static void init(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    ECRYPT_keysetup((ECRYPT_ctx*)state, key, 128, 128);
+    ECRYPT_ivsetup((ECRYPT_ctx*)state, iv);
+}
+
+static void process(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    ECRYPT_process_bytes64(0, (ECRYPT_ctx*)state, in, out, size);
+}
+
+// One key, a different IV per instance, set up by hc128_ivsetup_batch
+static void init_batch(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    Batch* batch = (Batch*)state;
+    ECRYPT_ctx* ctx[BATCH];
+    uint8_t ivs[BATCH][BENCH_IV_BYTES];
+    const u8* iv_ptr[BATCH];
+
+    for (int i = 0; i < BATCH; i++) {
+        for (int j = 0; j < BENCH_IV_BYTES; j++) {
+            ivs[i][j] = iv[j];
+        }
+        ivs[i][0] ^= (uint8_t)i;
+        ctx[i] = &batch->ctx[i];
+        iv_ptr[i] = ivs[i];
+    }
+
+    ECRYPT_keysetup(ctx[0], key, 128, 128);
+    hc128_ivsetup_batch(ctx[0], ctx, iv_ptr, BATCH);
+}
+
+// The buffer as independently IV'd segments
+static void process_batch(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Batch* batch = (Batch*)state;
+
+    for (int i = 0; i < BATCH; i++) {
+        size_t length = segment_size(size, BATCH, i, ECRYPT_BLOCKLENGTH);
+        ECRYPT_process_bytes64(0, &batch->ctx[i], in, out, length);
+        in += length;
+        out += length;
+    }
+}
+
+const BenchCipher HC128_CIPHERS[] = {
+    { "hc128", 1, sizeof(ECRYPT_ctx), NULL, NULL, init, process },
+    { "hc128-x8", BATCH, sizeof(Batch), NULL, NULL, init_batch, process_batch },
+    { NULL, 0, 0, NULL, NULL, NULL, NULL },
+};
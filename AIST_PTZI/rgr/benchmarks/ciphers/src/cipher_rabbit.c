@@ -0,0 +1,141 @@
+#include "cipher.h"
+#include "rabbit/ecrypt-sync.h"
+
+#include <string.h>
+
+#define BATCH 8
+// Sessions of a server, see init_sessions
+#define SESSIONS 64
+
+typedef struct {
+    ECRYPT_ctx ctx[BATCH];
+} Batch;
+
+typedef struct {
+    ECRYPT_ctx ctx[SESSIONS];
+} Sessions;
+
+static void init(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    ECRYPT_keysetup((ECRYPT_ctx*)state, key, 128, 64);
+    ECRYPT_ivsetup((ECRYPT_ctx*)state, iv);
+}
+
+static void process(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    ECRYPT_process_bytes64(0, (ECRYPT_ctx*)state, in, out, size);
+}
+
+// One key, a different IV per instance
+static void init_lanes(void* state, const uint8_t* key, const uint8_t* iv, int n)
+{
+    Batch* batch = (Batch*)state;
+    uint8_t instance_iv[BENCH_IV_BYTES];
+
+    ECRYPT_keysetup(&batch->ctx[0], key, 128, 64);
+    memcpy(instance_iv, iv, sizeof(instance_iv));
+    for (int i = 0; i < n; i++) {
+        batch->ctx[i].master_ctx = batch->ctx[0].master_ctx;
+        instance_iv[0] = iv[0] ^ (uint8_t)i;
+        ECRYPT_ivsetup(&batch->ctx[i], instance_iv);
+    }
+}
+
+// The buffer as independently IV'd segments, one per SIMD lane
+static void process_lanes(void* state, const uint8_t* in, uint8_t* out, size_t size, int n)
+{
+    Batch* batch = (Batch*)state;
+    ECRYPT_ctx* ctx[BATCH];
+    const u8* input[BATCH];
+    u8* output[BATCH];
+    u32 length[BATCH];
+
+    for (int i = 0; i < n; i++) {
+        ctx[i] = &batch->ctx[i];
+        input[i] = in;
+        output[i] = out;
+        length[i] = (u32)segment_size(size, n, i, ECRYPT_BLOCKLENGTH);
+        in += length[i];
+        out += length[i];
+    }
+
+    rabbit_process_batch(ctx, input, output, length, n);
+}
+
+static void init_x4(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    init_lanes(state, key, iv, 4);
+}
+
+static void init_x8(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    init_lanes(state, key, iv, 8);
+}
+
+static void process_x4(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 4);
+}
+
+static void process_x8(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 8);
+}
+
+// One key, a different IV per session, the buffer as one message per session
+static void init_sessions(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    Sessions* sessions = (Sessions*)state;
+    uint8_t session_iv[BENCH_IV_BYTES];
+
+    ECRYPT_keysetup(&sessions->ctx[0], key, 128, 64);
+    memcpy(session_iv, iv, sizeof(session_iv));
+    for (int i = 0; i < SESSIONS; i++) {
+        sessions->ctx[i].master_ctx = sessions->ctx[0].master_ctx;
+        session_iv[0] = iv[0] ^ (uint8_t)i;
+        ECRYPT_ivsetup(&sessions->ctx[i], session_iv);
+    }
+}
+
+// One call per session
+static void process_sessions(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Sessions* sessions = (Sessions*)state;
+
+    for (int i = 0; i < SESSIONS; i++) {
+        size_t length = segment_size(size, SESSIONS, i, ECRYPT_BLOCKLENGTH);
+        ECRYPT_process_bytes64(0, &sessions->ctx[i], in, out, length);
+        in += length;
+        out += length;
+    }
+}
+
+// All sessions in one rabbit_process_batch call
+static void process_sessions_batch(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Sessions* sessions = (Sessions*)state;
+    ECRYPT_ctx* ctx[SESSIONS];
+    const u8* input[SESSIONS];
+    u8* output[SESSIONS];
+    u32 length[SESSIONS];
+
+    for (int i = 0; i < SESSIONS; i++) {
+        ctx[i] = &sessions->ctx[i];
+        input[i] = in;
+        output[i] = out;
+        length[i] = (u32)segment_size(size, SESSIONS, i, ECRYPT_BLOCKLENGTH);
+        in += length[i];
+        out += length[i];
+    }
+
+    rabbit_process_batch(ctx, input, output, length, SESSIONS);
+}
+
+const BenchCipher RABBIT_CIPHERS[] = {
+    { "rabbit", 1, sizeof(ECRYPT_ctx), NULL, NULL, init, process },
+    { "rabbit-x4", 4, sizeof(Batch), NULL, NULL, init_x4, process_x4 },
+    { "rabbit-x8", 8, sizeof(Batch), NULL, NULL, init_x8, process_x8 },
+    { "rabbit-sessions", SESSIONS, sizeof(Sessions), NULL, NULL, init_sessions, process_sessions },
+    { "rabbit-batch", SESSIONS, sizeof(Sessions), NULL, NULL, init_sessions, process_sessions_batch },
+    { NULL, 0, 0, NULL, NULL, NULL, NULL },
+};
@@ -0,0 +1,137 @@
+#include "cipher.h"
+#include "salsa20/salsa20.h"
+
+#include <string.h>
+
+static void init(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    ECRYPT_keysetup((ECRYPT_ctx*)state, key, 256, 64);
+    ECRYPT_ivsetup((ECRYPT_ctx*)state, iv);
+}
+
+static void process_lanes(void* state, const uint8_t* in, uint8_t* out, size_t size, int lanes)
+{
+    salsa20_set_lanes(lanes);
+    ECRYPT_encrypt_bytes64((ECRYPT_ctx*)state, in, out, size);
+}
+
+static void process_scalar(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 0);
+}
+
+static void process_x4(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 4);
+}
+
+static void process_x8(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 8);
+}
+
+static void process_x16(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    process_lanes(state, in, out, size, 16);
+}
+
+static void process_mt(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    salsa20_set_lanes(16);
+    salsa20_encrypt_parallel((ECRYPT_ctx*)state, in, out, size);
+}
+
+// A server's sessions: one key, a different IV per session, the buffer as
+// one message per session
+#define SESSIONS 64
+
+typedef struct {
+    ECRYPT_ctx ctx[SESSIONS];
+} Sessions;
+
+static void init_sessions(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    Sessions* sessions = (Sessions*)state;
+    uint8_t session_iv[BENCH_IV_BYTES];
+
+    memcpy(session_iv, iv, sizeof(session_iv));
+    for (int i = 0; i < SESSIONS; i++) {
+        session_iv[0] = iv[0] ^ (uint8_t)i;
+        ECRYPT_keysetup(&sessions->ctx[i], key, 256, 64);
+        ECRYPT_ivsetup(&sessions->ctx[i], session_iv);
+    }
+}
+
+// One call per session
+static void process_sessions(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Sessions* sessions = (Sessions*)state;
+
+    salsa20_set_lanes(16);
+    for (int i = 0; i < SESSIONS; i++) {
+        size_t length = segment_size(size, SESSIONS, i, ECRYPT_BLOCKLENGTH);
+        ECRYPT_encrypt_bytes64(&sessions->ctx[i], in, out, length);
+        in += length;
+        out += length;
+    }
+}
+
+// All sessions in one salsa20_encrypt_batch call
+static void process_batch(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    Sessions* sessions = (Sessions*)state;
+    ECRYPT_ctx* ctx[SESSIONS];
+    const u8* input[SESSIONS];
+    u8* output[SESSIONS];
+    u32 length[SESSIONS];
+
+    for (int i = 0; i < SESSIONS; i++) {
+        ctx[i] = &sessions->ctx[i];
+        input[i] = in;
+        output[i] = out;
+        length[i] = (u32)segment_size(size, SESSIONS, i, ECRYPT_BLOCKLENGTH);
+        in += length[i];
+        out += length[i];
+    }
+
+    salsa20_set_lanes(16);
+    salsa20_encrypt_batch(ctx, input, output, length, SESSIONS);
+}
+
+static int supports(int lanes)
+{
+    salsa20_set_lanes(lanes);
+    return salsa20_lanes() == lanes;
+}
+
+static int available_x4(void) { return supports(4); }
+static int available_x8(void) { return supports(8); }
+static int available_x16(void) { return supports(16); }
+
+static int available_mt(void)
+{
+    return salsa20_threads() > 1;
+}
+
+// Worker threads inherit the affinity of the thread creating them
+static void prepare_mt(void)
+{
+    static uint8_t buffer[2 * SALSA20_PARALLEL_THRESHOLD];
+    ECRYPT_ctx ctx;
+    uint8_t key[BENCH_KEY_BYTES] = { 0 };
+    uint8_t iv[BENCH_IV_BYTES] = { 0 };
+
+    init(&ctx, key, iv);
+    salsa20_encrypt_parallel(&ctx, buffer, buffer, sizeof(buffer));
+}
+
+const BenchCipher SALSA20_CIPHERS[] = {
+    { "salsa20-scalar", 1, sizeof(ECRYPT_ctx), NULL, NULL, init, process_scalar },
+    { "salsa20-x4", 1, sizeof(ECRYPT_ctx), available_x4, NULL, init, process_x4 },
+    { "salsa20-x8", 1, sizeof(ECRYPT_ctx), available_x8, NULL, init, process_x8 },
+    { "salsa20-x16", 1, sizeof(ECRYPT_ctx), available_x16, NULL, init, process_x16 },
+    { "salsa20-mt", 1, sizeof(ECRYPT_ctx), available_mt, prepare_mt, init, process_mt },
+    { "salsa20-sessions", SESSIONS, sizeof(Sessions), NULL, NULL, init_sessions, process_sessions },
+    { "salsa20-batch", SESSIONS, sizeof(Sessions), NULL, NULL, init_sessions, process_batch },
+    { NULL, 0, 0, NULL, NULL, NULL, NULL },
+};
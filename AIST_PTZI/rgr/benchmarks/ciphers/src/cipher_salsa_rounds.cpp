@@ -0,0 +1,31 @@
+// Salsa20/8, /12 and /20 from the compile-time core of
+// practice_1_refinement, next to the C Salsa20 rows; whole blocks run on
+// the widest kernel of salsa20-simd.c
+extern "C" {
+#include "cipher.h"
+}
+
+#include "salsa_core.h"
+
+namespace {
+template <int Rounds>
+void init(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    typedef ciphers::salsa::Core<Rounds, 256> Core;
+    Core::set_key(static_cast<uint32_t*>(state), key);
+    Core::set_iv(static_cast<uint32_t*>(state), iv);
+}
+
+template <int Rounds>
+void process(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    ciphers::salsa::Core<Rounds, 256>::process(static_cast<uint32_t*>(state), in, out, size);
+}
+}
+
+extern "C" const BenchCipher SALSA_ROUNDS_CIPHERS[] = {
+    { "salsa20_20", 1, 16 * sizeof(uint32_t), NULL, NULL, init<20>, process<20> },
+    { "salsa20_12", 1, 16 * sizeof(uint32_t), NULL, NULL, init<12>, process<12> },
+    { "salsa20_8", 1, 16 * sizeof(uint32_t), NULL, NULL, init<8>, process<8> },
+    { NULL, 0, 0, NULL, NULL, NULL, NULL },
+};
@@ -0,0 +1,18 @@
+#include "cipher.h"
+#include "sosemanuk/ecrypt-sync.h"
+
+static void init(void* state, const uint8_t* key, const uint8_t* iv)
+{
+    ECRYPT_keysetup((ECRYPT_ctx*)state, key, 256, 128);
+    ECRYPT_ivsetup((ECRYPT_ctx*)state, iv);
+}
+
+static void process(void* state, const uint8_t* in, uint8_t* out, size_t size)
+{
+    ECRYPT_process_bytes64(0, (ECRYPT_ctx*)state, in, out, size);
+}
+
+const BenchCipher SOSEMANUK_CIPHERS[] = {
+    { "sosemanuk", 1, sizeof(ECRYPT_ctx), NULL, NULL, init, process },
+    { NULL, 0, 0, NULL, NULL, NULL, NULL },
+};
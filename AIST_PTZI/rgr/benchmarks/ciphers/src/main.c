@@ -0,0 +1,380 @@
+#include "buffer.h"
+#include "cipher.h"
+#include "report.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const BenchCipher* const CIPHER_GROUPS[] = {
+    SALSA20_CIPHERS,
+    SALSA_ROUNDS_CIPHERS,
+    HC128_CIPHERS,
+    RABBIT_CIPHERS,
+    SOSEMANUK_CIPHERS,
+    CHACHA20_CIPHERS,
+    POLY1305_CIPHERS,
+    AES_CIPHERS,
+};
+#define CIPHER_GROUPS_COUNT (sizeof(CIPHER_GROUPS) / sizeof(CIPHER_GROUPS[0]))
+
+#define MAX_VALUES 32
+
+static const size_t DEFAULT_SIZES[] = { 64, 256, 1024, 4096, 16384, 65536, 1048576 };
+static const size_t DEFAULT_ALIGNMENTS[] = { 0, 1 };
+
+typedef struct {
+    const char* filter; // comma-separated cipher names, NULL for all
+    size_t sizes[MAX_VALUES];
+    int sizes_count;
+    size_t alignments[MAX_VALUES];
+    int alignments_count;
+    int samples;
+    double min_time_ms;
+    double warmup_ms;
+    int cpu; // -1: the CPU the program starts on
+    int pin;
+    int huge_pages;
+    const char* csv_path;
+    const char* json_path;
+} Options;
+
+// "salsa20" selects every salsa20 variant, "salsa20-x8" just that one
+static int selected(const char* name, const char* filter)
+{
+    if (!filter) {
+        return 1;
+    }
+
+    size_t name_length = strlen(name);
+    for (const char* p = filter; *p;) {
+        size_t length = strcspn(p, ",");
+        if (length > 0 && length <= name_length && strncmp(name, p, length) == 0
+            && (name[length] == '\0' || name[length] == '-')) {
+            return 1;
+        }
+        p += length;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return 0;
+}
+
+static int parse_list(const char* text, size_t* values, int* count)
+{
+    char* end;
+
+    *count = 0;
+    while (*text) {
+        if (*count == MAX_VALUES) {
+            return 0;
+        }
+        values[(*count)++] = strtoull(text, &end, 10);
+        if (end == text || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+    return *count > 0;
+}
+
+static void usage(const char* program)
+{
+    printf("Usage: %s [options]\n"
+           "  --cipher NAMES     comma-separated ciphers or variants (default: all)\n"
+           "  --sizes LIST       buffer sizes in bytes (default: 64,...,1048576)\n"
+           "  --align LIST       buffer offsets from a 64-byte boundary (default: 0,1)\n"
+           "  --samples N        samples per measurement (default: 31)\n"
+           "  --min-time MS      minimum duration of a sample (default: 1)\n"
+           "  --warmup MS        warm-up before each measurement (default: 20)\n"
+           "  --cpu N            CPU to pin to (default: the current one)\n"
+           "  --no-pin           do not pin the thread\n"
+           "  --no-huge-pages    no transparent huge pages for buffers of 2 MiB and more\n"
+           "  --csv FILE         also write the results as CSV\n"
+           "  --json FILE        also write the results as JSON\n"
+           "  --list             list the cipher variants and exit\n",
+        program);
+}
+
+static int parse_options(int argc, char** argv, Options* options)
+{
+    options->filter = NULL;
+    options->sizes_count = (int)(sizeof(DEFAULT_SIZES) / sizeof(DEFAULT_SIZES[0]));
+    memcpy(options->sizes, DEFAULT_SIZES, sizeof(DEFAULT_SIZES));
+    options->alignments_count = (int)(sizeof(DEFAULT_ALIGNMENTS) / sizeof(DEFAULT_ALIGNMENTS[0]));
+    memcpy(options->alignments, DEFAULT_ALIGNMENTS, sizeof(DEFAULT_ALIGNMENTS));
+    options->samples = 31;
+    options->min_time_ms = 1;
+    options->warmup_ms = 20;
+    options->cpu = -1;
+    options->pin = 1;
+    options->huge_pages = 1;
+    options->csv_path = NULL;
+    options->json_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        int ok = 1;
+
+        if (strcmp(arg, "--no-pin") == 0) {
+            options->pin = 0;
+            continue;
+        }
+        if (strcmp(arg, "--no-huge-pages") == 0) {
+            options->huge_pages = 0;
+            continue;
+        }
+        if (strcmp(arg, "--list") == 0) {
+            for (size_t g = 0; g < CIPHER_GROUPS_COUNT; g++) {
+                for (const BenchCipher* c = CIPHER_GROUPS[g]; c->name; c++) {
+                    int available = !c->available || c->available();
+                    printf("%s%s\n", c->name, available ? "" : " (not available here)");
+                }
+            }
+            exit(EXIT_SUCCESS);
+        }
+        if (strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            exit(EXIT_SUCCESS);
+        }
+        if (!value) {
+            fprintf(stderr, "Unknown option or missing value: %s\n", arg);
+            return 0;
+        }
+
+        i++;
+        if (strcmp(arg, "--cipher") == 0) {
+            options->filter = value;
+        } else if (strcmp(arg, "--sizes") == 0) {
+            ok = parse_list(value, options->sizes, &options->sizes_count);
+        } else if (strcmp(arg, "--align") == 0) {
+            ok = parse_list(value, options->alignments, &options->alignments_count);
+        } else if (strcmp(arg, "--samples") == 0) {
+            options->samples = atoi(value);
+            ok = options->samples > 0;
+        } else if (strcmp(arg, "--min-time") == 0) {
+            options->min_time_ms = atof(value);
+            ok = options->min_time_ms > 0;
+        } else if (strcmp(arg, "--warmup") == 0) {
+            options->warmup_ms = atof(value);
+            ok = options->warmup_ms >= 0;
+        } else if (strcmp(arg, "--cpu") == 0) {
+            options->cpu = atoi(value);
+        } else if (strcmp(arg, "--csv") == 0) {
+            options->csv_path = value;
+        } else if (strcmp(arg, "--json") == 0) {
+            options->json_path = value;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return 0;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Invalid value for %s: %s\n", arg, value);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// What one sample times: key and IV setup if size == 0, otherwise process
+typedef struct {
+    const BenchCipher* cipher;
+    void* state;
+    const uint8_t* key;
+    const uint8_t* iv;
+    const uint8_t* in;
+    uint8_t* out;
+    size_t size;
+} Job;
+
+static void run(const Job* job, long iterations)
+{
+    for (long i = 0; i < iterations; i++) {
+        if (job->size == 0) {
+            job->cipher->init(job->state, job->key, job->iv);
+        } else {
+            job->cipher->process(job->state, job->in, job->out, job->size);
+        }
+    }
+}
+
+// Warm-up, then the number of calls per sample so that a sample takes at
+// least min_time_ms, then the samples
+static void measure(const Job* job, const Options* options, Result* result)
+{
+    double ns[options->samples], ticks[options->samples];
+    long iterations = 1;
+    uint64_t start = now_ns();
+
+    while (now_ns() - start < options->warmup_ms * 1e6) {
+        run(job, 1);
+    }
+
+    for (;;) {
+        uint64_t t = now_ns();
+        run(job, iterations);
+        if (now_ns() - t >= options->min_time_ms * 1e6) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    // init rows are per instance, process rows per call over the whole buffer
+    int calls = job->size == 0 ? job->cipher->instances : 1;
+
+    for (int s = 0; s < options->samples; s++) {
+        uint64_t t = now_ns();
+        uint64_t c = cycles();
+        run(job, iterations);
+        c = cycles() - c;
+        t = now_ns() - t;
+
+        ns[s] = (double)t / iterations / calls;
+        ticks[s] = (double)c / iterations / calls;
+    }
+
+    result->cipher = job->cipher->name;
+    result->size = job->size;
+    result->samples = options->samples;
+    result->ns = stat_of(ns, options->samples);
+    result->cycles = stat_of(ticks, options->samples);
+}
+
+static FILE* open_output(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    return file;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // room for every variant of every group
+    size_t variants = 0;
+    for (size_t g = 0; g < CIPHER_GROUPS_COUNT; g++) {
+        for (const BenchCipher* c = CIPHER_GROUPS[g]; c->name; c++) {
+            variants++;
+        }
+    }
+    const BenchCipher** ciphers = malloc(variants * sizeof(*ciphers));
+    if (!ciphers) {
+        perror("Memory allocation error");
+        return EXIT_FAILURE;
+    }
+    size_t ciphers_count = 0;
+    for (size_t g = 0; g < CIPHER_GROUPS_COUNT; g++) {
+        for (const BenchCipher* c = CIPHER_GROUPS[g]; c->name; c++) {
+            if (selected(c->name, options.filter) && (!c->available || c->available())) {
+                ciphers[ciphers_count++] = c;
+            }
+        }
+    }
+    if (ciphers_count == 0) {
+        fprintf(stderr, "No cipher matches %s\n", options.filter);
+        free(ciphers);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < ciphers_count; i++) {
+        if (ciphers[i]->prepare) {
+            ciphers[i]->prepare();
+        }
+    }
+
+    RunInfo info = { -1, options.samples, options.min_time_ms };
+    if (options.pin) {
+        info.cpu = pin_thread(options.cpu);
+        if (info.cpu < 0) {
+            fprintf(stderr, "Warning: could not pin the thread\n");
+        }
+    }
+    if (!have_cycles()) {
+        fprintf(stderr, "Warning: no time stamp counter, cycles are reported as 0\n");
+    }
+
+    size_t max_size = 0, max_alignment = 0;
+    for (int i = 0; i < options.sizes_count; i++) {
+        max_size = options.sizes[i] > max_size ? options.sizes[i] : max_size;
+    }
+    for (int i = 0; i < options.alignments_count; i++) {
+        max_alignment = options.alignments[i] > max_alignment ? options.alignments[i] : max_alignment;
+    }
+
+    // Allocated and pre-faulted once, then reused by every row
+    size_t max_state_size = 0;
+    for (size_t i = 0; i < ciphers_count; i++) {
+        max_state_size = ciphers[i]->state_size > max_state_size ? ciphers[i]->state_size : max_state_size;
+    }
+    uint8_t* input = buffer_alloc(max_size + max_alignment, options.huge_pages);
+    uint8_t* output = buffer_alloc(max_size + max_alignment, options.huge_pages);
+    void* state = buffer_alloc(max_state_size, options.huge_pages);
+    uint8_t key[BENCH_KEY_BYTES], iv[BENCH_IV_BYTES];
+    for (size_t i = 0; i < sizeof(key); i++) {
+        key[i] = (uint8_t)(0x5a + i);
+    }
+    for (size_t i = 0; i < sizeof(iv); i++) {
+        iv[i] = (uint8_t)(0xa5 - i);
+    }
+
+    size_t results_count = 0;
+    Result* results = malloc(ciphers_count * (1 + options.sizes_count * options.alignments_count) * sizeof(Result));
+    if (!results) {
+        perror("Memory allocation error");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < ciphers_count; i++) {
+        Job job = { ciphers[i], state, key, iv, NULL, NULL, 0 };
+        memset(state, 0, ciphers[i]->state_size);
+
+        fprintf(stderr, "Measuring %s\n", ciphers[i]->name);
+
+        Result* result = &results[results_count++];
+        measure(&job, &options, result);
+        result->alignment = 0;
+
+        for (int s = 0; s < options.sizes_count; s++) {
+            for (int a = 0; a < options.alignments_count; a++) {
+                job.in = input + options.alignments[a];
+                job.out = output + options.alignments[a];
+                job.size = options.sizes[s];
+
+                result = &results[results_count++];
+                measure(&job, &options, result);
+                result->alignment = options.alignments[a];
+            }
+        }
+    }
+
+    write_text(stdout, &info, results, results_count);
+    if (options.csv_path) {
+        FILE* file = open_output(options.csv_path);
+        write_csv(file, &info, results, results_count);
+        fclose(file);
+    }
+    if (options.json_path) {
+        FILE* file = open_output(options.json_path);
+        write_json(file, &info, results, results_count);
+        fclose(file);
+    }
+
+    free(results);
+    free(ciphers);
+    buffer_free(input);
+    buffer_free(output);
+    buffer_free(state);
+    return 0;
+}
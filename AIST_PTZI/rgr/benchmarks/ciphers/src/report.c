@@ -0,0 +1,78 @@
+#include "report.h"
+
+static const char* operation(const Result* result)
+{
+    return result->size > 0 ? "process" : "init";
+}
+
+static double cycles_per_byte(const Result* result)
+{
+    return result->cycles.mean / result->size;
+}
+
+// Bytes per nanosecond is GB/s
+static double gb_per_s(const Result* result)
+{
+    return result->size / result->ns.mean;
+}
+
+void write_text(FILE* out, const RunInfo* info, const Result* results, size_t count)
+{
+    if (info->cpu >= 0) {
+        fprintf(out, "Pinned to CPU %d, ", info->cpu);
+    } else {
+        fprintf(out, "Not pinned, ");
+    }
+    fprintf(out, "%d samples of >= %.1f ms per row, mean +- 95%% confidence interval\n\n",
+        info->samples, info->min_time_ms);
+
+    fprintf(out, "%-20s %-8s %8s %5s %24s %24s %9s %8s\n",
+        "cipher", "op", "size", "align", "ns/call", "cycles/call", "cycles/B", "GB/s");
+    for (size_t i = 0; i < count; i++) {
+        const Result* r = &results[i];
+        fprintf(out, "%-20s %-8s %8zu %5zu %12.1f +- %-8.1f %12.1f +- %-8.1f",
+            r->cipher, operation(r), r->size, r->alignment,
+            r->ns.mean, r->ns.ci95, r->cycles.mean, r->cycles.ci95);
+        if (r->size > 0) {
+            fprintf(out, " %9.3f %8.3f", cycles_per_byte(r), gb_per_s(r));
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void write_csv(FILE* out, const RunInfo* info, const Result* results, size_t count)
+{
+    (void)info;
+
+    fprintf(out, "cipher,operation,size,alignment,samples,ns,ns_ci95,cycles,cycles_ci95,cycles_per_byte,gb_per_s\n");
+    for (size_t i = 0; i < count; i++) {
+        const Result* r = &results[i];
+        fprintf(out, "%s,%s,%zu,%zu,%d,%.3f,%.3f,%.3f,%.3f,",
+            r->cipher, operation(r), r->size, r->alignment, r->samples,
+            r->ns.mean, r->ns.ci95, r->cycles.mean, r->cycles.ci95);
+        if (r->size > 0) {
+            fprintf(out, "%.4f,%.4f", cycles_per_byte(r), gb_per_s(r));
+        } else {
+            fprintf(out, ",");
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void write_json(FILE* out, const RunInfo* info, const Result* results, size_t count)
+{
+    fprintf(out, "{\n  \"cpu\": %d,\n  \"samples\": %d,\n  \"min_time_ms\": %.3f,\n  \"results\": [\n",
+        info->cpu, info->samples, info->min_time_ms);
+    for (size_t i = 0; i < count; i++) {
+        const Result* r = &results[i];
+        fprintf(out, "    {\"cipher\": \"%s\", \"operation\": \"%s\", \"size\": %zu, \"alignment\": %zu, "
+                     "\"samples\": %d, \"ns\": %.3f, \"ns_ci95\": %.3f, \"cycles\": %.3f, \"cycles_ci95\": %.3f",
+            r->cipher, operation(r), r->size, r->alignment, r->samples,
+            r->ns.mean, r->ns.ci95, r->cycles.mean, r->cycles.ci95);
+        if (r->size > 0) {
+            fprintf(out, ", \"cycles_per_byte\": %.4f, \"gb_per_s\": %.4f", cycles_per_byte(r), gb_per_s(r));
+        }
+        fprintf(out, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
@@ -0,0 +1,29 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include "stats.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+// One measured operation; size 0 is key and IV setup (per instance)
+typedef struct {
+    const char* cipher;
+    size_t size;
+    size_t alignment;
+    int samples;
+    Stat ns;     // per call
+    Stat cycles; // per call, TSC ticks; zero without a time stamp counter
+} Result;
+
+typedef struct {
+    int cpu; // pinned CPU, -1 if not pinned
+    int samples;
+    double min_time_ms;
+} RunInfo;
+
+void write_text(FILE* out, const RunInfo* info, const Result* results, size_t count);
+void write_csv(FILE* out, const RunInfo* info, const Result* results, size_t count);
+void write_json(FILE* out, const RunInfo* info, const Result* results, size_t count);
+
+#endif
@@ -0,0 +1,34 @@
+#include "stats.h"
+
+#include <math.h>
+
+// Two-sided 95% quantiles of Student's t distribution, df = 1..30
+static const double T95[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+Stat stat_of(const double* values, int count)
+{
+    Stat stat = { 0, 0 };
+    double sum = 0, squares = 0;
+
+    if (count <= 0) {
+        return stat;
+    }
+
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    stat.mean = sum / count;
+
+    if (count > 1) {
+        for (int i = 0; i < count; i++) {
+            squares += (values[i] - stat.mean) * (values[i] - stat.mean);
+        }
+        double t = count - 1 <= 30 ? T95[count - 2] : 1.96;
+        stat.ci95 = t * sqrt(squares / (count - 1) / count);
+    }
+    return stat;
+}
@@ -0,0 +1,12 @@
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+// Sample mean with the half-width of its 95% confidence interval
+typedef struct {
+    double mean;
+    double ci95;
+} Stat;
+
+Stat stat_of(const double* values, int count);
+
+#endif
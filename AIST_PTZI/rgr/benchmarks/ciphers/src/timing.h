@@ -0,0 +1,17 @@
+#ifndef BENCH_TIMING_H
+#define BENCH_TIMING_H
+
+#include <stdint.h>
+
+// Pins the calling thread to cpu, or to the CPU it runs on if cpu < 0.
+// Returns the CPU, or -1 if pinning is not supported.
+int pin_thread(int cpu);
+
+// Monotonic time in nanoseconds
+uint64_t now_ns(void);
+
+// Time stamp counter, 0 where there is none
+int have_cycles(void);
+uint64_t cycles(void);
+
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cipher_tests {
+
+typedef std::vector<uint8_t> Bytes;
+
+// Counts checks and failures of one suite. Failures are printed with the
+// context given by the test, so a fuzz failure can be replayed from the
+// seed and the printed lengths.
+class Checker {
+public:
+    explicit Checker(const std::string& suite)
+        : m_suite(suite)
+    {
+    }
+
+    const std::string& suite() const { return m_suite; }
+    size_t checks() const { return m_checks; }
+    size_t failures() const { return m_failures; }
+    size_t skipped() const { return m_skipped; }
+
+    bool expect(bool ok, const std::string& what);
+    // A check that cannot run on this platform; printed, neither passed nor failed
+    void skip(const std::string& what);
+    // Reports the first differing byte
+    bool equal(const uint8_t* expected, const uint8_t* actual, size_t size, const std::string& what);
+    bool equal(const Bytes& expected, const Bytes& actual, const std::string& what);
+
+private:
+    std::string m_suite;
+    size_t m_checks = 0;
+    size_t m_failures = 0;
+    size_t m_skipped = 0;
+};
+
+// Random lengths, split points and contents for the differential tests
+class Random {
+public:
+    explicit Random(uint64_t seed)
+        : m_engine(seed)
+    {
+    }
+
+    uint64_t next() { return m_engine(); }
+    // Uniform in [0, n), n > 0
+    size_t below(size_t n) { return static_cast<size_t>(m_engine() % n); }
+    // true with probability 1 / n
+    bool one_in(size_t n) { return below(n) == 0; }
+    void fill(uint8_t* data, size_t size);
+    Bytes bytes(size_t size);
+
+    // Mostly short messages around block boundaries, sometimes long ones
+    // that reach the wide SIMD kernels and the chunked entry points
+    size_t length(size_t block_bytes, size_t max_bytes);
+
+    // Piece lengths that add up to size. Every piece except the last is a
+    // multiple of granule, zero-length pieces included; granule 1 gives
+    // arbitrary split points
+    std::vector<size_t> splits(size_t size, size_t granule);
+
+private:
+    std::mt19937_64 m_engine;
+};
+
+// size bytes at a chosen distance from a 64-byte boundary, to run the
+// kernels on misaligned input and output
+class Buffer {
+public:
+    Buffer(size_t size, size_t misalign);
+
+    uint8_t* data() { return m_data; }
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    Bytes m_storage;
+    uint8_t* m_data;
+    size_t m_size;
+};
+
+// The chunk loop of a cipher's *_bytes64 functions, which only runs past
+// 4 GiB: encrypt64 (over zeros) and keystream64 produce chunk_length plus a
+// partial block of output, so the state has to carry across the chunk
+// boundary, and the last 64 MiB of both must match reference, the u32
+// keystream function called in pieces of whole blocks (block_bytes).
+// encrypt64 reads zero pages and writes 64 MiB of memory mapped over and
+// over. keystream64 may zero its output and encrypt it in place, which such
+// a ring would break, so it writes an unlinked file in $TMPDIR (/var/tmp by
+// default) instead. Linux only; elsewhere the check is skipped.
+void check_chunked(Checker& checker, const std::string& cipher, uint64_t chunk_length, size_t block_bytes,
+    const std::function<void(uint8_t* out, uint32_t size)>& reference,
+    const std::function<void(const uint8_t* in, uint8_t* out, uint64_t size)>& encrypt64,
+    const std::function<void(uint8_t* out, uint64_t size)>& keystream64);
+
+// Name of a check: "path, 1000 bytes", or "path, 256-bit key, 1000 bytes"
+// if key_bytes is given
+std::string describe(const std::string& path, size_t size, size_t key_bytes = 0);
+
+Bytes from_hex(const std::string& hex);
+std::string to_hex(const uint8_t* data, size_t size);
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "check.h"
+
+#include <cstddef>
+#include <string>
+
+namespace cipher_tests {
+
+struct Options {
+    // Directory with the cipher sources and their vector files
+    std::string vectors_dir = "../stream-ciphers";
+    // Random cases per optimized path
+    size_t iterations = 200;
+};
+
+// A suite runs the known-answer tests once; the differential tests compare
+// every optimized path of the cipher with its reference path on random
+// inputs and may be repeated with new seeds (--fuzz). The large tests, if
+// any, take minutes and gigabytes of address space and only run with --large
+struct Suite {
+    const char* name;
+    void (*known_answers)(Checker& checker, const Options& options);
+    void (*differential)(Checker& checker, Random& random, const Options& options);
+    void (*large)(Checker& checker, const Options& options);
+};
+
+void salsa20_known_answers(Checker& checker, const Options& options);
+void salsa20_differential(Checker& checker, Random& random, const Options& options);
+// The *_bytes64 functions across their first 4 GiB chunk
+void salsa20_large(Checker& checker, const Options& options);
+
+void chacha20_known_answers(Checker& checker, const Options& options);
+void chacha20_differential(Checker& checker, Random& random, const Options& options);
+// The *_bytes64 functions across their first 4 GiB chunk
+void chacha20_large(Checker& checker, const Options& options);
+
+void hc128_known_answers(Checker& checker, const Options& options);
+void hc128_differential(Checker& checker, Random& random, const Options& options);
+// The *_bytes64 functions across their first 4 GiB chunk
+void hc128_large(Checker& checker, const Options& options);
+
+void rabbit_known_answers(Checker& checker, const Options& options);
+void rabbit_differential(Checker& checker, Random& random, const Options& options);
+// The *_bytes64 functions across their first 4 GiB chunk
+void rabbit_large(Checker& checker, const Options& options);
+
+void sosemanuk_known_answers(Checker& checker, const Options& options);
+void sosemanuk_differential(Checker& checker, Random& random, const Options& options);
+// The *_bytes64 functions across their first 4 GiB chunk
+void sosemanuk_large(Checker& checker, const Options& options);
+
+void poly1305_known_answers(Checker& checker, const Options& options);
+void poly1305_differential(Checker& checker, Random& random, const Options& options);
+
+void aes_known_answers(Checker& checker, const Options& options);
+void aes_differential(Checker& checker, Random& random, const Options& options);
+
+// StreamCipher adapters, KeystreamBuffer and Aead from ciphers/
+void stream_cipher_known_answers(Checker& checker, const Options& options);
+void stream_cipher_differential(Checker& checker, Random& random, const Options& options);
+
+// SHA256 from lib/: FIPS 180-4 digests, SHA-NI and split adds against the
+// portable code
+void sha256_known_answers(Checker& checker, const Options& options);
+void sha256_differential(Checker& checker, Random& random, const Options& options);
+
+// SHA512, SHA512_256 and the HashAlgorithm factories from lib/: FIPS 180-4
+// digests and split adds against one add
+void sha512_known_answers(Checker& checker, const Options& options);
+void sha512_differential(Checker& checker, Random& random, const Options& options);
+
+// SHA256Tree from lib/: roots at leaf boundaries, verifyRange, split adds
+void sha256_tree_known_answers(Checker& checker, const Options& options);
+void sha256_tree_differential(Checker& checker, Random& random, const Options& options);
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "check.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cipher_tests {
+
+// One known-answer test: the keystream of a key/IV pair must match the
+// published segments
+struct KnownAnswer {
+    std::string name;
+    Bytes key;
+    // empty for vectors that skip the IV setup (Rabbit tests 1-3)
+    Bytes iv;
+    // Keystream bytes to generate; every segment lies within them
+    size_t stream_bytes = 0;
+    // (offset, expected keystream)
+    std::vector<std::pair<size_t, Bytes>> segments;
+    // ECRYPT only: XOR of all 64-byte blocks of the stream, may be empty
+    Bytes xor_digest;
+};
+
+// Parsers for the vector files shipped next to the cipher sources. They
+// throw std::runtime_error if the file cannot be read or has no vectors.
+
+// ECRYPT/eSTREAM "verified.test-vectors.txt" format
+std::vector<KnownAnswer> read_ecrypt_vectors(const std::string& path);
+// rabbit/test-vectors.txt: keyN, ivN and outN arrays
+std::vector<KnownAnswer> read_rabbit_vectors(const std::string& path);
+// sosemanuk/TEST_VECTOR_128.TXT: key, IV and "Total output" per vector
+std::vector<KnownAnswer> read_sosemanuk_vectors(const std::string& path);
+
+// Checks stream (stream_bytes of keystream) against the vector
+void check_known_answer(Checker& checker, const KnownAnswer& vector, const Bytes& stream, const std::string& how);
+
+}
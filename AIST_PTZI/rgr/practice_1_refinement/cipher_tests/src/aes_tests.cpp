@@ -0,0 +1,154 @@
+#include "suites.h"
+
+#include "aes/aes.h"
+
+#include <algorithm>
+
+namespace cipher_tests {
+
+namespace {
+const size_t BlockBytes = 16;
+const size_t MaxMessage = 64 * 1024;
+// portable, AES-NI, VAES
+const int Lanes[] = { 0, 8, 16 };
+const int KeyBits[] = { 128, 192, 256 };
+
+aes_ctx setup(const Bytes& key)
+{
+    aes_ctx ctx;
+    aes_keysetup(&ctx, key.data(), static_cast<int>(8 * key.size()));
+    return ctx;
+}
+
+Bytes ctr(const aes_ctx& ctx, Bytes counter, const uint8_t* message, size_t size)
+{
+    Bytes out(size);
+    aes_ctr_encrypt(&ctx, counter.data(), message, out.data(), size);
+    return out;
+}
+
+Bytes ghash(const Bytes& h, const uint8_t* message, const std::vector<size_t>& pieces)
+{
+    ghash_ctx ctx;
+    ghash_init(&ctx, h.data());
+    size_t offset = 0;
+    for (size_t piece : pieces) {
+        ghash_update(&ctx, message + offset, piece);
+        offset += piece;
+    }
+    Bytes out(16);
+    ghash_finish(&ctx, out.data());
+    return out;
+}
+}
+
+void aes_known_answers(Checker& checker, const Options&)
+{
+    // FIPS-197 appendix C
+    const char* const Keys[] = {
+        "000102030405060708090a0b0c0d0e0f",
+        "000102030405060708090a0b0c0d0e0f1011121314151617",
+        "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+    };
+    const char* const Ciphertexts[] = {
+        "69c4e0d86a7b0430d8cdb78070b4c55a",
+        "dda97ca4864cdfe06eaf70a0ec0d7191",
+        "8ea2b7ca516745bfeafc49904b496089",
+    };
+    Bytes plaintext = from_hex("00112233445566778899aabbccddeeff");
+
+    // SP 800-38A F.5.1 and F.5.5, CTR-AES128 and CTR-AES256
+    Bytes counter = from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    Bytes message = from_hex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                             "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    Bytes ctr128 = from_hex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+                            "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+    Bytes ctr256 = from_hex("601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c5"
+                            "2b0930daa23de94ce87017ba2d84988ddfc9c58db67aada613c2dd08457941a6");
+
+    // GCM specification (McGrew and Viega), test case 2: GHASH of the
+    // ciphertext and the length block
+    Bytes h = from_hex("66e94bd4ef8a2c3b884cfa59ca342b2e");
+    Bytes hashed = from_hex("0388dace60b6a392f328c2b971b2fe78" "00000000000000000000000000000080");
+
+    int default_lanes = aes_lanes();
+    for (int lanes : Lanes) {
+        aes_set_lanes(lanes);
+        if (aes_lanes() != lanes)
+            continue;
+        std::string with_lanes = ", lanes " + std::to_string(lanes);
+        for (int i = 0; i < 3; i++) {
+            aes_ctx ctx = setup(from_hex(Keys[i]));
+            Bytes block(16);
+            aes_encrypt_block(&ctx, plaintext.data(), block.data());
+            checker.equal(from_hex(Ciphertexts[i]), block,
+                "FIPS-197 AES-" + std::to_string(KeyBits[i]) + with_lanes);
+        }
+
+        aes_ctx ctx = setup(from_hex("2b7e151628aed2a6abf7158809cf4f3c"));
+        checker.equal(ctr128, ctr(ctx, counter, message.data(), message.size()), "SP 800-38A CTR-AES128" + with_lanes);
+        ctx = setup(from_hex("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4"));
+        checker.equal(ctr256, ctr(ctx, counter, message.data(), message.size()), "SP 800-38A CTR-AES256" + with_lanes);
+
+        checker.equal(from_hex("f38cbb1ad69223dcc3457ae5b6b0f885"), ghash(h, hashed.data(), { hashed.size() }),
+            "GCM test case 2 GHASH" + with_lanes);
+    }
+    aes_set_lanes(default_lanes);
+}
+
+void aes_differential(Checker& checker, Random& random, const Options& options)
+{
+    int default_lanes = aes_lanes();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        Bytes key = random.bytes(KeyBits[random.below(3)] / 8);
+        aes_ctx ctx = setup(key);
+        Bytes counter = random.bytes(16);
+        // sometimes close to the wrap of the 32-bit counter
+        if (random.one_in(4))
+            counter[12] = counter[13] = counter[14] = 0xff;
+        size_t size = random.length(BlockBytes, MaxMessage);
+        Bytes message = random.bytes(size);
+        std::string with_key = ", " + std::to_string(8 * key.size()) + "-bit key";
+
+        // the reference: the portable code in one call
+        aes_set_lanes(0);
+        Bytes expected = ctr(ctx, counter, message.data(), size);
+        Bytes h = random.bytes(16);
+        Bytes expected_hash = ghash(h, message.data(), { size });
+
+        for (int lanes : Lanes) {
+            aes_set_lanes(lanes);
+            if (aes_lanes() != lanes)
+                continue;
+            std::string with_lanes = ", lanes " + std::to_string(lanes);
+
+            // misaligned buffers
+            size_t in_offset = random.below(64), out_offset = random.below(64);
+            Buffer in(size, in_offset), out(size, out_offset);
+            std::copy(message.begin(), message.end(), in.data());
+            Bytes running = counter;
+            aes_ctr_encrypt(&ctx, running.data(), in.data(), out.data(), size);
+            checker.equal(expected.data(), out.data(), size,
+                describe("ctr, in +" + std::to_string(in_offset) + ", out +" + std::to_string(out_offset) + with_key
+                        + with_lanes, size));
+
+            // in place, in pieces of whole blocks: the counter continues
+            Bytes data = message;
+            running = counter;
+            size_t offset = 0;
+            for (size_t piece : random.splits(size, BlockBytes)) {
+                aes_ctr_encrypt(&ctx, running.data(), data.data() + offset, data.data() + offset, piece);
+                offset += piece;
+            }
+            checker.equal(expected, data, describe("chunked ctr in place" + with_key + with_lanes, size));
+
+            // GHASH with arbitrary split points
+            std::vector<size_t> pieces = random.splits(size, 1);
+            checker.equal(expected_hash, ghash(h, message.data(), pieces),
+                describe("ghash, " + std::to_string(pieces.size()) + " updates" + with_lanes, size));
+        }
+    }
+    aes_set_lanes(default_lanes);
+}
+
+}
@@ -0,0 +1,227 @@
+#include "suites.h"
+#include "test_vectors.h"
+
+extern "C" {
+#include "chacha20/chacha20.h"
+}
+
+#include <algorithm>
+
+namespace cipher_tests {
+
+namespace {
+// Kernel widths to compare; chacha20_set_lanes caps them at what the CPU has
+const int Lanes[] = { 4, 8, 16 };
+
+const size_t MaxMessage = 64 * 1024;
+
+// All-zero key and IV, the first test vector of draft-strombergson-chacha-test-vectors
+KnownAnswer zero_vector()
+{
+    KnownAnswer vector;
+    vector.name = "ChaCha20, zero key and IV";
+    vector.key.assign(32, 0);
+    vector.iv.assign(8, 0);
+    vector.stream_bytes = 64;
+    vector.segments.emplace_back(0, from_hex("76b8e0ada0f13d90405d6ae55386bd28bdd219b8a08ded1aa836efcc8b770dc7"
+                                             "da41597c5157488d7724e03fb8d84a376a43b8f41518a11cc387b669b2ee6586"));
+    return vector;
+}
+
+void setup(ECRYPT_ctx* ctx, const Bytes& key, const Bytes& iv)
+{
+    ECRYPT_keysetup(ctx, key.data(), static_cast<u32>(8 * key.size()), static_cast<u32>(8 * iv.size()));
+    ECRYPT_ivsetup(ctx, iv.data());
+}
+
+// The reference: scalar code, one call
+Bytes reference(const Bytes& key, const Bytes& iv, const uint8_t* message, size_t size)
+{
+    ECRYPT_ctx ctx;
+    setup(&ctx, key, iv);
+    Bytes out(size);
+    int lanes = chacha20_lanes();
+    chacha20_set_lanes(0);
+    ECRYPT_encrypt_bytes64(&ctx, message, out.data(), size);
+    chacha20_set_lanes(lanes);
+    return out;
+}
+}
+
+void chacha20_known_answers(Checker& checker, const Options&)
+{
+    ECRYPT_init();
+    int default_lanes = chacha20_lanes();
+    KnownAnswer vector = zero_vector();
+    for (int lanes : { 0, 4, 8, 16 }) {
+        chacha20_set_lanes(lanes);
+        ECRYPT_ctx ctx;
+        // several blocks, so the wide kernels produce block 0
+        Bytes stream(16 * 64);
+        setup(&ctx, vector.key, vector.iv);
+        ECRYPT_keystream_bytes(&ctx, stream.data(), static_cast<u32>(stream.size()));
+        check_known_answer(checker, vector, stream, "keystream_bytes, lanes " + std::to_string(lanes));
+    }
+    chacha20_set_lanes(default_lanes);
+
+    // HChaCha20, draft-irtf-cfrg-xchacha section 2.2.1
+    Bytes key(32);
+    for (size_t i = 0; i < key.size(); i++)
+        key[i] = static_cast<uint8_t>(i);
+    Bytes nonce = from_hex("000000090000004a0000000031415927");
+    Bytes subkey(32);
+    chacha20_hchacha20(subkey.data(), key.data(), nonce.data());
+    checker.equal(from_hex("82413b4227b27bfed30e42508a877d73a0f9e4d58a74a853c12ec41326d3ecdc"), subkey,
+        "hchacha20");
+}
+
+void chacha20_differential(Checker& checker, Random& random, const Options& options)
+{
+    ECRYPT_init();
+    int default_lanes = chacha20_lanes();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        Bytes key = random.bytes(random.one_in(2) ? 16 : 32);
+        Bytes iv = random.bytes(8);
+        size_t size = random.length(64, MaxMessage);
+        Bytes message = random.bytes(size);
+        Bytes expected = reference(key, iv, message.data(), size);
+        ECRYPT_ctx ctx;
+
+        // SIMD kernels, misaligned buffers, the counter after the call
+        for (int lanes : Lanes) {
+            chacha20_set_lanes(lanes);
+            size_t in_offset = random.below(64), out_offset = random.below(64);
+            Buffer in(size, in_offset), out(size, out_offset);
+            std::copy(message.begin(), message.end(), in.data());
+            setup(&ctx, key, iv);
+            ECRYPT_encrypt_bytes64(&ctx, in.data(), out.data(), size);
+            std::string what = describe("lanes " + std::to_string(lanes) + ", in +" + std::to_string(in_offset)
+                    + ", out +" + std::to_string(out_offset), size, key.size());
+            checker.equal(expected.data(), out.data(), size, what);
+            checker.expect(chacha20_counter(&ctx) == (size + 63) / 64, what + ": block counter");
+        }
+
+        int lanes = Lanes[random.below(3)];
+        chacha20_set_lanes(lanes);
+        std::string with_lanes = ", lanes " + std::to_string(lanes);
+
+        // in place
+        Bytes data = message;
+        setup(&ctx, key, iv);
+        ECRYPT_encrypt_bytes64(&ctx, data.data(), data.data(), size);
+        checker.equal(expected, data, describe("in place" + with_lanes, size, key.size()));
+
+        // keystream == encryption of zeros
+        Bytes keystream(size);
+        setup(&ctx, key, iv);
+        ECRYPT_keystream_bytes64(&ctx, keystream.data(), size);
+        for (size_t i = 0; i < size; i++)
+            keystream[i] ^= message[i];
+        checker.equal(expected, keystream, describe("keystream_bytes" + with_lanes, size, key.size()));
+
+        // consecutive calls, pieces of whole blocks
+        Bytes chunked(size);
+        setup(&ctx, key, iv);
+        size_t offset = 0;
+        for (size_t piece : random.splits(size, 64)) {
+            ECRYPT_encrypt_bytes(&ctx, message.data() + offset, chunked.data() + offset, static_cast<u32>(piece));
+            offset += piece;
+        }
+        checker.equal(expected, chunked, describe("chunked" + with_lanes, size, key.size()));
+
+        // random access: arbitrary split points through encrypt_range, out of order
+        Bytes ranged(size);
+        setup(&ctx, key, iv);
+        std::vector<size_t> pieces = random.splits(size, 1);
+        std::vector<size_t> starts(pieces.size());
+        offset = 0;
+        for (size_t i = 0; i < pieces.size(); i++) {
+            starts[i] = offset;
+            offset += pieces[i];
+        }
+        std::vector<size_t> order(pieces.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        for (size_t i = order.size(); i > 1; i--)
+            std::swap(order[i - 1], order[random.below(i)]);
+        for (size_t i : order) {
+            chacha20_encrypt_range(&ctx, starts[i], message.data() + starts[i], ranged.data() + starts[i],
+                static_cast<u32>(pieces[i]));
+        }
+        checker.equal(expected, ranged, describe("encrypt_range, " + std::to_string(pieces.size()) + " ranges" + with_lanes, size, key.size()));
+
+        // seek to a block and finish the message from there
+        size_t block = random.below(size / 64 + 1);
+        Bytes tail(size - 64 * block);
+        setup(&ctx, key, iv);
+        chacha20_set_counter(&ctx, block);
+        ECRYPT_encrypt_bytes64(&ctx, message.data() + 64 * block, tail.data(), tail.size());
+        checker.equal(expected.data() + 64 * block, tail.data(), tail.size(),
+            describe("set_counter " + std::to_string(block) + with_lanes, size, key.size()));
+
+        // XChaCha20 is ChaCha20 under the HChaCha20 subkey with the last 8 nonce bytes
+        Bytes xkey = random.bytes(32);
+        Bytes nonce = random.bytes(24);
+        Bytes subkey(32);
+        chacha20_hchacha20(subkey.data(), xkey.data(), nonce.data());
+        Bytes xexpected = reference(subkey, Bytes(nonce.begin() + 16, nonce.end()), message.data(), size);
+        Bytes xout(size);
+        setup(&ctx, xkey, nonce);
+        ECRYPT_encrypt_bytes64(&ctx, message.data(), xout.data(), size);
+        checker.equal(xexpected, xout, describe("xchacha20" + with_lanes, size, xkey.size()));
+    }
+
+    // Many sessions at once: short messages, lanes refilled as they run out
+    for (size_t iteration = 0; iteration < options.iterations / 4 + 1; iteration++) {
+        size_t count = 1 + random.below(40);
+        int lanes = random.one_in(4) ? 0 : Lanes[random.below(3)];
+        std::vector<ECRYPT_ctx> contexts(count);
+        std::vector<ECRYPT_ctx*> ctx_pointers;
+        std::vector<Bytes> messages, expected, outputs;
+        std::vector<const u8*> in;
+        std::vector<u8*> out;
+        std::vector<u32> sizes;
+        for (size_t i = 0; i < count; i++) {
+            // ChaCha20 and XChaCha20 sessions mixed
+            bool xchacha = random.one_in(3);
+            Bytes key = random.bytes(xchacha || random.one_in(2) ? 32 : 16);
+            Bytes iv = random.bytes(xchacha ? 24 : 8);
+            size_t size = random.one_in(4) ? random.length(64, 16 * 1024) : random.below(300);
+            messages.push_back(random.bytes(size));
+            expected.push_back(reference(key, iv, messages[i].data(), size));
+            outputs.emplace_back(size);
+            setup(&contexts[i], key, iv);
+        }
+        for (size_t i = 0; i < count; i++) {
+            ctx_pointers.push_back(&contexts[i]);
+            in.push_back(messages[i].data());
+            out.push_back(outputs[i].data());
+            sizes.push_back(static_cast<u32>(messages[i].size()));
+        }
+
+        chacha20_set_lanes(lanes);
+        chacha20_encrypt_batch(ctx_pointers.data(), in.data(), out.data(), sizes.data(), static_cast<u32>(count));
+        for (size_t i = 0; i < count; i++) {
+            std::string what = "encrypt_batch, message " + std::to_string(i) + " of " + std::to_string(count)
+                + ", lanes " + std::to_string(lanes) + ", " + std::to_string(sizes[i]) + " bytes";
+            checker.equal(expected[i], outputs[i], what);
+            checker.expect(chacha20_counter(&contexts[i]) == (sizes[i] + 63) / 64, what + ": block counter");
+        }
+    }
+    chacha20_set_lanes(default_lanes);
+}
+
+void chacha20_large(Checker& checker, const Options&)
+{
+    const Bytes key(32, 0x5a), iv(8, 0xa5);
+    ECRYPT_ctx reference, encrypt, keystream;
+    setup(&reference, key, iv);
+    setup(&encrypt, key, iv);
+    setup(&keystream, key, iv);
+    check_chunked(checker, "chacha20", ECRYPT_CHUNKLENGTH, ECRYPT_BLOCKLENGTH,
+        [&](uint8_t* out, uint32_t size) { ECRYPT_keystream_bytes(&reference, out, size); },
+        [&](const uint8_t* in, uint8_t* out, uint64_t size) { ECRYPT_encrypt_bytes64(&encrypt, in, out, size); },
+        [&](uint8_t* out, uint64_t size) { ECRYPT_keystream_bytes64(&keystream, out, size); });
+}
+
+}
@@ -0,0 +1,340 @@
+#include "check.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cipher_tests {
+
+namespace {
+// Failures printed per suite; a broken kernel fails every case
+const size_t MaxPrinted = 10;
+
+int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+#ifdef __linux__
+// Memory behind the output of check_chunked, and what is compared
+const size_t RingBytes = 64 << 20;
+// Pieces of the reference keystream
+const size_t PieceBytes = 1 << 20;
+
+// size bytes of address space in which every RingBytes map the same
+// memory, so a write at offset i lands at data()[i % RingBytes]
+class Ring {
+public:
+    explicit Ring(uint64_t size)
+        : m_span((size + RingBytes - 1) / RingBytes * RingBytes)
+    {
+        m_fd = memfd_create("cipher_tests", 0);
+        if (m_fd < 0 || ftruncate(m_fd, RingBytes) != 0) {
+            release();
+            throw std::runtime_error("cannot create the memory of a ring buffer");
+        }
+        void* base = mmap(nullptr, m_span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED) {
+            release();
+            throw std::runtime_error("cannot reserve " + std::to_string(m_span) + " bytes of address space");
+        }
+        m_data = static_cast<uint8_t*>(base);
+        for (uint64_t offset = 0; offset < m_span; offset += RingBytes) {
+            if (mmap(m_data + offset, RingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, m_fd, 0) == MAP_FAILED) {
+                release();
+                throw std::runtime_error("cannot map a ring buffer");
+            }
+        }
+    }
+    ~Ring() { release(); }
+
+    uint8_t* data() { return m_data; }
+
+private:
+    void release()
+    {
+        if (m_data)
+            munmap(m_data, m_span);
+        if (m_fd >= 0)
+            close(m_fd);
+        m_data = nullptr;
+        m_fd = -1;
+    }
+
+    uint64_t m_span;
+    uint8_t* m_data = nullptr;
+    int m_fd = -1;
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+};
+
+// size bytes of zeros, all backed by the shared zero page
+class Zeros {
+public:
+    explicit Zeros(uint64_t size)
+        : m_size(size)
+    {
+        void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED)
+            throw std::runtime_error("cannot map " + std::to_string(size) + " bytes of zeros");
+        m_data = static_cast<const uint8_t*>(base);
+    }
+    ~Zeros() { munmap(const_cast<uint8_t*>(m_data), m_size); }
+
+    const uint8_t* data() const { return m_data; }
+
+private:
+    uint64_t m_size;
+    const uint8_t* m_data;
+
+    Zeros(const Zeros&) = delete;
+    Zeros& operator=(const Zeros&) = delete;
+};
+
+// size bytes of an unlinked file, for output too large for memory
+class Spill {
+public:
+    explicit Spill(uint64_t size)
+        : m_size(size)
+    {
+        const char* dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir && *dir ? dir : "/var/tmp") + "/cipher_tests.XXXXXX";
+        m_fd = mkstemp(&path[0]);
+        if (m_fd < 0)
+            throw std::runtime_error("cannot create a file in " + path.substr(0, path.rfind('/')));
+        unlink(path.c_str());
+        void* base = MAP_FAILED;
+        if (ftruncate(m_fd, static_cast<off_t>(size)) == 0)
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (base == MAP_FAILED) {
+            close(m_fd);
+            throw std::runtime_error("cannot map a file of " + std::to_string(size) + " bytes");
+        }
+        m_data = static_cast<uint8_t*>(base);
+    }
+    ~Spill()
+    {
+        munmap(m_data, m_size);
+        close(m_fd);
+    }
+
+    uint8_t* data() { return m_data; }
+
+private:
+    uint64_t m_size;
+    uint8_t* m_data;
+    int m_fd;
+
+    Spill(const Spill&) = delete;
+    Spill& operator=(const Spill&) = delete;
+};
+#endif
+}
+
+bool Checker::expect(bool ok, const std::string& what)
+{
+    m_checks++;
+    if (ok)
+        return true;
+    m_failures++;
+    if (m_failures <= MaxPrinted)
+        std::cout << "FAIL " << m_suite << ": " << what << std::endl;
+    else if (m_failures == MaxPrinted + 1)
+        std::cout << "FAIL " << m_suite << ": more failures not shown" << std::endl;
+    return false;
+}
+
+void Checker::skip(const std::string& what)
+{
+    m_skipped++;
+    std::cout << "SKIP " << m_suite << ": " << what << std::endl;
+}
+
+bool Checker::equal(const uint8_t* expected, const uint8_t* actual, size_t size, const std::string& what)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (expected[i] != actual[i]) {
+            return expect(false, what + ": byte " + std::to_string(i) + " of " + std::to_string(size)
+                    + " is " + to_hex(actual + i, 1) + ", expected " + to_hex(expected + i, 1));
+        }
+    }
+    return expect(true, what);
+}
+
+bool Checker::equal(const Bytes& expected, const Bytes& actual, const std::string& what)
+{
+    if (expected.size() != actual.size()) {
+        return expect(false, what + ": " + std::to_string(actual.size()) + " bytes, expected "
+                + std::to_string(expected.size()));
+    }
+    return equal(expected.data(), actual.data(), expected.size(), what);
+}
+
+void Random::fill(uint8_t* data, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word = m_engine();
+        for (int j = 0; j < 8; j++)
+            data[i + j] = static_cast<uint8_t>(word >> (8 * j));
+    }
+    uint64_t word = m_engine();
+    for (; i < size; i++, word >>= 8)
+        data[i] = static_cast<uint8_t>(word);
+}
+
+Bytes Random::bytes(size_t size)
+{
+    Bytes out(size);
+    fill(out.data(), size);
+    return out;
+}
+
+size_t Random::length(size_t block_bytes, size_t max_bytes)
+{
+    switch (below(4)) {
+    case 0:
+        // a few bytes either side of a block boundary
+        return std::min(max_bytes, block_bytes * below(8) + below(3) + (one_in(2) ? 0 : block_bytes - below(3)));
+    case 1:
+        return below(std::min(max_bytes, 16 * block_bytes) + 1);
+    case 2:
+        return below(std::min(max_bytes, size_t(4096)) + 1);
+    default:
+        return below(max_bytes + 1);
+    }
+}
+
+std::vector<size_t> Random::splits(size_t size, size_t granule)
+{
+    std::vector<size_t> pieces;
+    while (size >= granule) {
+        if (one_in(16)) {
+            pieces.push_back(0);
+            continue;
+        }
+        size_t units = size / granule;
+        // mostly short pieces, so that one message has many split points
+        size_t piece = granule * (1 + below(one_in(4) ? units : std::min(units, size_t(8))));
+        if (one_in(8))
+            piece = size;
+        pieces.push_back(piece);
+        size -= piece;
+    }
+    if (size > 0 || pieces.empty())
+        pieces.push_back(size);
+    return pieces;
+}
+
+Buffer::Buffer(size_t size, size_t misalign)
+    : m_storage(size + misalign + 64)
+    , m_size(size)
+{
+    uintptr_t base = reinterpret_cast<uintptr_t>(m_storage.data());
+    size_t offset = (64 - base % 64) % 64 + misalign;
+    m_data = m_storage.data() + offset;
+}
+
+void check_chunked(Checker& checker, const std::string& cipher, uint64_t chunk_length, size_t block_bytes,
+    const std::function<void(uint8_t* out, uint32_t size)>& reference,
+    const std::function<void(const uint8_t* in, uint8_t* out, uint64_t size)>& encrypt64,
+    const std::function<void(uint8_t* out, uint64_t size)>& keystream64)
+{
+#ifdef __linux__
+    // a partial block after the first chunk
+    uint64_t size = chunk_length + block_bytes / 2 + 1;
+    uint64_t start = size - RingBytes;
+
+    // bytes [start, size) of the keystream
+    Bytes expected(RingBytes), piece(PieceBytes / block_bytes * block_bytes);
+    for (uint64_t offset = 0; offset < size;) {
+        uint32_t length = static_cast<uint32_t>(std::min<uint64_t>(piece.size(), size - offset));
+        reference(piece.data(), length);
+        if (offset + length > start) {
+            uint64_t from = std::max(offset, start);
+            memcpy(expected.data() + (from - start), piece.data() + (from - offset), offset + length - from);
+        }
+        offset += length;
+    }
+
+    auto compare = [&](const std::string& function, const Bytes& actual) {
+        checker.equal(expected, actual,
+            cipher + " " + function + ", last " + std::to_string(RingBytes) + " of " + std::to_string(size) + " bytes");
+    };
+
+    {
+        Zeros zeros(size);
+        Ring ring(size);
+        encrypt64(zeros.data(), ring.data(), size);
+        // the ring holds the last RingBytes written, rotated by start
+        size_t rotation = static_cast<size_t>(start % RingBytes);
+        Bytes actual(ring.data() + rotation, ring.data() + RingBytes);
+        actual.insert(actual.end(), ring.data(), ring.data() + rotation);
+        compare("encrypt_bytes64", actual);
+    }
+
+    Spill spill(size);
+    keystream64(spill.data(), size);
+    compare("keystream_bytes64", Bytes(spill.data() + start, spill.data() + size));
+#else
+    (void)chunk_length; (void)block_bytes; (void)reference; (void)encrypt64; (void)keystream64;
+    checker.skip(cipher + " encrypt_bytes64 and keystream_bytes64 past 4 GiB need Linux (memfd_create)");
+#endif
+}
+
+std::string describe(const std::string& path, size_t size, size_t key_bytes)
+{
+    std::string key = key_bytes ? ", " + std::to_string(8 * key_bytes) + "-bit key" : "";
+    return path + key + ", " + std::to_string(size) + " bytes";
+}
+
+Bytes from_hex(const std::string& hex)
+{
+    Bytes out;
+    int high = -1;
+    for (char c : hex) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            continue;
+        int digit = hex_digit(c);
+        if (digit < 0)
+            throw std::invalid_argument("not a hex string: " + hex);
+        if (high < 0) {
+            high = digit;
+        } else {
+            out.push_back(static_cast<uint8_t>(high << 4 | digit));
+            high = -1;
+        }
+    }
+    if (high >= 0)
+        throw std::invalid_argument("odd number of hex digits: " + hex);
+    return out;
+}
+
+std::string to_hex(const uint8_t* data, size_t size)
+{
+    static const char Digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(2 * size);
+    for (size_t i = 0; i < size; i++) {
+        out += Digits[data[i] >> 4];
+        out += Digits[data[i] & 15];
+    }
+    return out;
+}
+
+}
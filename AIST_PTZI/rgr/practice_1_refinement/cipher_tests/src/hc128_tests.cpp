@@ -0,0 +1,178 @@
+#include "suites.h"
+#include "test_vectors.h"
+
+extern "C" {
+#include "hc-128/ecrypt-sync.h"
+#include "hc-128/hc-128-simd.h"
+}
+
+#include <algorithm>
+#include <memory>
+
+namespace cipher_tests {
+
+namespace {
+const size_t BlockBytes = 64;
+const size_t MaxMessage = 64 * 1024;
+const size_t SimdLanes = 8;
+
+// Some thousand words of tables; kept off the stack
+typedef std::unique_ptr<ECRYPT_ctx> Context;
+
+Context setup(const Bytes& key, const Bytes& iv)
+{
+    Context ctx(new ECRYPT_ctx());
+    ECRYPT_keysetup(ctx.get(), key.data(), 128, 128);
+    ECRYPT_ivsetup(ctx.get(), iv.data());
+    return ctx;
+}
+
+// The reference: one keystream block per call
+Bytes reference(ECRYPT_ctx* ctx, const uint8_t* message, size_t size)
+{
+    Bytes out(size);
+    for (size_t offset = 0; offset < size; offset += BlockBytes) {
+        size_t length = std::min(BlockBytes, size - offset);
+        ECRYPT_process_bytes(0, ctx, message + offset, out.data() + offset, static_cast<u32>(length));
+    }
+    return out;
+}
+
+Bytes keystream(ECRYPT_ctx* ctx, size_t size)
+{
+    Bytes out(size);
+    ECRYPT_keystream_bytes64(ctx, out.data(), size);
+    return out;
+}
+}
+
+void hc128_known_answers(Checker& checker, const Options& options)
+{
+    ECRYPT_init();
+    std::string path = options.vectors_dir + "/hc-128/verified.test-vectors.txt";
+    std::vector<KnownAnswer> vectors = read_ecrypt_vectors(path);
+
+    for (const KnownAnswer& vector : vectors) {
+        Context ctx = setup(vector.key, vector.iv);
+        check_known_answer(checker, vector, keystream(ctx.get(), vector.stream_bytes), "keystream_bytes");
+
+        ECRYPT_ivsetup(ctx.get(), vector.iv.data());
+        Bytes zeros(vector.stream_bytes, 0);
+        Bytes stream(vector.stream_bytes);
+        ECRYPT_process_bytes64(0, ctx.get(), zeros.data(), stream.data(), stream.size());
+        check_known_answer(checker, vector, stream, "process_bytes");
+    }
+
+    // The AVX2 IV setup, eight vectors with different keys at a time. The
+    // contexts already hold the key and IV words from a scalar setup and are
+    // run forward, so the kernel has to rebuild the whole state.
+    if (hc128_simd_lanes() != static_cast<int>(SimdLanes))
+        return;
+    for (size_t first = 0; first + SimdLanes <= vectors.size(); first += SimdLanes) {
+        std::vector<Context> contexts;
+        ECRYPT_ctx* lanes[SimdLanes];
+        for (size_t i = 0; i < SimdLanes; i++) {
+            contexts.push_back(setup(vectors[first + i].key, vectors[first + i].iv));
+            keystream(contexts.back().get(), 3 * BlockBytes);
+            lanes[i] = contexts.back().get();
+        }
+        hc128_ivsetup_lanes(lanes);
+        for (size_t i = 0; i < SimdLanes; i++) {
+            const KnownAnswer& vector = vectors[first + i];
+            check_known_answer(checker, vector, keystream(lanes[i], vector.stream_bytes), "ivsetup_lanes");
+        }
+    }
+}
+
+void hc128_differential(Checker& checker, Random& random, const Options& options)
+{
+    ECRYPT_init();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        Bytes key = random.bytes(16);
+        Bytes iv = random.bytes(16);
+        size_t size = random.length(BlockBytes, MaxMessage);
+        Bytes message = random.bytes(size);
+        Context ctx = setup(key, iv);
+        Bytes expected = reference(ctx.get(), message.data(), size);
+
+        // batched keystream, misaligned buffers
+        size_t in_offset = random.below(64), out_offset = random.below(64);
+        Buffer in(size, in_offset), out(size, out_offset);
+        std::copy(message.begin(), message.end(), in.data());
+        ECRYPT_ivsetup(ctx.get(), iv.data());
+        ECRYPT_process_bytes64(0, ctx.get(), in.data(), out.data(), size);
+        checker.equal(expected.data(), out.data(), size,
+            describe("process_bytes, in +" + std::to_string(in_offset) + ", out +" + std::to_string(out_offset), size));
+
+        // in place
+        Bytes data = message;
+        ECRYPT_ivsetup(ctx.get(), iv.data());
+        ECRYPT_process_bytes64(0, ctx.get(), data.data(), data.data(), size);
+        checker.equal(expected, data, describe("in place", size));
+
+        // keystream written directly (aligned) or through a buffer
+        size_t stream_offset = random.below(8);
+        Buffer stream(size, stream_offset);
+        ECRYPT_ivsetup(ctx.get(), iv.data());
+        ECRYPT_keystream_bytes64(ctx.get(), stream.data(), size);
+        for (size_t i = 0; i < size; i++)
+            stream.data()[i] ^= message[i];
+        checker.equal(expected.data(), stream.data(), size,
+            describe("keystream_bytes, out +" + std::to_string(stream_offset), size));
+
+        // consecutive calls, pieces of whole blocks
+        Bytes chunked(size);
+        ECRYPT_ivsetup(ctx.get(), iv.data());
+        size_t offset = 0;
+        for (size_t piece : random.splits(size, BlockBytes)) {
+            ECRYPT_process_bytes(0, ctx.get(), message.data() + offset, chunked.data() + offset, static_cast<u32>(piece));
+            offset += piece;
+        }
+        checker.equal(expected, chunked, describe("chunked", size));
+    }
+
+    // Batched IV setup against one ECRYPT_ivsetup per context
+    for (size_t iteration = 0; iteration < options.iterations / 4 + 1; iteration++) {
+        Bytes key = random.bytes(16);
+        size_t count = 1 + random.below(3 * SimdLanes);
+        std::vector<Bytes> ivs;
+        std::vector<Context> contexts;
+        std::vector<ECRYPT_ctx*> batch;
+        std::vector<const u8*> iv_pointers;
+        for (size_t i = 0; i < count; i++) {
+            ivs.push_back(random.bytes(16));
+            contexts.emplace_back(new ECRYPT_ctx());
+            batch.push_back(contexts.back().get());
+        }
+        for (const Bytes& iv : ivs)
+            iv_pointers.push_back(iv.data());
+
+        // the key may come from one of the contexts being set up
+        Context own_key;
+        ECRYPT_ctx* key_ctx = batch[0];
+        if (random.one_in(2)) {
+            own_key.reset(new ECRYPT_ctx());
+            key_ctx = own_key.get();
+        }
+        ECRYPT_keysetup(key_ctx, key.data(), 128, 128);
+        hc128_ivsetup_batch(key_ctx, batch.data(), iv_pointers.data(), static_cast<u32>(count));
+
+        for (size_t i = 0; i < count; i++) {
+            Context single = setup(key, ivs[i]);
+            checker.equal(keystream(single.get(), 2 * BlockBytes), keystream(batch[i], 2 * BlockBytes),
+                "ivsetup_batch, context " + std::to_string(i) + " of " + std::to_string(count));
+        }
+    }
+}
+
+void hc128_large(Checker& checker, const Options&)
+{
+    const Bytes key(16, 0x5a), iv(16, 0xa5);
+    Context reference = setup(key, iv), encrypt = setup(key, iv), keystream = setup(key, iv);
+    check_chunked(checker, "hc128", ECRYPT_CHUNKLENGTH, ECRYPT_BLOCKLENGTH,
+        [&](uint8_t* out, uint32_t size) { ECRYPT_keystream_bytes(reference.get(), out, size); },
+        [&](const uint8_t* in, uint8_t* out, uint64_t size) { ECRYPT_encrypt_bytes64(encrypt.get(), in, out, size); },
+        [&](uint8_t* out, uint64_t size) { ECRYPT_keystream_bytes64(keystream.get(), out, size); });
+}
+
+}
@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "suites.h"
+
+// Usage: cipher_tests [--seed N] [--iterations N] [--fuzz SECONDS]
+//                     [--vectors DIR] [--large] [suite ...]
+// Known-answer tests of the stream ciphers, Poly1305 and AES against the
+// vector files in DIR (../stream-ciphers by default) and of the hashes in
+// lib/ against published digests, then differential tests of every
+// optimized path against the reference code on random keys, lengths,
+// alignments and split points. With --fuzz the differential
+// tests are repeated with new seeds until the time is up. --large adds the
+// tests of the *_bytes64 functions past 4 GiB (some minutes per cipher,
+// Linux only, reported as skipped elsewhere). Exits with 1 if any check
+// fails.
+
+namespace {
+using namespace cipher_tests;
+
+const Suite Suites[] = {
+    { "salsa20", salsa20_known_answers, salsa20_differential, salsa20_large },
+    { "chacha20", chacha20_known_answers, chacha20_differential, chacha20_large },
+    { "hc128", hc128_known_answers, hc128_differential, hc128_large },
+    { "rabbit", rabbit_known_answers, rabbit_differential, rabbit_large },
+    { "sosemanuk", sosemanuk_known_answers, sosemanuk_differential, sosemanuk_large },
+    { "poly1305", poly1305_known_answers, poly1305_differential, nullptr },
+    { "aes", aes_known_answers, aes_differential, nullptr },
+    { "stream_cipher", stream_cipher_known_answers, stream_cipher_differential, nullptr },
+    { "sha256", sha256_known_answers, sha256_differential, nullptr },
+    { "sha512", sha512_known_answers, sha512_differential, nullptr },
+    { "sha256_tree", sha256_tree_known_answers, sha256_tree_differential, nullptr },
+};
+
+struct Arguments {
+    Options options;
+    uint64_t seed = 1;
+    bool seed_given = false;
+    double fuzz_seconds = 0;
+    bool large = false;
+    std::vector<std::string> suites;
+};
+
+void usage()
+{
+    std::cerr << "Usage: cipher_tests [--seed N] [--iterations N] [--fuzz SECONDS] [--vectors DIR] [--large] [suite ...]\n"
+              << "Suites:";
+    for (const Suite& suite : Suites)
+        std::cerr << " " << suite.name;
+    std::cerr << std::endl;
+}
+
+bool parse(int argc, char** argv, Arguments& arguments)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--seed" && has_value) {
+            arguments.seed = std::strtoull(argv[++i], nullptr, 10);
+            arguments.seed_given = true;
+        } else if (arg == "--iterations" && has_value) {
+            arguments.options.iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--fuzz" && has_value) {
+            arguments.fuzz_seconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--vectors" && has_value) {
+            arguments.options.vectors_dir = argv[++i];
+        } else if (arg == "--large") {
+            arguments.large = true;
+        } else if (!arg.empty() && arg[0] != '-') {
+            bool known = false;
+            for (const Suite& suite : Suites)
+                known = known || arg == suite.name;
+            if (!known)
+                return false;
+            arguments.suites.push_back(arg);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool selected(const Arguments& arguments, const Suite& suite)
+{
+    if (arguments.suites.empty())
+        return true;
+    for (const std::string& name : arguments.suites) {
+        if (name == suite.name)
+            return true;
+    }
+    return false;
+}
+
+// Runs one part of a suite; an exception (e.g. a missing vector file)
+// counts as a failure
+template <typename Function>
+void run(Checker& checker, Function function)
+{
+    try {
+        function();
+    } catch (const std::exception& e) {
+        checker.expect(false, std::string("exception: ") + e.what());
+    }
+}
+
+void report(const Checker& known, const Checker& differential)
+{
+    std::cout << std::left << std::setw(14) << known.suite() << std::right
+              << std::setw(6) << known.checks() << " known-answer, "
+              << std::setw(8) << differential.checks() << " differential checks  "
+              << (known.failures() + differential.failures() == 0 ? "ok" : "FAILED") << std::endl;
+}
+}
+
+int main(int argc, char** argv)
+{
+    Arguments arguments;
+    if (!parse(argc, argv, arguments)) {
+        usage();
+        return 2;
+    }
+    if (arguments.fuzz_seconds > 0 && !arguments.seed_given)
+        arguments.seed = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+
+    std::cout << "seed " << arguments.seed << ", " << arguments.options.iterations
+              << " random cases per path" << std::endl;
+
+    size_t failures = 0, skipped = 0;
+    for (const Suite& suite : Suites) {
+        if (!selected(arguments, suite))
+            continue;
+        Checker known(suite.name), differential(suite.name);
+        Random random(arguments.seed);
+        run(known, [&] { suite.known_answers(known, arguments.options); });
+        run(differential, [&] { suite.differential(differential, random, arguments.options); });
+        report(known, differential);
+        failures += known.failures() + differential.failures();
+    }
+
+    if (arguments.large) {
+        for (const Suite& suite : Suites) {
+            if (!selected(arguments, suite) || !suite.large)
+                continue;
+            Checker large(suite.name);
+            auto start = std::chrono::steady_clock::now();
+            run(large, [&] { suite.large(large, arguments.options); });
+            std::cout << std::left << std::setw(14) << large.suite() << std::right
+                      << std::setw(6) << large.checks() << " large checks in " << std::fixed << std::setprecision(1)
+                      << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s  "
+                      << (large.failures() > 0 ? "FAILED" : large.skipped() > 0 ? "skipped" : "ok") << std::endl;
+            failures += large.failures();
+            skipped += large.skipped();
+        }
+    }
+
+    if (arguments.fuzz_seconds > 0) {
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+        size_t rounds = 0, checks = 0;
+        for (uint64_t seed = arguments.seed + 1; elapsed() < arguments.fuzz_seconds; seed++, rounds++) {
+            for (const Suite& suite : Suites) {
+                if (!selected(arguments, suite))
+                    continue;
+                Checker differential(suite.name);
+                Random random(seed);
+                run(differential, [&] { suite.differential(differential, random, arguments.options); });
+                checks += differential.checks();
+                if (differential.failures() > 0) {
+                    std::cout << "FAIL " << suite.name << " with --seed " << seed << std::endl;
+                    failures += differential.failures();
+                }
+            }
+        }
+        std::cout << "fuzz: " << rounds << " rounds, " << checks << " checks in "
+                  << std::fixed << std::setprecision(1) << elapsed() << " s" << std::endl;
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    if (skipped > 0)
+        std::cout << skipped << " checks skipped" << std::endl;
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
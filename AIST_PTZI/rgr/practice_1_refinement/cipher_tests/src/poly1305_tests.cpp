@@ -0,0 +1,81 @@
+#include "suites.h"
+
+#include "poly1305/poly1305.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cipher_tests {
+
+namespace {
+const size_t MaxMessage = 16 * 1024;
+
+Bytes tag_of(const Bytes& key, const uint8_t* message, const std::vector<size_t>& pieces)
+{
+    poly1305_ctx ctx;
+    poly1305_init(&ctx, key.data());
+    size_t offset = 0;
+    for (size_t piece : pieces) {
+        poly1305_update(&ctx, message + offset, piece);
+        offset += piece;
+    }
+    Bytes tag(16);
+    poly1305_finish(&ctx, tag.data());
+    return tag;
+}
+}
+
+void poly1305_known_answers(Checker& checker, const Options&)
+{
+    // RFC 8439 section 2.5.2
+    Bytes key = from_hex("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+    const char* text = "Cryptographic Forum Research Group";
+    Bytes expected = from_hex("a8061dc1305136c6c22b8baf0c0127a9");
+
+    int default_lanes = poly1305_lanes();
+    for (int lanes : { 0, 4, 8 }) {
+        poly1305_set_lanes(lanes);
+        Bytes tag(16);
+        poly1305_auth(tag.data(), reinterpret_cast<const uint8_t*>(text), strlen(text), key.data());
+        checker.equal(expected, tag, "RFC 8439 2.5.2, lanes " + std::to_string(lanes));
+    }
+    poly1305_set_lanes(default_lanes);
+
+    Bytes other = expected;
+    other[15] ^= 1;
+    checker.expect(poly1305_verify(expected.data(), expected.data()) == 1, "verify, equal tags");
+    checker.expect(poly1305_verify(expected.data(), other.data()) == 0, "verify, different tags");
+}
+
+void poly1305_differential(Checker& checker, Random& random, const Options& options)
+{
+    int default_lanes = poly1305_lanes();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        Bytes key = random.bytes(32);
+        size_t size = random.length(16, MaxMessage);
+        size_t misalign = random.below(16);
+        Buffer message(size, misalign);
+        random.fill(message.data(), size);
+        std::string what = std::to_string(size) + " bytes, message +" + std::to_string(misalign);
+
+        // the reference: scalar code, one update
+        poly1305_set_lanes(0);
+        Bytes expected = tag_of(key, message.data(), { size });
+
+        for (int lanes : { 4, 8 }) {
+            poly1305_set_lanes(lanes);
+            checker.equal(expected, tag_of(key, message.data(), { size }), "lanes " + std::to_string(lanes) + ", " + what);
+        }
+
+        // arbitrary split points: the leftover buffer between updates
+        for (int lanes : { 0, 4, 8 }) {
+            poly1305_set_lanes(lanes);
+            std::vector<size_t> pieces = random.splits(size, 1);
+            checker.equal(expected, tag_of(key, message.data(), pieces),
+                "lanes " + std::to_string(lanes) + ", " + std::to_string(pieces.size()) + " updates, " + what);
+        }
+    }
+    poly1305_set_lanes(default_lanes);
+}
+
+}
@@ -0,0 +1,220 @@
+#include "suites.h"
+#include "test_vectors.h"
+
+extern "C" {
+#include "rabbit/ecrypt-sync.h"
+#include "rabbit/rabbit-simd.h"
+}
+
+#include <algorithm>
+
+namespace cipher_tests {
+
+namespace {
+const size_t BlockBytes = ECRYPT_BLOCKLENGTH;
+const size_t MaxMessage = 64 * 1024;
+const int Lanes[] = { 4, 8 };
+
+// The third block of the key-only tests 1-3 in test-vectors.txt does not
+// follow RFC 4503 (tests 4-6 do in full), so only the first two are checked
+const size_t KeyOnlyCheckedBytes = 2 * BlockBytes;
+
+// An empty iv leaves the work state at the key setup (vectors 1-3)
+void setup(ECRYPT_ctx* ctx, const Bytes& key, const Bytes& iv)
+{
+    ECRYPT_keysetup(ctx, key.data(), 128, 64);
+    if (!iv.empty())
+        ECRYPT_ivsetup(ctx, iv.data());
+}
+
+// The reference: one keystream block per call
+Bytes reference(ECRYPT_ctx* ctx, const uint8_t* message, size_t size)
+{
+    Bytes out(size);
+    for (size_t offset = 0; offset < size; offset += BlockBytes) {
+        size_t length = std::min(BlockBytes, size - offset);
+        ECRYPT_process_bytes(0, ctx, message + offset, out.data() + offset, static_cast<u32>(length));
+    }
+    return out;
+}
+}
+
+void rabbit_known_answers(Checker& checker, const Options& options)
+{
+    ECRYPT_init();
+    std::string path = options.vectors_dir + "/rabbit/test-vectors.txt";
+    for (KnownAnswer vector : read_rabbit_vectors(path)) {
+        if (vector.iv.empty()) {
+            for (auto& segment : vector.segments)
+                segment.second.resize(std::min(segment.second.size(), KeyOnlyCheckedBytes));
+        }
+        ECRYPT_ctx ctx;
+        Bytes stream(vector.stream_bytes);
+        setup(&ctx, vector.key, vector.iv);
+        ECRYPT_keystream_bytes(&ctx, stream.data(), static_cast<u32>(stream.size()));
+        check_known_answer(checker, vector, stream, "keystream_bytes");
+
+        Bytes zeros(vector.stream_bytes, 0);
+        setup(&ctx, vector.key, vector.iv);
+        ECRYPT_process_bytes(0, &ctx, zeros.data(), stream.data(), static_cast<u32>(stream.size()));
+        check_known_answer(checker, vector, stream, "process_bytes");
+
+        // the same vector in every lane of the SIMD kernels
+        for (int lanes : Lanes) {
+            if (lanes > rabbit_simd_lanes())
+                continue;
+            ECRYPT_ctx contexts[8];
+            ECRYPT_ctx* ctx_pointers[8];
+            const u8* in[8];
+            u8* out[8];
+            Bytes streams[8];
+            for (int i = 0; i < lanes; i++) {
+                setup(&contexts[i], vector.key, vector.iv);
+                streams[i].resize(vector.stream_bytes);
+                ctx_pointers[i] = &contexts[i];
+                in[i] = zeros.data();
+                out[i] = streams[i].data();
+            }
+            rabbit_process_lanes(ctx_pointers, in, out, static_cast<u32>(vector.stream_bytes / BlockBytes), lanes);
+            for (int i = 0; i < lanes; i++) {
+                check_known_answer(checker, vector, streams[i],
+                    "process_lanes, lane " + std::to_string(i) + " of " + std::to_string(lanes));
+            }
+        }
+    }
+}
+
+void rabbit_differential(Checker& checker, Random& random, const Options& options)
+{
+    ECRYPT_init();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        Bytes key = random.bytes(16);
+        Bytes iv = random.bytes(8);
+        size_t size = random.length(BlockBytes, MaxMessage);
+        Bytes message = random.bytes(size);
+        ECRYPT_ctx ctx;
+        setup(&ctx, key, iv);
+        Bytes expected = reference(&ctx, message.data(), size);
+
+        // bulk keystream, misaligned buffers
+        size_t in_offset = random.below(64), out_offset = random.below(64);
+        Buffer in(size, in_offset), out(size, out_offset);
+        std::copy(message.begin(), message.end(), in.data());
+        setup(&ctx, key, iv);
+        ECRYPT_process_bytes64(0, &ctx, in.data(), out.data(), size);
+        checker.equal(expected.data(), out.data(), size,
+            describe("process_bytes, in +" + std::to_string(in_offset) + ", out +" + std::to_string(out_offset), size));
+
+        // in place
+        Bytes data = message;
+        setup(&ctx, key, iv);
+        ECRYPT_process_bytes64(0, &ctx, data.data(), data.data(), size);
+        checker.equal(expected, data, describe("in place", size));
+
+        // keystream written directly (aligned) or through a buffer
+        size_t stream_offset = random.below(8);
+        Buffer stream(size, stream_offset);
+        setup(&ctx, key, iv);
+        ECRYPT_keystream_bytes64(&ctx, stream.data(), size);
+        for (size_t i = 0; i < size; i++)
+            stream.data()[i] ^= message[i];
+        checker.equal(expected.data(), stream.data(), size,
+            describe("keystream_bytes, out +" + std::to_string(stream_offset), size));
+
+        // consecutive calls, pieces of whole blocks
+        Bytes chunked(size);
+        setup(&ctx, key, iv);
+        size_t offset = 0;
+        for (size_t piece : random.splits(size, BlockBytes)) {
+            ECRYPT_process_bytes(0, &ctx, message.data() + offset, chunked.data() + offset, static_cast<u32>(piece));
+            offset += piece;
+        }
+        checker.equal(expected, chunked, describe("chunked", size));
+    }
+
+    // Independent instances with their own keys, IVs and lengths
+    for (size_t iteration = 0; iteration < options.iterations / 4 + 1; iteration++) {
+        size_t count = 1 + random.below(40);
+        std::vector<ECRYPT_ctx> contexts(count);
+        std::vector<ECRYPT_ctx*> ctx_pointers;
+        std::vector<Bytes> messages, expected, outputs;
+        std::vector<const u8*> in;
+        std::vector<u8*> out;
+        std::vector<u32> lengths;
+        // similar lengths, so the lanes share most of their blocks
+        size_t common = random.length(BlockBytes, 16 * 1024);
+        for (size_t i = 0; i < count; i++) {
+            Bytes key = random.bytes(16), iv = random.bytes(8);
+            size_t size = random.one_in(4) ? random.length(BlockBytes, 16 * 1024)
+                : random.one_in(4)         ? random.below(2 * BlockBytes)
+                                           : common + random.below(40);
+            messages.push_back(random.bytes(size));
+            setup(&contexts[i], key, iv);
+            ECRYPT_ctx copy = contexts[i];
+            expected.push_back(reference(&copy, messages[i].data(), size));
+            outputs.emplace_back(size);
+        }
+        for (size_t i = 0; i < count; i++) {
+            ctx_pointers.push_back(&contexts[i]);
+            in.push_back(messages[i].data());
+            out.push_back(outputs[i].data());
+            lengths.push_back(static_cast<u32>(messages[i].size()));
+        }
+
+        rabbit_process_batch(ctx_pointers.data(), in.data(), out.data(), lengths.data(), static_cast<u32>(count));
+        for (size_t i = 0; i < count; i++) {
+            checker.equal(expected[i], outputs[i],
+                describe("process_batch, instance " + std::to_string(i) + " of " + std::to_string(count),
+                    messages[i].size()));
+        }
+    }
+
+    // The kernels directly, then the scalar code from the state they leave
+    for (int lanes : Lanes) {
+        if (lanes > rabbit_simd_lanes())
+            continue;
+        for (size_t iteration = 0; iteration < options.iterations / 4 + 1; iteration++) {
+            size_t blocks = 1 + random.below(200);
+            ECRYPT_ctx contexts[8];
+            ECRYPT_ctx* ctx_pointers[8];
+            Bytes messages[8], expected[8], outputs[8];
+            const u8* in[8];
+            u8* out[8];
+            for (int i = 0; i < lanes; i++) {
+                size_t size = blocks * BlockBytes + random.below(3 * BlockBytes);
+                messages[i] = random.bytes(size);
+                setup(&contexts[i], random.bytes(16), random.bytes(8));
+                ECRYPT_ctx copy = contexts[i];
+                expected[i] = reference(&copy, messages[i].data(), size);
+                outputs[i].resize(size);
+                ctx_pointers[i] = &contexts[i];
+                in[i] = messages[i].data();
+                out[i] = outputs[i].data();
+            }
+            rabbit_process_lanes(ctx_pointers, in, out, static_cast<u32>(blocks), lanes);
+            for (int i = 0; i < lanes; i++) {
+                size_t done = blocks * BlockBytes;
+                ECRYPT_process_bytes(0, &contexts[i], messages[i].data() + done, outputs[i].data() + done,
+                    static_cast<u32>(messages[i].size() - done));
+                checker.equal(expected[i], outputs[i],
+                    describe("process_lanes " + std::to_string(lanes) + ", lane " + std::to_string(i),
+                        messages[i].size()));
+            }
+        }
+    }
+}
+
+void rabbit_large(Checker& checker, const Options&)
+{
+    const Bytes key(16, 0x5a), iv(8, 0xa5);
+    ECRYPT_ctx reference, encrypt, keystream;
+    setup(&reference, key, iv);
+    setup(&encrypt, key, iv);
+    setup(&keystream, key, iv);
+    check_chunked(checker, "rabbit", ECRYPT_CHUNKLENGTH, ECRYPT_BLOCKLENGTH,
+        [&](uint8_t* out, uint32_t size) { ECRYPT_keystream_bytes(&reference, out, size); },
+        [&](const uint8_t* in, uint8_t* out, uint64_t size) { ECRYPT_encrypt_bytes64(&encrypt, in, out, size); },
+        [&](uint8_t* out, uint64_t size) { ECRYPT_keystream_bytes64(&keystream, out, size); });
+}
+
+}
@@ -0,0 +1,392 @@
+#include "suites.h"
+#include "test_vectors.h"
+
+#include "salsa_core.h"
+
+extern "C" {
+#include "salsa20/salsa20.h"
+}
+
+#include <algorithm>
+#include <thread>
+
+namespace cipher_tests {
+
+namespace {
+// Kernel widths to compare; salsa20_set_lanes caps them at what the CPU has
+const int Lanes[] = { 4, 8, 16 };
+
+const size_t MaxMessage = 64 * 1024;
+
+// Set 1, vector# 0 of the eSTREAM verified Salsa20/20 vectors (stream[0..63])
+KnownAnswer salsa20_vector(size_t key_bytes, const char* stream)
+{
+    KnownAnswer vector;
+    vector.name = "Set 1, vector# 0, " + std::to_string(8 * key_bytes) + "-bit key";
+    vector.key.assign(key_bytes, 0);
+    vector.key[0] = 0x80;
+    vector.iv.assign(8, 0);
+    vector.stream_bytes = 64;
+    vector.segments.emplace_back(0, from_hex(stream));
+    return vector;
+}
+
+// The same vector of the eSTREAM Salsa20/12 and Salsa20/8 vectors
+// (stream[0..63] and stream[448..511])
+KnownAnswer reduced_vector(size_t key_bytes, const char* stream0, const char* stream448)
+{
+    KnownAnswer vector = salsa20_vector(key_bytes, stream0);
+    vector.stream_bytes = 512;
+    vector.segments.emplace_back(448, from_hex(stream448));
+    return vector;
+}
+
+std::vector<KnownAnswer> known_vectors()
+{
+    return {
+        salsa20_vector(16, "4DFA5E481DA23EA09A31022050859936DA52FCEE218005164F267CB65F5CFD7F"
+                           "2B4F97E0FF16924A52DF269515110A07F9E460BC65EF95DA58F740B7D1DBB0AA"),
+        salsa20_vector(32, "E3BE8FDD8BECA2E3EA8EF9475B29A6E7003951E1097A5C38D23B7A5FAD9F6844"
+                           "B22C97559E2723C7CBBD3FE4FC8D9A0744652A83E72A9C461876AF4D7EF1A117"),
+    };
+}
+
+void setup(ECRYPT_ctx* ctx, const Bytes& key, const Bytes& iv)
+{
+    ECRYPT_keysetup(ctx, key.data(), static_cast<u32>(8 * key.size()), 64);
+    ECRYPT_ivsetup(ctx, iv.data());
+}
+
+// The reference: scalar code, one call
+Bytes reference(const Bytes& key, const Bytes& iv, const uint8_t* message, size_t size)
+{
+    ECRYPT_ctx ctx;
+    setup(&ctx, key, iv);
+    Bytes out(size);
+    int lanes = salsa20_lanes();
+    salsa20_set_lanes(0);
+    ECRYPT_encrypt_bytes64(&ctx, message, out.data(), size);
+    salsa20_set_lanes(lanes);
+    return out;
+}
+
+template <int KeyBits, int Rounds = 20>
+Bytes core_keystream(const Bytes& key, const Bytes& iv, size_t size)
+{
+    typedef ciphers::salsa::Core<Rounds, KeyBits> Core;
+    uint32_t state[16];
+    Core::set_key(state, key.data());
+    Core::set_iv(state, iv.data());
+    Bytes out(size, 0);
+    Core::process(state, out.data(), out.data(), size);
+    return out;
+}
+
+template <int KeyBits, int Rounds = 20>
+Bytes core_process(Random& random, const Bytes& key, const Bytes& iv, const uint8_t* message, size_t size)
+{
+    typedef ciphers::salsa::Core<Rounds, KeyBits> Core;
+    uint32_t state[16];
+    Core::set_key(state, key.data());
+    Core::set_iv(state, iv.data());
+    Bytes out(size);
+    size_t offset = 0;
+    for (size_t piece : random.splits(size, Core::BlockBytes)) {
+        Core::process(state, message + offset, out.data() + offset, piece);
+        offset += piece;
+    }
+    return out;
+}
+
+// The reference for the reduced-round cores: Core::block() one block at a
+// time, never the SIMD kernels
+template <int KeyBits, int Rounds>
+Bytes core_blocks(const Bytes& key, const Bytes& iv, const uint8_t* message, size_t size)
+{
+    typedef ciphers::salsa::Core<Rounds, KeyBits> Core;
+    uint32_t state[16];
+    Core::set_key(state, key.data());
+    Core::set_iv(state, iv.data());
+    Bytes out(size);
+    uint8_t keystream[Core::BlockBytes];
+    for (size_t offset = 0; offset < size; offset += Core::BlockBytes) {
+        Core::block(state, keystream);
+        Core::set_counter(state, Core::counter(state) + 1);
+        for (size_t i = offset; i < std::min(size, offset + Core::BlockBytes); i++)
+            out[i] = message[i] ^ keystream[i - offset];
+    }
+    return out;
+}
+
+template <int Rounds>
+void check_reduced_core(Checker& checker, Random& random, const Bytes& key, const Bytes& iv, const uint8_t* message, size_t size)
+{
+    Bytes expected = key.size() == 16 ? core_blocks<128, Rounds>(key, iv, message, size)
+                                      : core_blocks<256, Rounds>(key, iv, message, size);
+    Bytes core = key.size() == 16 ? core_process<128, Rounds>(random, key, iv, message, size)
+                                  : core_process<256, Rounds>(random, key, iv, message, size);
+    checker.equal(expected, core, describe("salsa::Core<" + std::to_string(Rounds) + ">", size, key.size()));
+}
+
+// Keystream of a reduced-round core through the SIMD kernels (process) and
+// one block at a time (block)
+template <int Rounds>
+void check_reduced_vector(Checker& checker, const KnownAnswer& vector)
+{
+    std::string core = "salsa::Core<" + std::to_string(Rounds) + ">";
+    Bytes zeros(16 * 64, 0);
+    bool key128 = vector.key.size() == 16;
+    Bytes stream = key128 ? core_keystream<128, Rounds>(vector.key, vector.iv, zeros.size())
+                          : core_keystream<256, Rounds>(vector.key, vector.iv, zeros.size());
+    check_known_answer(checker, vector, stream, core + "::process");
+    stream = key128 ? core_blocks<128, Rounds>(vector.key, vector.iv, zeros.data(), zeros.size())
+                    : core_blocks<256, Rounds>(vector.key, vector.iv, zeros.data(), zeros.size());
+    check_known_answer(checker, vector, stream, core + "::block");
+}
+}
+
+void salsa20_known_answers(Checker& checker, const Options&)
+{
+    ECRYPT_init();
+    int default_lanes = salsa20_lanes();
+    for (const KnownAnswer& vector : known_vectors()) {
+        for (int lanes : { 0, 4, 8, 16 }) {
+            salsa20_set_lanes(lanes);
+            ECRYPT_ctx ctx;
+            // several blocks, so the wide kernels produce block 0
+            Bytes stream(16 * 64);
+            setup(&ctx, vector.key, vector.iv);
+            ECRYPT_keystream_bytes(&ctx, stream.data(), static_cast<u32>(stream.size()));
+            check_known_answer(checker, vector, stream, "keystream_bytes, lanes " + std::to_string(lanes));
+        }
+        salsa20_set_lanes(default_lanes);
+
+        Bytes stream = vector.key.size() == 16 ? core_keystream<128>(vector.key, vector.iv, 16 * 64)
+                                               : core_keystream<256>(vector.key, vector.iv, 16 * 64);
+        check_known_answer(checker, vector, stream, "salsa::Core<20>");
+    }
+
+    // eSTREAM Salsa20/12 and Salsa20/8, Set 1, vector# 0
+    check_reduced_vector<12>(checker, reduced_vector(16,
+        "FC207DBFC76C5E1774961E7A5AAD09069B2225AC1CE0FE7A0CE77003E7E5BDF8"
+        "B31AF821000813E6C56B8C1771D6EE7039B2FBD0A68E8AD70A3944B677937897",
+        "A52ED8C37014B10EC0AA8E05B5CEEE123A1017557FB3B15C53E6C5EA8300BF74"
+        "264A73B5315DC821AD2CAB0F3BB2F152BDAEA3AEE97BA04B8E72A7B40DCC6BA4"));
+    check_reduced_vector<12>(checker, reduced_vector(32,
+        "AFE411ED1C4E07E4D0CDE3B33E31EC190FA4CC796A58BAFB848EAD8D07D02CD2"
+        "D4B6F9F30CB0B57007E3733895CC8D1060107975ACAEEB689B6CF614AB64A3D6",
+        "87A5191EC2E3C9049FA524CD8673E0677C77ADCF8AB5328FD828C4ACB3ECCCA5"
+        "49ADEDA04872518ECDF874ADCB2420C7BD1CCFE561B074080224FA7176F0CB5F"));
+    check_reduced_vector<8>(checker, reduced_vector(16,
+        "A9C9F888AB552A2D1BBFF9F36BEBEB337A8B4B107C75B63BAE26CB9A235BBA9D"
+        "784F38BEFC3ADF4CD3E266687EA7B9F09BA650AE81EAC6063AE31FF12218DDC5",
+        "BEE85903BEA506B05FC04795836FAAAC7F93F785D473EB762576D96B4A65FFE4"
+        "63B34AAE696777FC6351B67C3753B89BA6B197BD655D1D9CA86E067F4D770220"));
+    check_reduced_vector<8>(checker, reduced_vector(32,
+        "B1F599E9B0D96DF436AE31F5EF589565B92D245DB5A1D4C7A78E5E8D0146F8A4"
+        "9D326C1A3BF50C052C9C8F114DC74972C4469591E31C9ED11927AA9871F38583",
+        "53BF865C66A344CFCD19177476A05ACA5851CC45224B196ABF3206D899E7FE3B"
+        "13B3F028FA849B5564561A9181EA69E512BC34DA29180CDF6811E40A9A06A8D1"));
+}
+
+void salsa20_differential(Checker& checker, Random& random, const Options& options)
+{
+    ECRYPT_init();
+    int default_lanes = salsa20_lanes();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        Bytes key = random.bytes(random.one_in(2) ? 16 : 32);
+        Bytes iv = random.bytes(8);
+        size_t size = random.length(64, MaxMessage);
+        Bytes message = random.bytes(size);
+        Bytes expected = reference(key, iv, message.data(), size);
+        ECRYPT_ctx ctx;
+
+        // SIMD kernels, misaligned buffers, the counter after the call
+        for (int lanes : Lanes) {
+            salsa20_set_lanes(lanes);
+            size_t in_offset = random.below(64), out_offset = random.below(64);
+            Buffer in(size, in_offset), out(size, out_offset);
+            std::copy(message.begin(), message.end(), in.data());
+            setup(&ctx, key, iv);
+            ECRYPT_encrypt_bytes64(&ctx, in.data(), out.data(), size);
+            std::string what = describe("lanes " + std::to_string(lanes) + ", in +" + std::to_string(in_offset)
+                    + ", out +" + std::to_string(out_offset), size, key.size());
+            checker.equal(expected.data(), out.data(), size, what);
+            checker.expect(salsa20_counter(&ctx) == (size + 63) / 64, what + ": block counter");
+        }
+
+        int lanes = Lanes[random.below(3)];
+        salsa20_set_lanes(lanes);
+        std::string with_lanes = ", lanes " + std::to_string(lanes);
+
+        // in place
+        Bytes data = message;
+        setup(&ctx, key, iv);
+        ECRYPT_encrypt_bytes64(&ctx, data.data(), data.data(), size);
+        checker.equal(expected, data, describe("in place" + with_lanes, size, key.size()));
+
+        // keystream == encryption of zeros
+        Bytes keystream(size);
+        setup(&ctx, key, iv);
+        ECRYPT_keystream_bytes64(&ctx, keystream.data(), size);
+        for (size_t i = 0; i < size; i++)
+            keystream[i] ^= message[i];
+        checker.equal(expected, keystream, describe("keystream_bytes" + with_lanes, size, key.size()));
+
+        // consecutive calls, pieces of whole blocks
+        Bytes chunked(size);
+        setup(&ctx, key, iv);
+        size_t offset = 0;
+        for (size_t piece : random.splits(size, 64)) {
+            ECRYPT_encrypt_bytes(&ctx, message.data() + offset, chunked.data() + offset, static_cast<u32>(piece));
+            offset += piece;
+        }
+        checker.equal(expected, chunked, describe("chunked" + with_lanes, size, key.size()));
+
+        // random access: arbitrary split points through encrypt_range
+        Bytes ranged(size);
+        setup(&ctx, key, iv);
+        std::vector<size_t> pieces = random.splits(size, 1);
+        std::vector<size_t> starts(pieces.size());
+        offset = 0;
+        for (size_t i = 0; i < pieces.size(); i++) {
+            starts[i] = offset;
+            offset += pieces[i];
+        }
+        // out of order, so every range starts from a foreign counter
+        std::vector<size_t> order(pieces.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        for (size_t i = order.size(); i > 1; i--)
+            std::swap(order[i - 1], order[random.below(i)]);
+        for (size_t i : order) {
+            salsa20_encrypt_range(&ctx, starts[i], message.data() + starts[i], ranged.data() + starts[i],
+                static_cast<u32>(pieces[i]));
+        }
+        checker.equal(expected, ranged, describe("encrypt_range, " + std::to_string(pieces.size()) + " ranges" + with_lanes, size, key.size()));
+
+        // seek to a block and finish the message from there
+        size_t block = random.below(size / 64 + 1);
+        Bytes tail(size - 64 * block);
+        setup(&ctx, key, iv);
+        salsa20_set_counter(&ctx, block);
+        ECRYPT_encrypt_bytes64(&ctx, message.data() + 64 * block, tail.data(), tail.size());
+        checker.equal(expected.data() + 64 * block, tail.data(), tail.size(),
+            describe("set_counter " + std::to_string(block) + with_lanes, size, key.size()));
+
+        // the compile-time core
+        Bytes core = key.size() == 16 ? core_process<128>(random, key, iv, message.data(), size)
+                                      : core_process<256>(random, key, iv, message.data(), size);
+        checker.equal(expected, core, describe("salsa::Core<20>", size, key.size()));
+        check_reduced_core<12>(checker, random, key, iv, message.data(), size);
+        check_reduced_core<8>(checker, random, key, iv, message.data(), size);
+    }
+
+    // Many sessions at once: short messages, lanes refilled as they run out
+    for (size_t iteration = 0; iteration < options.iterations / 4 + 1; iteration++) {
+        size_t count = 1 + random.below(40);
+        int lanes = random.one_in(4) ? 0 : Lanes[random.below(3)];
+        std::vector<ECRYPT_ctx> contexts(count);
+        std::vector<ECRYPT_ctx*> ctx_pointers;
+        std::vector<Bytes> messages, expected, outputs;
+        std::vector<const u8*> in;
+        std::vector<u8*> out;
+        std::vector<u32> sizes;
+        for (size_t i = 0; i < count; i++) {
+            Bytes key = random.bytes(random.one_in(2) ? 16 : 32);
+            Bytes iv = random.bytes(8);
+            size_t size = random.one_in(4) ? random.length(64, 16 * 1024) : random.below(300);
+            messages.push_back(random.bytes(size));
+            expected.push_back(reference(key, iv, messages[i].data(), size));
+            outputs.emplace_back(size);
+            setup(&contexts[i], key, iv);
+        }
+        for (size_t i = 0; i < count; i++) {
+            ctx_pointers.push_back(&contexts[i]);
+            in.push_back(messages[i].data());
+            out.push_back(outputs[i].data());
+            sizes.push_back(static_cast<u32>(messages[i].size()));
+        }
+
+        salsa20_set_lanes(lanes);
+        salsa20_encrypt_batch(ctx_pointers.data(), in.data(), out.data(), sizes.data(), static_cast<u32>(count));
+        for (size_t i = 0; i < count; i++) {
+            std::string what = "encrypt_batch, message " + std::to_string(i) + " of " + std::to_string(count)
+                + ", lanes " + std::to_string(lanes) + ", " + std::to_string(sizes[i]) + " bytes";
+            checker.equal(expected[i], outputs[i], what);
+            checker.expect(salsa20_counter(&contexts[i]) == (sizes[i] + 63) / 64, what + ": block counter");
+        }
+    }
+
+    // Multi-threaded path, from just below the threshold to a few chunks
+    int threads = salsa20_threads();
+    for (size_t iteration = 0; iteration < options.iterations / 50 + 1; iteration++) {
+        Bytes key = random.bytes(32);
+        Bytes iv = random.bytes(8);
+        size_t size = SALSA20_PARALLEL_THRESHOLD - 1024 + random.below(3 * SALSA20_PARALLEL_THRESHOLD);
+        Bytes message = random.bytes(size);
+        Bytes expected = reference(key, iv, message.data(), size);
+
+        int workers = 1 + static_cast<int>(random.below(8));
+        salsa20_set_threads(workers);
+        salsa20_set_lanes(Lanes[random.below(3)]);
+        Bytes out(size);
+        ECRYPT_ctx ctx;
+        setup(&ctx, key, iv);
+        // up to two whole blocks through the serial code first: the parallel
+        // part continues at the block counter they leave
+        size_t head = random.below(3) * 64;
+        ECRYPT_encrypt_bytes(&ctx, message.data(), out.data(), static_cast<u32>(head));
+        salsa20_encrypt_parallel(&ctx, message.data() + head, out.data() + head, size - head);
+        std::string what = describe("encrypt_parallel, " + std::to_string(workers) + " threads", size, key.size());
+        checker.equal(expected, out, what);
+        checker.expect(salsa20_counter(&ctx) == (size + 63) / 64, what + ": block counter");
+    }
+
+    // Calls from several threads at once: whichever finds the pool busy
+    // encrypts on its own thread
+    salsa20_set_threads(4);
+    const size_t Callers = 3;
+    std::vector<Bytes> messages, expected, outputs(Callers);
+    std::vector<ECRYPT_ctx> contexts(Callers);
+    for (size_t i = 0; i < Callers; i++) {
+        Bytes key = random.bytes(32);
+        Bytes iv = random.bytes(8);
+        size_t size = SALSA20_PARALLEL_THRESHOLD + random.below(4 * SALSA20_PARALLEL_THRESHOLD);
+        messages.push_back(random.bytes(size));
+        expected.push_back(reference(key, iv, messages[i].data(), size));
+        outputs[i].resize(size);
+        setup(&contexts[i], key, iv);
+    }
+    std::vector<std::thread> callers;
+    for (size_t i = 0; i < Callers; i++) {
+        callers.emplace_back([&, i] {
+            salsa20_encrypt_parallel(&contexts[i], messages[i].data(), outputs[i].data(), messages[i].size());
+        });
+    }
+    for (std::thread& caller : callers)
+        caller.join();
+    for (size_t i = 0; i < Callers; i++) {
+        std::string what = describe("encrypt_parallel, caller " + std::to_string(i) + " of " + std::to_string(Callers),
+            messages[i].size());
+        checker.equal(expected[i], outputs[i], what);
+        checker.expect(salsa20_counter(&contexts[i]) == (messages[i].size() + 63) / 64, what + ": block counter");
+    }
+    salsa20_set_threads(threads);
+    salsa20_set_lanes(default_lanes);
+}
+
+void salsa20_large(Checker& checker, const Options&)
+{
+    const Bytes key(32, 0x5a), iv(8, 0xa5);
+    ECRYPT_ctx reference, encrypt, keystream;
+    setup(&reference, key, iv);
+    setup(&encrypt, key, iv);
+    setup(&keystream, key, iv);
+    check_chunked(checker, "salsa20", ECRYPT_CHUNKLENGTH, ECRYPT_BLOCKLENGTH,
+        [&](uint8_t* out, uint32_t size) { ECRYPT_keystream_bytes(&reference, out, size); },
+        [&](const uint8_t* in, uint8_t* out, uint64_t size) { ECRYPT_encrypt_bytes64(&encrypt, in, out, size); },
+        [&](uint8_t* out, uint64_t size) { ECRYPT_keystream_bytes64(&keystream, out, size); });
+}
+
+}
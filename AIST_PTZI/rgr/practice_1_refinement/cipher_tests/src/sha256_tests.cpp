@@ -0,0 +1,107 @@
+#include "suites.h"
+
+#include "sha256.h"
+
+#include <algorithm>
+
+namespace cipher_tests {
+
+namespace {
+const size_t MaxMessage = 64 * 1024;
+
+struct Implementation {
+    const char* name;
+    SHA256::Implementation implementation;
+};
+
+// The portable code, and SHA-NI where the CPU has it
+std::vector<Implementation> implementations()
+{
+    std::vector<Implementation> out = { { "portable", SHA256::Portable } };
+    if (SHA256(SHA256::HardwareAccelerated).isAccelerated())
+        out.push_back({ "sha-ni", SHA256::HardwareAccelerated });
+    return out;
+}
+
+std::string digest_of(SHA256::Implementation implementation, const uint8_t* data, const std::vector<size_t>& pieces)
+{
+    SHA256 sha256(implementation);
+    size_t offset = 0;
+    for (size_t piece : pieces) {
+        sha256.add(data + offset, piece);
+        offset += piece;
+    }
+    return sha256.getHash();
+}
+}
+
+void sha256_known_answers(Checker& checker, const Options&)
+{
+    // FIPS 180-4 examples (NIST CSRC "SHA256.pdf", "SHA2_Additional.pdf")
+    const char* Message448 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    const std::string MillionA(1000000, 'a');
+    const struct {
+        const char* name;
+        std::string message;
+        const char* digest;
+    } Vectors[] = {
+        { "empty", "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "\"abc\"", "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "448-bit message", Message448, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { "1M x 'a'", MillionA, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+    };
+
+    for (const Implementation& implementation : implementations()) {
+        for (const auto& vector : Vectors) {
+            const uint8_t* message = reinterpret_cast<const uint8_t*>(vector.message.data());
+            size_t size = vector.message.size();
+            std::string what = std::string(implementation.name) + ", " + vector.name;
+            checker.expect(digest_of(implementation.implementation, message, { size }) == vector.digest, "one add, " + what);
+            // a partial block, a run of whole blocks, the tail
+            size_t head = std::min<size_t>(size, 7);
+            size_t bulk = (size - head) / SHA256::BlockSize / 2 * SHA256::BlockSize;
+            checker.expect(digest_of(implementation.implementation, message, { head, bulk, size - head - bulk }) == vector.digest,
+                "three adds, " + what);
+
+            // operator() restarts the hash
+            SHA256 sha256(implementation.implementation);
+            sha256.add("x", 1);
+            checker.expect(sha256(vector.message) == vector.digest, "operator() after add, " + what);
+        }
+    }
+}
+
+void sha256_differential(Checker& checker, Random& random, const Options& options)
+{
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        size_t size = random.length(SHA256::BlockSize, MaxMessage);
+        size_t misalign = random.below(64);
+        Buffer message(size, misalign);
+        random.fill(message.data(), size);
+        std::string what = describe("message +" + std::to_string(misalign), size);
+
+        // the reference: portable code, one add
+        std::string expected = digest_of(SHA256::Portable, message.data(), { size });
+
+        for (const Implementation& implementation : implementations()) {
+            std::string path = std::string(implementation.name) + ", ";
+            if (implementation.implementation != SHA256::Portable)
+                checker.expect(digest_of(implementation.implementation, message.data(), { size }) == expected, path + "one add, " + what);
+
+            // fill the buffer partway, hash a run of whole blocks straight
+            // from the unaligned message, buffer the tail
+            size_t head = std::min(size, random.below(SHA256::BlockSize));
+            size_t bulk = random.below((size - head) / SHA256::BlockSize + 1) * SHA256::BlockSize;
+            std::vector<size_t> pieces = { head, bulk, size - head - bulk };
+            checker.expect(digest_of(implementation.implementation, message.data(), pieces) == expected,
+                path + std::to_string(head) + " + " + std::to_string(bulk) + " + rest, " + what);
+
+            // arbitrary split points
+            pieces = random.splits(size, 1);
+            checker.expect(digest_of(implementation.implementation, message.data(), pieces) == expected,
+                path + std::to_string(pieces.size()) + " adds, " + what);
+        }
+    }
+}
+
+}
@@ -0,0 +1,136 @@
+#include "suites.h"
+
+#include "sha256_tree.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace cipher_tests {
+
+namespace {
+const size_t LeafSize = SHA256Tree::LeafSize;
+
+// Input of the known answers: byte i is i mod 251, so no two leaves and no
+// two 64-byte blocks of a leaf are equal
+Bytes pattern(size_t size)
+{
+    Bytes data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = static_cast<uint8_t>(i % 251);
+    return data;
+}
+
+std::string tree_hash(ThreadPool& pool, const uint8_t* data, const std::vector<size_t>& pieces)
+{
+    SHA256Tree tree(pool);
+    size_t offset = 0;
+    for (size_t piece : pieces) {
+        tree.add(data + offset, piece);
+        offset += piece;
+    }
+    return tree.getHash();
+}
+
+std::string leaf_count(size_t size)
+{
+    return std::to_string(std::max<size_t>(1, (size + LeafSize - 1) / LeafSize)) + " leaves";
+}
+
+void check_verify_range(Checker& checker, ThreadPool& pool)
+{
+    // four full leaves and a short one
+    const size_t size = 4 * LeafSize + 3;
+    Bytes data = pattern(size);
+    SHA256Tree tree(pool);
+    tree.add(data.data(), size);
+    std::vector<SHA256Tree::Digest> leaves = tree.getLeaves();
+    checker.expect(leaves.size() == 5, "getLeaves, " + describe("5 leaves", size));
+
+    auto verify = [&](uint64_t offset, const uint8_t* bytes, size_t length) {
+        return tree.verifyRange(leaves, offset, bytes, length);
+    };
+    checker.expect(verify(0, data.data(), size), "verifyRange, whole file");
+    checker.expect(verify(LeafSize, data.data() + LeafSize, 2 * LeafSize), "verifyRange, leaves 1-2");
+    checker.expect(verify(4 * LeafSize, data.data() + 4 * LeafSize, 3), "verifyRange, short last leaf");
+    checker.expect(verify(3 * LeafSize, data.data() + 3 * LeafSize, LeafSize + 3), "verifyRange, last two leaves");
+
+    Bytes changed = data;
+    changed[2 * LeafSize + 12345] ^= 1;
+    checker.expect(!verify(0, changed.data(), size), "verifyRange rejects, one flipped bit");
+    checker.expect(!verify(2 * LeafSize, changed.data() + 2 * LeafSize, LeafSize), "verifyRange rejects, flipped bit in leaf 2");
+    checker.expect(!verify(LeafSize, data.data(), LeafSize), "verifyRange rejects, data of another leaf");
+    checker.expect(!verify(LeafSize / 2, data.data() + LeafSize / 2, LeafSize), "verifyRange rejects, unaligned offset");
+    checker.expect(!verify(0, data.data(), LeafSize - 1), "verifyRange rejects, short leaf before the end");
+    checker.expect(!verify(4 * LeafSize, data.data() + 4 * LeafSize, 2), "verifyRange rejects, truncated last leaf");
+    checker.expect(!verify(5 * LeafSize, data.data(), LeafSize), "verifyRange rejects, past the last leaf");
+    Bytes longer(data.begin() + 3 * LeafSize, data.end());
+    longer.resize(2 * LeafSize);
+    checker.expect(!verify(3 * LeafSize, longer.data(), longer.size()), "verifyRange rejects, longer than the file");
+
+    // empty file: one leaf, the hash of no bytes
+    SHA256Tree empty(pool);
+    std::vector<SHA256Tree::Digest> none = empty.getLeaves();
+    checker.expect(none.size() == 1, "getLeaves, empty file");
+    checker.expect(empty.verifyRange(none, 0, nullptr, 0), "verifyRange, empty file");
+    checker.expect(!empty.verifyRange(none, 0, data.data(), 1), "verifyRange rejects, byte of an empty file");
+}
+}
+
+void sha256_tree_known_answers(Checker& checker, const Options&)
+{
+    // Roots computed independently (Python hashlib), RFC 6962 prefixes with
+    // the odd node promoted. 2 MiB + 1 promotes leaf 2 once, 4 MiB + 3
+    // promotes leaf 4 over two levels
+    const struct {
+        size_t size;
+        const char* root;
+    } Vectors[] = {
+        { 0, "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d" },
+        { LeafSize - 1, "2dc4819212832ea69532e005288d8ff402d46a01450985e7bddde5d322535096" },
+        { LeafSize, "f4e53704c07aef05b5b12a89d6c1e54292fa7d9d8c3ee431c40b6f6ef6d19280" },
+        { LeafSize + 1, "c782cd77b0f9139f9d7fab306f384a6cab7f6c65426252d0f67ef5aadffcc3f3" },
+        { 2 * LeafSize + 1, "13fc36052180d2af460b52104fd4480bfa9513d46e40b3efad05a2dd4c81d7ab" },
+        { 4 * LeafSize + 3, "8e52f4d09f7f743d6da0f948987f8e37e781866a16326643c1b9f991c1c704cf" },
+    };
+
+    // one thread and several: the batch buffer holds 2 or 6 leaves
+    ThreadPool single(1), several(3);
+    Bytes data = pattern(4 * LeafSize + 3);
+    for (ThreadPool* pool : { &single, &several }) {
+        std::string threads = std::to_string(pool->size()) + " threads, ";
+        for (const auto& vector : Vectors) {
+            std::string what = threads + describe(leaf_count(vector.size), vector.size);
+            SHA256Tree tree(*pool);
+            checker.expect(tree(data.data(), vector.size) == vector.root, "one call, " + what);
+            // one byte, up to one byte past the first leaf, then the rest
+            size_t first = std::min<size_t>(1, vector.size);
+            size_t second = std::min(LeafSize + 1, vector.size) - first;
+            std::vector<size_t> pieces = { first, second, vector.size - first - second };
+            checker.expect(tree_hash(*pool, data.data(), pieces) == vector.root, "split add, " + what);
+        }
+        check_verify_range(checker, *pool);
+    }
+}
+
+void sha256_tree_differential(Checker& checker, Random& random, const Options& options)
+{
+    // MiB-sized messages: a tenth of the cipher iterations
+    ThreadPool pool(3);
+    size_t iterations = std::max<size_t>(1, options.iterations / 10);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        size_t size = random.length(LeafSize, 9 * LeafSize);
+        Bytes data = random.bytes(size);
+        std::string expected = tree_hash(pool, data.data(), { size });
+
+        // an unaligned first piece, then arbitrary pieces or whole leaves,
+        // so both the buffered and the direct path run
+        const size_t Granules[] = { 1, 4096, LeafSize };
+        size_t head = random.below(std::min(size, LeafSize) + 1);
+        std::vector<size_t> pieces = random.splits(size - head, Granules[random.below(3)]);
+        pieces.insert(pieces.begin(), head);
+        checker.expect(tree_hash(pool, data.data(), pieces) == expected,
+            describe(std::to_string(pieces.size()) + " adds", size));
+    }
+}
+
+}
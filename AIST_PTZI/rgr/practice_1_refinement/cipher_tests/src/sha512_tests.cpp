@@ -0,0 +1,140 @@
+#include "suites.h"
+
+#include "hash_algorithm.h"
+#include "sha512.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace cipher_tests {
+
+namespace {
+const size_t MaxMessage = 64 * 1024;
+
+const HashAlgorithm Sha512Family[] = { HashAlgorithm::SHA512, HashAlgorithm::SHA512_256 };
+
+std::string digest_of(Hash& hash, const uint8_t* data, const std::vector<size_t>& pieces)
+{
+    hash.reset();
+    size_t offset = 0;
+    for (size_t piece : pieces) {
+        hash.add(data + offset, piece);
+        offset += piece;
+    }
+    return hash.getHash();
+}
+
+void check_algorithms(Checker& checker)
+{
+    for (HashAlgorithm algorithm : { HashAlgorithm::SHA256, HashAlgorithm::SHA512, HashAlgorithm::SHA512_256 }) {
+        std::string name = hash_algorithm_name(algorithm);
+        checker.expect(parse_hash_algorithm(name) == algorithm, "parse_hash_algorithm(\"" + name + "\")");
+        // the file digest sent by duo_client is received with this length
+        size_t bytes = hash_digest_bytes(algorithm);
+        checker.expect(make_hash(algorithm)->getHash().size() == 2 * bytes, "hash_digest_bytes, make_hash, " + name);
+        checker.expect(make_file_hash(algorithm)->getHash().size() == 2 * bytes, "hash_digest_bytes, make_file_hash, " + name);
+    }
+    bool thrown = false;
+    try {
+        parse_hash_algorithm("sha384");
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    checker.expect(thrown, "parse_hash_algorithm(\"sha384\") throws");
+}
+}
+
+void sha512_known_answers(Checker& checker, const Options&)
+{
+    // FIPS 180-4 examples (NIST CSRC "SHA512.pdf", "SHA512_256.pdf",
+    // "SHA2_Additional.pdf")
+    const char* Message896 = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+                             "ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+    const std::string MillionA(1000000, 'a');
+    const struct {
+        HashAlgorithm algorithm;
+        const char* name;
+        std::string message;
+        const char* digest;
+    } Vectors[] = {
+        { HashAlgorithm::SHA512, "empty", "",
+            "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+            "47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e" },
+        { HashAlgorithm::SHA512, "\"abc\"", "abc",
+            "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+            "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f" },
+        { HashAlgorithm::SHA512, "896-bit message", Message896,
+            "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+            "501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909" },
+        { HashAlgorithm::SHA512, "1M x 'a'", MillionA,
+            "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+            "de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b" },
+        { HashAlgorithm::SHA512_256, "empty", "",
+            "c672b8d1ef56ed28ab87c3622c5114069bdd3ad7b8f9737498d0c01ecef0967a" },
+        { HashAlgorithm::SHA512_256, "\"abc\"", "abc",
+            "53048e2681941ef99b2e29b76b4c7dabe4c2d0c634fc6d46e0e2f13107e7af23" },
+        { HashAlgorithm::SHA512_256, "896-bit message", Message896,
+            "3928e184fb8690f840da3988121d31be65cb9d3ef83ee6146feac861e19b563a" },
+        { HashAlgorithm::SHA512_256, "1M x 'a'", MillionA,
+            "9a59a052930187a97038cae692f30708aa6491923ef5194394dc68d56c74fb21" },
+    };
+
+    for (const auto& vector : Vectors) {
+        const uint8_t* message = reinterpret_cast<const uint8_t*>(vector.message.data());
+        size_t size = vector.message.size();
+        std::string what = hash_algorithm_name(vector.algorithm) + ", " + vector.name;
+
+        std::unique_ptr<Hash> hash = make_hash(vector.algorithm);
+        checker.expect(digest_of(*hash, message, { size }) == vector.digest, "one add, " + what);
+        // a partial block, a run of whole blocks, the tail
+        size_t head = std::min<size_t>(size, 7);
+        size_t bulk = (size - head) / SHA512::BlockSize / 2 * SHA512::BlockSize;
+        checker.expect(digest_of(*hash, message, { head, bulk, size - head - bulk }) == vector.digest, "three adds, " + what);
+        checker.expect((*hash)(vector.message) == vector.digest, "operator(), " + what);
+
+        // the SHA-512 family hashes files with the plain streaming hash
+        std::unique_ptr<Hash> file_hash = make_file_hash(vector.algorithm);
+        checker.expect(digest_of(*file_hash, message, { size }) == vector.digest, "make_file_hash, " + what);
+
+        // binary digest of hashBytes() bytes
+        SHA512* sha512 = dynamic_cast<SHA512*>(hash.get());
+        if (checker.expect(sha512 != nullptr, "make_hash returns a SHA512, " + what)) {
+            Bytes digest(sha512->hashBytes());
+            sha512->getHash(digest.data());
+            checker.equal(from_hex(vector.digest), digest, "getHash(buffer), " + what);
+        }
+    }
+
+    check_algorithms(checker);
+}
+
+void sha512_differential(Checker& checker, Random& random, const Options& options)
+{
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        size_t size = random.length(SHA512::BlockSize, MaxMessage);
+        size_t misalign = random.below(64);
+        Buffer message(size, misalign);
+        random.fill(message.data(), size);
+        std::string what = describe("message +" + std::to_string(misalign), size);
+
+        for (HashAlgorithm algorithm : Sha512Family) {
+            std::unique_ptr<Hash> hash = make_hash(algorithm);
+            std::string path = hash_algorithm_name(algorithm) + ", ";
+            // the reference: one add
+            std::string expected = digest_of(*hash, message.data(), { size });
+
+            size_t head = std::min(size, random.below(SHA512::BlockSize));
+            size_t bulk = random.below((size - head) / SHA512::BlockSize + 1) * SHA512::BlockSize;
+            std::vector<size_t> pieces = { head, bulk, size - head - bulk };
+            checker.expect(digest_of(*hash, message.data(), pieces) == expected,
+                path + std::to_string(head) + " + " + std::to_string(bulk) + " + rest, " + what);
+
+            pieces = random.splits(size, 1);
+            checker.expect(digest_of(*hash, message.data(), pieces) == expected,
+                path + std::to_string(pieces.size()) + " adds, " + what);
+        }
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+#include "suites.h"
+#include "test_vectors.h"
+
+extern "C" {
+#include "sosemanuk/ecrypt-sync.h"
+}
+
+#include <algorithm>
+
+namespace cipher_tests {
+
+namespace {
+const size_t BlockBytes = ECRYPT_BLOCKLENGTH;
+const size_t MaxMessage = 64 * 1024;
+// Long enough for the batched (SSE2) path to produce the first blocks
+const size_t BatchedBytes = 8 * BlockBytes;
+
+void setup(ECRYPT_ctx* ctx, const Bytes& key, const Bytes& iv)
+{
+    ECRYPT_keysetup(ctx, key.data(), static_cast<u32>(8 * key.size()), static_cast<u32>(8 * iv.size()));
+    ECRYPT_ivsetup(ctx, iv.data());
+}
+
+// The reference: one block per call, never the batched kernel
+Bytes reference(ECRYPT_ctx* ctx, const uint8_t* message, size_t size)
+{
+    Bytes out(size);
+    size_t whole = size / BlockBytes * BlockBytes;
+    for (size_t offset = 0; offset < whole; offset += BlockBytes)
+        ECRYPT_process_blocks(0, ctx, message + offset, out.data() + offset, 1);
+    ECRYPT_process_bytes(0, ctx, message + whole, out.data() + whole, static_cast<u32>(size - whole));
+    return out;
+}
+}
+
+void sosemanuk_known_answers(Checker& checker, const Options& options)
+{
+    ECRYPT_init();
+    std::string path = options.vectors_dir + "/sosemanuk/TEST_VECTOR_128.TXT";
+    for (const KnownAnswer& vector : read_sosemanuk_vectors(path)) {
+        ECRYPT_ctx ctx;
+        size_t size = std::max(vector.stream_bytes, BatchedBytes);
+        Bytes zeros(size, 0);
+
+        setup(&ctx, vector.key, vector.iv);
+        check_known_answer(checker, vector, reference(&ctx, zeros.data(), size), "one block per call");
+
+        Bytes stream(size);
+        setup(&ctx, vector.key, vector.iv);
+        ECRYPT_keystream_bytes(&ctx, stream.data(), static_cast<u32>(size));
+        check_known_answer(checker, vector, stream, "keystream_bytes");
+
+        setup(&ctx, vector.key, vector.iv);
+        ECRYPT_process_bytes(0, &ctx, zeros.data(), stream.data(), static_cast<u32>(size));
+        check_known_answer(checker, vector, stream, "process_bytes");
+    }
+}
+
+void sosemanuk_differential(Checker& checker, Random& random, const Options& options)
+{
+    ECRYPT_init();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        // any key length up to 256 bits
+        Bytes key = random.bytes(1 + random.below(32));
+        Bytes iv = random.bytes(16);
+        size_t size = random.length(BlockBytes, MaxMessage);
+        Bytes message = random.bytes(size);
+        ECRYPT_ctx ctx;
+        setup(&ctx, key, iv);
+        Bytes expected = reference(&ctx, message.data(), size);
+        std::string with_key = ", " + std::to_string(8 * key.size()) + "-bit key";
+
+        // batched blocks, misaligned buffers
+        size_t in_offset = random.below(64), out_offset = random.below(64);
+        Buffer in(size, in_offset), out(size, out_offset);
+        std::copy(message.begin(), message.end(), in.data());
+        setup(&ctx, key, iv);
+        ECRYPT_process_bytes64(0, &ctx, in.data(), out.data(), size);
+        checker.equal(expected.data(), out.data(), size,
+            describe("process_bytes, in +" + std::to_string(in_offset) + ", out +" + std::to_string(out_offset) + with_key, size));
+
+        // in place
+        Bytes data = message;
+        setup(&ctx, key, iv);
+        ECRYPT_process_bytes64(0, &ctx, data.data(), data.data(), size);
+        checker.equal(expected, data, describe("in place" + with_key, size));
+
+        // keystream_bytes, and keystream_blocks for the whole blocks
+        size_t whole = size / BlockBytes;
+        for (bool blocks : { false, true }) {
+            Buffer stream(size, random.below(8));
+            setup(&ctx, key, iv);
+            if (blocks) {
+                ECRYPT_keystream_blocks(&ctx, stream.data(), static_cast<u32>(whole));
+                ECRYPT_keystream_bytes(&ctx, stream.data() + whole * BlockBytes,
+                    static_cast<u32>(size - whole * BlockBytes));
+            } else {
+                ECRYPT_keystream_bytes64(&ctx, stream.data(), size);
+            }
+            for (size_t i = 0; i < size; i++)
+                stream.data()[i] ^= message[i];
+            checker.equal(expected.data(), stream.data(), size,
+                describe(blocks ? "keystream_blocks" : "keystream_bytes", size));
+        }
+
+        // process_blocks in runs of any length, then the tail
+        Bytes blocked(size);
+        setup(&ctx, key, iv);
+        size_t offset = 0;
+        for (size_t piece : random.splits(whole * BlockBytes, BlockBytes)) {
+            ECRYPT_process_blocks(0, &ctx, message.data() + offset, blocked.data() + offset,
+                static_cast<u32>(piece / BlockBytes));
+            offset += piece;
+        }
+        ECRYPT_process_bytes(0, &ctx, message.data() + offset, blocked.data() + offset, static_cast<u32>(size - offset));
+        checker.equal(expected, blocked, describe("process_blocks" + with_key, size));
+
+        // consecutive calls, pieces of whole blocks
+        Bytes chunked(size);
+        setup(&ctx, key, iv);
+        offset = 0;
+        for (size_t piece : random.splits(size, BlockBytes)) {
+            ECRYPT_process_bytes(0, &ctx, message.data() + offset, chunked.data() + offset, static_cast<u32>(piece));
+            offset += piece;
+        }
+        checker.equal(expected, chunked, describe("chunked" + with_key, size));
+    }
+}
+
+void sosemanuk_large(Checker& checker, const Options&)
+{
+    const Bytes key(16, 0x5a), iv(16, 0xa5);
+    ECRYPT_ctx reference, encrypt, keystream;
+    setup(&reference, key, iv);
+    setup(&encrypt, key, iv);
+    setup(&keystream, key, iv);
+    check_chunked(checker, "sosemanuk", ECRYPT_CHUNKLENGTH, ECRYPT_BLOCKLENGTH,
+        [&](uint8_t* out, uint32_t size) { ECRYPT_keystream_bytes(&reference, out, size); },
+        [&](const uint8_t* in, uint8_t* out, uint64_t size) { ECRYPT_encrypt_bytes64(&encrypt, in, out, size); },
+        [&](uint8_t* out, uint64_t size) { ECRYPT_keystream_bytes64(&keystream, out, size); });
+}
+
+}
@@ -0,0 +1,389 @@
+#include "suites.h"
+
+#include "aead.h"
+#include "keystream_buffer.h"
+#include "stream_cipher.h"
+
+#include "aes/aes.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace cipher_tests {
+
+namespace {
+const size_t MaxMessage = 64 * 1024;
+
+Bytes process(ciphers::StreamCipher& cipher, const Bytes& key, const Bytes& iv, const Bytes& message)
+{
+    Bytes out(message.size());
+    cipher.set_key(key.data());
+    cipher.set_iv(iv.data());
+    cipher.process(message.data(), out.data(), out.size());
+    return out;
+}
+
+void check_cipher(Checker& checker, Random& random, const std::string& name)
+{
+    std::unique_ptr<ciphers::StreamCipher> cipher = ciphers::make_stream_cipher(name);
+    size_t block = cipher->block_bytes();
+    // pieces that continue the stream, see StreamCipher
+    size_t granule = cipher->seekable() ? 1 : block;
+
+    Bytes key = random.bytes(cipher->key_bytes());
+    Bytes iv = random.bytes(cipher->iv_bytes());
+    size_t size = random.length(block, MaxMessage);
+    Bytes message = random.bytes(size);
+    Bytes expected = process(*cipher, key, iv, message);
+
+    // consecutive calls
+    Bytes chunked(size);
+    cipher->set_iv(iv.data());
+    size_t offset = 0;
+    for (size_t piece : random.splits(size, granule)) {
+        cipher->process(message.data() + offset, chunked.data() + offset, piece);
+        offset += piece;
+    }
+    checker.equal(expected, chunked, describe(name + " chunked process", size));
+
+    Bytes stream(size);
+    cipher->set_iv(iv.data());
+    offset = 0;
+    for (size_t piece : random.splits(size, granule)) {
+        cipher->keystream(stream.data() + offset, piece);
+        offset += piece;
+    }
+    for (size_t i = 0; i < size; i++)
+        stream[i] ^= message[i];
+    checker.equal(expected, stream, describe(name + " chunked keystream", size));
+
+    // random access
+    if (cipher->seekable()) {
+        size_t position = random.below(size + 1);
+        Bytes tail(size - position);
+        cipher->set_iv(iv.data());
+        // away from the start first, so seek() has to move back
+        cipher->process(message.data(), tail.data(), std::min(tail.size(), size_t(1)));
+        cipher->seek(position);
+        cipher->process(message.data() + position, tail.data(), tail.size());
+        checker.equal(expected.data() + position, tail.data(), tail.size(),
+            describe(name + " seek " + std::to_string(position), size));
+    } else {
+        bool thrown = false;
+        try {
+            cipher->seek(0);
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        checker.expect(thrown, name + " seek on a cipher that cannot seek");
+    }
+
+    // precomputed keystream: arbitrary split points, with the buffer
+    // filled between messages, from a thread, or not at all
+    size_t capacity = block * (1 + random.below(256));
+    ciphers::KeystreamBuffer buffer(ciphers::make_stream_cipher(name), capacity);
+    int mode = static_cast<int>(random.below(3));
+    buffer.set_key(key.data());
+    buffer.set_iv(iv.data());
+    if (mode == 2)
+        buffer.start();
+    Bytes buffered(size);
+    offset = 0;
+    for (size_t piece : random.splits(size, 1)) {
+        if (mode == 1)
+            buffer.refill();
+        buffer.process(message.data() + offset, buffered.data() + offset, piece);
+        offset += piece;
+    }
+    buffer.stop();
+    static const char* const Modes[] = { "no refill", "refill", "thread" };
+    checker.equal(expected, buffered,
+        describe(name + " KeystreamBuffer " + std::to_string(capacity) + ", " + Modes[mode], size));
+}
+
+// Sessions of every cipher, some in the middle of a block, in one batch.
+// Some sessions have more than one message, as when a server queues two
+// for one connection: they must be encrypted one after the other
+void check_batch(Checker& checker, Random& random, const std::vector<std::string>& names)
+{
+    size_t count = 1 + random.below(60);
+    std::vector<std::unique_ptr<ciphers::StreamCipher>> batched, single;
+    for (size_t i = 0; i < count; i++) {
+        const std::string& name = names[random.below(names.size())];
+        batched.push_back(ciphers::make_stream_cipher(name));
+        single.push_back(ciphers::make_stream_cipher(name));
+        Bytes key = random.bytes(batched[i]->key_bytes());
+        Bytes iv = random.bytes(batched[i]->iv_bytes());
+        size_t block = batched[i]->block_bytes();
+        // a message already sent on the session; mid-block only where
+        // the stream continues from there
+        Bytes head = random.bytes(block * random.below(3) + (batched[i]->seekable() ? random.below(block) : 0));
+        Bytes scratch(head.size());
+        for (auto* cipher : { batched[i].get(), single[i].get() }) {
+            cipher->set_key(key.data());
+            cipher->set_iv(iv.data());
+            cipher->process(head.data(), scratch.data(), head.size());
+        }
+    }
+
+    // every session once, then a few more messages for random sessions
+    std::vector<size_t> sessions(count);
+    for (size_t i = 0; i < count; i++)
+        sessions[i] = i;
+    for (size_t extra = random.below(count / 2 + 1); extra > 0; extra--)
+        sessions.push_back(random.below(count));
+
+    std::vector<Bytes> messages, expected, outputs;
+    std::vector<size_t> last_size(count);
+    for (size_t session : sessions) {
+        size_t block = batched[session]->block_bytes();
+        size_t size = random.one_in(4) ? random.length(block, 16 * 1024) : random.below(300);
+        messages.push_back(random.bytes(size));
+        expected.emplace_back(size);
+        single[session]->process(messages.back().data(), expected.back().data(), size);
+        outputs.emplace_back(size);
+        last_size[session] = size;
+    }
+    std::vector<ciphers::BatchJob> jobs;
+    for (size_t k = 0; k < sessions.size(); k++)
+        jobs.push_back({ batched[sessions[k]].get(), messages[k].data(), outputs[k].data(), messages[k].size() });
+
+    ciphers::process_batch(jobs.data(), jobs.size());
+    for (size_t k = 0; k < sessions.size(); k++) {
+        checker.equal(expected[k], outputs[k],
+            describe(batched[sessions[k]]->name() + " process_batch, job " + std::to_string(k) + " of "
+                    + std::to_string(jobs.size()) + ", session " + std::to_string(sessions[k]),
+                messages[k].size()));
+    }
+
+    // the batch continues the streams
+    size_t i = random.below(count);
+    if (batched[i]->seekable() || last_size[i] % batched[i]->block_bytes() == 0) {
+        Bytes next = random.bytes(100), a(100), b(100);
+        batched[i]->process(next.data(), a.data(), next.size());
+        single[i]->process(next.data(), b.data(), next.size());
+        checker.equal(b, a, describe(batched[i]->name() + " process after process_batch", next.size()));
+    }
+}
+
+void check_aead(Checker& checker, Random& random, const std::string& name, const std::string& mac)
+{
+    std::unique_ptr<ciphers::Aead> aead = ciphers::make_aead(name, mac);
+    size_t block = aead->block_bytes();
+    size_t granule = ciphers::make_stream_cipher(name)->seekable() ? 1 : block;
+
+    Bytes key = random.bytes(aead->key_bytes());
+    Bytes nonce = random.bytes(aead->nonce_bytes());
+    Bytes ad = random.bytes(random.below(3) == 0 ? 0 : random.below(100));
+    size_t size = random.length(block, MaxMessage);
+    Bytes message = random.bytes(size);
+    aead->set_key(key.data());
+
+    Bytes ciphertext(size);
+    Bytes tag(ciphers::Aead::TagBytes);
+    aead->encrypt(nonce.data(), ad.data(), ad.size(), message.data(), ciphertext.data(), size, tag.data());
+
+    // the streaming interface gives the same ciphertext and tag
+    Bytes streamed(size);
+    Bytes streamed_tag(ciphers::Aead::TagBytes);
+    aead->begin(nonce.data(), ad.data(), ad.size());
+    size_t offset = 0;
+    for (size_t piece : random.splits(size, granule)) {
+        aead->encrypt_update(message.data() + offset, streamed.data() + offset, piece);
+        offset += piece;
+    }
+    aead->finish(streamed_tag.data());
+    checker.equal(ciphertext, streamed, describe(aead->name() + " streamed ciphertext", size));
+    checker.equal(tag, streamed_tag, describe(aead->name() + " streamed tag", size));
+
+    // in-place decryption in pieces
+    Bytes decrypted = ciphertext;
+    aead->begin(nonce.data(), ad.data(), ad.size());
+    offset = 0;
+    for (size_t piece : random.splits(size, granule)) {
+        aead->decrypt_update(decrypted.data() + offset, decrypted.data() + offset, piece);
+        offset += piece;
+    }
+    checker.expect(aead->verify(tag.data()), describe(aead->name() + " streamed decryption tag", size));
+    checker.equal(message, decrypted, describe(aead->name() + " streamed decryption", size));
+
+    // one flipped bit anywhere must fail the tag and zero the output
+    Bytes forged = ciphertext, forged_tag = tag, forged_ad = ad;
+    size_t target = random.below(3);
+    if (target == 0 && size > 0)
+        forged[random.below(size)] ^= static_cast<uint8_t>(1 << random.below(8));
+    else if (target == 1 && !ad.empty())
+        forged_ad[random.below(ad.size())] ^= static_cast<uint8_t>(1 << random.below(8));
+    else
+        forged_tag[random.below(forged_tag.size())] ^= static_cast<uint8_t>(1 << random.below(8));
+    Bytes out(size, 0xff);
+    bool accepted = aead->decrypt(nonce.data(), forged_ad.data(), forged_ad.size(), forged.data(), out.data(), size,
+        forged_tag.data());
+    checker.expect(!accepted, describe(aead->name() + " forgery accepted", size));
+    checker.expect(std::all_of(out.begin(), out.end(), [](uint8_t b) { return b == 0; }),
+        describe(aead->name() + " plaintext of a forgery not zeroed", size));
+}
+
+template <typename Function>
+bool throws_length_error(Function function)
+{
+    try {
+        function();
+    } catch (const std::length_error&) {
+        return true;
+    }
+    return false;
+}
+
+// The last blocks of an AES-CTR IV, where the 32-bit counter ends, and the
+// limits of AES-CTR and AES-GCM past them
+void check_aes_limit(Checker& checker)
+{
+    const uint64_t StreamBytes = uint64_t(16) << 32;
+    Bytes key(16, 0x2b), iv(12, 0x7e);
+    std::unique_ptr<ciphers::StreamCipher> aes = ciphers::make_aes128();
+    aes->set_key(key.data());
+    aes->set_iv(iv.data());
+
+    // blocks 2^32 - 2 and 2^32 - 1 from the C code
+    aes_ctx ctx;
+    uint8_t counter[16];
+    aes_keysetup(&ctx, key.data(), 128);
+    memcpy(counter, iv.data(), iv.size());
+    memset(counter + 12, 0xff, 4);
+    counter[15] = 0xfe;
+    Bytes expected(32, 0);
+    aes_ctr_encrypt(&ctx, counter, expected.data(), expected.data(), expected.size());
+
+    // up to the last byte, in two calls
+    Bytes stream(32);
+    aes->seek(StreamBytes - 32);
+    aes->keystream(stream.data(), 7);
+    aes->keystream(stream.data() + 7, 25);
+    checker.equal(expected, stream, "aes128 seek to 2^32 - 2 blocks");
+
+    uint8_t byte = 0;
+    checker.expect(throws_length_error([&] { aes->process(&byte, &byte, 1); }), "aes128 process past 2^32 blocks");
+    aes->seek(StreamBytes - 8);
+    checker.expect(throws_length_error([&] { aes->keystream(stream.data(), 16); }),
+        "aes128 process across 2^32 blocks");
+    checker.expect(throws_length_error([&] { aes->seek(StreamBytes + 1); }), "aes128 seek past 2^32 blocks");
+
+    // the message starts at block 2: 2^32 - 2 blocks are left, checked
+    // before anything is read or written
+    std::unique_ptr<ciphers::Aead> gcm = ciphers::make_aes_gcm(128);
+    gcm->set_key(key.data());
+    gcm->begin(iv.data(), nullptr, 0);
+    checker.expect(throws_length_error([&] { gcm->encrypt_update(nullptr, nullptr, StreamBytes - 32 + 1); }),
+        "aes128-gcm message of 2^32 - 2 blocks + 1 byte");
+    gcm->encrypt_update(stream.data(), stream.data(), 16);
+    checker.expect(throws_length_error([&] { gcm->decrypt_update(nullptr, nullptr, StreamBytes - 32 - 15); }),
+        "aes128-gcm message over 2^32 - 2 blocks in two updates");
+}
+}
+
+void stream_cipher_known_answers(Checker& checker, const Options&)
+{
+    // Salsa20/20 with a 128-bit key from the compile-time core, Set 1 vector# 0
+    std::unique_ptr<ciphers::StreamCipher> salsa = ciphers::make_salsa20_rounds(20, 128);
+    Bytes key(16, 0), iv(8, 0), stream(64);
+    key[0] = 0x80;
+    salsa->set_key(key.data());
+    salsa->set_iv(iv.data());
+    salsa->keystream(stream.data(), stream.size());
+    checker.equal(from_hex("4DFA5E481DA23EA09A31022050859936DA52FCEE218005164F267CB65F5CFD7F"
+                           "2B4F97E0FF16924A52DF269515110A07F9E460BC65EF95DA58F740B7D1DBB0AA"),
+        stream, "salsa20 rounds 20, 128-bit key, Set 1 vector# 0");
+
+    // XChaCha20-Poly1305, draft-irtf-cfrg-xchacha appendix A.3.1 (first 32
+    // ciphertext bytes and the tag)
+    std::unique_ptr<ciphers::Aead> aead = ciphers::make_aead("xchacha20");
+    Bytes aead_key(32), nonce(24);
+    for (size_t i = 0; i < aead_key.size(); i++)
+        aead_key[i] = static_cast<uint8_t>(0x80 + i);
+    for (size_t i = 0; i < nonce.size(); i++)
+        nonce[i] = static_cast<uint8_t>(0x40 + i);
+    Bytes ad = from_hex("50515253c0c1c2c3c4c5c6c7");
+    const char* text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the "
+                       "future, sunscreen would be it.";
+    Bytes plaintext(text, text + strlen(text));
+    Bytes ciphertext(plaintext.size()), tag(ciphers::Aead::TagBytes);
+    aead->set_key(aead_key.data());
+    aead->encrypt(nonce.data(), ad.data(), ad.size(), plaintext.data(), ciphertext.data(), plaintext.size(), tag.data());
+    checker.equal(from_hex("bd6d179d3e83d43b9576579493c0e939572a1700252bfaccbed2902c21396cbb"),
+        Bytes(ciphertext.begin(), ciphertext.begin() + 32), "xchacha20-poly1305 ciphertext");
+    checker.equal(from_hex("c0875924c1c7987947deafd8780acf49"), tag, "xchacha20-poly1305 tag");
+
+    Bytes decrypted(plaintext.size());
+    checker.expect(aead->decrypt(nonce.data(), ad.data(), ad.size(), ciphertext.data(), decrypted.data(),
+                       ciphertext.size(), tag.data()),
+        "xchacha20-poly1305 decryption tag");
+    checker.equal(plaintext, decrypted, "xchacha20-poly1305 decryption");
+
+    // AES-GCM, test cases 2, 3, 4, 14 and 16 of the GCM specification
+    struct GcmVector {
+        const char* name;
+        int key_bits;
+        const char* key;
+        const char* nonce;
+        const char* ad;
+        const char* plaintext;
+        const char* ciphertext;
+        const char* tag;
+    };
+    const char* const Key = "feffe9928665731c6d6a8f9467308308";
+    const char* const Nonce = "cafebabefacedbaddecaf888";
+    const char* const Ad = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+    const char* const Plaintext = "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+                                  "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39";
+    const GcmVector GcmVectors[] = {
+        { "aes128-gcm test case 2", 128, "00000000000000000000000000000000", "000000000000000000000000", "",
+            "00000000000000000000000000000000", "0388dace60b6a392f328c2b971b2fe78",
+            "ab6e47d42cec13bdf53a67b21257bddf" },
+        { "aes128-gcm test case 3", 128, Key, Nonce, "",
+            "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+            "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+            "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+            "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+            "4d5c2af327cd64a62cf35abd2ba6fab4" },
+        { "aes128-gcm test case 4", 128, Key, Nonce, Ad, Plaintext,
+            "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+            "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+            "5bc94fbc3221a5db94fae95ae7121a47" },
+        { "aes256-gcm test case 14", 256, "0000000000000000000000000000000000000000000000000000000000000000",
+            "000000000000000000000000", "", "00000000000000000000000000000000", "cea7403d4d606b6e074ec5d3baf39d18",
+            "d0d1c8a799996bf0265b98b5d48ab919" },
+        { "aes256-gcm test case 16", 256, "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", Nonce,
+            Ad, Plaintext,
+            "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+            "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+            "76fc6ece0f4e1768cddf8853bb2d551b" },
+    };
+    for (const GcmVector& vector : GcmVectors) {
+        std::unique_ptr<ciphers::Aead> gcm = ciphers::make_aes_gcm(vector.key_bits);
+        Bytes gcm_ad = from_hex(vector.ad), message = from_hex(vector.plaintext);
+        Bytes out(message.size()), gcm_tag(ciphers::Aead::TagBytes);
+        gcm->set_key(from_hex(vector.key).data());
+        gcm->encrypt(from_hex(vector.nonce).data(), gcm_ad.data(), gcm_ad.size(), message.data(), out.data(),
+            message.size(), gcm_tag.data());
+        checker.equal(from_hex(vector.ciphertext), out, std::string(vector.name) + " ciphertext");
+        checker.equal(from_hex(vector.tag), gcm_tag, std::string(vector.name) + " tag");
+    }
+
+    check_aes_limit(checker);
+}
+
+void stream_cipher_differential(Checker& checker, Random& random, const Options& options)
+{
+    std::vector<std::string> names = ciphers::stream_cipher_names();
+    for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+        for (const std::string& name : names)
+            check_cipher(checker, random, name);
+        check_batch(checker, random, names);
+        check_aead(checker, random, names[random.below(names.size())], "poly1305");
+        check_aead(checker, random, random.one_in(2) ? "aes128" : "aes256", "gcm");
+    }
+}
+
+}
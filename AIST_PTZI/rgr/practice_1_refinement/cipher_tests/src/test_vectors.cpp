@@ -0,0 +1,243 @@
+#include "test_vectors.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace cipher_tests {
+
+namespace {
+std::vector<std::string> read_lines(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+        throw std::runtime_error("cannot open " + path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+std::string trim(const std::string& s)
+{
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+        return "";
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool starts_with(const std::string& s, const std::string& prefix)
+{
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Hex digits and spaces only, e.g. the continuation lines of a stream segment
+bool is_hex_line(const std::string& line)
+{
+    bool digits = false;
+    for (char c : line) {
+        if (std::isxdigit(static_cast<unsigned char>(c)))
+            digits = true;
+        else if (c != ' ' && c != '\t')
+            return false;
+    }
+    return digits;
+}
+
+// "stream[192..255]" -> 192
+size_t segment_offset(const std::string& field)
+{
+    size_t open = field.find('[');
+    return std::stoul(field.substr(open + 1, field.find("..") - open - 1));
+}
+
+// (field, hex value) pairs of one ECRYPT vector -> KnownAnswer
+KnownAnswer make_ecrypt_vector(const std::string& name, size_t stream_bytes,
+    const std::vector<std::pair<std::string, std::string>>& fields)
+{
+    KnownAnswer vector;
+    vector.name = name;
+    vector.stream_bytes = stream_bytes;
+    for (const auto& field : fields) {
+        if (field.first == "key")
+            vector.key = from_hex(field.second);
+        else if (field.first == "IV")
+            vector.iv = from_hex(field.second);
+        else if (field.first == "xor-digest")
+            vector.xor_digest = from_hex(field.second);
+        else if (starts_with(field.first, "stream["))
+            vector.segments.emplace_back(segment_offset(field.first), from_hex(field.second));
+    }
+    // the long-stream sets (4 and 6) only say so through their last segment
+    for (const auto& segment : vector.segments)
+        vector.stream_bytes = std::max(vector.stream_bytes, segment.first + segment.second.size());
+    return vector;
+}
+}
+
+std::vector<KnownAnswer> read_ecrypt_vectors(const std::string& path)
+{
+    std::vector<KnownAnswer> vectors;
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> fields;
+    size_t stream_bytes = 512;
+
+    auto flush = [&]() {
+        if (!name.empty())
+            vectors.push_back(make_ecrypt_vector(name, stream_bytes, fields));
+        name.clear();
+        fields.clear();
+    };
+
+    const std::string generated = "(stream is generated by encrypting ";
+    for (const std::string& raw : read_lines(path)) {
+        std::string line = trim(raw);
+        if (starts_with(line, generated)) {
+            flush();
+            stream_bytes = std::stoul(line.substr(generated.size()));
+        } else if (starts_with(line, "Set ") && line.find("vector#") != std::string::npos) {
+            flush();
+            name = line.substr(0, line.find(':'));
+        } else if (name.empty()) {
+            continue;
+        } else if (line.find('=') != std::string::npos) {
+            size_t equals = line.find('=');
+            fields.emplace_back(trim(line.substr(0, equals)), line.substr(equals + 1));
+        } else if (is_hex_line(line) && !fields.empty()) {
+            fields.back().second += line;
+        } else {
+            flush();
+        }
+    }
+    flush();
+
+    if (vectors.empty())
+        throw std::runtime_error("no test vectors in " + path);
+    return vectors;
+}
+
+std::vector<KnownAnswer> read_rabbit_vectors(const std::string& path)
+{
+    // keyN / ivN / outN = [hex bytes ...], possibly over several lines
+    std::map<int, KnownAnswer> tests;
+    std::string field, value;
+    bool open = false;
+
+    auto store = [&]() {
+        size_t digits = field.find_first_of("0123456789");
+        if (digits == std::string::npos)
+            return;
+        int number = std::stoi(field.substr(digits));
+        std::string kind = field.substr(0, digits);
+        KnownAnswer& test = tests[number];
+        test.name = "Test " + std::to_string(number);
+        if (kind == "key") {
+            test.key = from_hex(value);
+        } else if (kind == "iv") {
+            test.iv = from_hex(value);
+        } else if (kind == "out") {
+            Bytes out = from_hex(value);
+            test.stream_bytes = out.size();
+            test.segments.emplace_back(0, out);
+        }
+    };
+
+    for (const std::string& raw : read_lines(path)) {
+        std::string line = trim(raw);
+        if (!open) {
+            size_t bracket = line.find('[');
+            if (line.find('=') == std::string::npos || bracket == std::string::npos)
+                continue;
+            field = trim(line.substr(0, line.find('=')));
+            value.clear();
+            line = line.substr(bracket + 1);
+            open = true;
+        }
+        size_t close = line.find(']');
+        value += line.substr(0, close);
+        if (close != std::string::npos) {
+            open = false;
+            store();
+        }
+    }
+
+    std::vector<KnownAnswer> vectors;
+    for (auto& test : tests) {
+        if (!test.second.key.empty() && !test.second.segments.empty())
+            vectors.push_back(test.second);
+    }
+    if (vectors.empty())
+        throw std::runtime_error("no test vectors in " + path);
+    return vectors;
+}
+
+std::vector<KnownAnswer> read_sosemanuk_vectors(const std::string& path)
+{
+    std::vector<KnownAnswer> vectors;
+    bool output = false;
+    std::string stream;
+
+    auto flush = [&]() {
+        if (output && !vectors.empty()) {
+            Bytes out = from_hex(stream);
+            vectors.back().stream_bytes = out.size();
+            vectors.back().segments.emplace_back(0, out);
+        }
+        output = false;
+        stream.clear();
+    };
+
+    for (const std::string& line : read_lines(path)) {
+        if (starts_with(line, "Detailed test vector")) {
+            flush();
+            vectors.emplace_back();
+            vectors.back().name = trim(line.substr(0, line.find(':')));
+        } else if (vectors.empty()) {
+            continue;
+        } else if (starts_with(line, "key = ")) {
+            vectors.back().key = from_hex(line.substr(6));
+        } else if (starts_with(line, "IV = ")) {
+            vectors.back().iv = from_hex(line.substr(5));
+        } else if (starts_with(line, "Total output:")) {
+            output = true;
+        } else if (output && is_hex_line(line)) {
+            stream += line;
+        } else if (output) {
+            flush();
+        }
+    }
+    flush();
+
+    vectors.erase(std::remove_if(vectors.begin(), vectors.end(),
+                      [](const KnownAnswer& v) { return v.segments.empty(); }),
+        vectors.end());
+    if (vectors.empty())
+        throw std::runtime_error("no test vectors in " + path);
+    return vectors;
+}
+
+void check_known_answer(Checker& checker, const KnownAnswer& vector, const Bytes& stream, const std::string& how)
+{
+    for (const auto& segment : vector.segments) {
+        std::string what = vector.name + " " + how + " stream[" + std::to_string(segment.first) + "..]";
+        if (!checker.expect(segment.first + segment.second.size() <= stream.size(), what + " outside the stream"))
+            continue;
+        checker.equal(segment.second.data(), stream.data() + segment.first, segment.second.size(), what);
+    }
+
+    if (!vector.xor_digest.empty()) {
+        Bytes digest(vector.xor_digest.size(), 0);
+        for (size_t i = 0; i < stream.size(); i++)
+            digest[i % digest.size()] ^= stream[i];
+        checker.equal(vector.xor_digest, digest, vector.name + " " + how + " xor-digest");
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "stream_cipher.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ciphers {
+
+// Authenticated encryption with additional data and a 16-byte tag.
+//
+// Messages that do not fit in memory go through begin(), any number of
+// encrypt_update() / decrypt_update() calls and finish(). Every piece but
+// the last must be a multiple of block_bytes() unless the cipher is
+// seekable. decrypt_update() returns plaintext before the tag is checked,
+// so the caller must discard it if verify() fails.
+class Aead {
+public:
+    static const size_t TagBytes = 16;
+
+    virtual ~Aead() = default;
+
+    // e.g. "chacha20-poly1305" or "aes128-gcm"
+    virtual std::string name() const = 0;
+    virtual size_t key_bytes() const = 0;
+    virtual size_t nonce_bytes() const = 0;
+    virtual size_t block_bytes() const = 0;
+
+    virtual void set_key(const uint8_t* key) = 0;
+
+    // out = in ^ keystream, in == out is allowed
+    void encrypt(const uint8_t* nonce, const uint8_t* ad, size_t ad_size,
+        const uint8_t* in, uint8_t* out, size_t size, uint8_t tag[TagBytes]);
+    // Returns false if the tag does not match; out is zeroed then
+    bool decrypt(const uint8_t* nonce, const uint8_t* ad, size_t ad_size,
+        const uint8_t* in, uint8_t* out, size_t size, const uint8_t tag[TagBytes]);
+
+    // Streaming interface, in == out is allowed
+    virtual void begin(const uint8_t* nonce, const uint8_t* ad, size_t ad_size) = 0;
+    virtual void encrypt_update(const uint8_t* in, uint8_t* out, size_t size) = 0;
+    virtual void decrypt_update(const uint8_t* in, uint8_t* out, size_t size) = 0;
+    virtual void finish(uint8_t tag[TagBytes]) = 0;
+    // finish() and a constant-time comparison with tag
+    bool verify(const uint8_t tag[TagBytes]);
+};
+
+// A stream cipher with a Poly1305 tag, in the layout of RFC 8439. For every
+// nonce the first keystream bytes (one block, 64 for Salsa20/ChaCha20) give
+// the one-time Poly1305 key, the message is encrypted with the keystream
+// after them, and the tag covers
+// ad || pad16 || ciphertext || pad16 || le64(ad size) || le64(ciphertext size).
+// Encryption and the MAC run over the same cache-sized chunks, so the data
+// is read from memory once. The MAC is the cost: even with the SIMD
+// Poly1305 kernels it takes about as long as the cipher, so the AEAD runs
+// at roughly half the speed of the bare stream cipher.
+std::unique_ptr<Aead> make_poly1305_aead(std::unique_ptr<StreamCipher> cipher);
+
+// AES-GCM (SP 800-38D) with 96-bit nonces over the AES-CTR stream ciphers;
+// GHASH uses PCLMULQDQ when the CPU has it. key_bits is 128 or 256, throws
+// std::invalid_argument otherwise. A message is at most 2^32 - 2 blocks;
+// an update past that throws std::length_error before touching out
+std::unique_ptr<Aead> make_aes_gcm(int key_bits);
+
+// mac is "poly1305" (any cipher of the registry) or "gcm" ("aes128",
+// "aes256"). Throws std::invalid_argument for other names
+std::unique_ptr<Aead> make_aead(const std::string& cipher_name, const std::string& mac = "poly1305");
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "stream_cipher.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ciphers {
+
+// Keystream generated ahead of time for latency-sensitive small messages.
+//
+// A ring buffer holds keystream produced while the session is idle, either
+// by refill() between messages or by a background thread (start()).
+// process() then only XORs against ready keystream; when the buffer runs
+// dry it waits for the thread, or generates the missing part itself
+// without one, so the output is always the plain cipher stream.
+//
+// One thread calls process(), refill(), set_key() and set_iv(); the
+// background thread is the only other user of the cipher.
+class KeystreamBuffer {
+public:
+    static const size_t DefaultCapacity = 64 * 1024;
+
+    // capacity is rounded down to whole cipher blocks
+    explicit KeystreamBuffer(std::unique_ptr<StreamCipher> cipher, size_t capacity = DefaultCapacity);
+    ~KeystreamBuffer();
+
+    const StreamCipher& cipher() const { return *m_cipher; }
+    size_t capacity() const { return m_ring.size(); }
+    // Keystream bytes ready for process()
+    size_t available() const;
+
+    // Drop the buffered keystream and restart; the background thread, if
+    // running, is paused meanwhile and starts filling the buffer again
+    void set_key(const uint8_t* key);
+    void set_iv(const uint8_t* iv);
+
+    // out = in ^ keystream, in == out is allowed
+    void process(const uint8_t* in, uint8_t* out, size_t size);
+
+    // Fill the free space of the buffer now; returns the bytes added.
+    // Does nothing while the background thread is running.
+    size_t refill();
+
+    // Keep the buffer full from a background thread
+    void start();
+    void stop();
+    bool running() const { return m_thread.joinable(); }
+
+private:
+    // Generate up to max bytes at m_head, returns the bytes added
+    size_t produce(size_t max);
+    void producer_loop();
+    void reset();
+
+    std::unique_ptr<StreamCipher> m_cipher;
+    std::vector<uint8_t> m_ring;
+    // Bytes produced and consumed since the last reset; the producer owns
+    // m_head, the consumer m_tail
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_produced;
+    std::condition_variable m_consumed;
+    bool m_stop = false;
+
+    KeystreamBuffer(const KeystreamBuffer&) = delete;
+    KeystreamBuffer& operator=(const KeystreamBuffer&) = delete;
+};
+
+}
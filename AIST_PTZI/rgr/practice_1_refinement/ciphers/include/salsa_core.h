@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+extern "C" {
+#include "salsa20/salsa20-simd.h"
+}
+
+namespace ciphers {
+namespace salsa {
+
+// Word operations for the rounds
+inline uint32_t add(uint32_t a, uint32_t b) { return a + b; }
+inline uint32_t xor_(uint32_t a, uint32_t b) { return a ^ b; }
+template <int C>
+inline uint32_t rotl(uint32_t v) { return (v << C) | (v >> (32 - C)); }
+
+// Column round then row round
+template <typename V>
+__attribute__((always_inline)) inline void double_round(V* x)
+{
+    x[4] = xor_(x[4], rotl<7>(add(x[0], x[12])));
+    x[8] = xor_(x[8], rotl<9>(add(x[4], x[0])));
+    x[12] = xor_(x[12], rotl<13>(add(x[8], x[4])));
+    x[0] = xor_(x[0], rotl<18>(add(x[12], x[8])));
+    x[9] = xor_(x[9], rotl<7>(add(x[5], x[1])));
+    x[13] = xor_(x[13], rotl<9>(add(x[9], x[5])));
+    x[1] = xor_(x[1], rotl<13>(add(x[13], x[9])));
+    x[5] = xor_(x[5], rotl<18>(add(x[1], x[13])));
+    x[14] = xor_(x[14], rotl<7>(add(x[10], x[6])));
+    x[2] = xor_(x[2], rotl<9>(add(x[14], x[10])));
+    x[6] = xor_(x[6], rotl<13>(add(x[2], x[14])));
+    x[10] = xor_(x[10], rotl<18>(add(x[6], x[2])));
+    x[3] = xor_(x[3], rotl<7>(add(x[15], x[11])));
+    x[7] = xor_(x[7], rotl<9>(add(x[3], x[15])));
+    x[11] = xor_(x[11], rotl<13>(add(x[7], x[3])));
+    x[15] = xor_(x[15], rotl<18>(add(x[11], x[7])));
+
+    x[1] = xor_(x[1], rotl<7>(add(x[0], x[3])));
+    x[2] = xor_(x[2], rotl<9>(add(x[1], x[0])));
+    x[3] = xor_(x[3], rotl<13>(add(x[2], x[1])));
+    x[0] = xor_(x[0], rotl<18>(add(x[3], x[2])));
+    x[6] = xor_(x[6], rotl<7>(add(x[5], x[4])));
+    x[7] = xor_(x[7], rotl<9>(add(x[6], x[5])));
+    x[4] = xor_(x[4], rotl<13>(add(x[7], x[6])));
+    x[5] = xor_(x[5], rotl<18>(add(x[4], x[7])));
+    x[11] = xor_(x[11], rotl<7>(add(x[10], x[9])));
+    x[8] = xor_(x[8], rotl<9>(add(x[11], x[10])));
+    x[9] = xor_(x[9], rotl<13>(add(x[8], x[11])));
+    x[10] = xor_(x[10], rotl<18>(add(x[9], x[8])));
+    x[12] = xor_(x[12], rotl<7>(add(x[15], x[14])));
+    x[13] = xor_(x[13], rotl<9>(add(x[12], x[15])));
+    x[14] = xor_(x[14], rotl<13>(add(x[13], x[12])));
+    x[15] = xor_(x[15], rotl<18>(add(x[14], x[13])));
+}
+
+template <typename V, size_t... I>
+__attribute__((always_inline)) inline void unrolled(V* x, std::index_sequence<I...>)
+{
+    (((void)I, double_round(x)), ...);
+}
+
+// Rounds / 2 copies of the double round, no loop left for the compiler to keep
+template <int Rounds, typename V>
+__attribute__((always_inline)) inline void rounds(V* x)
+{
+    unrolled(x, std::make_index_sequence<Rounds / 2>());
+}
+
+// Salsa20/r core specialised at compile time on the number of rounds and
+// the key size. The double rounds are unrolled by rounds() and the key
+// constants are picked with if constexpr, so block() is straight-line code
+// with no branches on either.
+//
+// The state is the 16-word input matrix of salsa20.c: constants, key, IV
+// in words 6..7 and the 64-bit block counter in words 8..9. Core<20, 256>
+// produces the same keystream as the ECRYPT Salsa20 code. Runs of whole
+// blocks go to the SSE2/AVX2/AVX-512 kernels of salsa20-simd.c. Those are
+// built once each for 8, 12 and 20 rounds with the rounds unrolled the
+// same way; process() picks its set with the constant Rounds. Other round
+// counts have no kernels and run every block through block().
+template <int Rounds, int KeyBits>
+struct Core {
+    static_assert(Rounds > 0 && Rounds % 2 == 0, "Salsa20 runs double rounds");
+    static_assert(KeyBits == 128 || KeyBits == 256, "Salsa20 keys are 128 or 256 bits");
+
+    static constexpr size_t KeyBytes = KeyBits / 8;
+    static constexpr size_t IvBytes = 8;
+    static constexpr size_t BlockBytes = 64;
+
+    static void set_key(uint32_t state[16], const uint8_t* key)
+    {
+        // "expand 32-byte k" or "expand 16-byte k"
+        if constexpr (KeyBits == 256) {
+            state[0] = 0x61707865;
+            state[5] = 0x3320646e;
+            state[10] = 0x79622d32;
+            state[15] = 0x6b206574;
+        } else {
+            state[0] = 0x61707865;
+            state[5] = 0x3120646e;
+            state[10] = 0x79622d36;
+            state[15] = 0x6b206574;
+        }
+        const uint8_t* key2 = KeyBits == 256 ? key + 16 : key;
+        for (int i = 0; i < 4; i++) {
+            state[1 + i] = load32(key + 4 * i);
+            state[11 + i] = load32(key2 + 4 * i);
+        }
+    }
+
+    // Restarts the stream at block 0
+    static void set_iv(uint32_t state[16], const uint8_t iv[IvBytes])
+    {
+        state[6] = load32(iv);
+        state[7] = load32(iv + 4);
+        set_counter(state, 0);
+    }
+
+    static void set_counter(uint32_t state[16], uint64_t block)
+    {
+        state[8] = static_cast<uint32_t>(block);
+        state[9] = static_cast<uint32_t>(block >> 32);
+    }
+
+    static uint64_t counter(const uint32_t state[16])
+    {
+        return (static_cast<uint64_t>(state[9]) << 32) | state[8];
+    }
+
+    // Keystream block at the current counter; the counter is not advanced
+    static void block(const uint32_t state[16], uint8_t out[BlockBytes])
+    {
+        uint32_t x[16];
+        memcpy(x, state, sizeof(x));
+        salsa::rounds<Rounds>(x);
+        for (int i = 0; i < 16; i++)
+            store32(out + 4 * i, x[i] + state[i]);
+    }
+
+    // out = in ^ keystream for size bytes starting at the counter, which is
+    // advanced past every block touched (a partial last block is used up)
+    static void process(uint32_t state[16], const uint8_t* in, uint8_t* out, size_t size)
+    {
+        size_t blocks = size / BlockBytes;
+        size_t wide = salsa20_simd_blocks_rounds(state, in, out, blocks, salsa20_simd_max_lanes(), Rounds);
+        uint8_t keystream[BlockBytes];
+        for (size_t i = wide * BlockBytes; i < size; i += BlockBytes) {
+            block(state, keystream);
+            set_counter(state, counter(state) + 1);
+            size_t length = size - i < BlockBytes ? size - i : BlockBytes;
+            for (size_t j = 0; j < length; j++)
+                out[i + j] = in[i + j] ^ keystream[j];
+        }
+    }
+
+private:
+    static uint32_t load32(const uint8_t* p)
+    {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8
+            | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    static void store32(uint8_t* p, uint32_t v)
+    {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        p[2] = static_cast<uint8_t>(v >> 16);
+        p[3] = static_cast<uint8_t>(v >> 24);
+    }
+};
+
+}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ciphers {
+
+struct BatchJob;
+
+// Synchronous stream cipher: encryption and decryption are the same
+// operation, c = m ^ keystream. Implemented by adapters over the C code in
+// stream-ciphers/, so all ciphers can be used from one program.
+//
+// Usage: set_key(), set_iv(), then process() or keystream() any number of
+// times. Consecutive calls continue the stream when every length except the
+// last one is a multiple of block_bytes(); seekable ciphers (Salsa20, ChaCha20,
+// AES-CTR) continue it for any lengths.
+class StreamCipher {
+public:
+    virtual ~StreamCipher() = default;
+
+    // Registry name, e.g. "salsa20"
+    virtual std::string name() const = 0;
+
+    // Sizes of the key and IV passed to set_key / set_iv
+    virtual size_t key_bytes() const = 0;
+    virtual size_t iv_bytes() const = 0;
+    // Keystream block length
+    virtual size_t block_bytes() const = 0;
+
+    // Key setup, must be followed by set_iv
+    virtual void set_key(const uint8_t* key) = 0;
+    // Restart the keystream for a new IV
+    virtual void set_iv(const uint8_t* iv) = 0;
+
+    // out = in ^ keystream, in == out is allowed
+    virtual void process(const uint8_t* in, uint8_t* out, size_t size) = 0;
+    virtual void keystream(uint8_t* out, size_t size) = 0;
+
+    // Random access to the keystream; seek() throws std::logic_error
+    // if the cipher does not support it
+    virtual bool seekable() const { return false; }
+    virtual void seek(uint64_t offset);
+
+    // Jobs whose ciphers all have the type of this one and are distinct
+    // (distinct_ciphers), see process_batch; the default calls process()
+    // for each of them
+    virtual void process_jobs(const BatchJob* jobs, size_t count);
+};
+
+// One message of a batch: cipher->process(in, out, size)
+struct BatchJob {
+    StreamCipher* cipher;
+    const uint8_t* in;
+    uint8_t* out;
+    size_t size;
+};
+
+// Many messages at once, e.g. one per session of a server: the same as
+// calling process() for every job in order. Salsa20, ChaCha20/XChaCha20
+// and Rabbit sessions share SIMD lanes, so short messages are encrypted at
+// nearly the bulk rate. A cipher with several jobs (two messages queued
+// for one session) takes part in one pass over the batch per job
+void process_batch(const BatchJob* jobs, size_t count);
+
+// true if no cipher has more than one of the jobs
+bool distinct_ciphers(const BatchJob* jobs, size_t count);
+
+std::unique_ptr<StreamCipher> make_salsa20();
+std::unique_ptr<StreamCipher> make_hc128();
+std::unique_ptr<StreamCipher> make_rabbit();
+std::unique_ptr<StreamCipher> make_sosemanuk();
+std::unique_ptr<StreamCipher> make_chacha20();
+std::unique_ptr<StreamCipher> make_xchacha20();
+
+// AES-128/256 in counter mode (aes/aes.h): AES-NI or VAES when the CPU has
+// them, a constant-time bitsliced fallback otherwise. 96-bit IV, keystream
+// block i is AES_K(iv || be32(i)) as in GCM, so an IV gives 2^32 blocks
+// (64 GiB); process() and seek() past them throw std::length_error
+std::unique_ptr<StreamCipher> make_aes128();
+std::unique_ptr<StreamCipher> make_aes256();
+
+// Reduced-round Salsa20 from the compile-time core in salsa_core.h, for
+// traffic that does not need the full 20 rounds. make_salsa20_rounds picks
+// the kernel at run time: rounds 8, 12 or 20, keys of 128 or 256 bits;
+// throws std::invalid_argument for other values
+std::unique_ptr<StreamCipher> make_salsa20_rounds(int rounds, int key_bits = 256);
+std::unique_ptr<StreamCipher> make_salsa20_12();
+std::unique_ptr<StreamCipher> make_salsa20_8();
+
+// Registry of all ciphers: "salsa20", "hc128", "rabbit", "sosemanuk",
+// "chacha20", "xchacha20", "aes128", "aes256", "salsa20_12", "salsa20_8"
+std::vector<std::string> stream_cipher_names();
+// Throws std::invalid_argument for an unknown name
+std::unique_ptr<StreamCipher> make_stream_cipher(const std::string& name);
+
+// Name of the full-round cipher with the highest throughput on this
+// machine, measured once per process on a short buffer
+std::string fastest_stream_cipher();
+
+}
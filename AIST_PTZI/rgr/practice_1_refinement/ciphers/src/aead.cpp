@@ -0,0 +1,147 @@
+#include "aead.h"
+
+#include "poly1305/poly1305.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace ciphers {
+
+namespace {
+// Encrypted and authenticated in one go; fits in L1/L2 with the keystream
+const size_t ChunkBytes = 16 * 1024;
+
+const uint8_t Zeros[16] = { 0 };
+
+void store_le64(uint8_t* out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t)(value >> (8 * i));
+}
+
+class Poly1305Aead : public Aead {
+public:
+    explicit Poly1305Aead(std::unique_ptr<StreamCipher> cipher)
+        : m_cipher(std::move(cipher))
+    {
+        // whole blocks, so the message keystream continues the stream
+        size_t block = m_cipher->block_bytes();
+        m_key_block.resize((32 + block - 1) / block * block);
+    }
+
+    std::string name() const override { return m_cipher->name() + "-poly1305"; }
+    size_t key_bytes() const override { return m_cipher->key_bytes(); }
+    size_t nonce_bytes() const override { return m_cipher->iv_bytes(); }
+    size_t block_bytes() const override { return m_cipher->block_bytes(); }
+
+    void set_key(const uint8_t* key) override
+    {
+        m_cipher->set_key(key);
+    }
+
+    void begin(const uint8_t* nonce, const uint8_t* ad, size_t ad_size) override
+    {
+        m_cipher->set_iv(nonce);
+        m_cipher->keystream(m_key_block.data(), m_key_block.size());
+        poly1305_init(&m_mac, m_key_block.data());
+
+        poly1305_update(&m_mac, ad, ad_size);
+        if (ad_size % 16 != 0)
+            poly1305_update(&m_mac, Zeros, 16 - ad_size % 16);
+
+        m_ad_size = ad_size;
+        m_size = 0;
+    }
+
+    void encrypt_update(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        size_t chunk = ChunkBytes / m_cipher->block_bytes() * m_cipher->block_bytes();
+        for (size_t offset = 0; offset < size; offset += chunk) {
+            size_t length = std::min(chunk, size - offset);
+            m_cipher->process(in + offset, out + offset, length);
+            poly1305_update(&m_mac, out + offset, length);
+        }
+        m_size += size;
+    }
+
+    void decrypt_update(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        // the MAC reads the chunk before decryption overwrites it (in == out)
+        size_t chunk = ChunkBytes / m_cipher->block_bytes() * m_cipher->block_bytes();
+        for (size_t offset = 0; offset < size; offset += chunk) {
+            size_t length = std::min(chunk, size - offset);
+            poly1305_update(&m_mac, in + offset, length);
+            m_cipher->process(in + offset, out + offset, length);
+        }
+        m_size += size;
+    }
+
+    void finish(uint8_t tag[TagBytes]) override
+    {
+        uint8_t lengths[16];
+        if (m_size % 16 != 0)
+            poly1305_update(&m_mac, Zeros, 16 - m_size % 16);
+        store_le64(lengths, m_ad_size);
+        store_le64(lengths + 8, m_size);
+        poly1305_update(&m_mac, lengths, sizeof(lengths));
+        poly1305_finish(&m_mac, tag);
+    }
+
+private:
+    std::unique_ptr<StreamCipher> m_cipher;
+    poly1305_ctx m_mac;
+    std::vector<uint8_t> m_key_block;
+    size_t m_ad_size = 0;
+    size_t m_size = 0;
+};
+}
+
+bool Aead::verify(const uint8_t tag[TagBytes])
+{
+    uint8_t expected[TagBytes];
+    finish(expected);
+    return poly1305_verify(expected, tag) != 0;
+}
+
+void Aead::encrypt(const uint8_t* nonce, const uint8_t* ad, size_t ad_size,
+    const uint8_t* in, uint8_t* out, size_t size, uint8_t tag[TagBytes])
+{
+    begin(nonce, ad, ad_size);
+    encrypt_update(in, out, size);
+    finish(tag);
+}
+
+bool Aead::decrypt(const uint8_t* nonce, const uint8_t* ad, size_t ad_size,
+    const uint8_t* in, uint8_t* out, size_t size, const uint8_t tag[TagBytes])
+{
+    begin(nonce, ad, ad_size);
+    decrypt_update(in, out, size);
+    if (!verify(tag)) {
+        memset(out, 0, size);
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Aead> make_poly1305_aead(std::unique_ptr<StreamCipher> cipher)
+{
+    return std::unique_ptr<Aead>(new Poly1305Aead(std::move(cipher)));
+}
+
+std::unique_ptr<Aead> make_aead(const std::string& cipher_name, const std::string& mac)
+{
+    if (mac == "poly1305")
+        return make_poly1305_aead(make_stream_cipher(cipher_name));
+    if (mac == "gcm") {
+        if (cipher_name == "aes128")
+            return make_aes_gcm(128);
+        if (cipher_name == "aes256")
+            return make_aes_gcm(256);
+        throw std::invalid_argument("GCM needs an AES cipher, not " + cipher_name);
+    }
+    throw std::invalid_argument("Unknown MAC: " + mac);
+}
+
+}
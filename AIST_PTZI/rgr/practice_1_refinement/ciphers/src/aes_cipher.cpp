@@ -0,0 +1,116 @@
+#include "stream_cipher.h"
+
+#include "aes/aes.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ciphers {
+
+namespace {
+const size_t BlockBytes = 16;
+// Keystream of one IV: the 32-bit counter numbers 2^32 blocks
+const uint64_t StreamBytes = BlockBytes << 32;
+
+// AES in counter mode with a 96-bit IV: keystream block i is
+// AES_K(iv || be32(i)), the counter layout of GCM, so one IV covers up to
+// 2^32 blocks (64 GiB). Keeps the stream position itself like ChaCha20,
+// so calls of any length continue the stream and seek() is supported.
+class Aes : public StreamCipher {
+public:
+    Aes(const char* name, int key_bits)
+        : m_name(name)
+        , m_key_bits(key_bits)
+    {
+    }
+
+    std::string name() const override { return m_name; }
+    size_t key_bytes() const override { return m_key_bits / 8; }
+    size_t iv_bytes() const override { return sizeof(m_iv); }
+    size_t block_bytes() const override { return BlockBytes; }
+
+    void set_key(const uint8_t* key) override
+    {
+        aes_keysetup(&m_ctx, key, m_key_bits);
+        m_position = 0;
+    }
+
+    void set_iv(const uint8_t* iv) override
+    {
+        memcpy(m_iv, iv, sizeof(m_iv));
+        m_position = 0;
+    }
+
+    void process(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        uint8_t counter[BlockBytes];
+
+        // the counter would wrap and repeat the keystream
+        if (m_position > StreamBytes || size > StreamBytes - m_position)
+            throw std::length_error(m_name + std::string(": more than 2^32 blocks for one IV"));
+
+        // rest of a block started by the previous call
+        size_t offset = m_position % BlockBytes;
+        if (offset != 0 && size > 0) {
+            uint8_t block[BlockBytes] = { 0 };
+            size_t head = std::min(size, BlockBytes - offset);
+            counter_block(counter, m_position / BlockBytes);
+            aes_ctr_encrypt(&m_ctx, counter, block, block, BlockBytes);
+            for (size_t i = 0; i < head; i++)
+                out[i] = in[i] ^ block[offset + i];
+            in += head;
+            out += head;
+            size -= head;
+            m_position += head;
+        }
+
+        if (size > 0) {
+            counter_block(counter, m_position / BlockBytes);
+            aes_ctr_encrypt(&m_ctx, counter, in, out, size);
+            m_position += size;
+        }
+    }
+
+    void keystream(uint8_t* out, size_t size) override
+    {
+        memset(out, 0, size);
+        process(out, out, size);
+    }
+
+    bool seekable() const override { return true; }
+
+    void seek(uint64_t offset) override
+    {
+        if (offset > StreamBytes)
+            throw std::length_error(m_name + std::string(": seek past 2^32 blocks"));
+        m_position = offset;
+    }
+
+private:
+    void counter_block(uint8_t counter[BlockBytes], uint64_t block) const
+    {
+        memcpy(counter, m_iv, sizeof(m_iv));
+        for (int i = 0; i < 4; i++)
+            counter[12 + i] = (uint8_t)(block >> (24 - 8 * i));
+    }
+
+    const char* m_name;
+    int m_key_bits;
+    aes_ctx m_ctx;
+    uint8_t m_iv[12] = { 0 };
+    uint64_t m_position = 0; // bytes of keystream used since set_iv
+};
+}
+
+std::unique_ptr<StreamCipher> make_aes128()
+{
+    return std::unique_ptr<StreamCipher>(new Aes("aes128", 128));
+}
+
+std::unique_ptr<StreamCipher> make_aes256()
+{
+    return std::unique_ptr<StreamCipher>(new Aes("aes256", 256));
+}
+
+}
@@ -0,0 +1,121 @@
+#include "aead.h"
+
+#include "aes/aes.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ciphers {
+
+namespace {
+// Encrypted and authenticated in one go, as in the Poly1305 construction
+const size_t ChunkBytes = 16 * 1024;
+// SP 800-38D: 2^39 - 256 bits, the counter blocks after J0 = n || 1
+const uint64_t MaxMessageBytes = ((uint64_t(1) << 32) - 2) * 16;
+
+void store_be64(uint8_t* out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        out[i] = (uint8_t)(value >> (56 - 8 * i));
+}
+
+// With the AES-CTR stream cipher, keystream block i of nonce n is
+// AES_K(n || be32(i)): block 0 of the zero nonce is the hash key
+// H = AES_K(0^128), block 1 masks the tag (J0 = n || 1) and the message is
+// encrypted from block 2 on.
+class AesGcm : public Aead {
+public:
+    explicit AesGcm(std::unique_ptr<StreamCipher> cipher)
+        : m_cipher(std::move(cipher))
+    {
+    }
+
+    std::string name() const override { return m_cipher->name() + "-gcm"; }
+    size_t key_bytes() const override { return m_cipher->key_bytes(); }
+    size_t nonce_bytes() const override { return m_cipher->iv_bytes(); }
+    size_t block_bytes() const override { return m_cipher->block_bytes(); }
+
+    void set_key(const uint8_t* key) override
+    {
+        const uint8_t zero_nonce[12] = { 0 };
+        m_cipher->set_key(key);
+        m_cipher->set_iv(zero_nonce);
+        m_cipher->keystream(m_hash_key, sizeof(m_hash_key));
+    }
+
+    void begin(const uint8_t* nonce, const uint8_t* ad, size_t ad_size) override
+    {
+        m_cipher->set_iv(nonce);
+        m_cipher->seek(16);
+        m_cipher->keystream(m_tag_mask, sizeof(m_tag_mask));
+
+        ghash_init(&m_mac, m_hash_key);
+        ghash_update(&m_mac, ad, ad_size);
+        ghash_pad(&m_mac);
+
+        m_ad_size = ad_size;
+        m_size = 0;
+    }
+
+    void encrypt_update(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        check_length(size);
+        for (size_t offset = 0; offset < size; offset += ChunkBytes) {
+            size_t length = std::min(ChunkBytes, size - offset);
+            m_cipher->process(in + offset, out + offset, length);
+            ghash_update(&m_mac, out + offset, length);
+        }
+        m_size += size;
+    }
+
+    void decrypt_update(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        check_length(size);
+        // GHASH reads the chunk before decryption overwrites it (in == out)
+        for (size_t offset = 0; offset < size; offset += ChunkBytes) {
+            size_t length = std::min(ChunkBytes, size - offset);
+            ghash_update(&m_mac, in + offset, length);
+            m_cipher->process(in + offset, out + offset, length);
+        }
+        m_size += size;
+    }
+
+    void finish(uint8_t tag[TagBytes]) override
+    {
+        // lengths in bits, big-endian
+        uint8_t lengths[16];
+        ghash_pad(&m_mac);
+        store_be64(lengths, m_ad_size * 8);
+        store_be64(lengths + 8, m_size * 8);
+        ghash_update(&m_mac, lengths, sizeof(lengths));
+        ghash_finish(&m_mac, tag);
+        for (size_t i = 0; i < TagBytes; i++)
+            tag[i] ^= m_tag_mask[i];
+    }
+
+private:
+    void check_length(size_t size) const
+    {
+        if (size > MaxMessageBytes - m_size)
+            throw std::length_error(name() + ": message longer than 2^32 - 2 blocks");
+    }
+
+    std::unique_ptr<StreamCipher> m_cipher;
+    ghash_ctx m_mac;
+    uint8_t m_hash_key[16] = { 0 };
+    uint8_t m_tag_mask[16] = { 0 };
+    uint64_t m_ad_size = 0;
+    uint64_t m_size = 0;
+};
+}
+
+std::unique_ptr<Aead> make_aes_gcm(int key_bits)
+{
+    if (key_bits == 128)
+        return std::unique_ptr<Aead>(new AesGcm(make_aes128()));
+    if (key_bits == 256)
+        return std::unique_ptr<Aead>(new AesGcm(make_aes256()));
+    throw std::invalid_argument("AES-GCM key size must be 128 or 256 bits");
+}
+
+}
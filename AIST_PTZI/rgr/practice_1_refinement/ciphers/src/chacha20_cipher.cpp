@@ -0,0 +1,119 @@
+#include "stream_cipher.h"
+
+#include "chacha20/chacha20.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace ciphers {
+
+namespace {
+const size_t BlockBytes = ECRYPT_BLOCKLENGTH;
+
+// 256-bit key; 64-bit IV for ChaCha20, 192-bit IV for XChaCha20. Keeps the
+// stream position itself like Salsa20, so calls of any length continue the
+// stream and seek() is supported.
+class ChaCha20 : public StreamCipher {
+public:
+    ChaCha20(const char* name, size_t iv_bytes)
+        : m_name(name)
+        , m_iv_bytes(iv_bytes)
+    {
+        ECRYPT_init();
+    }
+
+    std::string name() const override { return m_name; }
+    size_t key_bytes() const override { return 32; }
+    size_t iv_bytes() const override { return m_iv_bytes; }
+    size_t block_bytes() const override { return BlockBytes; }
+
+    void set_key(const uint8_t* key) override
+    {
+        ECRYPT_keysetup(&m_ctx, key, 256, (u32)m_iv_bytes * 8);
+        m_position = 0;
+    }
+
+    void set_iv(const uint8_t* iv) override
+    {
+        ECRYPT_ivsetup(&m_ctx, iv);
+        m_position = 0;
+    }
+
+    void process(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        // rest of a block started by the previous call
+        size_t offset = m_position % BlockBytes;
+        if (offset != 0 && size > 0) {
+            size_t head = std::min(size, BlockBytes - offset);
+            chacha20_encrypt_range(&m_ctx, m_position, in, out, (u32)head);
+            in += head;
+            out += head;
+            size -= head;
+            m_position += head;
+        }
+
+        if (size > 0) {
+            ECRYPT_encrypt_bytes64(&m_ctx, in, out, size);
+            m_position += size;
+        }
+    }
+
+    void keystream(uint8_t* out, size_t size) override
+    {
+        memset(out, 0, size);
+        process(out, out, size);
+    }
+
+    bool seekable() const override { return true; }
+
+    void seek(uint64_t offset) override
+    {
+        chacha20_set_counter(&m_ctx, offset / BlockBytes);
+        m_position = offset;
+    }
+
+    // ChaCha20 and XChaCha20 sessions may be mixed
+    void process_jobs(const BatchJob* jobs, size_t count) override
+    {
+        std::vector<ECRYPT_ctx*> contexts;
+        std::vector<const u8*> in;
+        std::vector<u8*> out;
+        std::vector<u32> sizes;
+        // two lanes on one context would both read its counter
+        assert(distinct_ciphers(jobs, count));
+        for (size_t i = 0; i < count; i++) {
+            ChaCha20& cipher = static_cast<ChaCha20&>(*jobs[i].cipher);
+            if (cipher.m_position % BlockBytes != 0 || jobs[i].size > ECRYPT_CHUNKLENGTH) {
+                cipher.process(jobs[i].in, jobs[i].out, jobs[i].size);
+                continue;
+            }
+            contexts.push_back(&cipher.m_ctx);
+            in.push_back(jobs[i].in);
+            out.push_back(jobs[i].out);
+            sizes.push_back((u32)jobs[i].size);
+            cipher.m_position += jobs[i].size;
+        }
+        chacha20_encrypt_batch(contexts.data(), in.data(), out.data(), sizes.data(), (u32)contexts.size());
+    }
+
+private:
+    const char* m_name;
+    size_t m_iv_bytes;
+    ECRYPT_ctx m_ctx;
+    uint64_t m_position = 0; // bytes of keystream used since set_iv
+};
+}
+
+std::unique_ptr<StreamCipher> make_chacha20()
+{
+    return std::unique_ptr<StreamCipher>(new ChaCha20("chacha20", 8));
+}
+
+std::unique_ptr<StreamCipher> make_xchacha20()
+{
+    return std::unique_ptr<StreamCipher>(new ChaCha20("xchacha20", 24));
+}
+
+}
@@ -0,0 +1,202 @@
+#include "keystream_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ciphers {
+
+namespace {
+// Keystream made visible to the consumer per step of the background thread
+const size_t RefillBytes = 4 * 1024;
+
+void xor_bytes(const uint8_t* in, const uint8_t* keystream, uint8_t* out, size_t size)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keystream + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(a, k));
+    }
+#else
+    for (; i + 8 <= size; i += 8) {
+        uint64_t a, k;
+        memcpy(&a, in + i, 8);
+        memcpy(&k, keystream + i, 8);
+        a ^= k;
+        memcpy(out + i, &a, 8);
+    }
+#endif
+    for (; i < size; i++)
+        out[i] = in[i] ^ keystream[i];
+}
+}
+
+KeystreamBuffer::KeystreamBuffer(std::unique_ptr<StreamCipher> cipher, size_t capacity)
+    : m_cipher(std::move(cipher))
+    , m_head(0)
+    , m_tail(0)
+{
+    size_t block = m_cipher->block_bytes();
+    // whole blocks, so every keystream() call but the last continues the stream
+    capacity = capacity / block * block;
+    if (capacity == 0)
+        throw std::invalid_argument("KeystreamBuffer capacity is below one " + m_cipher->name() + " block");
+    m_ring.resize(capacity);
+}
+
+KeystreamBuffer::~KeystreamBuffer()
+{
+    stop();
+}
+
+size_t KeystreamBuffer::available() const
+{
+    return static_cast<size_t>(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed));
+}
+
+void KeystreamBuffer::reset()
+{
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+}
+
+void KeystreamBuffer::set_key(const uint8_t* key)
+{
+    bool was_running = running();
+    stop();
+    m_cipher->set_key(key);
+    reset();
+    if (was_running)
+        start();
+}
+
+void KeystreamBuffer::set_iv(const uint8_t* iv)
+{
+    bool was_running = running();
+    stop();
+    m_cipher->set_iv(iv);
+    reset();
+    if (was_running)
+        start();
+}
+
+size_t KeystreamBuffer::produce(size_t max)
+{
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    size_t free = m_ring.size() - static_cast<size_t>(head - m_tail.load(std::memory_order_acquire));
+    size_t offset = static_cast<size_t>(head % m_ring.size());
+    // head and the wrap point are on block boundaries; keep it that way
+    size_t block = m_cipher->block_bytes();
+    size_t size = std::min({ free, m_ring.size() - offset, max }) / block * block;
+    if (size == 0)
+        return 0;
+
+    m_cipher->keystream(m_ring.data() + offset, size);
+    m_head.store(head + size, std::memory_order_release);
+    return size;
+}
+
+size_t KeystreamBuffer::refill()
+{
+    if (running())
+        return 0;
+    size_t added = 0;
+    while (size_t size = produce(m_ring.size()))
+        added += size;
+    return added;
+}
+
+void KeystreamBuffer::process(const uint8_t* in, uint8_t* out, size_t size)
+{
+    size_t block = m_cipher->block_bytes();
+    while (size > 0) {
+        size_t ready = available();
+        if (ready == 0) {
+            if (!running()) {
+                // no thread to wait for and the cipher is at the read
+                // position: whole blocks go straight through it, the rest
+                // is generated into the buffer
+                size_t direct = size / block * block;
+                if (direct > 0) {
+                    m_cipher->process(in, out, direct);
+                    m_head.store(m_head.load(std::memory_order_relaxed) + direct, std::memory_order_relaxed);
+                    m_tail.store(m_tail.load(std::memory_order_relaxed) + direct, std::memory_order_relaxed);
+                    in += direct;
+                    out += direct;
+                    size -= direct;
+                } else {
+                    produce(block);
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_produced.wait(lock, [&] { return available() > 0; });
+            continue;
+        }
+
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t offset = static_cast<size_t>(tail % m_ring.size());
+        size_t length = std::min({ ready, size, m_ring.size() - offset });
+        xor_bytes(in, m_ring.data() + offset, out, length);
+        m_tail.store(tail + length, std::memory_order_release);
+        in += length;
+        out += length;
+        size -= length;
+
+        if (running()) {
+            // taking the lock orders the update with the producer's wait
+            { std::lock_guard<std::mutex> lock(m_mutex); }
+            m_consumed.notify_one();
+        }
+    }
+}
+
+void KeystreamBuffer::start()
+{
+    if (running())
+        return;
+    m_stop = false;
+    m_thread = std::thread(&KeystreamBuffer::producer_loop, this);
+}
+
+void KeystreamBuffer::stop()
+{
+    if (!running())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_consumed.notify_one();
+    m_thread.join();
+}
+
+void KeystreamBuffer::producer_loop()
+{
+    size_t block = m_cipher->block_bytes();
+    size_t step = std::max(RefillBytes / block, size_t(1)) * block;
+    while (true) {
+        if (produce(step) > 0) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stop)
+                    return;
+            }
+            m_produced.notify_one();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_consumed.wait(lock, [&] { return m_stop || available() < m_ring.size(); });
+        if (m_stop)
+            return;
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+#include "stream_cipher.h"
+
+extern "C" {
+#include "rabbit/ecrypt-sync.h"
+}
+
+#include <cassert>
+#include <vector>
+
+namespace ciphers {
+
+namespace {
+// 128-bit key, 64-bit IV
+class Rabbit : public StreamCipher {
+public:
+    Rabbit() { ECRYPT_init(); }
+
+    std::string name() const override { return "rabbit"; }
+    size_t key_bytes() const override { return 16; }
+    size_t iv_bytes() const override { return 8; }
+    size_t block_bytes() const override { return ECRYPT_BLOCKLENGTH; }
+
+    void set_key(const uint8_t* key) override { ECRYPT_keysetup(&m_ctx, key, 128, 64); }
+    void set_iv(const uint8_t* iv) override { ECRYPT_ivsetup(&m_ctx, iv); }
+
+    void process(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        ECRYPT_encrypt_bytes64(&m_ctx, in, out, size);
+    }
+
+    void keystream(uint8_t* out, size_t size) override
+    {
+        ECRYPT_keystream_bytes64(&m_ctx, out, size);
+    }
+
+    void process_jobs(const BatchJob* jobs, size_t count) override
+    {
+        std::vector<ECRYPT_ctx*> contexts;
+        std::vector<const u8*> in;
+        std::vector<u8*> out;
+        std::vector<u32> sizes;
+        // two lanes on one context would both read its counter
+        assert(distinct_ciphers(jobs, count));
+        for (size_t i = 0; i < count; i++) {
+            Rabbit& cipher = static_cast<Rabbit&>(*jobs[i].cipher);
+            if (jobs[i].size > ECRYPT_CHUNKLENGTH) {
+                cipher.process(jobs[i].in, jobs[i].out, jobs[i].size);
+                continue;
+            }
+            contexts.push_back(&cipher.m_ctx);
+            in.push_back(jobs[i].in);
+            out.push_back(jobs[i].out);
+            sizes.push_back((u32)jobs[i].size);
+        }
+        rabbit_process_batch(contexts.data(), in.data(), out.data(), sizes.data(), (u32)contexts.size());
+    }
+
+private:
+    ECRYPT_ctx m_ctx;
+};
+}
+
+std::unique_ptr<StreamCipher> make_rabbit()
+{
+    return std::unique_ptr<StreamCipher>(new Rabbit());
+}
+
+}
@@ -0,0 +1,108 @@
+#include "stream_cipher.h"
+
+#include "salsa20/salsa20.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace ciphers {
+
+namespace {
+const size_t BlockBytes = ECRYPT_BLOCKLENGTH;
+
+// 256-bit key, 64-bit IV. Keeps the stream position itself, so calls of any
+// length continue the stream and seek() is supported.
+class Salsa20 : public StreamCipher {
+public:
+    Salsa20() { ECRYPT_init(); }
+
+    std::string name() const override { return "salsa20"; }
+    size_t key_bytes() const override { return 32; }
+    size_t iv_bytes() const override { return 8; }
+    size_t block_bytes() const override { return BlockBytes; }
+
+    void set_key(const uint8_t* key) override
+    {
+        ECRYPT_keysetup(&m_ctx, key, 256, 64);
+        m_position = 0;
+    }
+
+    void set_iv(const uint8_t* iv) override
+    {
+        ECRYPT_ivsetup(&m_ctx, iv);
+        m_position = 0;
+    }
+
+    void process(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        // rest of a block started by the previous call
+        size_t offset = m_position % BlockBytes;
+        if (offset != 0 && size > 0) {
+            size_t head = std::min(size, BlockBytes - offset);
+            salsa20_encrypt_range(&m_ctx, m_position, in, out, (u32)head);
+            in += head;
+            out += head;
+            size -= head;
+            m_position += head;
+        }
+
+        // whole blocks from here on, split between threads if large
+        if (size > 0) {
+            salsa20_encrypt_parallel(&m_ctx, in, out, size);
+            m_position += size;
+        }
+    }
+
+    void keystream(uint8_t* out, size_t size) override
+    {
+        memset(out, 0, size);
+        process(out, out, size);
+    }
+
+    bool seekable() const override { return true; }
+
+    void seek(uint64_t offset) override
+    {
+        salsa20_set_counter(&m_ctx, offset / BlockBytes);
+        m_position = offset;
+    }
+
+    void process_jobs(const BatchJob* jobs, size_t count) override
+    {
+        std::vector<ECRYPT_ctx*> contexts;
+        std::vector<const u8*> in;
+        std::vector<u8*> out;
+        std::vector<u32> sizes;
+        // two lanes on one context would both read its counter
+        assert(distinct_ciphers(jobs, count));
+        for (size_t i = 0; i < count; i++) {
+            Salsa20& cipher = static_cast<Salsa20&>(*jobs[i].cipher);
+            // streams stopped inside a block and buffers for the threads
+            // take the usual way
+            if (cipher.m_position % BlockBytes != 0 || jobs[i].size >= SALSA20_PARALLEL_THRESHOLD) {
+                cipher.process(jobs[i].in, jobs[i].out, jobs[i].size);
+                continue;
+            }
+            contexts.push_back(&cipher.m_ctx);
+            in.push_back(jobs[i].in);
+            out.push_back(jobs[i].out);
+            sizes.push_back((u32)jobs[i].size);
+            cipher.m_position += jobs[i].size;
+        }
+        salsa20_encrypt_batch(contexts.data(), in.data(), out.data(), sizes.data(), (u32)contexts.size());
+    }
+
+private:
+    ECRYPT_ctx m_ctx;
+    uint64_t m_position = 0; // bytes of keystream used since set_iv
+};
+}
+
+std::unique_ptr<StreamCipher> make_salsa20()
+{
+    return std::unique_ptr<StreamCipher>(new Salsa20());
+}
+
+}
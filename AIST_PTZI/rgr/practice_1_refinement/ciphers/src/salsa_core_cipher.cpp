@@ -0,0 +1,125 @@
+#include "stream_cipher.h"
+
+#include "salsa_core.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ciphers {
+
+namespace {
+// Salsa20/r over the compile-time core of salsa_core.h, 64-bit IV. Keeps the
+// stream position itself like Salsa20, so calls of any length continue the
+// stream and seek() is supported.
+template <int Rounds, int KeyBits>
+class SalsaRounds : public StreamCipher {
+    typedef salsa::Core<Rounds, KeyBits> Core;
+
+public:
+    explicit SalsaRounds(const char* name)
+        : m_name(name)
+    {
+    }
+
+    std::string name() const override { return m_name; }
+    size_t key_bytes() const override { return Core::KeyBytes; }
+    size_t iv_bytes() const override { return Core::IvBytes; }
+    size_t block_bytes() const override { return Core::BlockBytes; }
+
+    void set_key(const uint8_t* key) override
+    {
+        Core::set_key(m_state, key);
+        m_position = 0;
+    }
+
+    void set_iv(const uint8_t* iv) override
+    {
+        Core::set_iv(m_state, iv);
+        m_position = 0;
+    }
+
+    void process(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        // rest of a block started by the previous call
+        size_t offset = m_position % Core::BlockBytes;
+        if (offset != 0 && size > 0) {
+            uint8_t keystream[Core::BlockBytes];
+            Core::set_counter(m_state, m_position / Core::BlockBytes);
+            Core::block(m_state, keystream);
+            size_t head = std::min(size, Core::BlockBytes - offset);
+            for (size_t i = 0; i < head; i++)
+                out[i] = in[i] ^ keystream[offset + i];
+            in += head;
+            out += head;
+            size -= head;
+            m_position += head;
+        }
+
+        if (size > 0) {
+            Core::set_counter(m_state, m_position / Core::BlockBytes);
+            Core::process(m_state, in, out, size);
+            m_position += size;
+        }
+    }
+
+    void keystream(uint8_t* out, size_t size) override
+    {
+        memset(out, 0, size);
+        process(out, out, size);
+    }
+
+    bool seekable() const override { return true; }
+
+    void seek(uint64_t offset) override { m_position = offset; }
+
+private:
+    const char* m_name;
+    uint32_t m_state[16] = {};
+    uint64_t m_position = 0; // bytes of keystream used since set_iv
+};
+
+template <int Rounds, int KeyBits>
+std::unique_ptr<StreamCipher> make(const char* name)
+{
+    return std::unique_ptr<StreamCipher>(new SalsaRounds<Rounds, KeyBits>(name));
+}
+
+struct Variant {
+    int rounds;
+    int key_bits;
+    std::unique_ptr<StreamCipher> (*make)(const char* name);
+    const char* name;
+};
+
+// Every instantiated kernel; make_salsa20_rounds picks one at run time
+const Variant Variants[] = {
+    { 20, 256, make<20, 256>, "salsa20_20" },
+    { 12, 256, make<12, 256>, "salsa20_12" },
+    { 8, 256, make<8, 256>, "salsa20_8" },
+    { 20, 128, make<20, 128>, "salsa20_20_128" },
+    { 12, 128, make<12, 128>, "salsa20_12_128" },
+    { 8, 128, make<8, 128>, "salsa20_8_128" },
+};
+}
+
+std::unique_ptr<StreamCipher> make_salsa20_rounds(int rounds, int key_bits)
+{
+    for (const auto& variant : Variants)
+        if (variant.rounds == rounds && variant.key_bits == key_bits)
+            return variant.make(variant.name);
+    throw std::invalid_argument("No Salsa20/" + std::to_string(rounds) + " kernel for "
+        + std::to_string(key_bits) + "-bit keys");
+}
+
+std::unique_ptr<StreamCipher> make_salsa20_12()
+{
+    return make_salsa20_rounds(12, 256);
+}
+
+std::unique_ptr<StreamCipher> make_salsa20_8()
+{
+    return make_salsa20_rounds(8, 256);
+}
+
+}
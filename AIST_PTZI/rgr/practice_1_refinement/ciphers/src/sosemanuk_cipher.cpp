@@ -0,0 +1,43 @@
+#include "stream_cipher.h"
+
+extern "C" {
+#include "sosemanuk/ecrypt-sync.h"
+}
+
+namespace ciphers {
+
+namespace {
+// 256-bit key, 128-bit IV
+class Sosemanuk : public StreamCipher {
+public:
+    Sosemanuk() { ECRYPT_init(); }
+
+    std::string name() const override { return "sosemanuk"; }
+    size_t key_bytes() const override { return 32; }
+    size_t iv_bytes() const override { return 16; }
+    size_t block_bytes() const override { return ECRYPT_BLOCKLENGTH; }
+
+    void set_key(const uint8_t* key) override { ECRYPT_keysetup(&m_ctx, key, 256, 128); }
+    void set_iv(const uint8_t* iv) override { ECRYPT_ivsetup(&m_ctx, iv); }
+
+    void process(const uint8_t* in, uint8_t* out, size_t size) override
+    {
+        ECRYPT_encrypt_bytes64(&m_ctx, in, out, size);
+    }
+
+    void keystream(uint8_t* out, size_t size) override
+    {
+        ECRYPT_keystream_bytes64(&m_ctx, out, size);
+    }
+
+private:
+    ECRYPT_ctx m_ctx;
+};
+}
+
+std::unique_ptr<StreamCipher> make_sosemanuk()
+{
+    return std::unique_ptr<StreamCipher>(new Sosemanuk());
+}
+
+}
@@ -0,0 +1,148 @@
+#include "stream_cipher.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ciphers {
+
+namespace {
+struct Entry {
+    const char* name;
+    std::unique_ptr<StreamCipher> (*make)();
+    // reduced-round variant, never reported as the fastest cipher
+    bool reduced;
+};
+
+const Entry Registry[] = {
+    { "salsa20", make_salsa20, false },
+    { "hc128", make_hc128, false },
+    { "rabbit", make_rabbit, false },
+    { "sosemanuk", make_sosemanuk, false },
+    { "chacha20", make_chacha20, false },
+    { "xchacha20", make_xchacha20, false },
+    { "aes128", make_aes128, false },
+    { "aes256", make_aes256, false },
+    { "salsa20_12", make_salsa20_12, true },
+    { "salsa20_8", make_salsa20_8, true },
+};
+
+// Throughput in bytes per second for one pass over buffer
+double measure(StreamCipher& cipher, std::vector<uint8_t>& buffer)
+{
+    std::vector<uint8_t> key(cipher.key_bytes(), 0x5a);
+    std::vector<uint8_t> iv(cipher.iv_bytes(), 0xa5);
+    cipher.set_key(key.data());
+    cipher.set_iv(iv.data());
+
+    auto start = std::chrono::steady_clock::now();
+    cipher.process(buffer.data(), buffer.data(), buffer.size());
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return seconds > 0 ? buffer.size() / seconds : 0;
+}
+}
+
+void StreamCipher::seek(uint64_t)
+{
+    throw std::logic_error(name() + " does not support seeking");
+}
+
+void StreamCipher::process_jobs(const BatchJob* jobs, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        jobs[i].cipher->process(jobs[i].in, jobs[i].out, jobs[i].size);
+}
+
+bool distinct_ciphers(const BatchJob* jobs, size_t count)
+{
+    std::unordered_set<const StreamCipher*> seen;
+    for (size_t i = 0; i < count; i++) {
+        if (!seen.insert(jobs[i].cipher).second)
+            return false;
+    }
+    return true;
+}
+
+namespace {
+// Jobs of distinct ciphers: one process_jobs call per cipher type, the
+// jobs in their order
+void process_distinct(const BatchJob* jobs, size_t count)
+{
+    std::vector<bool> taken(count, false);
+    std::vector<BatchJob> group;
+    for (size_t i = 0; i < count; i++) {
+        if (taken[i])
+            continue;
+        const std::type_info& type = typeid(*jobs[i].cipher);
+        group.clear();
+        for (size_t j = i; j < count; j++) {
+            if (!taken[j] && typeid(*jobs[j].cipher) == type) {
+                group.push_back(jobs[j]);
+                taken[j] = true;
+            }
+        }
+        jobs[i].cipher->process_jobs(group.data(), group.size());
+    }
+}
+}
+
+void process_batch(const BatchJob* jobs, size_t count)
+{
+    // The n-th job of every cipher goes into pass n, so the ciphers of a
+    // pass are distinct and the jobs of one cipher run in their order
+    std::unordered_map<const StreamCipher*, size_t> seen;
+    std::vector<std::vector<BatchJob>> passes;
+    for (size_t i = 0; i < count; i++) {
+        size_t pass = seen[jobs[i].cipher]++;
+        if (pass == passes.size())
+            passes.emplace_back();
+        passes[pass].push_back(jobs[i]);
+    }
+    for (const std::vector<BatchJob>& pass : passes)
+        process_distinct(pass.data(), pass.size());
+}
+
+std::vector<std::string> stream_cipher_names()
+{
+    std::vector<std::string> names;
+    for (const auto& entry : Registry)
+        names.push_back(entry.name);
+    return names;
+}
+
+std::unique_ptr<StreamCipher> make_stream_cipher(const std::string& name)
+{
+    for (const auto& entry : Registry)
+        if (name == entry.name)
+            return entry.make();
+    throw std::invalid_argument("Unknown stream cipher: " + name);
+}
+
+std::string fastest_stream_cipher()
+{
+    static const std::string fastest = [] {
+        // large enough for the SIMD paths, small enough to take milliseconds
+        std::vector<uint8_t> buffer(1 << 20);
+        std::string best;
+        double best_rate = 0;
+        for (const auto& entry : Registry) {
+            if (entry.reduced)
+                continue;
+            auto cipher = entry.make();
+            measure(*cipher, buffer); // warm-up
+            double rate = measure(*cipher, buffer);
+            if (best.empty() || rate > best_rate) {
+                best = entry.name;
+                best_rate = rate;
+            }
+        }
+        return best;
+    }();
+    return fastest;
+}
+
+}
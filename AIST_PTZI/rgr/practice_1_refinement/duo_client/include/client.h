@@ -3,8 +3,8 @@
 #include "protocol.h"
 #include <string>
 
-void run_client(const std::string& params_path, const std::string& server_ip, Protocol protocol, const std::string& file_to_send);
+void run_client(const std::string& params_path, const std::string& server_ip, const Protocol& protocol, const std::string& file_to_send);
 
 void run_dh_client(const std::string& params_path, const std::string& server_ip);
 void run_mqv_client(const std::string& params_path, const std::string& server_ip);
-void run_mqv_client_sha256_salsa20(const std::string& params_path, const std::string& server_ip, const std::string& file_to_send);
+void run_mqv_client_cipher(HashAlgorithm hash_algorithm, const std::string& cipher_name, const std::string& mac, const std::string& params_path, const std::string& server_ip, const std::string& file_to_send);
@@ -1,5 +1,6 @@
-#include "sha256.h"
+#include "hash.h"
 #include <cstdint>
+#include <iomanip>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -18,20 +19,38 @@ static std::vector<uint8_t> hex_to_bytes(const std::string& hex)
     return out;
 }
 
-// Деривация key (32 байта) и iv (8 байт) из hex-строки SHA256
-static void derive_salsa20_key_iv(const std::string& hashed_secret_hex, uint8_t key_out[32], uint8_t iv_out[8])
+// байты -> hex
+static inline std::string bytes_to_hex(const std::vector<uint8_t>& bytes)
+{
+    std::ostringstream oss;
+    for (uint8_t byte : bytes)
+        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned int>(byte);
+    return oss.str();
+}
+
+// Размер блока передачи файла: файл проходит через один буфер такого размера,
+// кратного блоку шифра, чтобы keystream продолжался между блоками
+static inline size_t transfer_chunk_bytes(size_t block_bytes)
+{
+    const size_t chunk_bytes = 256 * 1024;
+    return chunk_bytes / block_bytes * block_bytes;
+}
+
+// Деривация key и iv из hex-строки хеша секрета
+// key = первые key_size байт хеша (key_size <= 32), iv = первые iv_size байт hash(hex + "IV")
+static void derive_key_iv(const std::string& hashed_secret_hex, uint8_t* key_out, size_t key_size, uint8_t* iv_out, size_t iv_size, Hash& hash)
 {
     auto hash_bytes = hex_to_bytes(hashed_secret_hex);
-    if (hash_bytes.size() < 32)
-        hash_bytes.resize(32, 0);
-    for (size_t i = 0; i < 32; ++i)
+    if (hash_bytes.size() < key_size)
+        hash_bytes.resize(key_size, 0);
+    for (size_t i = 0; i < key_size; ++i)
         key_out[i] = hash_bytes[i];
 
-    // iv = первые 8 байт SHA256(hashed_secret_hex + "IV")
-    SHA256 sha;
     std::string iv_source = hashed_secret_hex + "IV";
-    std::string iv_hash_hex = sha(iv_source);
+    std::string iv_hash_hex = hash(iv_source);
     auto iv_hash_bytes = hex_to_bytes(iv_hash_hex);
-    for (size_t i = 0; i < 8; ++i)
+    if (iv_hash_bytes.size() < iv_size)
+        iv_hash_bytes.resize(iv_size, 0);
+    for (size_t i = 0; i < iv_size; ++i)
         iv_out[i] = iv_hash_bytes[i];
-}
+}
\ No newline at end of file
@@ -29,5 +29,8 @@ void string_to_mpz(mpz_t num, const std::string& str);
 bool send_mpz(SocketType sock, const mpz_t num);
 bool receive_mpz(SocketType sock, mpz_t num);
 
+// Return 1 once all size bytes are transferred, the send/recv result otherwise
+int send_all(SocketType sock, const uint8_t* data, size_t size);
 int send_all(SocketType sock, const std::vector<uint8_t>& data);
+int receive_all(SocketType sock, uint8_t* out, size_t size);
 int receive_all(SocketType sock, std::vector<uint8_t>& out, size_t size);
\ No newline at end of file
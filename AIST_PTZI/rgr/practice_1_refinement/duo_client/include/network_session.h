@@ -30,6 +30,9 @@ public:
 
     int send_data(const std::vector<uint8_t>& data);
     int receive_data(std::vector<uint8_t>& out, size_t size);
+    // Into caller-owned memory, e.g. a reused transfer chunk
+    int send_data(const uint8_t* data, size_t size);
+    int receive_data(uint8_t* out, size_t size);
 
 private:
 #ifdef _WIN32
@@ -1,21 +1,77 @@
 #pragma once
+#include "hash_algorithm.h"
+#include "aead.h"
 #include <stdexcept>
 
-enum class Protocol {
+enum class ProtocolType {
     DH,
     MQV,
-    MQV_SHA256_SALSA20
+    // MQV, then a file encrypted with a stream cipher
+    MQV_CIPHER
 };
 
-inline Protocol parse_protocol(std::string str)
+struct Protocol {
+    ProtocolType type;
+    // MQV_CIPHER only: hash for key derivation and the file digest, cipher name
+    HashAlgorithm hash;
+    std::string cipher;
+    // MQV_CIPHER only: "poly1305" or "gcm" if a tag (ciphers::Aead) replaces
+    // the file digest, empty otherwise
+    std::string mac;
+};
+
+// "dh", "mqv" or "mqv-<hash>-<cipher>[-poly1305|-gcm]", e.g.
+// "mqv-sha512-256-salsa20", "mqv-sha256-chacha20-poly1305" or
+// "mqv-sha256-aes128-gcm"
+inline Protocol parse_protocol(const std::string& name)
 {
+    std::string str = name;
     if (str == "dh") {
-        return Protocol::DH;
+        return { ProtocolType::DH, HashAlgorithm::SHA256, "", "" };
     } else if (str == "mqv") {
-        return Protocol::MQV;
-    } else if (str == "mqv-sha256-salsa20") {
-        return Protocol::MQV_SHA256_SALSA20;
+        return { ProtocolType::MQV, HashAlgorithm::SHA256, "", "" };
+    }
+
+    std::string mac;
+    for (const std::string candidate : { "poly1305", "gcm" }) {
+        const std::string mac_suffix = "-" + candidate;
+        if (str.size() > mac_suffix.size()
+            && str.compare(str.size() - mac_suffix.size(), mac_suffix.size(), mac_suffix) == 0) {
+            str.erase(str.size() - mac_suffix.size());
+            mac = candidate;
+            break;
+        }
+    }
+
+    // hash names contain '-', cipher names don't
+    const std::string prefix = "mqv-";
+    size_t dash = str.rfind('-');
+    if (str.compare(0, prefix.size(), prefix) != 0 || dash < prefix.size()) {
+        throw std::invalid_argument("Unknown protocol: " + name);
+    }
+
+    Protocol protocol;
+    protocol.type = ProtocolType::MQV_CIPHER;
+    protocol.hash = parse_hash_algorithm(str.substr(prefix.size(), dash - prefix.size()));
+    protocol.cipher = str.substr(dash + 1);
+    protocol.mac = mac;
+    // throw for unknown names and for GCM with a cipher other than AES
+    if (mac.empty()) {
+        ciphers::make_stream_cipher(protocol.cipher);
     } else {
-        throw std::invalid_argument("Unknown protocol: " + str);
+        ciphers::make_aead(protocol.cipher, mac);
     }
-}
\ No newline at end of file
+    return protocol;
+}
+
+// Name of the tag in the performance tables, e.g. "Poly1305"
+inline std::string mac_display_name(const std::string& mac)
+{
+    return mac == "gcm" ? "GCM" : "Poly1305";
+}
+
+// Protocols that encrypt a file
+inline bool uses_cipher(const Protocol& protocol)
+{
+    return protocol.type == ProtocolType::MQV_CIPHER;
+}
@@ -3,8 +3,8 @@
 #include "protocol.h"
 #include <string>
 
-void run_server(const std::string& params_path, Protocol protocol);
+void run_server(const std::string& params_path, const Protocol& protocol);
 
 void run_dh_server(const std::string& params_path);
 void run_mqv_server(const std::string& params_path);
-void run_mqv_server_sha256_salsa20(const std::string& params_path);
+void run_mqv_server_cipher(HashAlgorithm hash_algorithm, const std::string& cipher_name, const std::string& mac, const std::string& params_path);
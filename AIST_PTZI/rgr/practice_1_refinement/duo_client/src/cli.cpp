@@ -30,7 +30,7 @@ Args parse_args(int argc, char* argv[])
         }
         server_ip = argv[4];
 
-        if (protocol == Protocol::MQV_SHA256_SALSA20) {
+        if (uses_cipher(protocol)) {
             if (argc < 6 || strlen(argv[5]) == 0) {
                 file_to_send = "";
                 throw std::invalid_argument("File to send is empty");
@@ -68,9 +68,20 @@ void print_usage(std::string& path)
 
     std::cout << "Usage:" << std::endl;
     std::cout << "  Server mode: " << cleaned_name << " -s <protocol> <params_file>" << std::endl;
-    std::cout << "  Client mode: " << cleaned_name << " -c <protocol> <params_file> <server_ip> [file_to_send (only mqv-sha256-salsa20)]" << std::endl;
+    std::cout << "  Client mode: " << cleaned_name << " -c <protocol> <params_file> <server_ip> [file_to_send (only mqv-<hash>-<cipher>)]" << std::endl;
     std::cout << "Protocols:" << std::endl;
-    std::cout << "  dh                 - Diffie-Hellman (subgroup depends on params)" << std::endl;
-    std::cout << "  mqv                - MQV protocol" << std::endl;
-    std::cout << "  mqv-sha256-salsa20 - MQV protocol with SHA256 and Salsa20" << std::endl;
+    std::cout << "  dh                     - Diffie-Hellman (subgroup depends on params)" << std::endl;
+    std::cout << "  mqv                    - MQV protocol" << std::endl;
+    std::cout << "  mqv-<hash>-<cipher>    - MQV protocol, then the file encrypted with <cipher>," << std::endl;
+    std::cout << "                           key and digest from <hash> (e.g. mqv-sha256-salsa20)" << std::endl;
+    std::cout << "  mqv-<hash>-<cipher>-poly1305" << std::endl;
+    std::cout << "                         - the same, authenticated with a Poly1305 tag" << std::endl;
+    std::cout << "                           instead of the digest (e.g. mqv-sha256-chacha20-poly1305)" << std::endl;
+    std::cout << "  mqv-<hash>-<aes128|aes256>-gcm" << std::endl;
+    std::cout << "                         - the same with an AES-GCM tag (e.g. mqv-sha256-aes128-gcm)" << std::endl;
+    std::cout << "Hashes: sha256, sha512, sha512-256" << std::endl;
+    std::cout << "Ciphers:";
+    for (const auto& name : ciphers::stream_cipher_names())
+        std::cout << " " << name;
+    std::cout << " (fastest here: " << ciphers::fastest_stream_cipher() << ")" << std::endl;
 }
@@ -1,12 +1,12 @@
 #include "client.h"
+#include "aead.h"
+#include "buffer_pool.h"
 #include "dh.h"
 #include "dh_params.h"
 #include "measure.h"
 #include "mqv.h"
 #include "network_session.h"
 #include "print.h"
-#include "salsa20.h"
-#include "sha256.h"
 #include <fstream>
 #include <helpers.h>
 #include <iostream>
@@ -15,17 +15,17 @@
 const int NAME_WIDTH = 24;
 const int CYCLES_WIDTH = 20;
 
-void run_client(const std::string& params_path, const std::string& server_ip, Protocol protocol, const std::string& file_to_send)
+void run_client(const std::string& params_path, const std::string& server_ip, const Protocol& protocol, const std::string& file_to_send)
 {
-    switch (protocol) {
-    case Protocol::DH:
+    switch (protocol.type) {
+    case ProtocolType::DH:
         run_dh_client(params_path, server_ip);
         break;
-    case Protocol::MQV:
+    case ProtocolType::MQV:
         run_mqv_client(params_path, server_ip);
         break;
-    case Protocol::MQV_SHA256_SALSA20:
-        run_mqv_client_sha256_salsa20(params_path, server_ip, file_to_send);
+    case ProtocolType::MQV_CIPHER:
+        run_mqv_client_cipher(protocol.hash, protocol.cipher, protocol.mac, params_path, server_ip, file_to_send);
         break;
     }
 }
@@ -148,14 +148,9 @@ void run_mqv_client(const std::string& params_path, const std::string& server_ip
         server_static_public, client_secret, NULL);
 }
 
-std::vector<uint8_t> readFile(const std::string& filename)
-{
-    std::ifstream file(filename, std::ios::binary);
-    return { std::istreambuf_iterator<char>(file), {} };
-}
-
-void run_mqv_client_sha256_salsa20(const std::string& params_path, const std::string& server_ip, const std::string& file_to_send)
+void run_mqv_client_cipher(HashAlgorithm hash_algorithm, const std::string& cipher_name, const std::string& mac, const std::string& params_path, const std::string& server_ip, const std::string& file_to_send)
 {
+    const bool authenticated = !mac.empty();
     NetworkSession session;
     session.connect_to_server(server_ip);
 
@@ -207,71 +202,136 @@ void run_mqv_client_sha256_salsa20(const std::string& params_path, const std::st
                 params);
         });
 
-        SHA256 sha256;
+        auto hash = make_hash(hash_algorithm);
+        const std::string hash_name = hash_algorithm_name(hash_algorithm);
         std::string client_secret_str = mpz_get_str(nullptr, 16, client_secret);
         std::string hashed_secret = "";
 
-        auto sha256_time = measure_time([&]() {
-            hashed_secret = sha256(client_secret_str);
+        auto hash_time = measure_time([&]() {
+            hashed_secret = (*hash)(client_secret_str);
         });
 
-        uint8_t key[32];
-        uint8_t iv[8];
+        auto cipher = ciphers::make_stream_cipher(cipher_name);
+        std::unique_ptr<ciphers::Aead> aead;
+        if (authenticated) {
+            aead = ciphers::make_aead(cipher_name, mac);
+        }
+        std::vector<uint8_t> key(cipher->key_bytes());
+        std::vector<uint8_t> iv(cipher->iv_bytes());
         auto derive_key_time = measure_time([&]() {
-            derive_salsa20_key_iv(hashed_secret, key, iv);
+            derive_key_iv(hashed_secret, key.data(), key.size(), iv.data(), iv.size(), *hash);
         });
 
-        // Init Salsa20
-        ECRYPT_ctx ctx;
-        auto ecrypt_init_time = measure_time([&]() {
-            ECRYPT_init();
-            ECRYPT_keysetup(&ctx, key, 256, 64); // keybits=256, ivbits=64 (8 bytes)
-            ECRYPT_ivsetup(&ctx, iv);
+        auto cipher_init_time = measure_time([&]() {
+            if (aead) {
+                aead->set_key(key.data());
+            } else {
+                cipher->set_key(key.data());
+                cipher->set_iv(iv.data());
+            }
         });
 
         std::cout << "\nClient's shared secret:" << std::endl;
         mpz_out_str(stdout, 16, client_secret);
         std::cout << std::endl;
 
-        std::cout << "\nClient's shared secret (sha-256):" << std::endl;
+        std::cout << "\nClient's shared secret (" << hash_name << "):" << std::endl;
         std::cout << hashed_secret << std::endl;
         std::cout << std::endl;
 
-        auto plain = readFile(file_to_send);
+        std::ifstream file(file_to_send, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Failed to open " + file_to_send);
+        }
+        size_t size = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+
+        // The file is read, hashed, encrypted in place and sent chunk by
+        // chunk, so memory use does not depend on its size. The digest of the
+        // plain file is checked by the server after decryption; an
+        // authenticated transfer sends the Poly1305 or GCM tag instead.
+        auto file_hash = make_file_hash(hash_algorithm);
+        // From the shared pool: pre-faulted on first use, reused by later
+        // transfers, so the timed loop below takes no page faults
+        BufferPool::Buffer chunk;
+        auto buffer_time = measure_time([&]() {
+            chunk = BufferPool::shared().acquire(transfer_chunk_bytes(cipher->block_bytes()));
+        });
+        std::vector<uint8_t> digest;
+        double read_time = 0, file_hash_time = 0, encrypt_time = 0, send_time = 0;
 
-        std::vector<uint8_t> cipher;
-        cipher.resize(plain.size());
-        auto encrypt_time = measure_time([&]() {
-            if (!plain.empty()) {
-                ECRYPT_encrypt_bytes(&ctx, plain.data(), cipher.data(), static_cast<u32>(plain.size()));
+        send_time += measure_time([&]() {
+            if (session.send_data(reinterpret_cast<const uint8_t*>(&size), sizeof(size)) < 0) { // Отправляем размер
+                throw std::runtime_error("Failed to send encrypted data size");
             }
         });
+        if (aead) {
+            aead->begin(iv.data(), nullptr, 0);
+        }
 
-        auto size = cipher.size();
-        std::vector<uint8_t> size_in_bytes(sizeof(size));
-        ::memcpy(size_in_bytes.data(), &size, sizeof(size));
-        auto send_time = measure_time([&]() {
-            if (session.send_data(size_in_bytes) < 0) { // Отправляем размер
-                throw std::runtime_error("Failed to send encrypted data size");
+        for (size_t offset = 0; offset < size;) {
+            size_t length = std::min(chunk.size(), size - offset);
+            read_time += measure_time([&]() {
+                if (!file.read(reinterpret_cast<char*>(chunk.data()), length)) {
+                    throw std::runtime_error("Failed to read " + file_to_send);
+                }
+            });
+            if (!authenticated) {
+                file_hash_time += measure_time([&]() {
+                    file_hash->add(chunk.data(), length);
+                });
             }
-            if (session.send_data(cipher) < 0) {
-                throw std::runtime_error("Failed to send encrypted data");
+            encrypt_time += measure_time([&]() {
+                if (aead) {
+                    aead->encrypt_update(chunk.data(), chunk.data(), length);
+                } else {
+                    cipher->process(chunk.data(), chunk.data(), length);
+                }
+            });
+            send_time += measure_time([&]() {
+                if (session.send_data(chunk.data(), length) < 0) {
+                    throw std::runtime_error("Failed to send encrypted data");
+                }
+            });
+            offset += length;
+        }
+
+        if (aead) {
+            digest.resize(ciphers::Aead::TagBytes);
+            encrypt_time += measure_time([&]() {
+                aead->finish(digest.data());
+            });
+        } else {
+            file_hash_time += measure_time([&]() {
+                digest = hex_to_bytes(file_hash->getHash());
+            });
+        }
+        send_time += measure_time([&]() {
+            if (session.send_data(digest) < 0) {
+                throw std::runtime_error(authenticated ? "Failed to send tag" : "Failed to send file digest");
             }
         });
 
-        print_performance_table(
-            "MQV protocol (Client)",
-            { { "Client static key", client_static_time },
-                { "Client ephemeral key", client_ephemeral_time },
-                { "Client shared secret", client_secret_time },
-                { "SHA256", sha256_time },
-                { "Derive key + iv", derive_key_time },
-                { "Salsa20 init", ecrypt_init_time },
-                { "Encrypt data", encrypt_time },
-                { "Send data", send_time } },
-            NAME_WIDTH, CYCLES_WIDTH);
+        std::vector<std::tuple<std::string, unsigned int>> rows = {
+            { "Client static key", client_static_time },
+            { "Client ephemeral key", client_ephemeral_time },
+            { "Client shared secret", client_secret_time },
+            { hash_name, hash_time },
+            { "Derive key + iv", derive_key_time },
+            { cipher_name + " init", cipher_init_time },
+            { "Buffer setup", buffer_time },
+            { "Read file", read_time },
+        };
+        if (!authenticated) {
+            rows.push_back({ "File digest", file_hash_time });
+        }
+        rows.push_back({ authenticated ? "Encrypt + " + mac_display_name(mac) : "Encrypt data", encrypt_time });
+        rows.push_back({ "Send data", send_time });
+        print_performance_table("MQV protocol (Client)", rows, NAME_WIDTH, CYCLES_WIDTH);
 
-        std::cout << "Encrypted data sent to server" << "(" << size << " bytes)" << std::endl;
+        std::cout << "Encrypted data sent to server" << "(" << size << " bytes, "
+                  << chunk.size() << "-byte chunks)" << std::endl;
+        std::cout << (authenticated ? mac_display_name(mac) + " tag: " : "File digest: ") << bytes_to_hex(digest) << std::endl;
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -36,33 +36,41 @@ bool receive_mpz(SocketType sock, mpz_t num)
     char buffer[BUFFER_SIZE];
     std::string str;
 
+    // Peek first and consume only up to the '\n': data sent right after the
+    // number must stay in the socket for the next receive
+    while (true) {
 #ifdef _WIN32
-    int bytes;
-    while ((bytes = recv(sock, buffer, BUFFER_SIZE - 1, 0)) > 0) {
+        int bytes = recv(sock, buffer, BUFFER_SIZE, MSG_PEEK);
 #else
-    ssize_t bytes;
-    while ((bytes = recv(sock, buffer, BUFFER_SIZE - 1, 0)) > 0) {
+        ssize_t bytes = recv(sock, buffer, BUFFER_SIZE, MSG_PEEK);
 #endif
-        buffer[bytes] = '\0';
-        str += buffer;
-        if (str.find('\n') != std::string::npos) {
+        if (bytes <= 0)
+            return false;
+
+        const char* end = static_cast<const char*>(memchr(buffer, '\n', static_cast<size_t>(bytes)));
+        size_t take = end ? static_cast<size_t>(end - buffer) + 1 : static_cast<size_t>(bytes);
+#ifdef _WIN32
+        bytes = recv(sock, buffer, static_cast<int>(take), 0);
+#else
+        bytes = recv(sock, buffer, take, 0);
+#endif
+        if (bytes <= 0)
+            return false;
+
+        str.append(buffer, static_cast<size_t>(bytes));
+        if (end)
             break;
-        }
     }
 
-    if (bytes <= 0)
-        return false;
-
     str = str.substr(0, str.find('\n'));
     string_to_mpz(num, str);
     return true;
 }
 
-int send_all(SocketType sock, const std::vector<uint8_t>& data)
+int send_all(SocketType sock, const uint8_t* data, size_t size)
 {
     size_t total_sent = 0;
-    const char* data_ptr = reinterpret_cast<const char*>(data.data());
-    const auto size = data.size();
+    const char* data_ptr = reinterpret_cast<const char*>(data);
 
     while (total_sent < size) {
 #ifdef _WIN32
@@ -79,14 +87,18 @@ int send_all(SocketType sock, const std::vector<uint8_t>& data)
     return 1;
 }
 
-int receive_all(SocketType sock, std::vector<uint8_t>& out, size_t size)
+int send_all(SocketType sock, const std::vector<uint8_t>& data)
+{
+    return send_all(sock, data.data(), data.size());
+}
+
+int receive_all(SocketType sock, uint8_t* out, size_t size)
 {
-    out.resize(size);
     if (size == 0)
         return true;
 
     size_t total_received = 0;
-    char* data_ptr = reinterpret_cast<char*>(out.data());
+    char* data_ptr = reinterpret_cast<char*>(out);
 
     while (total_received < size) {
 #ifdef _WIN32
@@ -101,4 +113,10 @@ int receive_all(SocketType sock, std::vector<uint8_t>& out, size_t size)
     }
 
     return 1;
+}
+
+int receive_all(SocketType sock, std::vector<uint8_t>& out, size_t size)
+{
+    out.resize(size);
+    return receive_all(sock, out.data(), size);
 }
\ No newline at end of file
@@ -110,6 +110,16 @@ int NetworkSession::send_data(const std::vector<uint8_t>& data)
 }
 
 int NetworkSession::receive_data(std::vector<uint8_t>& out, size_t size)
+{
+    return receive_all(clientSocket, out, size);
+}
+
+int NetworkSession::send_data(const uint8_t* data, size_t size)
+{
+    return send_all(clientSocket, data, size);
+}
+
+int NetworkSession::receive_data(uint8_t* out, size_t size)
 {
     return receive_all(clientSocket, out, size);
 }
\ No newline at end of file
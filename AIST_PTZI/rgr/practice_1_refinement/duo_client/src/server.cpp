@@ -1,4 +1,6 @@
 #include "server.h"
+#include "aead.h"
+#include "buffer_pool.h"
 #include "dh.h"
 #include "dh_params.h"
 #include "measure.h"
@@ -8,24 +10,23 @@
 #include <fstream>
 #include <helpers.h>
 #include <iostream>
-#include <salsa20.h>
-#include <sha256.h>
+#include <cstdio>
 #include <cstring>
 
 const int NAME_WIDTH = 24;
 const int CYCLES_WIDTH = 20;
 
-void run_server(const std::string& params_path, Protocol protocol)
+void run_server(const std::string& params_path, const Protocol& protocol)
 {
-    switch (protocol) {
-    case Protocol::DH:
+    switch (protocol.type) {
+    case ProtocolType::DH:
         run_dh_server(params_path);
         break;
-    case Protocol::MQV:
+    case ProtocolType::MQV:
         run_mqv_server(params_path);
         break;
-    case Protocol::MQV_SHA256_SALSA20:
-        run_mqv_server_sha256_salsa20(params_path);
+    case ProtocolType::MQV_CIPHER:
+        run_mqv_server_cipher(protocol.hash, protocol.cipher, protocol.mac, params_path);
         break;
     }
 }
@@ -148,14 +149,9 @@ void run_mqv_server(const std::string& params_path)
         client_static_public, server_secret, NULL);
 }
 
-void writeFile(const std::string& filename, const std::vector<uint8_t>& data)
-{
-    std::ofstream file(filename, std::ios::binary);
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
-}
-
-void run_mqv_server_sha256_salsa20(const std::string& params_path)
+void run_mqv_server_cipher(HashAlgorithm hash_algorithm, const std::string& cipher_name, const std::string& mac, const std::string& params_path)
 {
+    const bool authenticated = !mac.empty();
     NetworkSession session;
     session.start_server();
 
@@ -208,78 +204,151 @@ void run_mqv_server_sha256_salsa20(const std::string& params_path)
         });
 
         // Derive key + iv
-        SHA256 sha256;
+        auto hash = make_hash(hash_algorithm);
+        const std::string hash_name = hash_algorithm_name(hash_algorithm);
         std::string server_secret_str = mpz_get_str(nullptr, 16, server_secret);
         std::string hashed_secret = "";
 
-        auto sha256_time = measure_time([&]() {
-            hashed_secret = sha256(server_secret_str);
+        auto hash_time = measure_time([&]() {
+            hashed_secret = (*hash)(server_secret_str);
         });
 
-        uint8_t key[32];
-        uint8_t iv[8];
+        auto cipher = ciphers::make_stream_cipher(cipher_name);
+        std::unique_ptr<ciphers::Aead> aead;
+        if (authenticated) {
+            aead = ciphers::make_aead(cipher_name, mac);
+        }
+        std::vector<uint8_t> key(cipher->key_bytes());
+        std::vector<uint8_t> iv(cipher->iv_bytes());
         auto derive_key_time = measure_time([&]() {
-            derive_salsa20_key_iv(hashed_secret, key, iv);
+            derive_key_iv(hashed_secret, key.data(), key.size(), iv.data(), iv.size(), *hash);
         });
-        // Init Salsa20
-        ECRYPT_ctx ctx;
-        auto ecrypt_init_time = measure_time([&]() {
-            ECRYPT_init();
-            ECRYPT_keysetup(&ctx, key, 256, 64); // keybits=256, ivbits=64 (8 bytes)
-            ECRYPT_ivsetup(&ctx, iv);
+        auto cipher_init_time = measure_time([&]() {
+            if (aead) {
+                aead->set_key(key.data());
+            } else {
+                cipher->set_key(key.data());
+                cipher->set_iv(iv.data());
+            }
         });
 
         std::cout << "\nServer's shared secret:" << std::endl;
         mpz_out_str(stdout, 16, server_secret);
         std::cout << std::endl;
 
-        std::cout << "\nServer's shared secret (sha-256):" << std::endl;
+        std::cout << "\nServer's shared secret (" << hash_name << "):" << std::endl;
         std::cout << hashed_secret << std::endl;
         std::cout << std::endl;
 
+        // Chunks are received, decrypted in place, hashed and written out one
+        // at a time. An authenticated transfer is written to a temporary file
+        // that only becomes received.txt once the tag verifies.
+        const std::string received_path = "received.txt";
+        const std::string output_path = authenticated ? received_path + ".part" : received_path;
+        std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Failed to create " + output_path);
+        }
+
+        auto file_hash = make_file_hash(hash_algorithm);
+        // From the shared pool: pre-faulted on first use, reused by later
+        // transfers, so the timed loop below takes no page faults
+        BufferPool::Buffer chunk;
+        auto buffer_time = measure_time([&]() {
+            chunk = BufferPool::shared().acquire(transfer_chunk_bytes(cipher->block_bytes()));
+        });
+        std::vector<uint8_t> digest;
         size_t size = 0;
-        std::vector<uint8_t> size_in_bytes(sizeof(size));
-        std::vector<uint8_t> cipher;
+        double receive_time = 0, decrypt_time = 0, file_hash_time = 0, write_time = 0;
 
-        auto receive_time = measure_time([&]() {
-            if (!session.receive_data(size_in_bytes, sizeof(size))) {
+        receive_time += measure_time([&]() {
+            if (!session.receive_data(reinterpret_cast<uint8_t*>(&size), sizeof(size))) {
                 throw std::runtime_error("Failed to receive encrypted data");
             }
-            ::memcpy(&size, size_in_bytes.data(), sizeof(size));
+        });
+        if (aead) {
+            aead->begin(iv.data(), nullptr, 0);
+        }
 
-            if (!session.receive_data(cipher, size)) {
-                throw std::runtime_error("Failed to receive encrypted data");
+        for (size_t offset = 0; offset < size;) {
+            size_t length = std::min(chunk.size(), size - offset);
+            receive_time += measure_time([&]() {
+                if (!session.receive_data(chunk.data(), length)) {
+                    throw std::runtime_error("Failed to receive encrypted data");
+                }
+            });
+            // Дешифровка
+            decrypt_time += measure_time([&]() {
+                if (aead) {
+                    aead->decrypt_update(chunk.data(), chunk.data(), length);
+                } else {
+                    cipher->process(chunk.data(), chunk.data(), length);
+                }
+            });
+            if (!authenticated) {
+                file_hash_time += measure_time([&]() {
+                    file_hash->add(chunk.data(), length);
+                });
             }
-        });
+            write_time += measure_time([&]() {
+                if (!file.write(reinterpret_cast<const char*>(chunk.data()), length)) {
+                    throw std::runtime_error("Failed to write " + output_path);
+                }
+            });
+            offset += length;
+        }
+        file.close();
 
-        // Дешифровка
-        std::vector<uint8_t> plain;
-        plain.resize(cipher.size());
-        auto decrypt_time = measure_time([&]() {
-            if (!cipher.empty()) {
-                ECRYPT_decrypt_bytes(&ctx, cipher.data(), plain.data(), static_cast<u32>(cipher.size()));
+        receive_time += measure_time([&]() {
+            // file digest has the length of the selected hash, the tag is fixed
+            size_t digest_size = authenticated ? ciphers::Aead::TagBytes : hash_digest_bytes(hash_algorithm);
+            if (!session.receive_data(digest, digest_size)) {
+                throw std::runtime_error(authenticated ? "Failed to receive tag" : "Failed to receive file digest");
             }
         });
 
-        writeFile("received.txt", plain);
+        // Integrity check of the decrypted file; a forged message is never
+        // left on disk
+        bool integrity_ok = false;
+        if (aead) {
+            decrypt_time += measure_time([&]() {
+                integrity_ok = aead->verify(digest.data());
+            });
+            if (integrity_ok) {
+                std::rename(output_path.c_str(), received_path.c_str());
+            } else {
+                std::remove(output_path.c_str());
+            }
+        } else {
+            file_hash_time += measure_time([&]() {
+                integrity_ok = hex_to_bytes(file_hash->getHash()) == digest;
+            });
+        }
 
-        print_performance_table(
-            "MQV protocol (Server)",
-            {
-                { "Server static key", server_static_time },
-                { "Server ephemeral key", server_ephemeral_time },
-                { "Server shared secret", server_secret_time },
-                { "SHA-256", sha256_time },
-                { "Derive key + iv", derive_key_time },
-                { "Salsa20 init", ecrypt_init_time },
-                { "Receive", receive_time },
-                { "Decrypt", decrypt_time },
-            },
-            NAME_WIDTH, CYCLES_WIDTH);
+        std::vector<std::tuple<std::string, unsigned int>> rows = {
+            { "Server static key", server_static_time },
+            { "Server ephemeral key", server_ephemeral_time },
+            { "Server shared secret", server_secret_time },
+            { hash_name, hash_time },
+            { "Derive key + iv", derive_key_time },
+            { cipher_name + " init", cipher_init_time },
+            { "Buffer setup", buffer_time },
+            { "Receive", receive_time },
+            { authenticated ? "Decrypt + " + mac_display_name(mac) : "Decrypt", decrypt_time },
+        };
+        if (!authenticated) {
+            rows.push_back({ "File digest", file_hash_time });
+        }
+        rows.push_back({ "Write file", write_time });
+        print_performance_table("MQV protocol (Server)", rows, NAME_WIDTH, CYCLES_WIDTH);
 
-        std::cout << "Received " << "(" << plain.size() << " bytes)" << " (decrypted)" << std::endl
-                  << "saved to received.txt"
-                  << std::endl;
+        std::cout << "Received " << "(" << size << " bytes, " << chunk.size() << "-byte chunks)"
+                  << " (decrypted)" << std::endl;
+        if (!authenticated || integrity_ok) {
+            std::cout << "saved to " << received_path << std::endl;
+        }
+        std::cout << (authenticated ? "Authentication: " : "Integrity check: ")
+                  << (integrity_ok ? "OK" : "FAILED") << std::endl;
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Reusable buffers for cipher and network I/O.
+// Buffers come straight from the OS, so data() is page-aligned (and thus
+// 64-byte aligned for the SIMD kernels), and every page is touched when a
+// buffer is created. A released buffer goes back to the pool and is handed
+// out again by the next acquire() that fits, so steady-state transfers
+// neither allocate nor take first-touch page faults. With huge pages,
+// buffers of 2 MiB and more are placed on 2 MiB boundaries and advised as
+// transparent huge pages (Linux; elsewhere they get normal pages).
+class BufferPool {
+public:
+    class Buffer;
+
+    explicit BufferPool(bool huge_pages = true);
+    ~BufferPool();
+
+    // At least size bytes; Buffer::size() is size. Throws std::bad_alloc
+    Buffer acquire(size_t size);
+
+    // Buffers created so far; stays put while acquire() reuses them
+    size_t allocations() const;
+
+    // Process-wide pool with huge pages
+    static BufferPool& shared();
+
+private:
+    struct Block {
+        uint8_t* data;
+        size_t capacity;
+        void* mapping;
+        size_t mapping_size;
+    };
+
+    Block create(size_t size);
+    void release(const Block& block);
+    static void unmap(const Block& block);
+
+    std::vector<Block> m_free;
+    mutable std::mutex m_mutex;
+    bool m_huge_pages;
+    size_t m_allocations;
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+};
+
+// Owns a block of the pool and returns it on destruction
+class BufferPool::Buffer {
+public:
+    // Empty, for assignment from acquire() later
+    Buffer();
+    Buffer(Buffer&& other) noexcept;
+    Buffer& operator=(Buffer&& other) noexcept;
+    ~Buffer();
+
+    uint8_t* data() const { return m_block.data; }
+    size_t size() const { return m_size; }
+
+private:
+    friend class BufferPool;
+    Buffer(BufferPool* pool, const Block& block, size_t size);
+    void reset();
+
+    BufferPool* m_pool;
+    Block m_block;
+    size_t m_size;
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+};
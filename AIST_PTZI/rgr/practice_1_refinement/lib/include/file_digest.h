@@ -0,0 +1,26 @@
+#pragma once
+
+#include "hash.h"
+
+#include <cstdint>
+#include <string>
+
+struct FileDigest {
+    std::string hash; // hex digest
+    uint64_t bytes; // bytes hashed
+    double seconds; // wall time spent reading and hashing
+    bool mapped; // true if the file was memory-mapped
+
+    // Throughput in MB/s (10^6 bytes)
+    double throughput() const
+    {
+        return seconds > 0 ? bytes / seconds / 1e6 : 0;
+    }
+};
+
+// Hash a whole file with constant memory use.
+// The file is memory-mapped window by window (with sequential read-ahead
+// advice) and fed to hasher.add() without copies. If mapping is not
+// possible it is read in large aligned chunks instead.
+// hasher is reset first. Throws std::runtime_error if the file cannot be read.
+FileDigest hash_file(const std::string& path, Hash& hasher);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "hash.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Hash functions selectable for key derivation and file digests
+enum class HashAlgorithm {
+    SHA256,
+    SHA512,
+    SHA512_256
+};
+
+// "sha256", "sha512" or "sha512-256", throws std::invalid_argument otherwise
+HashAlgorithm parse_hash_algorithm(const std::string& name);
+std::string hash_algorithm_name(HashAlgorithm algorithm);
+// Length of the binary digest: 32 for SHA-256 and SHA-512/256, 64 for SHA-512.
+// make_file_hash digests have the same length
+size_t hash_digest_bytes(HashAlgorithm algorithm);
+
+// Plain streaming hash
+std::unique_ptr<Hash> make_hash(HashAlgorithm algorithm);
+// Hash for whole files: SHA-256 uses the parallel SHA256Tree,
+// the SHA-512 family is already fast enough as a streaming hash
+std::unique_ptr<Hash> make_file_hash(HashAlgorithm algorithm);
@@ -6,7 +6,7 @@
 
 #pragma once
 
-//#include "hash.h"
+#include "hash.h"
 #include <string>
 
 // define fixed size integer types
@@ -34,14 +34,20 @@ typedef unsigned __int64 uint64_t;
       sha256.add(pointer to fresh data, number of new bytes);
     std::string myHash3 = sha256.getHash();
   */
-class SHA256 //: public Hash
+class SHA256 : public Hash
 {
 public:
   /// split into 64 byte blocks (=> 512 bits), hash is 32 bytes long
   enum { BlockSize = 512 / 8, HashBytes = 32 };
 
-  /// same as reset()
-  SHA256();
+  /// compression function used for full blocks
+  enum Implementation { Auto, Portable, HardwareAccelerated };
+
+  /// same as reset(), Auto picks SHA-NI when the CPU supports it
+  explicit SHA256(Implementation implementation = Auto);
+
+  /// true if blocks are compressed with the SHA-NI instructions
+  bool isAccelerated() const;
 
   /// compute SHA256 of a memory block
   std::string operator()(const void* data, size_t numBytes);
@@ -60,8 +66,10 @@ public:
   void reset();
 
 private:
-  /// process 64 bytes
+  /// process 64 bytes with the portable code
   void processBlock(const void* data);
+  /// process numBlocks consecutive 64 byte blocks
+  void processBlocks(const void* data, size_t numBlocks);
   /// process everything left in the internal buffer
   void processBuffer();
 
@@ -75,4 +83,6 @@ private:
   enum { HashValues = HashBytes / 4 };
   /// hash, stored as integers
   uint32_t m_hash[HashValues];
+  /// use sha256_shani_blocks() instead of the portable code
+  bool     m_accelerated;
 };
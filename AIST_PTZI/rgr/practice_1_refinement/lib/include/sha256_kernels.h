@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Hardware-specific SHA-256 code paths. Every *_supported() check is done
+// at run time, the kernels must not be called when it returns false.
+
+// Compress numBlocks consecutive 64-byte blocks into state with the
+// x86 SHA extensions (SHA-NI).
+bool sha256_shani_supported();
+void sha256_shani_blocks(uint32_t state[8], const void* data, size_t numBlocks);
+
+// Multi-buffer hashing: eight independent messages of the same length,
+// one per AVX2 lane. Writes eight complete (padded) SHA-256 digests.
+bool sha256_x8_supported();
+void sha256_x8(const void* const data[8], size_t numBytes, unsigned char hashes[8][32]);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "hash.h"
+#include "sha256.h"
+#include "thread_pool.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+/// compute a SHA256 Merkle tree hash, leaves are hashed in parallel
+/** The input is split into LeafSize chunks (the last one may be shorter,
+    empty input is one empty leaf). Hashes use RFC 6962 domain separation:
+      leaf = SHA256(0x00 || chunk)
+      node = SHA256(0x01 || left || right)
+    An odd node at the end of a level is promoted to the next level unchanged.
+
+    Usage:
+    SHA256Tree tree;
+    while (more data available)
+      tree.add(pointer to fresh data, number of new bytes);
+    std::string root = tree.getHash();
+    auto leaves      = tree.getLeaves();   // e.g. sent along with the file
+
+    // later, check bytes [offset, offset + size) of the file
+    bool ok = tree.verifyRange(leaves, offset, data, size);
+  */
+class SHA256Tree : public Hash {
+public:
+    /// fixed leaf size: 1 MiB
+    enum { LeafSize = 1 << 20, HashBytes = SHA256::HashBytes };
+
+    typedef std::array<uint8_t, HashBytes> Digest;
+
+    explicit SHA256Tree(ThreadPool& pool = ThreadPool::shared());
+
+    /// compute the tree hash of a memory block
+    std::string operator()(const void* data, size_t numBytes);
+    /// compute the tree hash of a string, excluding final zero
+    std::string operator()(const std::string& text);
+
+    /// add arbitrary number of bytes
+    void add(const void* data, size_t numBytes);
+
+    /// return root hash as 64 hex characters
+    std::string getHash();
+    /// return root hash as bytes
+    void getHash(unsigned char buffer[HashBytes]);
+    /// return hashes of all leaves, including the unfinished last one
+    std::vector<Digest> getLeaves();
+
+    /// restart
+    void reset();
+
+    /// check that data at a leaf-aligned offset matches the given leaf hashes;
+    /// a range may end mid-leaf only at the end of the file
+    bool verifyRange(const std::vector<Digest>& leaves, uint64_t offset,
+        const void* data, size_t numBytes);
+
+    static Digest hashLeaf(const void* data, size_t numBytes);
+    static Digest hashNode(const Digest& left, const Digest& right);
+    /// fold leaf hashes into the root hash
+    static Digest root(std::vector<Digest> leaves);
+
+private:
+    /// hash consecutive full leaves in parallel
+    void hashLeaves(const uint8_t* data, size_t count);
+    /// hash all full leaves waiting in m_buffer
+    void flushBuffer();
+
+    ThreadPool& m_pool;
+    /// finished leaves
+    std::vector<Digest> m_leaves;
+    /// pending data, a batch of leaves is hashed at once
+    std::vector<uint8_t> m_buffer;
+    /// valid bytes in m_buffer
+    size_t m_bufferSize;
+};
@@ -0,0 +1,92 @@
+// //////////////////////////////////////////////////////////
+// sha512.h
+// SHA-512 and SHA-512/256 (FIPS 180-4), same interface as SHA256
+//
+
+#pragma once
+
+#include "hash.h"
+#include <string>
+#include <stdint.h>
+
+
+/// compute SHA512 hash
+/** Usage:
+    SHA512 sha512;
+    std::string myHash  = sha512("Hello World");     // std::string
+    std::string myHash2 = sha512("How are you", 11); // arbitrary data, 11 bytes
+
+    // or in a streaming fashion:
+
+    SHA512 sha512;
+    while (more data available)
+      sha512.add(pointer to fresh data, number of new bytes);
+    std::string myHash3 = sha512.getHash();
+
+    64-bit words and 128 byte blocks: on 64-bit hosts this is usually
+    faster per byte than the portable SHA256 for large inputs.
+  */
+class SHA512 : public Hash
+{
+public:
+  /// split into 128 byte blocks (=> 1024 bits), hash is 64 bytes long
+  enum { BlockSize = 1024 / 8, HashBytes = 64 };
+
+  /// same as reset()
+  SHA512();
+
+  /// compute SHA512 of a memory block
+  std::string operator()(const void* data, size_t numBytes);
+  /// compute SHA512 of a string, excluding final zero
+  std::string operator()(const std::string& text);
+
+  /// add arbitrary number of bytes
+  void add(const void* data, size_t numBytes);
+
+  /// return latest hash as hex characters
+  std::string getHash();
+  /// return latest hash as bytes, hashBytes() of them
+  void        getHash(unsigned char* buffer);
+
+  /// restart
+  void reset();
+
+  /// length of the digest in bytes
+  size_t hashBytes() const;
+
+protected:
+  /// SHA-512 variant with its own initial hash values and truncated output
+  SHA512(const uint64_t initialHash[8], size_t hashBytes);
+
+private:
+  /// process numBlocks consecutive 128 byte blocks
+  void processBlocks(const void* data, size_t numBlocks);
+  /// process everything left in the internal buffer
+  void processBuffer();
+
+  /// size of processed data in bytes
+  uint64_t m_numBytes;
+  /// valid bytes in m_buffer
+  size_t   m_bufferSize;
+  /// bytes not processed yet
+  uint8_t  m_buffer[BlockSize];
+
+  enum { HashValues = HashBytes / 8 };
+  /// hash, stored as integers
+  uint64_t m_hash[HashValues];
+  /// values used by reset()
+  const uint64_t* m_initialHash;
+  /// digest length, 64 for SHA-512
+  size_t   m_hashBytes;
+};
+
+
+/// compute SHA-512/256: SHA512 with different initial values, truncated to 32 bytes
+class SHA512_256 : public SHA512
+{
+public:
+  enum { HashBytes = 32 };
+
+  /// same as reset()
+  SHA512_256();
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads.
+// parallel_for() splits [0, count) between the workers and the calling thread
+// and returns when every index has been processed.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    // Number of threads taking part in parallel_for (workers + caller)
+    size_t size() const { return m_workers.size() + 1; }
+
+    void parallel_for(size_t count, const std::function<void(size_t)>& task);
+
+    // Process-wide pool sized to the number of hardware threads
+    static ThreadPool& shared();
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop;
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+};
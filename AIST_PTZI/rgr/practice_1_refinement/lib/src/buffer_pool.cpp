@@ -0,0 +1,175 @@
+#include "buffer_pool.h"
+
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const size_t HUGE_PAGE = 2u << 20;
+
+size_t round_up(size_t size, size_t granule)
+{
+    return (size + granule - 1) / granule * granule;
+}
+
+size_t page_size()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+}
+
+BufferPool::BufferPool(bool huge_pages)
+    : m_huge_pages(huge_pages)
+    , m_allocations(0)
+{
+}
+
+BufferPool::~BufferPool()
+{
+    // Buffers still handed out must not outlive the pool
+    for (const Block& block : m_free)
+        unmap(block);
+}
+
+BufferPool& BufferPool::shared()
+{
+    static BufferPool pool;
+    return pool;
+}
+
+size_t BufferPool::allocations() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocations;
+}
+
+BufferPool::Buffer BufferPool::acquire(size_t size)
+{
+    {
+        // the smallest free block that fits
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t best = m_free.size();
+        for (size_t i = 0; i < m_free.size(); i++) {
+            if (m_free[i].capacity >= size && (best == m_free.size() || m_free[i].capacity < m_free[best].capacity))
+                best = i;
+        }
+        if (best != m_free.size()) {
+            Block block = m_free[best];
+            m_free[best] = m_free.back();
+            m_free.pop_back();
+            return Buffer(this, block, size);
+        }
+    }
+
+    Block block = create(size);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocations++;
+    return Buffer(this, block, size);
+}
+
+BufferPool::Block BufferPool::create(size_t size)
+{
+    bool huge = m_huge_pages && size >= HUGE_PAGE;
+    size_t capacity = round_up(size > 0 ? size : 1, huge ? HUGE_PAGE : page_size());
+    Block block = { nullptr, capacity, nullptr, capacity };
+
+#ifdef _WIN32
+    // Large pages need a privilege most accounts lack, normal pages then
+    block.mapping = VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!block.mapping)
+        throw std::bad_alloc();
+    block.data = static_cast<uint8_t*>(block.mapping);
+#else
+    // One huge page more than needed, to start on a 2 MiB boundary
+    if (huge)
+        block.mapping_size = capacity + HUGE_PAGE;
+    block.mapping = mmap(nullptr, block.mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block.mapping == MAP_FAILED)
+        throw std::bad_alloc();
+    block.data = static_cast<uint8_t*>(block.mapping);
+    if (huge) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(block.mapping);
+        block.data += round_up(address, HUGE_PAGE) - address;
+#ifdef MADV_HUGEPAGE
+        madvise(block.data, capacity, MADV_HUGEPAGE);
+#endif
+    }
+#endif
+
+    // Pre-fault: write every page now rather than during the first transfer
+    memset(block.data, 0, capacity);
+    return block;
+}
+
+void BufferPool::release(const Block& block)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(block);
+}
+
+void BufferPool::unmap(const Block& block)
+{
+#ifdef _WIN32
+    VirtualFree(block.mapping, 0, MEM_RELEASE);
+#else
+    munmap(block.mapping, block.mapping_size);
+#endif
+}
+
+BufferPool::Buffer::Buffer()
+    : m_pool(nullptr)
+    , m_block()
+    , m_size(0)
+{
+}
+
+BufferPool::Buffer::Buffer(BufferPool* pool, const Block& block, size_t size)
+    : m_pool(pool)
+    , m_block(block)
+    , m_size(size)
+{
+}
+
+BufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_block(other.m_block)
+    , m_size(other.m_size)
+{
+    other.m_pool = nullptr;
+}
+
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        m_pool = other.m_pool;
+        m_block = other.m_block;
+        m_size = other.m_size;
+        other.m_pool = nullptr;
+    }
+    return *this;
+}
+
+BufferPool::Buffer::~Buffer()
+{
+    reset();
+}
+
+void BufferPool::Buffer::reset()
+{
+    if (m_pool)
+        m_pool->release(m_block);
+    m_pool = nullptr;
+}
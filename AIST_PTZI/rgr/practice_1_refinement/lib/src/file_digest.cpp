@@ -0,0 +1,108 @@
+#include "file_digest.h"
+
+#include "buffer_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// Window mapped at once, bounds the address space used for any file size
+const uint64_t MAP_WINDOW = 64ull << 20;
+// Chunk size for the read() fallback; page-aligned buffers from the pool
+const size_t READ_CHUNK = 1 << 20;
+
+#ifndef _WIN32
+// Returns false if the file cannot be mapped (e.g. a pipe), nothing is hashed then
+bool hash_mapped(int fd, uint64_t size, Hash& hasher)
+{
+    for (uint64_t offset = 0; offset < size; offset += MAP_WINDOW) {
+        size_t length = static_cast<size_t>(std::min(MAP_WINDOW, size - offset));
+        void* window = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+        if (window == MAP_FAILED) {
+            if (offset == 0)
+                return false;
+            throw std::runtime_error("Failed to map file");
+        }
+        madvise(window, length, MADV_SEQUENTIAL);
+
+        hasher.add(window, length);
+
+        munmap(window, length);
+    }
+    return true;
+}
+
+uint64_t hash_read(int fd, Hash& hasher)
+{
+    auto chunk = BufferPool::shared().acquire(READ_CHUNK);
+    uint64_t total = 0;
+    for (;;) {
+        ssize_t bytes = read(fd, chunk.data(), READ_CHUNK);
+        if (bytes < 0)
+            throw std::runtime_error("Failed to read file");
+        if (bytes == 0)
+            break;
+        hasher.add(chunk.data(), static_cast<size_t>(bytes));
+        total += static_cast<uint64_t>(bytes);
+    }
+    return total;
+}
+#endif
+}
+
+FileDigest hash_file(const std::string& path, Hash& hasher)
+{
+    FileDigest result = { "", 0, 0, false };
+    auto start = std::chrono::steady_clock::now();
+
+    hasher.reset();
+
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("Could not open file for reading: " + path);
+
+    auto chunk = BufferPool::shared().acquire(READ_CHUNK);
+    while (file) {
+        file.read(reinterpret_cast<char*>(chunk.data()), READ_CHUNK);
+        auto bytes = file.gcount();
+        if (bytes <= 0)
+            break;
+        hasher.add(chunk.data(), static_cast<size_t>(bytes));
+        result.bytes += static_cast<uint64_t>(bytes);
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open file for reading: " + path);
+
+    try {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0
+            && hash_mapped(fd, static_cast<uint64_t>(info.st_size), hasher)) {
+            result.bytes = static_cast<uint64_t>(info.st_size);
+            result.mapped = true;
+        } else {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            result.bytes = hash_read(fd, hasher);
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+#endif
+
+    result.hash = hasher.getHash();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
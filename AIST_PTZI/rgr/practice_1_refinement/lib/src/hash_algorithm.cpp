@@ -0,0 +1,65 @@
+#include "hash_algorithm.h"
+#include "sha256.h"
+#include "sha256_tree.h"
+#include "sha512.h"
+
+#include <stdexcept>
+
+HashAlgorithm parse_hash_algorithm(const std::string& name)
+{
+    if (name == "sha256") {
+        return HashAlgorithm::SHA256;
+    } else if (name == "sha512") {
+        return HashAlgorithm::SHA512;
+    } else if (name == "sha512-256") {
+        return HashAlgorithm::SHA512_256;
+    } else {
+        throw std::invalid_argument("Unknown hash algorithm: " + name);
+    }
+}
+
+std::string hash_algorithm_name(HashAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case HashAlgorithm::SHA256:
+        return "sha256";
+    case HashAlgorithm::SHA512:
+        return "sha512";
+    case HashAlgorithm::SHA512_256:
+        return "sha512-256";
+    }
+    throw std::invalid_argument("Unknown hash algorithm");
+}
+
+size_t hash_digest_bytes(HashAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case HashAlgorithm::SHA256:
+        return SHA256::HashBytes;
+    case HashAlgorithm::SHA512:
+        return SHA512::HashBytes;
+    case HashAlgorithm::SHA512_256:
+        return SHA512_256::HashBytes;
+    }
+    throw std::invalid_argument("Unknown hash algorithm");
+}
+
+std::unique_ptr<Hash> make_hash(HashAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case HashAlgorithm::SHA256:
+        return std::unique_ptr<Hash>(new SHA256());
+    case HashAlgorithm::SHA512:
+        return std::unique_ptr<Hash>(new SHA512());
+    case HashAlgorithm::SHA512_256:
+        return std::unique_ptr<Hash>(new SHA512_256());
+    }
+    throw std::invalid_argument("Unknown hash algorithm");
+}
+
+std::unique_ptr<Hash> make_file_hash(HashAlgorithm algorithm)
+{
+    if (algorithm == HashAlgorithm::SHA256)
+        return std::unique_ptr<Hash>(new SHA256Tree());
+    return make_hash(algorithm);
+}
@@ -5,6 +5,10 @@
 //
 
 #include "sha256.h"
+#include "sha256_kernels.h"
+
+#include <algorithm>
+#include <cstring>
 
 // big endian architectures need #define __BYTE_ORDER __BIG_ENDIAN
 // #ifndef _MSC_VER
@@ -16,12 +20,19 @@
 #endif
 #endif
 
-/// same as reset()
-SHA256::SHA256()
+/// same as reset(), Auto picks SHA-NI when the CPU supports it
+SHA256::SHA256(Implementation implementation)
+    : m_accelerated(implementation != Portable && sha256_shani_supported())
 {
     reset();
 }
 
+/// true if blocks are compressed with the SHA-NI instructions
+bool SHA256::isAccelerated() const
+{
+    return m_accelerated;
+}
+
 /// restart
 void SHA256::reset()
 {
@@ -86,16 +97,15 @@ void SHA256::processBlock(const void* data)
     uint32_t g = m_hash[6];
     uint32_t h = m_hash[7];
 
-    // data represented as 16x 32-bit words
-    const uint32_t* input = (uint32_t*)data;
-    // convert to big endian
+    // data represented as 16x 32-bit words, copied because blocks may come
+    // straight from the caller's memory at any alignment
     uint32_t words[64];
+    memcpy(words, data, 16 * sizeof(uint32_t));
     int i;
+#if !(defined(__BYTE_ORDER) && (__BYTE_ORDER != 0) && (__BYTE_ORDER == __BIG_ENDIAN))
+    // convert to big endian
     for (i = 0; i < 16; i++)
-#if defined(__BYTE_ORDER) && (__BYTE_ORDER != 0) && (__BYTE_ORDER == __BIG_ENDIAN)
-        words[i] = input[i];
-#else
-        words[i] = swap(input[i]);
+        words[i] = swap(words[i]);
 #endif
 
     uint32_t x, y; // temporaries
@@ -407,42 +417,56 @@ void SHA256::processBlock(const void* data)
     m_hash[7] += h;
 }
 
+/// process numBlocks consecutive 64 byte blocks
+void SHA256::processBlocks(const void* data, size_t numBlocks)
+{
+    if (m_accelerated) {
+        sha256_shani_blocks(m_hash, data, numBlocks);
+        return;
+    }
+
+    const uint8_t* current = (const uint8_t*)data;
+    for (size_t i = 0; i < numBlocks; i++, current += BlockSize)
+        processBlock(current);
+}
+
 /// add arbitrary number of bytes
 void SHA256::add(const void* data, size_t numBytes)
 {
+    // data may be null then, which memcpy does not allow even for 0 bytes
+    if (numBytes == 0)
+        return;
+
     const uint8_t* current = (const uint8_t*)data;
 
+    // complete a partially filled buffer first
     if (m_bufferSize > 0) {
-        while (numBytes > 0 && m_bufferSize < BlockSize) {
-            m_buffer[m_bufferSize++] = *current++;
-            numBytes--;
-        }
-    }
+        size_t take = std::min(numBytes, BlockSize - m_bufferSize);
+        memcpy(m_buffer + m_bufferSize, current, take);
+        m_bufferSize += take;
+        current += take;
+        numBytes -= take;
+
+        if (m_bufferSize < BlockSize)
+            return;
 
-    // full buffer
-    if (m_bufferSize == BlockSize) {
-        processBlock(m_buffer);
+        processBlocks(m_buffer, 1);
         m_numBytes += BlockSize;
         m_bufferSize = 0;
     }
 
-    // no more data ?
-    if (numBytes == 0)
-        return;
-
-    // process full blocks
-    while (numBytes >= BlockSize) {
-        processBlock(current);
-        current += BlockSize;
-        m_numBytes += BlockSize;
-        numBytes -= BlockSize;
+    // full blocks straight from the caller's memory
+    size_t numBlocks = numBytes / BlockSize;
+    if (numBlocks > 0) {
+        processBlocks(current, numBlocks);
+        current += numBlocks * BlockSize;
+        m_numBytes += numBlocks * BlockSize;
+        numBytes -= numBlocks * BlockSize;
     }
 
     // keep remaining bytes in buffer
-    while (numBytes > 0) {
-        m_buffer[m_bufferSize++] = *current++;
-        numBytes--;
-    }
+    memcpy(m_buffer, current, numBytes);
+    m_bufferSize = numBytes;
 }
 
 /// process final block, less than 64 bytes
@@ -504,10 +528,10 @@ void SHA256::processBuffer()
     *addLength = (unsigned char)(msgBits & 0xFF);
 
     // process blocks
-    processBlock(m_buffer);
+    processBlocks(m_buffer, 1);
     // flowed over into a second block ?
     if (paddedLength > BlockSize)
-        processBlock(extra);
+        processBlocks(extra, 1);
 }
 
 /// return latest hash as 64 hex characters
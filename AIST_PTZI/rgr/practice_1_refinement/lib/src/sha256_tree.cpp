@@ -0,0 +1,205 @@
+#include "sha256_tree.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const uint8_t LeafPrefix = 0x00;
+const uint8_t NodePrefix = 0x01;
+
+std::string toHex(const SHA256Tree::Digest& digest)
+{
+    static const char dec2hex[16 + 1] = "0123456789abcdef";
+    std::string result;
+    result.reserve(2 * digest.size());
+    for (uint8_t byte : digest) {
+        result += dec2hex[(byte >> 4) & 15];
+        result += dec2hex[byte & 15];
+    }
+    return result;
+}
+}
+
+SHA256Tree::SHA256Tree(ThreadPool& pool)
+    : m_pool(pool)
+    , m_bufferSize(0)
+{
+}
+
+void SHA256Tree::reset()
+{
+    m_leaves.clear();
+    m_bufferSize = 0;
+}
+
+SHA256Tree::Digest SHA256Tree::hashLeaf(const void* data, size_t numBytes)
+{
+    SHA256 sha256;
+    sha256.add(&LeafPrefix, 1);
+    sha256.add(data, numBytes);
+
+    Digest digest;
+    sha256.getHash(digest.data());
+    return digest;
+}
+
+SHA256Tree::Digest SHA256Tree::hashNode(const Digest& left, const Digest& right)
+{
+    SHA256 sha256;
+    sha256.add(&NodePrefix, 1);
+    sha256.add(left.data(), left.size());
+    sha256.add(right.data(), right.size());
+
+    Digest digest;
+    sha256.getHash(digest.data());
+    return digest;
+}
+
+SHA256Tree::Digest SHA256Tree::root(std::vector<Digest> level)
+{
+    if (level.empty())
+        return hashLeaf(nullptr, 0);
+
+    while (level.size() > 1) {
+        size_t next = 0;
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+            level[next++] = hashNode(level[i], level[i + 1]);
+        // odd node is promoted
+        if (level.size() % 2 != 0)
+            level[next++] = level.back();
+        level.resize(next);
+    }
+    return level[0];
+}
+
+void SHA256Tree::hashLeaves(const uint8_t* data, size_t count)
+{
+    size_t first = m_leaves.size();
+    m_leaves.resize(first + count);
+    m_pool.parallel_for(count, [&](size_t i) {
+        m_leaves[first + i] = hashLeaf(data + i * LeafSize, LeafSize);
+    });
+}
+
+void SHA256Tree::flushBuffer()
+{
+    size_t full = m_bufferSize / LeafSize;
+    if (full == 0)
+        return;
+
+    hashLeaves(m_buffer.data(), full);
+
+    // keep the unfinished leaf
+    size_t rest = m_bufferSize - full * LeafSize;
+    if (rest > 0)
+        memmove(m_buffer.data(), m_buffer.data() + full * LeafSize, rest);
+    m_bufferSize = rest;
+}
+
+/// add arbitrary number of bytes
+void SHA256Tree::add(const void* data, size_t numBytes)
+{
+    // data may be null then, which memcpy does not allow even for 0 bytes
+    if (numBytes == 0)
+        return;
+
+    const uint8_t* current = (const uint8_t*)data;
+
+    // enough room for one leaf per thread, twice
+    if (m_buffer.empty())
+        m_buffer.resize(2 * m_pool.size() * LeafSize);
+
+    // complete the leaf under construction
+    size_t partial = m_bufferSize % LeafSize;
+    if (partial > 0) {
+        size_t take = std::min(numBytes, LeafSize - partial);
+        memcpy(m_buffer.data() + m_bufferSize, current, take);
+        m_bufferSize += take;
+        current += take;
+        numBytes -= take;
+    }
+
+    if (m_bufferSize == m_buffer.size())
+        flushBuffer();
+
+    // whole leaves are hashed straight from the caller's memory
+    size_t full = numBytes / LeafSize;
+    if (full > 0) {
+        flushBuffer();
+        hashLeaves(current, full);
+        current += full * LeafSize;
+        numBytes -= full * LeafSize;
+    }
+
+    // keep remaining bytes, m_buffer is leaf aligned and not full here
+    if (numBytes > 0) {
+        memcpy(m_buffer.data() + m_bufferSize, current, numBytes);
+        m_bufferSize += numBytes;
+    }
+}
+
+/// return hashes of all leaves, including the unfinished last one
+std::vector<SHA256Tree::Digest> SHA256Tree::getLeaves()
+{
+    flushBuffer();
+
+    std::vector<Digest> leaves = m_leaves;
+    if (m_bufferSize > 0 || leaves.empty())
+        leaves.push_back(hashLeaf(m_buffer.data(), m_bufferSize));
+    return leaves;
+}
+
+/// return root hash as bytes
+void SHA256Tree::getHash(unsigned char buffer[HashBytes])
+{
+    Digest digest = root(getLeaves());
+    memcpy(buffer, digest.data(), HashBytes);
+}
+
+/// return root hash as 64 hex characters
+std::string SHA256Tree::getHash()
+{
+    return toHex(root(getLeaves()));
+}
+
+/// compute the tree hash of a memory block
+std::string SHA256Tree::operator()(const void* data, size_t numBytes)
+{
+    reset();
+    add(data, numBytes);
+    return getHash();
+}
+
+/// compute the tree hash of a string, excluding final zero
+std::string SHA256Tree::operator()(const std::string& text)
+{
+    return (*this)(text.c_str(), text.size());
+}
+
+bool SHA256Tree::verifyRange(const std::vector<Digest>& leaves, uint64_t offset,
+    const void* data, size_t numBytes)
+{
+    if (offset % LeafSize != 0)
+        return false;
+
+    size_t first = offset / LeafSize;
+    size_t count = (numBytes + LeafSize - 1) / LeafSize;
+    if (numBytes == 0)
+        count = (first == 0 && leaves.size() == 1) ? 1 : 0;
+    if (first + count > leaves.size())
+        return false;
+
+    // a short leaf is only allowed at the very end of the file
+    bool shortTail = numBytes % LeafSize != 0;
+    if (shortTail && first + count != leaves.size())
+        return false;
+
+    const uint8_t* current = (const uint8_t*)data;
+    std::vector<char> matches(count, 0);
+    m_pool.parallel_for(count, [&](size_t i) {
+        size_t size = std::min<size_t>(LeafSize, numBytes - i * LeafSize);
+        matches[i] = hashLeaf(current + i * LeafSize, size) == leaves[first + i];
+    });
+
+    return std::all_of(matches.begin(), matches.end(), [](char ok) { return ok != 0; });
+}
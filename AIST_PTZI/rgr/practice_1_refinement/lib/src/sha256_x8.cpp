@@ -0,0 +1,187 @@
+#include "sha256_kernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+namespace {
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define SHA256_X8 __attribute__((target("avx2")))
+
+SHA256_X8 inline __m256i rotr(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// rows[i] holds eight consecutive words of lane i, afterwards rows[j] holds word j of every lane
+SHA256_X8 inline void transpose8(__m256i rows[8])
+{
+    __m256i t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    rows[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    rows[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    rows[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    rows[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    rows[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    rows[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    rows[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    rows[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// process one 64-byte block of every lane, state[j] holds word j of all lanes
+SHA256_X8 void processBlock8(__m256i state[8], const uint8_t* const blocks[8])
+{
+    const __m256i bswap = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    __m256i w[16];
+    for (int half = 0; half < 2; half++) {
+        __m256i* rows = w + 8 * half;
+        for (int lane = 0; lane < 8; lane++)
+            rows[lane] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(blocks[lane] + 32 * half)), bswap);
+        transpose8(rows);
+    }
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; i++) {
+        // extend the message schedule in place, w[] is a ring of 16 words
+        if (i >= 16) {
+            __m256i w15 = w[(i + 1) & 15];
+            __m256i w2 = w[(i + 14) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr(w15, 7), rotr(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr(w2, 17), rotr(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i + 9) & 15], s1));
+        }
+
+        __m256i sum1 = _mm256_xor_si256(_mm256_xor_si256(rotr(e, 6), rotr(e, 11)), rotr(e, 25));
+        __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sum1),
+            _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32((int)K[i]), w[i & 15])));
+        __m256i sum0 = _mm256_xor_si256(_mm256_xor_si256(rotr(a, 2), rotr(a, 13)), rotr(a, 22));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(sum0, maj);
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    state[0] = _mm256_add_epi32(state[0], a);
+    state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c);
+    state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e);
+    state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g);
+    state[7] = _mm256_add_epi32(state[7], h);
+}
+}
+
+bool sha256_x8_supported()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+SHA256_X8 void sha256_x8(const void* const data[8], size_t numBytes, unsigned char hashes[8][32])
+{
+    __m256i state[8];
+    for (int j = 0; j < 8; j++)
+        state[j] = _mm256_set1_epi32((int)H0[j]);
+
+    // full blocks straight from the callers' memory
+    const uint8_t* blocks[8];
+    for (int lane = 0; lane < 8; lane++)
+        blocks[lane] = (const uint8_t*)data[lane];
+
+    size_t numBlocks = numBytes / 64;
+    for (size_t i = 0; i < numBlocks; i++) {
+        processBlock8(state, blocks);
+        for (int lane = 0; lane < 8; lane++)
+            blocks[lane] += 64;
+    }
+
+    // same padding as SHA256::processBuffer, one or two final blocks per lane
+    size_t rest = numBytes % 64;
+    size_t paddedBlocks = rest + 1 + 8 <= 64 ? 1 : 2;
+    uint64_t numBits = (uint64_t)numBytes * 8;
+
+    uint8_t tail[8][128];
+    for (int lane = 0; lane < 8; lane++) {
+        memcpy(tail[lane], blocks[lane], rest);
+        tail[lane][rest] = 0x80;
+        memset(tail[lane] + rest + 1, 0, 64 * paddedBlocks - rest - 1);
+        for (int i = 0; i < 8; i++)
+            tail[lane][64 * paddedBlocks - 1 - i] = (uint8_t)(numBits >> (8 * i));
+    }
+
+    for (size_t i = 0; i < paddedBlocks; i++) {
+        for (int lane = 0; lane < 8; lane++)
+            blocks[lane] = tail[lane] + 64 * i;
+        processBlock8(state, blocks);
+    }
+
+    alignas(32) uint32_t words[8][8];
+    for (int j = 0; j < 8; j++)
+        _mm256_store_si256((__m256i*)words[j], state[j]);
+
+    for (int lane = 0; lane < 8; lane++)
+        for (int j = 0; j < 8; j++) {
+            hashes[lane][4 * j + 0] = (unsigned char)(words[j][lane] >> 24);
+            hashes[lane][4 * j + 1] = (unsigned char)(words[j][lane] >> 16);
+            hashes[lane][4 * j + 2] = (unsigned char)(words[j][lane] >> 8);
+            hashes[lane][4 * j + 3] = (unsigned char)(words[j][lane]);
+        }
+}
+
+#else
+
+bool sha256_x8_supported()
+{
+    return false;
+}
+
+void sha256_x8(const void* const*, size_t, unsigned char (*)[32])
+{
+}
+
+#endif
@@ -0,0 +1,271 @@
+// //////////////////////////////////////////////////////////
+// sha512.cpp
+// SHA-512 and SHA-512/256 (FIPS 180-4)
+//
+
+#include "sha512.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// FIPS 180-4, 5.3.5
+const uint64_t SHA512Initial[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+// FIPS 180-4, 5.3.6.2
+const uint64_t SHA512_256Initial[8] = {
+    0x22312194fc2bf72cULL, 0x9f555fa3c84c64c2ULL, 0x2393b86b6f53b151ULL, 0x963877195940eabdULL,
+    0x96283ee2a88effe3ULL, 0xbe5e1e2553863992ULL, 0x2b0199fc2c85b8aaULL, 0x0eb72ddc81c52ca2ULL
+};
+
+const uint64_t K[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+inline uint64_t rotate(uint64_t a, uint64_t c)
+{
+    return (a >> c) | (a << (64 - c));
+}
+
+// read 8 bytes as big endian
+inline uint64_t load64(const uint8_t* p)
+{
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+#if defined(__GNUC__) || defined(__clang__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+#else
+    x = ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32)
+        | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) | ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+#endif
+    return x;
+}
+}
+
+/// same as reset()
+SHA512::SHA512()
+    : m_initialHash(SHA512Initial)
+    , m_hashBytes(HashBytes)
+{
+    reset();
+}
+
+/// SHA-512 variant with its own initial hash values and truncated output
+SHA512::SHA512(const uint64_t initialHash[8], size_t hashBytes)
+    : m_initialHash(initialHash)
+    , m_hashBytes(hashBytes)
+{
+    reset();
+}
+
+/// same as reset()
+SHA512_256::SHA512_256()
+    : SHA512(SHA512_256Initial, HashBytes)
+{
+}
+
+/// restart
+void SHA512::reset()
+{
+    m_numBytes = 0;
+    m_bufferSize = 0;
+    for (int i = 0; i < HashValues; i++)
+        m_hash[i] = m_initialHash[i];
+}
+
+/// length of the digest in bytes
+size_t SHA512::hashBytes() const
+{
+    return m_hashBytes;
+}
+
+/// process numBlocks consecutive 128 byte blocks
+void SHA512::processBlocks(const void* data, size_t numBlocks)
+{
+    const uint8_t* current = (const uint8_t*)data;
+
+    for (; numBlocks > 0; numBlocks--, current += BlockSize) {
+        uint64_t a = m_hash[0];
+        uint64_t b = m_hash[1];
+        uint64_t c = m_hash[2];
+        uint64_t d = m_hash[3];
+        uint64_t e = m_hash[4];
+        uint64_t f = m_hash[5];
+        uint64_t g = m_hash[6];
+        uint64_t h = m_hash[7];
+
+        // message schedule, 16 words kept in a ring
+        uint64_t words[16];
+        for (int i = 0; i < 16; i++)
+            words[i] = load64(current + 8 * i);
+
+        for (int i = 0; i < 80; i++) {
+            if (i >= 16) {
+                uint64_t w15 = words[(i + 1) & 15];
+                uint64_t w2 = words[(i + 14) & 15];
+                uint64_t s0 = rotate(w15, 1) ^ rotate(w15, 8) ^ (w15 >> 7);
+                uint64_t s1 = rotate(w2, 19) ^ rotate(w2, 61) ^ (w2 >> 6);
+                words[i & 15] += s0 + words[(i + 9) & 15] + s1;
+            }
+
+            uint64_t x = h + (rotate(e, 14) ^ rotate(e, 18) ^ rotate(e, 41)) + (g ^ (e & (f ^ g))) + K[i] + words[i & 15];
+            uint64_t y = (rotate(a, 28) ^ rotate(a, 34) ^ rotate(a, 39)) + (((a | b) & c) | (a & b));
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + x;
+            d = c;
+            c = b;
+            b = a;
+            a = x + y;
+        }
+
+        m_hash[0] += a;
+        m_hash[1] += b;
+        m_hash[2] += c;
+        m_hash[3] += d;
+        m_hash[4] += e;
+        m_hash[5] += f;
+        m_hash[6] += g;
+        m_hash[7] += h;
+    }
+}
+
+/// add arbitrary number of bytes
+void SHA512::add(const void* data, size_t numBytes)
+{
+    // data may be null then, which memcpy does not allow even for 0 bytes
+    if (numBytes == 0)
+        return;
+
+    const uint8_t* current = (const uint8_t*)data;
+
+    // complete a partially filled buffer first
+    if (m_bufferSize > 0) {
+        size_t take = std::min(numBytes, BlockSize - m_bufferSize);
+        memcpy(m_buffer + m_bufferSize, current, take);
+        m_bufferSize += take;
+        current += take;
+        numBytes -= take;
+
+        if (m_bufferSize < BlockSize)
+            return;
+
+        processBlocks(m_buffer, 1);
+        m_numBytes += BlockSize;
+        m_bufferSize = 0;
+    }
+
+    // full blocks straight from the caller's memory
+    size_t numBlocks = numBytes / BlockSize;
+    if (numBlocks > 0) {
+        processBlocks(current, numBlocks);
+        current += numBlocks * BlockSize;
+        m_numBytes += numBlocks * BlockSize;
+        numBytes -= numBlocks * BlockSize;
+    }
+
+    // keep remaining bytes in buffer
+    memcpy(m_buffer, current, numBytes);
+    m_bufferSize = numBytes;
+}
+
+/// process final block, less than 128 bytes
+void SHA512::processBuffer()
+{
+    // append a "1" bit, zeros and the message length as 128 bit big endian number;
+    // one extra block if the length doesn't fit behind the data
+    uint8_t padded[2 * BlockSize];
+    memcpy(padded, m_buffer, m_bufferSize);
+    padded[m_bufferSize] = 0x80;
+
+    size_t numBlocks = m_bufferSize + 1 + 16 <= BlockSize ? 1 : 2;
+    size_t length = numBlocks * BlockSize;
+    memset(padded + m_bufferSize + 1, 0, length - m_bufferSize - 1);
+
+    // upper 64 bits of the length are always zero here
+    uint64_t msgBits = 8 * (m_numBytes + m_bufferSize);
+    for (int i = 0; i < 8; i++)
+        padded[length - 1 - i] = (uint8_t)(msgBits >> (8 * i));
+
+    processBlocks(padded, numBlocks);
+}
+
+/// return latest hash as hex characters
+std::string SHA512::getHash()
+{
+    // compute hash (as raw bytes)
+    unsigned char rawHash[HashBytes];
+    getHash(rawHash);
+
+    // convert to hex string
+    std::string result;
+    result.reserve(2 * m_hashBytes);
+    for (size_t i = 0; i < m_hashBytes; i++) {
+        static const char dec2hex[16 + 1] = "0123456789abcdef";
+        result += dec2hex[(rawHash[i] >> 4) & 15];
+        result += dec2hex[rawHash[i] & 15];
+    }
+
+    return result;
+}
+
+/// return latest hash as bytes, hashBytes() of them
+void SHA512::getHash(unsigned char* buffer)
+{
+    // save old hash if buffer is partially filled
+    uint64_t oldHash[HashValues];
+    for (int i = 0; i < HashValues; i++)
+        oldHash[i] = m_hash[i];
+
+    // process remaining bytes
+    processBuffer();
+
+    for (size_t i = 0; i < m_hashBytes; i++)
+        buffer[i] = (unsigned char)(m_hash[i / 8] >> (56 - 8 * (i % 8)));
+
+    // restore old hash
+    for (int i = 0; i < HashValues; i++)
+        m_hash[i] = oldHash[i];
+}
+
+/// compute SHA512 of a memory block
+std::string SHA512::operator()(const void* data, size_t numBytes)
+{
+    reset();
+    add(data, numBytes);
+    return getHash();
+}
+
+/// compute SHA512 of a string, excluding final zero
+std::string SHA512::operator()(const std::string& text)
+{
+    reset();
+    add(text.c_str(), text.size());
+    return getHash();
+}
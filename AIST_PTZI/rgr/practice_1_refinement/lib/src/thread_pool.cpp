@@ -0,0 +1,101 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t threads)
+    : m_stop(false)
+{
+    // The calling thread always takes part, so one thread less is enough
+    size_t workers = threads > 1 ? threads - 1 : 0;
+    for (size_t i = 0; i < workers; i++)
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::worker_loop()
+{
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&]() { return m_stop || !m_jobs.empty(); });
+            if (m_stop && m_jobs.empty())
+                return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+        job();
+    }
+}
+
+namespace {
+struct ParallelForState {
+    std::atomic<size_t> next { 0 };
+    std::atomic<size_t> done { 0 };
+    size_t count = 0;
+    const std::function<void(size_t)>* task = nullptr;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // Take indices until none are left
+    void run()
+    {
+        size_t i;
+        while ((i = next.fetch_add(1)) < count) {
+            (*task)(i);
+            if (done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0)
+        return;
+
+    if (count == 1 || m_workers.empty()) {
+        for (size_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    // Helpers may be scheduled after all work is done, so the state is shared
+    auto state = std::make_shared<ParallelForState>();
+    state->count = count;
+    state->task = &task;
+
+    size_t helpers = std::min(m_workers.size(), count - 1);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < helpers; i++)
+            m_jobs.push([state]() { state->run(); });
+    }
+    m_cv.notify_all();
+
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done.load() == count; });
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "file_digest.h"
+#include "hash_algorithm.h"
+#include "rdtsc.h"
+#include "sha256.h"
+#include "sha256_kernels.h"
+#include "sha512.h"
+
+// Usage: sha_bench [csv|json] [max_size_bytes]
+//        sha_bench file PATH [sha256|sha512|sha512-256]
+// Compares SHA-256 implementations and SHA-512 on the same inputs.
+// Sizes go from 0 B to max_size_bytes (1 GiB by default) in steps of 4x.
+// The file mode hashes a file from disk as the client does (SHA-256 is the
+// tree hash) and reports the throughput of mapping or reading it.
+
+namespace {
+const size_t MaxSizeDefault = size_t(1) << 30;
+// every sample hashes at least this many bytes, small messages are repeated
+const size_t SampleBytes = size_t(16) << 20;
+
+struct Stats {
+    double median = 0, mean = 0, stddev = 0, min = 0, max = 0;
+};
+
+struct Result {
+    std::string implementation;
+    size_t size;
+    size_t samples;
+    size_t iterations;
+    double ns_per_hash;
+    Stats cycles_per_byte;
+    Stats gbps;
+};
+
+// one hash of the first `size` bytes of the buffer
+typedef std::function<void(const uint8_t*, size_t)> HashFunc;
+
+struct Implementation {
+    std::string name;
+    HashFunc hash;
+};
+
+volatile uint8_t sink;
+
+Stats make_stats(std::vector<double> values)
+{
+    Stats stats;
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    stats.min = values.front();
+    stats.max = values.back();
+    stats.median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+
+    double sum = 0;
+    for (double v : values)
+        sum += v;
+    stats.mean = sum / n;
+
+    double sq = 0;
+    for (double v : values)
+        sq += (v - stats.mean) * (v - stats.mean);
+    stats.stddev = n > 1 ? std::sqrt(sq / (n - 1)) : 0;
+    return stats;
+}
+
+Result run(const Implementation& impl, const uint8_t* data, size_t size)
+{
+    size_t iterations = std::max<size_t>(1, SampleBytes / std::max<size_t>(size, SHA256::BlockSize));
+    size_t samples = size >= (size_t(256) << 20) ? 3 : 9;
+
+    // warm-up: caches, page faults, CPU frequency
+    for (size_t i = 0; i < iterations; i++)
+        impl.hash(data, size);
+
+    std::vector<double> cycles_per_byte, gbps, ns_per_hash;
+    for (size_t s = 0; s < samples; s++) {
+        auto start_time = std::chrono::steady_clock::now();
+        unsigned long long start = rdtsc();
+        for (size_t i = 0; i < iterations; i++)
+            impl.hash(data, size);
+        unsigned long long end = rdtsc();
+        auto end_time = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end_time - start_time).count();
+        double bytes = double(size) * iterations;
+        cycles_per_byte.push_back(bytes > 0 ? double(end - start) / bytes : 0);
+        gbps.push_back(bytes / seconds / 1e9);
+        ns_per_hash.push_back(seconds * 1e9 / iterations);
+    }
+
+    return { impl.name, size, samples, iterations, make_stats(ns_per_hash).median,
+        make_stats(cycles_per_byte), make_stats(gbps) };
+}
+
+std::vector<Implementation> implementations()
+{
+    std::vector<Implementation> result;
+
+    result.push_back({ "scalar", [](const uint8_t* data, size_t size) {
+                          SHA256 sha256(SHA256::Portable);
+                          unsigned char digest[SHA256::HashBytes];
+                          sha256.add(data, size);
+                          sha256.getHash(digest);
+                          sink = digest[0];
+                      } });
+
+    if (sha256_shani_supported())
+        result.push_back({ "sha-ni", [](const uint8_t* data, size_t size) {
+                              SHA256 sha256(SHA256::HardwareAccelerated);
+                              unsigned char digest[SHA256::HashBytes];
+                              sha256.add(data, size);
+                              sha256.getHash(digest);
+                              sink = digest[0];
+                          } });
+
+    result.push_back({ "sha512", [](const uint8_t* data, size_t size) {
+                          SHA512 sha512;
+                          unsigned char digest[SHA512::HashBytes];
+                          sha512.add(data, size);
+                          sha512.getHash(digest);
+                          sink = digest[0];
+                      } });
+
+    result.push_back({ "sha512-256", [](const uint8_t* data, size_t size) {
+                          SHA512_256 sha512;
+                          unsigned char digest[SHA512::HashBytes];
+                          sha512.add(data, size);
+                          sha512.getHash(digest);
+                          sink = digest[0];
+                      } });
+
+    // eight independent messages of size / 8 bytes each
+    if (sha256_x8_supported())
+        result.push_back({ "avx2-x8", [](const uint8_t* data, size_t size) {
+                              size_t part = size / 8;
+                              const void* parts[8];
+                              for (int i = 0; i < 8; i++)
+                                  parts[i] = data + i * part;
+                              unsigned char digests[8][32];
+                              sha256_x8(parts, part, digests);
+                              sink = digests[7][0];
+                          } });
+
+    return result;
+}
+
+// all implementations must agree with the portable code
+bool self_test(const uint8_t* data)
+{
+    const size_t sizes[] = { 0, 1, 55, 56, 63, 64, 65, 119, 120, 1000, 4096 + 17 };
+    for (size_t size : sizes) {
+        std::string expected = SHA256(SHA256::Portable)(data, size);
+        if (sha256_shani_supported() && SHA256(SHA256::HardwareAccelerated)(data, size) != expected)
+            return false;
+
+        if (sha256_x8_supported()) {
+            const void* parts[8];
+            for (int i = 0; i < 8; i++)
+                parts[i] = data + i * 31;
+            unsigned char digests[8][32];
+            sha256_x8(parts, size, digests);
+            for (int i = 0; i < 8; i++) {
+                unsigned char digest[SHA256::HashBytes];
+                SHA256 sha256(SHA256::Portable);
+                sha256.add(data + i * 31, size);
+                sha256.getHash(digest);
+                if (memcmp(digest, digests[i], sizeof(digest)) != 0)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void print_csv(const std::vector<Result>& results)
+{
+    std::cout << "implementation,size,samples,iterations,ns_per_hash,"
+                 "cycles_per_byte_median,cycles_per_byte_mean,cycles_per_byte_stddev,cycles_per_byte_min,"
+                 "gbps_median,gbps_mean,gbps_stddev,gbps_max\n";
+    for (const auto& r : results)
+        std::cout << r.implementation << ',' << r.size << ',' << r.samples << ',' << r.iterations << ','
+                  << r.ns_per_hash << ','
+                  << r.cycles_per_byte.median << ',' << r.cycles_per_byte.mean << ','
+                  << r.cycles_per_byte.stddev << ',' << r.cycles_per_byte.min << ','
+                  << r.gbps.median << ',' << r.gbps.mean << ',' << r.gbps.stddev << ',' << r.gbps.max << '\n';
+}
+
+void print_stats_json(const char* name, const Stats& stats)
+{
+    std::cout << "\"" << name << "\": {\"median\": " << stats.median << ", \"mean\": " << stats.mean
+              << ", \"stddev\": " << stats.stddev << ", \"min\": " << stats.min << ", \"max\": " << stats.max << "}";
+}
+
+void print_json(const std::vector<Result>& results)
+{
+    std::cout << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        std::cout << "  {\"implementation\": \"" << r.implementation << "\", \"size\": " << r.size
+                  << ", \"samples\": " << r.samples << ", \"iterations\": " << r.iterations
+                  << ", \"ns_per_hash\": " << r.ns_per_hash << ", ";
+        print_stats_json("cycles_per_byte", r.cycles_per_byte);
+        std::cout << ", ";
+        print_stats_json("gbps", r.gbps);
+        std::cout << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "]\n";
+}
+
+int hash_one_file(const std::string& path, const std::string& algorithm)
+{
+    try {
+        auto hasher = make_file_hash(parse_hash_algorithm(algorithm));
+        FileDigest digest = hash_file(path, *hasher);
+        std::cout << digest.hash << "  " << path << std::endl;
+        std::cerr << algorithm << ": " << digest.bytes << " bytes in " << digest.seconds << " s, "
+                  << digest.throughput() << " MB/s (" << (digest.mapped ? "mmap" : "read") << ")" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    std::string format = argc > 1 ? argv[1] : "csv";
+    if (format == "file" && (argc == 3 || argc == 4))
+        return hash_one_file(argv[2], argc == 4 ? argv[3] : "sha256");
+    size_t max_size = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : MaxSizeDefault;
+
+    if (format != "csv" && format != "json") {
+        std::cerr << "Usage: " << argv[0] << " [csv|json] [max_size_bytes]\n"
+                  << "       " << argv[0] << " file PATH [sha256|sha512|sha512-256]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<size_t> sizes = { 0 };
+    for (size_t size = SHA256::BlockSize; size <= max_size; size *= 4)
+        sizes.push_back(size);
+
+    // pseudo-random contents, every page is touched before timing
+    std::vector<uint8_t> buffer(std::max<size_t>(max_size, 8192));
+    uint64_t x = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        buffer[i] = (uint8_t)x;
+    }
+
+    if (!self_test(buffer.data())) {
+        std::cerr << "SHA-256 implementations disagree" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Result> results;
+    for (const auto& impl : implementations())
+        for (size_t size : sizes) {
+            std::cerr << impl.name << " " << size << " bytes..." << std::endl;
+            results.push_back(run(impl, buffer.data(), size));
+        }
+
+    std::cout << std::setprecision(6);
+    if (format == "json")
+        print_json(results);
+    else
+        print_csv(results);
+
+    return EXIT_SUCCESS;
+}
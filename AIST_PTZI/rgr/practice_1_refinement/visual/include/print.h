@@ -2,6 +2,8 @@
 
 #include <chrono>
 #include <gmp.h>
+#include <string>
+#include <tuple>
 #include <vector>
 
 std::string center(const std::string s, const int w);
@@ -0,0 +1,302 @@
+/*
+ * AES-NI and VAES counter mode, and GHASH with PCLMULQDQ.
+ *
+ * aesenc has a latency of several cycles but can start every cycle, so the
+ * AES-NI kernel keeps 8 independent blocks in flight and the VAES kernel
+ * 16 (two per AVX2 register). Counter blocks are built by inserting the
+ * byte-swapped 32-bit counter into the last word of the IV block.
+ *
+ * GHASH works on byte-reversed blocks, where the bit-reflected field
+ * elements of GCM become 128-bit integers: a carry-less product, a shift
+ * by one and a reduction by x^128 + x^7 + x^2 + x + 1 (Gueron and
+ * Kounavis, Intel white paper 323640). Eight blocks are multiplied by
+ * h^8..h^1 and summed before one reduction.
+ */
+
+#include "aes-simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+static uint32_t load32_be(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void store32_be(uint8_t *p,uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+/* the IV block with the big-endian counter n in its last word */
+__attribute__((target("sse4.1")))
+static __m128i aes_counter(__m128i iv,uint32_t n)
+{
+  return _mm_insert_epi32(iv,(int)__builtin_bswap32(n),3);
+}
+
+__attribute__((target("aes,sse4.1")))
+static void aes_ctr8(const uint8_t round_keys[][16],int rounds,uint8_t counter[16],
+  const uint8_t *m,uint8_t *c,size_t bytes)
+{
+  const __m128i iv = _mm_loadu_si128((const __m128i *)counter);
+  __m128i k[15], b0, b1, b2, b3, b4, b5, b6, b7, x;
+  uint32_t n = load32_be(counter + 12);
+  uint8_t last[16];
+  size_t i, length;
+  int r;
+
+  for (r = 0;r <= rounds;++r) k[r] = _mm_loadu_si128((const __m128i *)round_keys[r]);
+
+  for (;bytes >= 128;bytes -= 128,m += 128,c += 128,n += 8) {
+    b0 = _mm_xor_si128(aes_counter(iv,n),k[0]);
+    b1 = _mm_xor_si128(aes_counter(iv,n + 1),k[0]);
+    b2 = _mm_xor_si128(aes_counter(iv,n + 2),k[0]);
+    b3 = _mm_xor_si128(aes_counter(iv,n + 3),k[0]);
+    b4 = _mm_xor_si128(aes_counter(iv,n + 4),k[0]);
+    b5 = _mm_xor_si128(aes_counter(iv,n + 5),k[0]);
+    b6 = _mm_xor_si128(aes_counter(iv,n + 6),k[0]);
+    b7 = _mm_xor_si128(aes_counter(iv,n + 7),k[0]);
+    for (r = 1;r < rounds;++r) {
+      b0 = _mm_aesenc_si128(b0,k[r]);
+      b1 = _mm_aesenc_si128(b1,k[r]);
+      b2 = _mm_aesenc_si128(b2,k[r]);
+      b3 = _mm_aesenc_si128(b3,k[r]);
+      b4 = _mm_aesenc_si128(b4,k[r]);
+      b5 = _mm_aesenc_si128(b5,k[r]);
+      b6 = _mm_aesenc_si128(b6,k[r]);
+      b7 = _mm_aesenc_si128(b7,k[r]);
+    }
+#define AES_LAST(j,b) \
+    _mm_storeu_si128((__m128i *)(c + 16 * j), \
+      _mm_xor_si128(_mm_aesenclast_si128(b,k[rounds]),_mm_loadu_si128((const __m128i *)(m + 16 * j))))
+    AES_LAST(0,b0); AES_LAST(1,b1); AES_LAST(2,b2); AES_LAST(3,b3);
+    AES_LAST(4,b4); AES_LAST(5,b5); AES_LAST(6,b6); AES_LAST(7,b7);
+#undef AES_LAST
+  }
+
+  /* the rest one block at a time, a partial block through a buffer */
+  for (;bytes > 0;bytes -= length,m += length,c += length,++n) {
+    x = _mm_xor_si128(aes_counter(iv,n),k[0]);
+    for (r = 1;r < rounds;++r) x = _mm_aesenc_si128(x,k[r]);
+    x = _mm_aesenclast_si128(x,k[rounds]);
+    length = bytes < 16 ? bytes : 16;
+    if (length == 16) {
+      _mm_storeu_si128((__m128i *)c,_mm_xor_si128(x,_mm_loadu_si128((const __m128i *)m)));
+    } else {
+      _mm_storeu_si128((__m128i *)last,x);
+      for (i = 0;i < length;++i) c[i] = m[i] ^ last[i];
+    }
+  }
+  store32_be(counter + 12,n);
+}
+
+/* two counter blocks, n in the low half */
+__attribute__((target("avx2")))
+static __m256i aes_counter2(__m128i iv,uint32_t n)
+{
+  return _mm256_set_m128i(aes_counter(iv,n + 1),aes_counter(iv,n));
+}
+
+__attribute__((target("vaes,aes,avx2")))
+static void aes_ctr16(const uint8_t round_keys[][16],int rounds,uint8_t counter[16],
+  const uint8_t *m,uint8_t *c,size_t bytes)
+{
+  const __m128i iv = _mm_loadu_si128((const __m128i *)counter);
+  __m256i k[15], b0, b1, b2, b3, b4, b5, b6, b7;
+  uint32_t n = load32_be(counter + 12);
+  int r;
+
+  for (r = 0;r <= rounds;++r) k[r] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)round_keys[r]));
+
+  for (;bytes >= 256;bytes -= 256,m += 256,c += 256,n += 16) {
+    b0 = _mm256_xor_si256(aes_counter2(iv,n),k[0]);
+    b1 = _mm256_xor_si256(aes_counter2(iv,n + 2),k[0]);
+    b2 = _mm256_xor_si256(aes_counter2(iv,n + 4),k[0]);
+    b3 = _mm256_xor_si256(aes_counter2(iv,n + 6),k[0]);
+    b4 = _mm256_xor_si256(aes_counter2(iv,n + 8),k[0]);
+    b5 = _mm256_xor_si256(aes_counter2(iv,n + 10),k[0]);
+    b6 = _mm256_xor_si256(aes_counter2(iv,n + 12),k[0]);
+    b7 = _mm256_xor_si256(aes_counter2(iv,n + 14),k[0]);
+    for (r = 1;r < rounds;++r) {
+      b0 = _mm256_aesenc_epi128(b0,k[r]);
+      b1 = _mm256_aesenc_epi128(b1,k[r]);
+      b2 = _mm256_aesenc_epi128(b2,k[r]);
+      b3 = _mm256_aesenc_epi128(b3,k[r]);
+      b4 = _mm256_aesenc_epi128(b4,k[r]);
+      b5 = _mm256_aesenc_epi128(b5,k[r]);
+      b6 = _mm256_aesenc_epi128(b6,k[r]);
+      b7 = _mm256_aesenc_epi128(b7,k[r]);
+    }
+#define AES_LAST(j,b) \
+    _mm256_storeu_si256((__m256i *)(c + 32 * j), \
+      _mm256_xor_si256(_mm256_aesenclast_epi128(b,k[rounds]),_mm256_loadu_si256((const __m256i *)(m + 32 * j))))
+    AES_LAST(0,b0); AES_LAST(1,b1); AES_LAST(2,b2); AES_LAST(3,b3);
+    AES_LAST(4,b4); AES_LAST(5,b5); AES_LAST(6,b6); AES_LAST(7,b7);
+#undef AES_LAST
+  }
+
+  store32_be(counter + 12,n);
+  aes_ctr8(round_keys,rounds,counter,m,c,bytes);
+}
+
+int aes_simd_max_lanes(void)
+{
+  if (!__builtin_cpu_supports("aes") || !__builtin_cpu_supports("sse4.1")) return 0;
+  if (__builtin_cpu_supports("vaes") && __builtin_cpu_supports("avx2")) return 16;
+  return 8;
+}
+
+int aes_simd_ctr(const uint8_t round_keys[][16],int rounds,uint8_t counter[16],
+  const uint8_t *m,uint8_t *c,size_t bytes,int max_lanes)
+{
+  int lanes = aes_simd_max_lanes();
+
+  if (max_lanes < lanes) lanes = max_lanes;
+  if (lanes >= 16)
+    aes_ctr16(round_keys,rounds,counter,m,c,bytes);
+  else if (lanes >= 8)
+    aes_ctr8(round_keys,rounds,counter,m,c,bytes);
+  else
+    return 0;
+  return 1;
+}
+
+/* ghash_ctx layout <-> byte-reversed block */
+__attribute__((target("sse4.1")))
+static __m128i ghash_load(const uint64_t x[2])
+{
+  return _mm_set_epi64x((long long)x[0],(long long)x[1]);
+}
+
+__attribute__((target("sse4.1")))
+static void ghash_store(uint64_t x[2],__m128i v)
+{
+  uint64_t t[2];
+
+  _mm_storeu_si128((__m128i *)t,v);
+  x[0] = t[1];
+  x[1] = t[0];
+}
+
+/* lo, mid, hi += the partial products of a * b */
+__attribute__((target("pclmul,sse4.1")))
+static void ghash_clmul(__m128i a,__m128i b,__m128i *lo,__m128i *mid,__m128i *hi)
+{
+  *lo = _mm_xor_si128(*lo,_mm_clmulepi64_si128(a,b,0x00));
+  *hi = _mm_xor_si128(*hi,_mm_clmulepi64_si128(a,b,0x11));
+  *mid = _mm_xor_si128(*mid,_mm_xor_si128(_mm_clmulepi64_si128(a,b,0x01),_mm_clmulepi64_si128(a,b,0x10)));
+}
+
+/* the 256-bit product, shifted left by one bit and reduced */
+__attribute__((target("pclmul,sse4.1")))
+static __m128i ghash_reduce(__m128i lo,__m128i mid,__m128i hi)
+{
+  __m128i t, u, v;
+
+  lo = _mm_xor_si128(lo,_mm_slli_si128(mid,8));
+  hi = _mm_xor_si128(hi,_mm_srli_si128(mid,8));
+
+  /* hi:lo <<= 1 */
+  t = _mm_srli_epi32(lo,31);
+  u = _mm_srli_epi32(hi,31);
+  lo = _mm_slli_epi32(lo,1);
+  hi = _mm_slli_epi32(hi,1);
+  v = _mm_srli_si128(t,12);
+  u = _mm_slli_si128(u,4);
+  t = _mm_slli_si128(t,4);
+  lo = _mm_or_si128(lo,t);
+  hi = _mm_or_si128(_mm_or_si128(hi,u),v);
+
+  /* fold lo into hi */
+  t = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo,31),_mm_slli_epi32(lo,30)),_mm_slli_epi32(lo,25));
+  u = _mm_srli_si128(t,4);
+  lo = _mm_xor_si128(lo,_mm_slli_si128(t,12));
+  v = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo,1),_mm_srli_epi32(lo,2)),_mm_srli_epi32(lo,7));
+  lo = _mm_xor_si128(lo,_mm_xor_si128(v,u));
+  return _mm_xor_si128(hi,lo);
+}
+
+__attribute__((target("pclmul,sse4.1")))
+static __m128i ghash_mul(__m128i a,__m128i b)
+{
+  __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+
+  ghash_clmul(a,b,&lo,&mid,&hi);
+  return ghash_reduce(lo,mid,hi);
+}
+
+int ghash_simd_available(void)
+{
+  return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+}
+
+__attribute__((target("pclmul,sse4.1")))
+void ghash_simd_powers(const uint64_t h[2],uint64_t powers[8][2])
+{
+  __m128i hv = ghash_load(h), p = hv;
+  int k;
+
+  ghash_store(powers[0],p);
+  for (k = 1;k < 8;++k) {
+    p = ghash_mul(p,hv);
+    ghash_store(powers[k],p);
+  }
+}
+
+__attribute__((target("pclmul,sse4.1")))
+void ghash_simd_blocks(uint64_t x[2],const uint64_t powers[8][2],const uint8_t *m,size_t blocks)
+{
+  const __m128i reverse = _mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+  __m128i acc = ghash_load(x), h[8], lo, mid, hi, b;
+  int j;
+
+  for (j = 0;j < 8;++j) h[j] = ghash_load(powers[j]);
+
+  for (;blocks >= 8;blocks -= 8,m += 128) {
+    lo = mid = hi = _mm_setzero_si128();
+    for (j = 0;j < 8;++j) {
+      b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(m + 16 * j)),reverse);
+      if (j == 0) b = _mm_xor_si128(b,acc);
+      ghash_clmul(b,h[7 - j],&lo,&mid,&hi);
+    }
+    acc = ghash_reduce(lo,mid,hi);
+  }
+
+  for (;blocks > 0;--blocks,m += 16) {
+    b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)m),reverse);
+    acc = ghash_mul(_mm_xor_si128(acc,b),h[0]);
+  }
+  ghash_store(x,acc);
+}
+
+#else
+
+int aes_simd_max_lanes(void)
+{
+  return 0;
+}
+
+int aes_simd_ctr(const uint8_t round_keys[][16],int rounds,uint8_t counter[16],
+  const uint8_t *m,uint8_t *c,size_t bytes,int max_lanes)
+{
+  (void)round_keys; (void)rounds; (void)counter; (void)m; (void)c; (void)bytes; (void)max_lanes;
+  return 0;
+}
+
+int ghash_simd_available(void)
+{
+  return 0;
+}
+
+void ghash_simd_powers(const uint64_t h[2],uint64_t powers[8][2])
+{
+  (void)h; (void)powers;
+}
+
+void ghash_simd_blocks(uint64_t x[2],const uint64_t powers[8][2],const uint8_t *m,size_t blocks)
+{
+  (void)x; (void)powers; (void)m; (void)blocks;
+}
+
+#endif
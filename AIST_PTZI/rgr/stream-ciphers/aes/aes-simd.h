@@ -0,0 +1,30 @@
+#ifndef AES_SIMD_H
+#define AES_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Blocks per kernel step the CPU supports: 16 (VAES), 8 (AES-NI) or 0 */
+int aes_simd_max_lanes(void);
+
+/*
+ * aes_ctr_encrypt with the AES-NI (max_lanes 8) or VAES (16) kernel,
+ * including a partial last block. Returns 0 without touching anything if
+ * neither can run.
+ */
+int aes_simd_ctr(const uint8_t round_keys[][16],int rounds,uint8_t counter[16],
+  const uint8_t *m,uint8_t *c,size_t bytes,int max_lanes);
+
+/* 1 if the CPU has PCLMULQDQ */
+int ghash_simd_available(void);
+
+/* powers[k] = h^(k+1), k < 8, in the layout of ghash_ctx */
+void ghash_simd_powers(const uint64_t h[2],uint64_t powers[8][2]);
+
+/*
+ * Absorbs whole blocks into the accumulator x (layout of ghash_ctx), eight
+ * at a time with one reduction per group. powers[k] is h^(k+1).
+ */
+void ghash_simd_blocks(uint64_t x[2],const uint64_t powers[8][2],const uint8_t *m,size_t blocks);
+
+#endif
@@ -0,0 +1,496 @@
+/*
+ * Portable AES, bitsliced over 4 blocks: bit i of every state byte goes to
+ * the 64-bit word q[i], at position 16 * row + 4 * column + block. ShiftRows
+ * then rotates 4-bit groups within each 16-bit row, MixColumns combines
+ * rotations of whole rows, and the S-box is a Boolean circuit over the
+ * words. No table is indexed by the key or the data, so the timing depends
+ * on neither; the key schedule reuses the circuit and GHASH multiplies bit
+ * by bit.
+ */
+
+#include "aes.h"
+#include "aes-simd.h"
+
+#define ROTR64(x,n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+/* widest SIMD kernel allowed, see aes_set_lanes */
+static int max_lanes = 16;
+
+static uint32_t load32_be(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void store32_be(uint8_t *p,uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+static uint64_t load64_be(const uint8_t *p)
+{
+  return ((uint64_t)load32_be(p) << 32) | load32_be(p + 4);
+}
+
+static void store64_be(uint8_t *p,uint64_t v)
+{
+  store32_be(p,(uint32_t)(v >> 32));
+  store32_be(p + 4,(uint32_t)v);
+}
+
+/*
+ * The S-box as a circuit of 113 XOR/AND/XNOR gates over the bit planes
+ * (Boyar and Peralta, "A depth-16 circuit for the AES S-box"); x0 is the
+ * most significant bit.
+ */
+static void aes_sub_bytes(uint64_t q[8])
+{
+  uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+  uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11, y12, y13, y14, y15, y16, y17, y18, y19, y20, y21;
+  uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11, z12, z13, z14, z15, z16, z17;
+  uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+  uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+  uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+  uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+  uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+  x0 = q[7]; x1 = q[6]; x2 = q[5]; x3 = q[4];
+  x4 = q[3]; x5 = q[2]; x6 = q[1]; x7 = q[0];
+
+  /* top linear transformation */
+  y14 = x3 ^ x5;
+  y13 = x0 ^ x6;
+  y9 = x0 ^ x3;
+  y8 = x0 ^ x5;
+  t0 = x1 ^ x2;
+  y1 = t0 ^ x7;
+  y4 = y1 ^ x3;
+  y12 = y13 ^ y14;
+  y2 = y1 ^ x0;
+  y5 = y1 ^ x6;
+  y3 = y5 ^ y8;
+  t1 = x4 ^ y12;
+  y15 = t1 ^ x5;
+  y20 = t1 ^ x1;
+  y6 = y15 ^ x7;
+  y10 = y15 ^ t0;
+  y11 = y20 ^ y9;
+  y7 = x7 ^ y11;
+  y17 = y10 ^ y11;
+  y19 = y10 ^ y8;
+  y16 = t0 ^ y11;
+  y21 = y13 ^ y16;
+  y18 = x0 ^ y16;
+
+  /* inversion in GF(2^4)^2 */
+  t2 = y12 & y15;
+  t3 = y3 & y6;
+  t4 = t3 ^ t2;
+  t5 = y4 & x7;
+  t6 = t5 ^ t2;
+  t7 = y13 & y16;
+  t8 = y5 & y1;
+  t9 = t8 ^ t7;
+  t10 = y2 & y7;
+  t11 = t10 ^ t7;
+  t12 = y9 & y11;
+  t13 = y14 & y17;
+  t14 = t13 ^ t12;
+  t15 = y8 & y10;
+  t16 = t15 ^ t12;
+  t17 = t4 ^ t14;
+  t18 = t6 ^ t16;
+  t19 = t9 ^ t14;
+  t20 = t11 ^ t16;
+  t21 = t17 ^ y20;
+  t22 = t18 ^ y19;
+  t23 = t19 ^ y21;
+  t24 = t20 ^ y18;
+  t25 = t21 ^ t22;
+  t26 = t21 & t23;
+  t27 = t24 ^ t26;
+  t28 = t25 & t27;
+  t29 = t28 ^ t22;
+  t30 = t23 ^ t24;
+  t31 = t22 ^ t26;
+  t32 = t31 & t30;
+  t33 = t32 ^ t24;
+  t34 = t23 ^ t33;
+  t35 = t27 ^ t33;
+  t36 = t24 & t35;
+  t37 = t36 ^ t34;
+  t38 = t27 ^ t36;
+  t39 = t29 & t38;
+  t40 = t25 ^ t39;
+  t41 = t40 ^ t37;
+  t42 = t29 ^ t33;
+  t43 = t29 ^ t40;
+  t44 = t33 ^ t37;
+  t45 = t42 ^ t41;
+  z0 = t44 & y15;
+  z1 = t37 & y6;
+  z2 = t33 & x7;
+  z3 = t43 & y16;
+  z4 = t40 & y1;
+  z5 = t29 & y7;
+  z6 = t42 & y11;
+  z7 = t45 & y17;
+  z8 = t41 & y10;
+  z9 = t44 & y12;
+  z10 = t37 & y3;
+  z11 = t33 & y4;
+  z12 = t43 & y13;
+  z13 = t40 & y5;
+  z14 = t29 & y2;
+  z15 = t42 & y9;
+  z16 = t45 & y14;
+  z17 = t41 & y8;
+
+  /* bottom linear transformation, with the affine constant */
+  t46 = z15 ^ z16;
+  t47 = z10 ^ z11;
+  t48 = z5 ^ z13;
+  t49 = z9 ^ z10;
+  t50 = z2 ^ z12;
+  t51 = z2 ^ z5;
+  t52 = z7 ^ z8;
+  t53 = z0 ^ z3;
+  t54 = z6 ^ z7;
+  t55 = z16 ^ z17;
+  t56 = z12 ^ t48;
+  t57 = t50 ^ t53;
+  t58 = z4 ^ t46;
+  t59 = z3 ^ t54;
+  t60 = t46 ^ t57;
+  t61 = z14 ^ t57;
+  t62 = t52 ^ t58;
+  t63 = t49 ^ t58;
+  t64 = z4 ^ t59;
+  t65 = t61 ^ t62;
+  t66 = z1 ^ t63;
+  s0 = t59 ^ t63;
+  s6 = t56 ^ ~t62;
+  s7 = t48 ^ ~t60;
+  t67 = t64 ^ t65;
+  s3 = t53 ^ t66;
+  s4 = t51 ^ t66;
+  s5 = t47 ^ t65;
+  s1 = t64 ^ ~s3;
+  s2 = t55 ^ ~t67;
+
+  q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3;
+  q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+}
+
+/* row r takes column (c + r) mod 4 into column c */
+static void aes_shift_rows(uint64_t q[8])
+{
+  uint64_t x;
+  int i;
+
+  for (i = 0;i < 8;++i) {
+    x = q[i];
+    q[i] = (x & 0xffffULL)
+      | ((x >> 4) & 0x0fff0000ULL) | ((x << 12) & 0xf0000000ULL)
+      | ((x >> 8) & 0x000000ff00000000ULL) | ((x << 8) & 0x0000ff0000000000ULL)
+      | ((x >> 12) & 0x000f000000000000ULL) | ((x << 4) & 0xfff0000000000000ULL);
+  }
+}
+
+/* a_r = 2 * (a_r ^ a_(r+1)) ^ a_(r+1) ^ a_(r+2) ^ a_(r+3); a rotation by 16 bits moves row r + 1 to row r */
+static void aes_mix_columns(uint64_t q[8])
+{
+  uint64_t t[8];
+  int i;
+
+  for (i = 0;i < 8;++i) {
+    t[i] = q[i] ^ ROTR64(q[i],16);
+    q[i] = ROTR64(q[i],16) ^ ROTR64(q[i],32) ^ ROTR64(q[i],48);
+  }
+  q[0] ^= t[7];
+  q[1] ^= t[0] ^ t[7];
+  q[2] ^= t[1];
+  q[3] ^= t[2] ^ t[7];
+  q[4] ^= t[3] ^ t[7];
+  q[5] ^= t[4];
+  q[6] ^= t[5];
+  q[7] ^= t[6];
+}
+
+/* bit c of byte r <-> bit r of byte c (Hacker's Delight, transpose8) */
+static uint64_t aes_transpose8(uint64_t x)
+{
+  uint64_t t;
+
+  t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+  x ^= t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+  x ^= t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+  x ^= t ^ (t << 28);
+  return x;
+}
+
+/* byte i of x[j] <-> byte j of x[i], by swapping ever smaller sub-blocks */
+static void aes_transpose_bytes(uint64_t x[8])
+{
+  uint64_t t;
+  int i;
+
+  for (i = 0;i < 4;++i) {
+    t = ((x[i] >> 32) ^ x[i + 4]) & 0x00000000ffffffffULL;
+    x[i] ^= t << 32; x[i + 4] ^= t;
+  }
+  for (i = 0;i < 8;i += (i & 1) ? 3 : 1) {
+    t = ((x[i] >> 16) ^ x[i + 2]) & 0x0000ffff0000ffffULL;
+    x[i] ^= t << 16; x[i + 2] ^= t;
+  }
+  for (i = 0;i < 8;i += 2) {
+    t = ((x[i] >> 8) ^ x[i + 1]) & 0x00ff00ff00ff00ffULL;
+    x[i] ^= t << 8; x[i + 1] ^= t;
+  }
+}
+
+/*
+ * 4 blocks of 16 bytes <-> bit planes. Bit positions 8j..8j+7 are the
+ * bytes (row j / 2, columns 2 (j & 1) and 2 (j & 1) + 1) of blocks 0..3,
+ * i.e. the offsets 0, 16, 32, 48, 4, 20, 36, 52 from j / 2 + 8 (j & 1).
+ * Each such group is an 8x8 bit matrix, transposed with aes_transpose8;
+ * byte i of group j then is byte j of plane i.
+ */
+static void aes_slice(uint64_t q[8],const uint8_t blocks[64])
+{
+  const uint8_t *p;
+  int j;
+
+  for (j = 0;j < 8;++j) {
+    p = blocks + (j >> 1) + 8 * (j & 1);
+    q[j] = aes_transpose8((uint64_t)p[0] | (uint64_t)p[16] << 8 | (uint64_t)p[32] << 16 | (uint64_t)p[48] << 24
+      | (uint64_t)p[4] << 32 | (uint64_t)p[20] << 40 | (uint64_t)p[36] << 48 | (uint64_t)p[52] << 56);
+  }
+  aes_transpose_bytes(q);
+}
+
+static void aes_unslice(uint8_t blocks[64],const uint64_t q[8])
+{
+  uint64_t x[8];
+  uint8_t *p;
+  int j;
+
+  for (j = 0;j < 8;++j) x[j] = q[j];
+  aes_transpose_bytes(x);
+  for (j = 0;j < 8;++j) {
+    x[j] = aes_transpose8(x[j]);
+    p = blocks + (j >> 1) + 8 * (j & 1);
+    p[0] = (uint8_t)x[j]; p[16] = (uint8_t)(x[j] >> 8); p[32] = (uint8_t)(x[j] >> 16); p[48] = (uint8_t)(x[j] >> 24);
+    p[4] = (uint8_t)(x[j] >> 32); p[20] = (uint8_t)(x[j] >> 40); p[36] = (uint8_t)(x[j] >> 48); p[52] = (uint8_t)(x[j] >> 56);
+  }
+}
+
+static void aes_add_round_key(uint64_t q[8],const uint64_t key[8])
+{
+  int i;
+
+  for (i = 0;i < 8;++i) q[i] ^= key[i];
+}
+
+static void aes_encrypt4(const aes_ctx *ctx,const uint8_t in[64],uint8_t out[64])
+{
+  uint64_t q[8];
+  int r;
+
+  aes_slice(q,in);
+  aes_add_round_key(q,ctx->sliced_keys[0]);
+  for (r = 1;r < ctx->rounds;++r) {
+    aes_sub_bytes(q);
+    aes_shift_rows(q);
+    aes_mix_columns(q);
+    aes_add_round_key(q,ctx->sliced_keys[r]);
+  }
+  aes_sub_bytes(q);
+  aes_shift_rows(q);
+  aes_add_round_key(q,ctx->sliced_keys[ctx->rounds]);
+  aes_unslice(out,q);
+}
+
+/* SubWord through the bitsliced S-box, so the key schedule is constant-time too */
+static void aes_sub_word(uint8_t t[4])
+{
+  uint8_t blocks[64] = { 0 };
+  uint64_t q[8];
+  int i;
+
+  for (i = 0;i < 4;++i) blocks[i] = t[i];
+  aes_slice(q,blocks);
+  aes_sub_bytes(q);
+  aes_unslice(blocks,q);
+  for (i = 0;i < 4;++i) t[i] = blocks[i];
+}
+
+void aes_keysetup(aes_ctx *ctx,const uint8_t *key,int key_bits)
+{
+  uint8_t w[60][4], t[4], first, rcon = 1, blocks[64];
+  int nk = key_bits / 32, words, i, j;
+
+  ctx->rounds = nk + 6;
+  words = 4 * (ctx->rounds + 1);
+  for (i = 0;i < nk;++i)
+    for (j = 0;j < 4;++j) w[i][j] = key[4 * i + j];
+
+  for (i = nk;i < words;++i) {
+    for (j = 0;j < 4;++j) t[j] = w[i - 1][j];
+    if (i % nk == 0) {
+      /* SubWord(RotWord(t)) ^ Rcon */
+      first = t[0];
+      t[0] = t[1]; t[1] = t[2]; t[2] = t[3]; t[3] = first;
+      aes_sub_word(t);
+      t[0] ^= rcon;
+      rcon = (uint8_t)((rcon << 1) ^ (0x1b & (0 - (rcon >> 7))));
+    } else if (nk > 6 && i % nk == 4) {
+      aes_sub_word(t);
+    }
+    for (j = 0;j < 4;++j) w[i][j] = w[i - nk][j] ^ t[j];
+  }
+
+  for (i = 0;i <= ctx->rounds;++i) {
+    for (j = 0;j < 16;++j) ctx->round_keys[i][j] = w[4 * i + j / 4][j % 4];
+    for (j = 0;j < 64;++j) blocks[j] = ctx->round_keys[i][j % 16];
+    aes_slice(ctx->sliced_keys[i],blocks);
+  }
+}
+
+void aes_encrypt_block(const aes_ctx *ctx,const uint8_t in[16],uint8_t out[16])
+{
+  uint8_t blocks[64] = { 0 };
+  int i;
+
+  for (i = 0;i < 16;++i) blocks[i] = in[i];
+  aes_encrypt4(ctx,blocks,blocks);
+  for (i = 0;i < 16;++i) out[i] = blocks[i];
+}
+
+void aes_ctr_encrypt(const aes_ctx *ctx,uint8_t counter[16],const uint8_t *m,uint8_t *c,size_t bytes)
+{
+  uint8_t blocks[64], stream[64];
+  uint32_t n;
+  size_t i, length;
+  int k;
+
+  if (bytes == 0) return;
+  if (aes_simd_ctr(ctx->round_keys,ctx->rounds,counter,m,c,bytes,aes_lanes())) return;
+
+  for (;bytes > 0;m += length,c += length,bytes -= length) {
+    n = load32_be(counter + 12);
+    for (k = 0;k < 4;++k) {
+      for (i = 0;i < 12;++i) blocks[16 * k + i] = counter[i];
+      store32_be(blocks + 16 * k + 12,n + (uint32_t)k);
+    }
+    aes_encrypt4(ctx,blocks,stream);
+
+    length = bytes < 64 ? bytes : 64;
+    for (i = 0;i < length;++i) c[i] = m[i] ^ stream[i];
+    store32_be(counter + 12,n + (uint32_t)((length + 15) / 16));
+  }
+}
+
+void aes_set_lanes(int lanes)
+{
+  max_lanes = lanes;
+}
+
+int aes_lanes(void)
+{
+  int lanes = aes_simd_max_lanes();
+  return max_lanes < lanes ? max_lanes : lanes;
+}
+
+/* z = x * y in GF(2^128) with the bit order of GCM (SP 800-38D, algorithm 1) */
+static void ghash_mul(uint64_t z[2],const uint64_t x[2],const uint64_t y[2])
+{
+  uint64_t v0 = y[0], v1 = y[1], z0 = 0, z1 = 0, mask;
+  int i;
+
+  for (i = 0;i < 128;++i) {
+    mask = 0 - ((x[i >> 6] >> (63 - (i & 63))) & 1);
+    z0 ^= v0 & mask;
+    z1 ^= v1 & mask;
+    /* v = v * x: a right shift, reduced by R = 0xe1 || 0^120 */
+    mask = 0 - (v1 & 1);
+    v1 = (v1 >> 1) | (v0 << 63);
+    v0 = (v0 >> 1) ^ (0xe100000000000000ULL & mask);
+  }
+  z[0] = z0;
+  z[1] = z1;
+}
+
+static void ghash_blocks(ghash_ctx *ctx,const uint8_t *m,size_t blocks)
+{
+  if (aes_lanes() > 0 && ghash_simd_available()) {
+    if (!ctx->have_powers) {
+      ghash_simd_powers(ctx->h,ctx->powers);
+      ctx->have_powers = 1;
+    }
+    ghash_simd_blocks(ctx->x,(const uint64_t (*)[2])ctx->powers,m,blocks);
+    return;
+  }
+
+  for (;blocks > 0;--blocks,m += 16) {
+    ctx->x[0] ^= load64_be(m);
+    ctx->x[1] ^= load64_be(m + 8);
+    ghash_mul(ctx->x,ctx->x,ctx->h);
+  }
+}
+
+void ghash_init(ghash_ctx *ctx,const uint8_t h[16])
+{
+  ctx->h[0] = load64_be(h);
+  ctx->h[1] = load64_be(h + 8);
+  ctx->x[0] = 0;
+  ctx->x[1] = 0;
+  ctx->have_powers = 0;
+  ctx->leftover = 0;
+}
+
+void ghash_update(ghash_ctx *ctx,const uint8_t *m,size_t bytes)
+{
+  size_t i, n;
+
+  /* complete the buffered block */
+  if (ctx->leftover) {
+    n = 16 - ctx->leftover < bytes ? 16 - ctx->leftover : bytes;
+    for (i = 0;i < n;++i) ctx->buffer[ctx->leftover + i] = m[i];
+    ctx->leftover += n;
+    m += n;
+    bytes -= n;
+    if (ctx->leftover < 16) return;
+    ghash_blocks(ctx,ctx->buffer,1);
+    ctx->leftover = 0;
+  }
+
+  if (bytes >= 16) {
+    n = bytes / 16;
+    ghash_blocks(ctx,m,n);
+    m += 16 * n;
+    bytes -= 16 * n;
+  }
+
+  for (i = 0;i < bytes;++i) ctx->buffer[i] = m[i];
+  ctx->leftover = bytes;
+}
+
+void ghash_pad(ghash_ctx *ctx)
+{
+  size_t i;
+
+  if (ctx->leftover) {
+    for (i = ctx->leftover;i < 16;++i) ctx->buffer[i] = 0;
+    ghash_blocks(ctx,ctx->buffer,1);
+    ctx->leftover = 0;
+  }
+}
+
+void ghash_finish(ghash_ctx *ctx,uint8_t out[16])
+{
+  ghash_pad(ctx);
+  store64_be(out,ctx->x[0]);
+  store64_be(out + 8,ctx->x[1]);
+}
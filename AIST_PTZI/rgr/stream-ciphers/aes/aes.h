@@ -0,0 +1,74 @@
+#ifndef AES_H
+#define AES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * AES (FIPS-197) in counter mode, with GHASH for GCM (SP 800-38D).
+ *
+ * The block function has three implementations chosen at run time: VAES
+ * (16 blocks per step in AVX2 registers), AES-NI (8 blocks per step, so
+ * the aesenc latency is hidden) and a portable bitsliced one (4 blocks in
+ * 64-bit words, no table lookups, so its timing does not depend on the key
+ * or the data). The key schedule is shared: round keys are kept in the byte
+ * order of the state, which is what aesenc expects, and bitsliced for the
+ * portable code.
+ */
+typedef struct {
+  uint8_t round_keys[15][16];
+  uint64_t sliced_keys[15][8]; /* the same, bitsliced for 4 blocks */
+  int rounds; /* 10, 12 or 14 */
+} aes_ctx;
+
+/* key_bits is 128, 192 or 256 */
+void aes_keysetup(aes_ctx *ctx,const uint8_t *key,int key_bits);
+
+void aes_encrypt_block(const aes_ctx *ctx,const uint8_t in[16],uint8_t out[16]);
+
+/*
+ * c = m ^ keystream, the keystream being the encryptions of counter,
+ * counter + 1, ... where only the last 32 bits are incremented, big-endian
+ * and modulo 2^32 (inc32 of SP 800-38D). counter is advanced by the
+ * number of blocks used, a partial last block counting as a whole one.
+ */
+void aes_ctr_encrypt(const aes_ctx *ctx,uint8_t counter[16],const uint8_t *m,uint8_t *c,size_t bytes);
+
+/*
+ * Blocks per kernel step: 16 (VAES), 8 (AES-NI) or 0 (portable code only).
+ * aes_set_lanes(0) disables the kernels, e.g. to compare the paths; GHASH
+ * uses PCLMULQDQ only when the lanes are not 0.
+ */
+void aes_set_lanes(int lanes);
+int aes_lanes(void);
+
+/*
+ * GHASH with the hash key h = AES_K(0^128). Data is absorbed in 16-byte
+ * blocks; ghash_pad zero-pads a partial block, as GCM does at the end of
+ * the additional data and of the ciphertext. The SIMD path needs
+ * h^1..h^8, which are computed on first use.
+ */
+typedef struct {
+  uint64_t h[2]; /* as a big-endian 128-bit number: h[0] the high half */
+  uint64_t x[2]; /* accumulator, the same layout */
+  uint64_t powers[8][2]; /* h^1..h^8, valid if have_powers */
+  int have_powers;
+  size_t leftover;
+  uint8_t buffer[16];
+} ghash_ctx;
+
+void ghash_init(ghash_ctx *ctx,const uint8_t h[16]);
+void ghash_update(ghash_ctx *ctx,const uint8_t *m,size_t bytes);
+void ghash_pad(ghash_ctx *ctx);
+/* ghash_pad, then the accumulator */
+void ghash_finish(ghash_ctx *ctx,uint8_t out[16]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+/*
+ * SIMD ChaCha20 kernels: 4, 8 or 16 blocks at once.
+ *
+ * Same layout as the Salsa20 kernels: lane k of vector x[i] holds word i of
+ * block (counter + k), so a quarter round is plain vertical arithmetic on
+ * four vectors. The 16- and 8-bit rotations are byte shuffles where the
+ * instruction set has them. The words are transposed back into blocks before
+ * the XOR with the message. As there, the lanes may hold blocks of different
+ * states instead (chacha20_simd_multi).
+ */
+
+#include "chacha20-simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+#define CHACHA20_QUARTERROUND(a,b,c,d,ADD,XOR,R16,R12,R8,R7) \
+  x[a] = ADD(x[a],x[b]); x[d] = R16(XOR(x[d],x[a])); \
+  x[c] = ADD(x[c],x[d]); x[b] = R12(XOR(x[b],x[c])); \
+  x[a] = ADD(x[a],x[b]); x[d] = R8(XOR(x[d],x[a])); \
+  x[c] = ADD(x[c],x[d]); x[b] = R7(XOR(x[b],x[c]));
+
+#define CHACHA20_ROUNDS(x,ADD,XOR,R16,R12,R8,R7) \
+  for (r = 20;r > 0;r -= 2) { \
+    CHACHA20_QUARTERROUND( 0, 4, 8,12,ADD,XOR,R16,R12,R8,R7) \
+    CHACHA20_QUARTERROUND( 1, 5, 9,13,ADD,XOR,R16,R12,R8,R7) \
+    CHACHA20_QUARTERROUND( 2, 6,10,14,ADD,XOR,R16,R12,R8,R7) \
+    CHACHA20_QUARTERROUND( 3, 7,11,15,ADD,XOR,R16,R12,R8,R7) \
+    CHACHA20_QUARTERROUND( 0, 5,10,15,ADD,XOR,R16,R12,R8,R7) \
+    CHACHA20_QUARTERROUND( 1, 6,11,12,ADD,XOR,R16,R12,R8,R7) \
+    CHACHA20_QUARTERROUND( 2, 7, 8,13,ADD,XOR,R16,R12,R8,R7) \
+    CHACHA20_QUARTERROUND( 3, 4, 9,14,ADD,XOR,R16,R12,R8,R7) \
+  }
+
+/* 64-bit block counters of the lanes, split into input[12] and input[13] words */
+static void chacha20_lane_counters(const u32 input[16],u32 *lo,u32 *hi,int lanes)
+{
+  u64 counter = ((u64)input[13] << 32) | input[12];
+  int k;
+
+  for (k = 0;k < lanes;++k) {
+    lo[k] = (u32)(counter + k);
+    hi[k] = (u32)((counter + k) >> 32);
+  }
+}
+
+static void chacha20_advance(u32 input[16],size_t blocks)
+{
+  u64 counter = (((u64)input[13] << 32) | input[12]) + blocks;
+
+  input[12] = (u32)counter;
+  input[13] = (u32)(counter >> 32);
+}
+
+/* consecutive blocks of one message */
+static void chacha20_block_pointers(const u8 *m,u8 *c,const u8 **ms,u8 **cs,int lanes)
+{
+  int k;
+
+  for (k = 0;k < lanes;++k) {
+    ms[k] = m + 64 * k;
+    cs[k] = c + 64 * k;
+  }
+}
+
+/* words[lanes * i + k] = word i of state k, one row per vector */
+static void chacha20_gather(u32 *const input[],u32 *words,int lanes)
+{
+  int i, k;
+
+  for (i = 0;i < 16;++i)
+    for (k = 0;k < lanes;++k) words[lanes * i + k] = input[k][i];
+}
+
+#define ADD_SSE2(a,b) _mm_add_epi32(a,b)
+#define XOR_SSE2(a,b) _mm_xor_si128(a,b)
+#define ROTL_SSE2(a,n) _mm_or_si128(_mm_slli_epi32(a,n),_mm_srli_epi32(a,32 - (n)))
+#define ROTL16_SSE2(a) ROTL_SSE2(a,16)
+#define ROTL12_SSE2(a) ROTL_SSE2(a,12)
+#define ROTL8_SSE2(a) ROTL_SSE2(a,8)
+#define ROTL7_SSE2(a) ROTL_SSE2(a,7)
+
+/* block j of the kernels comes from m[j] and goes to c[j] */
+__attribute__((target("sse2")))
+static void chacha20_core4(const __m128i in[16],const u8 *const m[],u8 *const c[])
+{
+  __m128i x[16], t[4], u[4];
+  int i, j, g, r;
+
+  for (i = 0;i < 16;++i) x[i] = in[i];
+  CHACHA20_ROUNDS(x,ADD_SSE2,XOR_SSE2,ROTL16_SSE2,ROTL12_SSE2,ROTL8_SSE2,ROTL7_SSE2)
+  for (i = 0;i < 16;++i) x[i] = ADD_SSE2(x[i],in[i]);
+
+  /* u[j] = words 4g..4g+3 of block j */
+  for (g = 0;g < 4;++g) {
+    t[0] = _mm_unpacklo_epi32(x[4 * g],x[4 * g + 1]);
+    t[1] = _mm_unpackhi_epi32(x[4 * g],x[4 * g + 1]);
+    t[2] = _mm_unpacklo_epi32(x[4 * g + 2],x[4 * g + 3]);
+    t[3] = _mm_unpackhi_epi32(x[4 * g + 2],x[4 * g + 3]);
+    u[0] = _mm_unpacklo_epi64(t[0],t[2]);
+    u[1] = _mm_unpackhi_epi64(t[0],t[2]);
+    u[2] = _mm_unpacklo_epi64(t[1],t[3]);
+    u[3] = _mm_unpackhi_epi64(t[1],t[3]);
+    for (j = 0;j < 4;++j) {
+      const u8 *src = m[j] + 16 * g;
+      _mm_storeu_si128((__m128i *)(c[j] + 16 * g),
+        _mm_xor_si128(u[j],_mm_loadu_si128((const __m128i *)src)));
+    }
+  }
+}
+
+__attribute__((target("sse2")))
+static void chacha20_blocks4(const u32 input[16],const u8 *m,u8 *c)
+{
+  __m128i in[16];
+  const u8 *ms[4];
+  u8 *cs[4];
+  u32 lo[4], hi[4];
+  int i;
+
+  chacha20_lane_counters(input,lo,hi,4);
+  for (i = 0;i < 16;++i) in[i] = _mm_set1_epi32((int)input[i]);
+  in[12] = _mm_loadu_si128((const __m128i *)lo);
+  in[13] = _mm_loadu_si128((const __m128i *)hi);
+  chacha20_block_pointers(m,c,ms,cs,4);
+  chacha20_core4(in,ms,cs);
+}
+
+__attribute__((target("sse2")))
+static void chacha20_multi4(u32 *const input[],const u8 *const m[],u8 *const c[])
+{
+  __m128i in[16];
+  u32 words[16 * 4];
+  int i;
+
+  chacha20_gather(input,words,4);
+  for (i = 0;i < 16;++i) in[i] = _mm_loadu_si128((const __m128i *)(words + 4 * i));
+  chacha20_core4(in,m,c);
+}
+
+#define ADD_AVX2(a,b) _mm256_add_epi32(a,b)
+#define XOR_AVX2(a,b) _mm256_xor_si256(a,b)
+#define ROTL_AVX2(a,n) _mm256_or_si256(_mm256_slli_epi32(a,n),_mm256_srli_epi32(a,32 - (n)))
+#define ROTL16_AVX2(a) _mm256_shuffle_epi8(a,rot16)
+#define ROTL12_AVX2(a) ROTL_AVX2(a,12)
+#define ROTL8_AVX2(a) _mm256_shuffle_epi8(a,rot8)
+#define ROTL7_AVX2(a) ROTL_AVX2(a,7)
+
+__attribute__((target("avx2")))
+static void chacha20_xor32(u8 *c,const u8 *m,__m256i keystream)
+{
+  _mm256_storeu_si256((__m256i *)c,_mm256_xor_si256(keystream,_mm256_loadu_si256((const __m256i *)m)));
+}
+
+__attribute__((target("avx2")))
+static void chacha20_core8(const __m256i in[16],const u8 *const m[],u8 *const c[])
+{
+  const __m256i rot16 = _mm256_set_epi8(
+    13,12,15,14,9,8,11,10,5,4,7,6,1,0,3,2,
+    13,12,15,14,9,8,11,10,5,4,7,6,1,0,3,2);
+  const __m256i rot8 = _mm256_set_epi8(
+    14,13,12,15,10,9,8,11,6,5,4,7,2,1,0,3,
+    14,13,12,15,10,9,8,11,6,5,4,7,2,1,0,3);
+  __m256i x[16], t[4], u[16];
+  int i, j, g, r;
+
+  for (i = 0;i < 16;++i) x[i] = in[i];
+  CHACHA20_ROUNDS(x,ADD_AVX2,XOR_AVX2,ROTL16_AVX2,ROTL12_AVX2,ROTL8_AVX2,ROTL7_AVX2)
+  for (i = 0;i < 16;++i) x[i] = ADD_AVX2(x[i],in[i]);
+
+  /* 128-bit lane L of u[4g + j] = words 4g..4g+3 of block 4L + j */
+  for (g = 0;g < 4;++g) {
+    t[0] = _mm256_unpacklo_epi32(x[4 * g],x[4 * g + 1]);
+    t[1] = _mm256_unpackhi_epi32(x[4 * g],x[4 * g + 1]);
+    t[2] = _mm256_unpacklo_epi32(x[4 * g + 2],x[4 * g + 3]);
+    t[3] = _mm256_unpackhi_epi32(x[4 * g + 2],x[4 * g + 3]);
+    u[4 * g + 0] = _mm256_unpacklo_epi64(t[0],t[2]);
+    u[4 * g + 1] = _mm256_unpackhi_epi64(t[0],t[2]);
+    u[4 * g + 2] = _mm256_unpacklo_epi64(t[1],t[3]);
+    u[4 * g + 3] = _mm256_unpackhi_epi64(t[1],t[3]);
+  }
+
+  for (j = 0;j < 4;++j) {
+    chacha20_xor32(c[j],m[j],_mm256_permute2x128_si256(u[j],u[4 + j],0x20));
+    chacha20_xor32(c[j] + 32,m[j] + 32,_mm256_permute2x128_si256(u[8 + j],u[12 + j],0x20));
+    chacha20_xor32(c[4 + j],m[4 + j],_mm256_permute2x128_si256(u[j],u[4 + j],0x31));
+    chacha20_xor32(c[4 + j] + 32,m[4 + j] + 32,_mm256_permute2x128_si256(u[8 + j],u[12 + j],0x31));
+  }
+}
+
+__attribute__((target("avx2")))
+static void chacha20_blocks8(const u32 input[16],const u8 *m,u8 *c)
+{
+  __m256i in[16];
+  const u8 *ms[8];
+  u8 *cs[8];
+  u32 lo[8], hi[8];
+  int i;
+
+  chacha20_lane_counters(input,lo,hi,8);
+  for (i = 0;i < 16;++i) in[i] = _mm256_set1_epi32((int)input[i]);
+  in[12] = _mm256_loadu_si256((const __m256i *)lo);
+  in[13] = _mm256_loadu_si256((const __m256i *)hi);
+  chacha20_block_pointers(m,c,ms,cs,8);
+  chacha20_core8(in,ms,cs);
+}
+
+__attribute__((target("avx2")))
+static void chacha20_multi8(u32 *const input[],const u8 *const m[],u8 *const c[])
+{
+  __m256i in[16];
+  u32 words[16 * 8];
+  int i;
+
+  chacha20_gather(input,words,8);
+  for (i = 0;i < 16;++i) in[i] = _mm256_loadu_si256((const __m256i *)(words + 8 * i));
+  chacha20_core8(in,m,c);
+}
+
+#define ADD_AVX512(a,b) _mm512_add_epi32(a,b)
+#define XOR_AVX512(a,b) _mm512_xor_si512(a,b)
+#define ROTL16_AVX512(a) _mm512_rol_epi32(a,16)
+#define ROTL12_AVX512(a) _mm512_rol_epi32(a,12)
+#define ROTL8_AVX512(a) _mm512_rol_epi32(a,8)
+#define ROTL7_AVX512(a) _mm512_rol_epi32(a,7)
+
+__attribute__((target("avx512f")))
+static void chacha20_xor64(u8 *c,const u8 *m,__m512i keystream)
+{
+  _mm512_storeu_si512((void *)c,_mm512_xor_si512(keystream,_mm512_loadu_si512((const void *)m)));
+}
+
+__attribute__((target("avx512f")))
+static void chacha20_core16(const __m512i in[16],const u8 *const m[],u8 *const c[])
+{
+  __m512i x[16], t[4], u[16], p, q, s, w;
+  int i, j, g, r;
+
+  for (i = 0;i < 16;++i) x[i] = in[i];
+  CHACHA20_ROUNDS(x,ADD_AVX512,XOR_AVX512,ROTL16_AVX512,ROTL12_AVX512,ROTL8_AVX512,ROTL7_AVX512)
+  for (i = 0;i < 16;++i) x[i] = ADD_AVX512(x[i],in[i]);
+
+  /* 128-bit lane L of u[4g + j] = words 4g..4g+3 of block 4L + j */
+  for (g = 0;g < 4;++g) {
+    t[0] = _mm512_unpacklo_epi32(x[4 * g],x[4 * g + 1]);
+    t[1] = _mm512_unpackhi_epi32(x[4 * g],x[4 * g + 1]);
+    t[2] = _mm512_unpacklo_epi32(x[4 * g + 2],x[4 * g + 3]);
+    t[3] = _mm512_unpackhi_epi32(x[4 * g + 2],x[4 * g + 3]);
+    u[4 * g + 0] = _mm512_unpacklo_epi64(t[0],t[2]);
+    u[4 * g + 1] = _mm512_unpackhi_epi64(t[0],t[2]);
+    u[4 * g + 2] = _mm512_unpacklo_epi64(t[1],t[3]);
+    u[4 * g + 3] = _mm512_unpackhi_epi64(t[1],t[3]);
+  }
+
+  /* 4x4 transpose of 128-bit lanes gives whole blocks */
+  for (j = 0;j < 4;++j) {
+    p = _mm512_shuffle_i32x4(u[j],u[4 + j],0x44);
+    q = _mm512_shuffle_i32x4(u[8 + j],u[12 + j],0x44);
+    s = _mm512_shuffle_i32x4(u[j],u[4 + j],0xEE);
+    w = _mm512_shuffle_i32x4(u[8 + j],u[12 + j],0xEE);
+    chacha20_xor64(c[j],m[j],_mm512_shuffle_i32x4(p,q,0x88));
+    chacha20_xor64(c[4 + j],m[4 + j],_mm512_shuffle_i32x4(p,q,0xDD));
+    chacha20_xor64(c[8 + j],m[8 + j],_mm512_shuffle_i32x4(s,w,0x88));
+    chacha20_xor64(c[12 + j],m[12 + j],_mm512_shuffle_i32x4(s,w,0xDD));
+  }
+}
+
+__attribute__((target("avx512f")))
+static void chacha20_blocks16(const u32 input[16],const u8 *m,u8 *c)
+{
+  __m512i in[16];
+  const u8 *ms[16];
+  u8 *cs[16];
+  u32 lo[16], hi[16];
+  int i;
+
+  chacha20_lane_counters(input,lo,hi,16);
+  for (i = 0;i < 16;++i) in[i] = _mm512_set1_epi32((int)input[i]);
+  in[12] = _mm512_loadu_si512((const void *)lo);
+  in[13] = _mm512_loadu_si512((const void *)hi);
+  chacha20_block_pointers(m,c,ms,cs,16);
+  chacha20_core16(in,ms,cs);
+}
+
+__attribute__((target("avx512f")))
+static void chacha20_multi16(u32 *const input[],const u8 *const m[],u8 *const c[])
+{
+  __m512i in[16];
+  u32 words[16 * 16];
+  int i;
+
+  chacha20_gather(input,words,16);
+  for (i = 0;i < 16;++i) in[i] = _mm512_loadu_si512((const void *)(words + 16 * i));
+  chacha20_core16(in,m,c);
+}
+
+int chacha20_simd_max_lanes(void)
+{
+  if (__builtin_cpu_supports("avx512f")) return 16;
+  if (__builtin_cpu_supports("avx2")) return 8;
+  if (__builtin_cpu_supports("sse2")) return 4;
+  return 0;
+}
+
+size_t chacha20_simd_blocks(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes)
+{
+  size_t done = 0;
+  int lanes = chacha20_simd_max_lanes();
+
+  if (max_lanes < lanes) lanes = max_lanes;
+
+  /* widest kernel for the bulk, narrower ones for what is left */
+  if (lanes >= 16)
+    for (;blocks - done >= 16;done += 16) {
+      chacha20_blocks16(input,m + 64 * done,c + 64 * done);
+      chacha20_advance(input,16);
+    }
+  if (lanes >= 8)
+    for (;blocks - done >= 8;done += 8) {
+      chacha20_blocks8(input,m + 64 * done,c + 64 * done);
+      chacha20_advance(input,8);
+    }
+  if (lanes >= 4)
+    for (;blocks - done >= 4;done += 4) {
+      chacha20_blocks4(input,m + 64 * done,c + 64 * done);
+      chacha20_advance(input,4);
+    }
+  return done;
+}
+
+void chacha20_simd_multi(u32 *const input[],const u8 *const m[],u8 *const c[],int lanes)
+{
+  int k;
+
+  if (lanes == 16) chacha20_multi16(input,m,c);
+  else if (lanes == 8) chacha20_multi8(input,m,c);
+  else chacha20_multi4(input,m,c);
+  for (k = 0;k < lanes;++k) chacha20_advance(input[k],1);
+}
+
+#else
+
+int chacha20_simd_max_lanes(void)
+{
+  return 0;
+}
+
+size_t chacha20_simd_blocks(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes)
+{
+  (void)input; (void)m; (void)c; (void)blocks; (void)max_lanes;
+  return 0;
+}
+
+void chacha20_simd_multi(u32 *const input[],const u8 *const m[],u8 *const c[],int lanes)
+{
+  (void)input; (void)m; (void)c; (void)lanes;
+}
+
+#endif
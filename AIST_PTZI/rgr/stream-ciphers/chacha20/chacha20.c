@@ -0,0 +1,285 @@
+#include "chacha20.h"
+#include "chacha20-simd.h"
+
+#define ROTATE(v,c) (ROTL32(v,c))
+#define XOR(v,w) ((v) ^ (w))
+#define PLUS(v,w) (U32V((v) + (w)))
+#define PLUSONE(v) (PLUS((v),1))
+
+#define QUARTERROUND(a,b,c,d) \
+  x[a] = PLUS(x[a],x[b]); x[d] = ROTATE(XOR(x[d],x[a]),16); \
+  x[c] = PLUS(x[c],x[d]); x[b] = ROTATE(XOR(x[b],x[c]),12); \
+  x[a] = PLUS(x[a],x[b]); x[d] = ROTATE(XOR(x[d],x[a]), 8); \
+  x[c] = PLUS(x[c],x[d]); x[b] = ROTATE(XOR(x[b],x[c]), 7);
+
+static const char sigma[17] = "expand 32-byte k";
+static const char tau[17] = "expand 16-byte k";
+
+/* widest SIMD kernel allowed, see chacha20_set_lanes */
+static int max_lanes = 16;
+
+static void chacha20_rounds(u32 x[16])
+{
+  int i;
+
+  for (i = 20;i > 0;i -= 2) {
+    QUARTERROUND( 0, 4, 8,12)
+    QUARTERROUND( 1, 5, 9,13)
+    QUARTERROUND( 2, 6,10,14)
+    QUARTERROUND( 3, 7,11,15)
+    QUARTERROUND( 0, 5,10,15)
+    QUARTERROUND( 1, 6,11,12)
+    QUARTERROUND( 2, 7, 8,13)
+    QUARTERROUND( 3, 4, 9,14)
+  }
+}
+
+static void chacha20_wordtobyte(u8 output[64],const u32 input[16])
+{
+  u32 x[16];
+  int i;
+
+  for (i = 0;i < 16;++i) x[i] = input[i];
+  chacha20_rounds(x);
+  for (i = 0;i < 16;++i) x[i] = PLUS(x[i],input[i]);
+  for (i = 0;i < 16;++i) U32TO8_LITTLE(output + 4 * i,x[i]);
+}
+
+void ECRYPT_init(void)
+{
+  return;
+}
+
+void chacha20_set_lanes(int lanes)
+{
+  max_lanes = lanes;
+}
+
+int chacha20_lanes(void)
+{
+  int lanes = chacha20_simd_max_lanes();
+  return max_lanes < lanes ? max_lanes : lanes;
+}
+
+void chacha20_hchacha20(u8 out[32],const u8 key[32],const u8 nonce[16])
+{
+  u32 x[16];
+  int i;
+
+  for (i = 0;i < 4;++i) x[i] = U8TO32_LITTLE(sigma + 4 * i);
+  for (i = 0;i < 8;++i) x[4 + i] = U8TO32_LITTLE(key + 4 * i);
+  for (i = 0;i < 4;++i) x[12 + i] = U8TO32_LITTLE(nonce + 4 * i);
+  chacha20_rounds(x);
+
+  /* no feed-forward: words 0..3 and 12..15 are the subkey */
+  for (i = 0;i < 4;++i) U32TO8_LITTLE(out + 4 * i,x[i]);
+  for (i = 0;i < 4;++i) U32TO8_LITTLE(out + 16 + 4 * i,x[12 + i]);
+}
+
+void ECRYPT_keysetup(ECRYPT_ctx *x,const u8 *k,u32 kbits,u32 ivbits)
+{
+  const char *constants;
+  int i;
+
+  x->input[4] = U8TO32_LITTLE(k + 0);
+  x->input[5] = U8TO32_LITTLE(k + 4);
+  x->input[6] = U8TO32_LITTLE(k + 8);
+  x->input[7] = U8TO32_LITTLE(k + 12);
+  if (kbits == 256) { /* recommended */
+    k += 16;
+    constants = sigma;
+  } else { /* kbits == 128 */
+    constants = tau;
+  }
+  x->input[8] = U8TO32_LITTLE(k + 0);
+  x->input[9] = U8TO32_LITTLE(k + 4);
+  x->input[10] = U8TO32_LITTLE(k + 8);
+  x->input[11] = U8TO32_LITTLE(k + 12);
+  x->input[0] = U8TO32_LITTLE(constants + 0);
+  x->input[1] = U8TO32_LITTLE(constants + 4);
+  x->input[2] = U8TO32_LITTLE(constants + 8);
+  x->input[3] = U8TO32_LITTLE(constants + 12);
+
+  for (i = 0;i < 8;++i) x->key[i] = x->input[4 + i];
+  x->ivsize = ivbits;
+}
+
+void ECRYPT_ivsetup(ECRYPT_ctx *x,const u8 *iv)
+{
+  u8 key[32], subkey[32];
+  int i;
+
+  if (x->ivsize == 192) {
+    for (i = 0;i < 8;++i) U32TO8_LITTLE(key + 4 * i,x->key[i]);
+    chacha20_hchacha20(subkey,key,iv);
+    for (i = 0;i < 8;++i) x->input[4 + i] = U8TO32_LITTLE(subkey + 4 * i);
+    iv += 16;
+  }
+
+  x->input[12] = 0;
+  x->input[13] = 0;
+  x->input[14] = U8TO32_LITTLE(iv + 0);
+  x->input[15] = U8TO32_LITTLE(iv + 4);
+}
+
+void ECRYPT_encrypt_bytes(ECRYPT_ctx *x,const u8 *m,u8 *c,u32 bytes)
+{
+  u8 output[64];
+  u32 done;
+  u32 i;
+
+  if (!bytes) return;
+
+  /* whole blocks go to the SIMD kernels */
+  done = (u32)chacha20_simd_blocks(x->input,m,c,bytes / 64,max_lanes) * 64;
+  bytes -= done;
+  c += done;
+  m += done;
+  if (!bytes) return;
+
+  for (;;) {
+    chacha20_wordtobyte(output,x->input);
+    x->input[12] = PLUSONE(x->input[12]);
+    if (!x->input[12]) {
+      x->input[13] = PLUSONE(x->input[13]);
+      /* stopping at 2^70 bytes per nonce is user's responsibility */
+    }
+    if (bytes <= 64) {
+      for (i = 0;i < bytes;++i) c[i] = m[i] ^ output[i];
+      return;
+    }
+    for (i = 0;i < 64;++i) c[i] = m[i] ^ output[i];
+    bytes -= 64;
+    c += 64;
+    m += 64;
+  }
+}
+
+void ECRYPT_decrypt_bytes(ECRYPT_ctx *x,const u8 *c,u8 *m,u32 bytes)
+{
+  ECRYPT_encrypt_bytes(x,c,m,bytes);
+}
+
+void chacha20_encrypt_batch(ECRYPT_ctx *const x[],const u8 *const m[],u8 *const c[],
+  const u32 bytes[],u32 count)
+{
+  /* lane k: message job[k], its next whole block at in[k] / out[k] */
+  u32 *state[16];
+  const u8 *in[16];
+  u8 *out[16];
+  u32 job[16], blocks[16];
+  int lanes = chacha20_lanes(), active = 0, k, n;
+  u32 next = 0, done;
+
+  if (lanes > 16) lanes = 16;
+  while (lanes >= 4) {
+    /* whole kernels of one message at a time are as fast as it gets, only
+       the blocks left over go to the lanes; messages without any need none */
+    for (;active < lanes && next < count;++next) {
+      done = bytes[next] / 64 / lanes * lanes;
+      if (done) done = (u32)chacha20_simd_blocks(x[next]->input,m[next],c[next],done,lanes);
+      if (bytes[next] / 64 == done) {
+        ECRYPT_encrypt_bytes(x[next],m[next] + 64 * done,c[next] + 64 * done,bytes[next] % 64);
+        continue;
+      }
+      state[active] = x[next]->input;
+      in[active] = m[next] + 64 * done;
+      out[active] = c[next] + 64 * done;
+      job[active] = next;
+      blocks[active] = bytes[next] / 64 - done;
+      ++active;
+    }
+    if (active < 4) break;
+
+    /* widest kernels that fit, the last (active % 4) lanes wait */
+    for (k = 0;active - k >= 4;k += n) {
+      n = active - k >= 16 && lanes >= 16 ? 16 : active - k >= 8 && lanes >= 8 ? 8 : 4;
+      chacha20_simd_multi(state + k,in + k,out + k,n);
+    }
+
+    /* retire finished messages, the last lane takes the free place */
+    for (k = active - active % 4;k-- > 0;) {
+      in[k] += 64;
+      out[k] += 64;
+      if (--blocks[k]) continue;
+      ECRYPT_encrypt_bytes(x[job[k]],in[k],out[k],bytes[job[k]] % 64);
+      --active;
+      state[k] = state[active];
+      in[k] = in[active];
+      out[k] = out[active];
+      job[k] = job[active];
+      blocks[k] = blocks[active];
+    }
+  }
+
+  /* too few messages left to fill a kernel (or no SIMD): one at a time */
+  for (k = 0;k < active;++k)
+    ECRYPT_encrypt_bytes(x[job[k]],in[k],out[k],blocks[k] * 64 + bytes[job[k]] % 64);
+  for (;next < count;++next)
+    ECRYPT_encrypt_bytes(x[next],m[next],c[next],bytes[next]);
+}
+
+void chacha20_set_counter(ECRYPT_ctx *x,u64 block)
+{
+  x->input[12] = U32V(block);
+  x->input[13] = U32V(block >> 32);
+}
+
+u64 chacha20_counter(const ECRYPT_ctx *x)
+{
+  return ((u64)x->input[13] << 32) | x->input[12];
+}
+
+void chacha20_encrypt_range(ECRYPT_ctx *x,u64 offset,const u8 *m,u8 *c,u32 bytes)
+{
+  u8 output[64];
+  u32 skip = (u32)(offset % 64);
+  u32 i, n;
+
+  chacha20_set_counter(x,offset / 64);
+  if (!bytes) return;
+
+  /* range starts inside a block: use the tail of its keystream */
+  if (skip) {
+    chacha20_wordtobyte(output,x->input);
+    chacha20_set_counter(x,offset / 64 + 1);
+    n = 64 - skip < bytes ? 64 - skip : bytes;
+    for (i = 0;i < n;++i) c[i] = m[i] ^ output[skip + i];
+    bytes -= n;
+    c += n;
+    m += n;
+  }
+
+  ECRYPT_encrypt_bytes(x,m,c,bytes);
+}
+
+void ECRYPT_keystream_bytes(ECRYPT_ctx *x,u8 *stream,u32 bytes)
+{
+  u32 i;
+  for (i = 0;i < bytes;++i) stream[i] = 0;
+  ECRYPT_encrypt_bytes(x,stream,stream,bytes);
+}
+
+void ECRYPT_encrypt_bytes64(ECRYPT_ctx *x,const u8 *m,u8 *c,u64 bytes)
+{
+  for (;bytes > ECRYPT_CHUNKLENGTH;bytes -= ECRYPT_CHUNKLENGTH) {
+    ECRYPT_encrypt_bytes(x,m,c,ECRYPT_CHUNKLENGTH);
+    m += ECRYPT_CHUNKLENGTH;
+    c += ECRYPT_CHUNKLENGTH;
+  }
+  ECRYPT_encrypt_bytes(x,m,c,(u32)bytes);
+}
+
+void ECRYPT_decrypt_bytes64(ECRYPT_ctx *x,const u8 *c,u8 *m,u64 bytes)
+{
+  ECRYPT_encrypt_bytes64(x,c,m,bytes);
+}
+
+void ECRYPT_keystream_bytes64(ECRYPT_ctx *x,u8 *stream,u64 bytes)
+{
+  for (;bytes > ECRYPT_CHUNKLENGTH;bytes -= ECRYPT_CHUNKLENGTH) {
+    ECRYPT_keystream_bytes(x,stream,ECRYPT_CHUNKLENGTH);
+    stream += ECRYPT_CHUNKLENGTH;
+  }
+  ECRYPT_keystream_bytes(x,stream,(u32)bytes);
+}
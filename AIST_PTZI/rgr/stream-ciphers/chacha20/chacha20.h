@@ -0,0 +1,66 @@
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ecrypt-sync.h"
+#include <stddef.h>
+
+/*
+ * ChaCha20 with a 64-bit block counter in words 12..13. ivsize selects the
+ * nonce: 64 bits (original ChaCha20) or 192 bits (XChaCha20, 256-bit keys
+ * only). For XChaCha20 ECRYPT_ivsetup derives a subkey from the key and the
+ * first 16 nonce bytes with HChaCha20 and uses the last 8 as the nonce, so
+ * random nonces are safe and every IV gets a fresh key.
+ */
+void ECRYPT_init(void);
+
+void ECRYPT_keysetup(ECRYPT_ctx *x,const u8 *k,u32 kbits,u32 ivbits);
+
+void ECRYPT_ivsetup(ECRYPT_ctx *x,const u8 *iv);
+
+void ECRYPT_encrypt_bytes(ECRYPT_ctx *x,const u8 *m,u8 *c,u32 bytes);
+void ECRYPT_decrypt_bytes(ECRYPT_ctx *x,const u8 *c,u8 *m,u32 bytes);
+
+void ECRYPT_keystream_bytes(ECRYPT_ctx *x,u8 *stream,u32 bytes);
+
+/* any length, in chunks of ECRYPT_CHUNKLENGTH bytes */
+void ECRYPT_encrypt_bytes64(ECRYPT_ctx *x,const u8 *m,u8 *c,u64 bytes);
+void ECRYPT_decrypt_bytes64(ECRYPT_ctx *x,const u8 *c,u8 *m,u64 bytes);
+void ECRYPT_keystream_bytes64(ECRYPT_ctx *x,u8 *stream,u64 bytes);
+
+/* HChaCha20: 32-byte subkey from a 32-byte key and a 16-byte nonce */
+void chacha20_hchacha20(u8 out[32],const u8 key[32],const u8 nonce[16]);
+
+/*
+ * Random access, as for Salsa20: the counter is the number of the next
+ * 64-byte block, chacha20_encrypt_range encrypts bytes at the given offset
+ * of the stream and leaves the counter after the last touched block.
+ */
+void chacha20_set_counter(ECRYPT_ctx *x,u64 block);
+u64 chacha20_counter(const ECRYPT_ctx *x);
+void chacha20_encrypt_range(ECRYPT_ctx *x,u64 offset,const u8 *m,u8 *c,u32 bytes);
+
+/*
+ * Many messages at once, as salsa20_encrypt_batch: the same as count calls
+ * of ECRYPT_encrypt_bytes with distinct contexts (ChaCha20 and XChaCha20
+ * may be mixed), with blocks of different messages in the SIMD lanes.
+ */
+void chacha20_encrypt_batch(ECRYPT_ctx *const x[],const u8 *const m[],u8 *const c[],
+  const u32 bytes[],u32 count);
+
+/*
+ * Whole blocks are processed 16, 8 or 4 at a time by AVX-512, AVX2 or SSE2
+ * kernels, chosen at run time. chacha20_set_lanes limits the width
+ * (0 = scalar only); the CPU may allow less.
+ */
+void chacha20_set_lanes(int lanes);
+int chacha20_lanes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,12 +14,35 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* Symbol names */
+
+/*
+ * All ciphers in stream-ciphers/ implement the same ECRYPT_* API. The
+ * names are given a per-cipher prefix here so that several ciphers can be
+ * linked into one program; code including this header keeps using the
+ * ECRYPT_* names.
+ */
+#define ECRYPT_ctx               chacha20_ECRYPT_ctx
+#define ECRYPT_init              chacha20_ECRYPT_init
+#define ECRYPT_keysetup          chacha20_ECRYPT_keysetup
+#define ECRYPT_ivsetup           chacha20_ECRYPT_ivsetup
+#define ECRYPT_encrypt_bytes     chacha20_ECRYPT_encrypt_bytes
+#define ECRYPT_decrypt_bytes     chacha20_ECRYPT_decrypt_bytes
+#define ECRYPT_keystream_bytes   chacha20_ECRYPT_keystream_bytes
+#define ECRYPT_encrypt_bytes64   chacha20_ECRYPT_encrypt_bytes64
+#define ECRYPT_decrypt_bytes64   chacha20_ECRYPT_decrypt_bytes64
+#define ECRYPT_keystream_bytes64 chacha20_ECRYPT_keystream_bytes64
+#define ECRYPT_encrypt_packet    chacha20_ECRYPT_encrypt_packet
+#define ECRYPT_decrypt_packet    chacha20_ECRYPT_decrypt_packet
+
+/* ------------------------------------------------------------------------- */
+
 /* Cipher parameters */
 
 /* 
  * The name of your cipher.
  */
-#define ECRYPT_NAME "Salsa20 stream cipher"    /* [edit] */ 
+#define ECRYPT_NAME "ChaCha20 stream cipher"    /* [edit] */ 
 
 /*
  * Specify which key and IV sizes are supported by your cipher. A user
@@ -39,8 +62,9 @@
 #define ECRYPT_MAXKEYSIZE 256                 /* [edit] */
 #define ECRYPT_KEYSIZE(i) (128 + (i)*128)     /* [edit] */
 
-#define ECRYPT_MAXIVSIZE 64                   /* [edit] */
-#define ECRYPT_IVSIZE(i) (64 + (i)*64)        /* [edit] */
+/* 64-bit nonce (ChaCha20) or 192-bit nonce (XChaCha20) */
+#define ECRYPT_MAXIVSIZE 192                  /* [edit] */
+#define ECRYPT_IVSIZE(i) (64 + (i)*128)       /* [edit] */
 
 /* ------------------------------------------------------------------------- */
 
@@ -54,6 +78,8 @@
 typedef struct
 {
   u32 input[16]; /* could be compressed */
+  u32 key[8];    /* XChaCha20: the key HChaCha20 derives subkeys from */
+  u32 ivsize;    /* in bits, 64 or 192 */
   /* 
    * [edit]
    *
@@ -167,6 +193,41 @@ void ECRYPT_keystream_bytes(
 
 /* ------------------------------------------------------------------------- */
 
+/* 64-bit lengths */
+
+/*
+ * The functions above take u32 lengths, so a single call handles less
+ * than 4 GiB. The *_bytes64 variants accept any length: they call the
+ * u32 functions on chunks of ECRYPT_CHUNKLENGTH bytes, a whole number of
+ * blocks, so the output and the final state are the same as one call
+ * with the full length would give.
+ */
+#define ECRYPT_CHUNKLENGTH \
+  (0xFFFFFFFFUL / ECRYPT_BLOCKLENGTH * ECRYPT_BLOCKLENGTH)
+
+void ECRYPT_encrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* plaintext, 
+  u8* ciphertext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+void ECRYPT_decrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* ciphertext, 
+  u8* plaintext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#ifdef ECRYPT_GENERATES_KEYSTREAM
+
+void ECRYPT_keystream_bytes64(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u64 length);                /* Length of keystream in bytes. */
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
 /* Optional optimizations */
 
 /* 
@@ -13,6 +13,26 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* Symbol names */
+
+/*
+ * All ciphers in stream-ciphers/ implement the same ECRYPT_* API. The
+ * names are given a per-cipher prefix here so that several ciphers can be
+ * linked into one program; code including this header keeps using the
+ * ECRYPT_* names.
+ */
+#define ECRYPT_ctx               hc128_ECRYPT_ctx
+#define ECRYPT_init              hc128_ECRYPT_init
+#define ECRYPT_keysetup          hc128_ECRYPT_keysetup
+#define ECRYPT_ivsetup           hc128_ECRYPT_ivsetup
+#define ECRYPT_process_bytes     hc128_ECRYPT_process_bytes
+#define ECRYPT_process_bytes64   hc128_ECRYPT_process_bytes64
+#define ECRYPT_keystream_bytes   hc128_ECRYPT_keystream_bytes
+#define ECRYPT_keystream_bytes64 hc128_ECRYPT_keystream_bytes64
+#define ECRYPT_process_packet    hc128_ECRYPT_process_packet
+
+/* ------------------------------------------------------------------------- */
+
 /* Cipher parameters */
 
 /* 
@@ -72,6 +92,19 @@
  * internal state of your cipher. 
  */
 
+/*
+ * P and Q start on a cache line, so the 4 KiB of tables take 64 lines.
+ * A context on the heap therefore needs 64-byte aligned memory
+ * (aligned_alloc, or new in C++17).
+ */
+#if defined(__GNUC__)
+#define HC128_ALIGN __attribute__((aligned(64)))
+#elif defined(_MSC_VER)
+#define HC128_ALIGN __declspec(align(64))
+#else
+#define HC128_ALIGN
+#endif
+
 typedef struct
 {
   /* 
@@ -79,7 +112,7 @@ typedef struct
    *
    * Put here all state variable needed during the encryption process.
   */
-  u32 T[1024];       /* P[i] = T[i]; Q[i] = T[1024+i];*/
+  HC128_ALIGN u32 T[1024]; /* P[i] = T[i]; Q[i] = T[512+i];*/
   u32 X[16];
   u32 Y[16];
   u32 counter1024;   /*counter1024 = i mod 1024 at the i-th step */ 
@@ -97,6 +130,21 @@ void generate_keystream(ECRYPT_ctx* ctx, u32* keystream);
 
 void setup_update(ECRYPT_ctx* ctx);
 
+/*
+ * Rekeying. HC-128 mixes the key and the IV from the first step of the
+ * table expansion, so only the key words carry over between IVs:
+ * ECRYPT_keysetup stores them once and every ECRYPT_ivsetup runs the
+ * 2304 initialization steps. hc128_ivsetup_batch sets up count contexts
+ * with the key of `key` (set by ECRYPT_keysetup; it may be one of ctx)
+ * and the IV iv[i] each, 8 at a time with AVX2 when the CPU has it, which
+ * makes per-packet rekeying several times cheaper.
+ */
+void hc128_ivsetup_batch(
+  const ECRYPT_ctx* key,
+  ECRYPT_ctx* const ctx[],
+  const u8* const iv[],
+  u32 count);
+
 /* ------------------------------------------------------------------------- */
 
 /* Mandatory functions */
@@ -230,6 +278,60 @@ void ECRYPT_keystream_bytes(
 
 /* ------------------------------------------------------------------------- */
 
+/* 64-bit lengths */
+
+/*
+ * The functions above take u32 lengths, so a single call handles less
+ * than 4 GiB. The *_bytes64 variants accept any length: they call the
+ * u32 functions on chunks of ECRYPT_CHUNKLENGTH bytes, a whole number of
+ * blocks, so the output and the final state are the same as one call
+ * with the full length would give.
+ */
+#define ECRYPT_CHUNKLENGTH \
+  (0xFFFFFFFFUL / ECRYPT_BLOCKLENGTH * ECRYPT_BLOCKLENGTH)
+
+#ifdef ECRYPT_HAS_SINGLE_BYTE_FUNCTION
+
+#define ECRYPT_encrypt_bytes64(ctx, plaintext, ciphertext, msglen) \
+  ECRYPT_process_bytes64(0, ctx, plaintext, ciphertext, msglen)
+
+#define ECRYPT_decrypt_bytes64(ctx, ciphertext, plaintext, msglen) \
+  ECRYPT_process_bytes64(1, ctx, ciphertext, plaintext, msglen)
+
+void ECRYPT_process_bytes64(
+  int action,                 /* 0 = encrypt; 1 = decrypt; */
+  ECRYPT_ctx* ctx, 
+  const u8* input, 
+  u8* output, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#else
+
+void ECRYPT_encrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* plaintext, 
+  u8* ciphertext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+void ECRYPT_decrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* ciphertext, 
+  u8* plaintext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#endif
+
+#ifdef ECRYPT_GENERATES_KEYSTREAM
+
+void ECRYPT_keystream_bytes64(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u64 length);                /* Length of keystream in bytes. */
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
 /* Optional optimizations */
 
 /* 
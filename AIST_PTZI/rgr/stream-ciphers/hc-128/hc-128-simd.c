@@ -0,0 +1,178 @@
+/*
+ * SIMD HC-128 initialization: 8 contexts at once.
+ *
+ * Lane k of vector W[i] holds T[i] of context k. The table expansion is
+ * plain arithmetic, and during the 1024 setup steps all contexts touch the
+ * same table positions, so every step runs on 8 contexts like update_P and
+ * update_Q; only the h1/h2 lookups depend on the data and use gathers.
+ * The tables are transposed back into the contexts at the end.
+ */
+
+#include "hc-128-simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+#define ADD(a,b) _mm256_add_epi32((a),(b))
+#define XOR(a,b) _mm256_xor_si256((a),(b))
+#define ROTR(x,n) _mm256_or_si256(_mm256_srli_epi32((x),(n)),_mm256_slli_epi32((x),32-(n)))
+
+#define F1(x) XOR(XOR(ROTR((x),7),ROTR((x),18)),_mm256_srli_epi32((x),3))
+#define F2(x) XOR(XOR(ROTR((x),17),ROTR((x),19)),_mm256_srli_epi32((x),10))
+
+/* T[base+(u8)x] + T[base+256+(u8)(x>>16)] in every lane */
+#define H(W,x,base,y) { \
+     __m256i ia,ic; \
+     ia = _mm256_and_si256((x),byte); \
+     ic = _mm256_and_si256(_mm256_srli_epi32((x),16),byte); \
+     ia = ADD(_mm256_slli_epi32(ia,3),_mm256_set1_epi32(8*(base))); \
+     ic = ADD(_mm256_slli_epi32(ic,3),_mm256_set1_epi32(8*((base)+256))); \
+     ia = ADD(ia,lane); \
+     ic = ADD(ic,lane); \
+     y = ADD(_mm256_i32gather_epi32((const int*)(W),ia,4), \
+             _mm256_i32gather_epi32((const int*)(W),ic,4)); \
+}
+
+/* update_P and update_Q on 8 contexts */
+#define UPDATE_P(W,X,u,v,a,b,c,d) { \
+     __m256i tem0,tem1,tem2,tem3; \
+     tem0 = ROTR(W[(v)],23); \
+     tem1 = ROTR(X[(c)],10); \
+     tem2 = ROTR(X[(b)],8); \
+     H(W,X[(d)],512,tem3); \
+     W[(u)] = XOR(ADD(W[(u)],ADD(tem2,XOR(tem0,tem1))),tem3); \
+     X[(a)] = W[(u)]; \
+}
+
+#define UPDATE_Q(W,Y,u,v,a,b,c,d) { \
+     __m256i tem0,tem1,tem2,tem3; \
+     tem0 = ROTR(W[(v)],32-23); \
+     tem1 = ROTR(Y[(c)],32-10); \
+     tem2 = ROTR(Y[(b)],32-8); \
+     H(W,Y[(d)],0,tem3); \
+     W[(u)] = XOR(ADD(W[(u)],ADD(tem2,XOR(tem0,tem1))),tem3); \
+     Y[(a)] = W[(u)]; \
+}
+
+#define UPDATE16(UPDATE,W,S,o,cc,dd) { \
+     UPDATE(W,S,o+cc+0, o+cc+1, 0, 6, 13,4); \
+     UPDATE(W,S,o+cc+1, o+cc+2, 1, 7, 14,5); \
+     UPDATE(W,S,o+cc+2, o+cc+3, 2, 8, 15,6); \
+     UPDATE(W,S,o+cc+3, o+cc+4, 3, 9, 0, 7); \
+     UPDATE(W,S,o+cc+4, o+cc+5, 4, 10,1, 8); \
+     UPDATE(W,S,o+cc+5, o+cc+6, 5, 11,2, 9); \
+     UPDATE(W,S,o+cc+6, o+cc+7, 6, 12,3, 10); \
+     UPDATE(W,S,o+cc+7, o+cc+8, 7, 13,4, 11); \
+     UPDATE(W,S,o+cc+8, o+cc+9, 8, 14,5, 12); \
+     UPDATE(W,S,o+cc+9, o+cc+10,9, 15,6, 13); \
+     UPDATE(W,S,o+cc+10,o+cc+11,10,0, 7, 14); \
+     UPDATE(W,S,o+cc+11,o+cc+12,11,1, 8, 15); \
+     UPDATE(W,S,o+cc+12,o+cc+13,12,2, 9, 0); \
+     UPDATE(W,S,o+cc+13,o+cc+14,13,3, 10,1); \
+     UPDATE(W,S,o+cc+14,o+cc+15,14,4, 11,2); \
+     UPDATE(W,S,o+cc+15,o+dd+0, 15,5, 12,3); \
+}
+
+/* words w[0..7] of 8 contexts -> 8 words of each context, stored at out[k] */
+__attribute__((target("avx2")))
+static void hc128_transpose8(const __m256i w[8],u32* const out[8])
+{
+  __m256i a0,a1,a2,a3,a4,a5,a6,a7,b0,b1,b2,b3,b4,b5,b6,b7;
+
+  a0 = _mm256_unpacklo_epi32(w[0],w[1]);
+  a1 = _mm256_unpackhi_epi32(w[0],w[1]);
+  a2 = _mm256_unpacklo_epi32(w[2],w[3]);
+  a3 = _mm256_unpackhi_epi32(w[2],w[3]);
+  a4 = _mm256_unpacklo_epi32(w[4],w[5]);
+  a5 = _mm256_unpackhi_epi32(w[4],w[5]);
+  a6 = _mm256_unpacklo_epi32(w[6],w[7]);
+  a7 = _mm256_unpackhi_epi32(w[6],w[7]);
+  b0 = _mm256_unpacklo_epi64(a0,a2);
+  b1 = _mm256_unpackhi_epi64(a0,a2);
+  b2 = _mm256_unpacklo_epi64(a1,a3);
+  b3 = _mm256_unpackhi_epi64(a1,a3);
+  b4 = _mm256_unpacklo_epi64(a4,a6);
+  b5 = _mm256_unpackhi_epi64(a4,a6);
+  b6 = _mm256_unpacklo_epi64(a5,a7);
+  b7 = _mm256_unpackhi_epi64(a5,a7);
+  _mm256_storeu_si256((__m256i*)out[0],_mm256_permute2x128_si256(b0,b4,0x20));
+  _mm256_storeu_si256((__m256i*)out[1],_mm256_permute2x128_si256(b1,b5,0x20));
+  _mm256_storeu_si256((__m256i*)out[2],_mm256_permute2x128_si256(b2,b6,0x20));
+  _mm256_storeu_si256((__m256i*)out[3],_mm256_permute2x128_si256(b3,b7,0x20));
+  _mm256_storeu_si256((__m256i*)out[4],_mm256_permute2x128_si256(b0,b4,0x31));
+  _mm256_storeu_si256((__m256i*)out[5],_mm256_permute2x128_si256(b1,b5,0x31));
+  _mm256_storeu_si256((__m256i*)out[6],_mm256_permute2x128_si256(b2,b6,0x31));
+  _mm256_storeu_si256((__m256i*)out[7],_mm256_permute2x128_si256(b3,b7,0x31));
+}
+
+/* words [first, first + 8 * n) of the lanes into the same words of dst */
+#define HC128_STORE(w,field,first,n) \
+  for (i = 0;i < (n);i++) { \
+    for (k = 0;k < 8;k++) out[k] = ctx[k]->field + (first) + 8 * i; \
+    hc128_transpose8((w) + 8 * i,out); \
+  }
+
+__attribute__((target("avx2")))
+void hc128_ivsetup_lanes(ECRYPT_ctx* const ctx[])
+{
+  __attribute__((aligned(32))) __m256i W[1024];
+  __m256i X[16],Y[16];
+  const __m256i byte = _mm256_set1_epi32(0xff);
+  const __m256i lane = _mm256_setr_epi32(0,1,2,3,4,5,6,7);
+  u32* out[8];
+  u32 i,k,cc,dd;
+
+  /* expand the keys and IVs into the tables, as in ECRYPT_ivsetup */
+  for (i = 0;i < 8;i++) {
+    W[i] = _mm256_setr_epi32(ctx[0]->key[i],ctx[1]->key[i],ctx[2]->key[i],ctx[3]->key[i],
+                             ctx[4]->key[i],ctx[5]->key[i],ctx[6]->key[i],ctx[7]->key[i]);
+    W[8 + i] = _mm256_setr_epi32(ctx[0]->iv[i],ctx[1]->iv[i],ctx[2]->iv[i],ctx[3]->iv[i],
+                                 ctx[4]->iv[i],ctx[5]->iv[i],ctx[6]->iv[i],ctx[7]->iv[i]);
+  }
+
+  for (i = 16;i < 256 + 16;i++)
+    W[i] = ADD(ADD(F2(W[i - 2]),W[i - 7]),ADD(ADD(F1(W[i - 15]),W[i - 16]),_mm256_set1_epi32(i)));
+
+  for (i = 0;i < 16;i++) W[i] = W[256 + i];
+
+  for (i = 16;i < 1024;i++)
+    W[i] = ADD(ADD(F2(W[i - 2]),W[i - 7]),ADD(ADD(F1(W[i - 15]),W[i - 16]),_mm256_set1_epi32(256 + i)));
+
+  for (i = 0;i < 16;i++) X[i] = W[512 - 16 + i];
+  for (i = 0;i < 16;i++) Y[i] = W[512 + 512 - 16 + i];
+
+  /* 1024 steps: 512 updating P, then 512 updating Q */
+  for (cc = 0;cc < 512;cc += 16) {
+    dd = (cc + 16) & 0x1ff;
+    UPDATE16(UPDATE_P,W,X,0,cc,dd);
+  }
+  for (cc = 0;cc < 512;cc += 16) {
+    dd = (cc + 16) & 0x1ff;
+    UPDATE16(UPDATE_Q,W,Y,512,cc,dd);
+  }
+
+  HC128_STORE(W,T,0,128);
+  HC128_STORE(X,X,0,2);
+  HC128_STORE(Y,Y,0,2);
+  for (k = 0;k < 8;k++) ctx[k]->counter1024 = 0;
+}
+
+int hc128_simd_lanes(void)
+{
+  if (__builtin_cpu_supports("avx2")) return 8;
+  return 0;
+}
+
+#else
+
+int hc128_simd_lanes(void)
+{
+  return 0;
+}
+
+void hc128_ivsetup_lanes(ECRYPT_ctx* const ctx[])
+{
+  (void)ctx;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HC128_SIMD_H
+#define HC128_SIMD_H
+
+#include "ecrypt-sync.h"
+
+/*
+ * Number of contexts hc128_ivsetup_lanes initializes at once:
+ * 8 (AVX2) or 0 (scalar only).
+ */
+int hc128_simd_lanes(void);
+
+/*
+ * ECRYPT_ivsetup for 8 contexts at once. ctx[i]->key and ctx[i]->iv must
+ * already hold the key and IV words; the contexts may have different keys.
+ */
+void hc128_ivsetup_lanes(ECRYPT_ctx* const ctx[]);
+
+#endif
@@ -1,6 +1,13 @@
 
 #include "ecrypt-sync.h"
 #include "hc-128.h"
+#include "hc-128-simd.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* =====================================================================
  *     The following defines the keystream generation function          
@@ -147,17 +154,23 @@ void ECRYPT_keysetup(
 } /* initialize the key, save the iv size*/
 
 
-void ECRYPT_ivsetup(ECRYPT_ctx* ctx, const u8* iv)
-{ 
+/* initialize the iv */
+static void load_iv(ECRYPT_ctx* ctx, const u8* iv)
+{
     u32 i;
-	
-    /* initialize the iv */
+
     /* IV size in bits  128*/
 
 	for (i = 0; i < (ctx->ivsize >> 5); i++)  ctx->iv[i] = U32TO32_LITTLE(((u32*)iv)[i]);
 	
     for (; i < 8; i++) ctx->iv[i] = ctx->iv[i-4];
-  
+}
+
+/* the 2304 initialization steps on the key and IV words */
+static void init_tables(ECRYPT_ctx* ctx)
+{ 
+    u32 i;
+	
     /* expand the key and IV into the table T */ 
     /* (expand the key and IV into the table P and Q) */ 
 	
@@ -181,11 +194,75 @@ void ECRYPT_ivsetup(ECRYPT_ctx* ctx, const u8* iv)
 	for (i = 0; i < 64; i++)  setup_update(ctx);  
 }
 
+void ECRYPT_ivsetup(ECRYPT_ctx* ctx, const u8* iv)
+{
+    load_iv(ctx, iv);
+    init_tables(ctx);
+}
+
+void hc128_ivsetup_batch(
+  const ECRYPT_ctx* key,
+  ECRYPT_ctx* const ctx[],
+  const u8* const iv[],
+  u32 count)
+{
+  u32 i;
+
+  for (i = 0; i < count; i++)
+  {
+      if (ctx[i] != key)
+      {
+          memcpy(ctx[i]->key, key->key, sizeof(key->key));
+          ctx[i]->keysize = key->keysize;
+          ctx[i]->ivsize = key->ivsize;
+      }
+      load_iv(ctx[i], iv[i]);
+  }
+
+  /* 8 contexts per SIMD call, the rest one by one */
+  i = 0;
+  if (hc128_simd_lanes() == 8)
+      for ( ; count - i >= 8; i += 8) hc128_ivsetup_lanes(ctx + i);
+
+  for ( ; i < count; i++) init_tables(ctx[i]);
+}
+
 /*========================================================
  *  The following defines the encryption of data stream
  *========================================================
  */
 
+/* keystream blocks generated per batch before they are XORed in */
+#define HC128_BATCH 8
+
+/* keystream for a number of 64-byte blocks as little-endian bytes */
+static void keystream_words(ECRYPT_ctx* ctx, u32* keystream, u32 blocks)
+{
+  u32 i;
+
+  for (i = 0; i < blocks; i++) generate_keystream(ctx, keystream + 16 * i);
+
+#ifndef ECRYPT_LITTLE_ENDIAN
+  for (i = 0; i < 16 * blocks; i++) keystream[i] = U32TO32_LITTLE(keystream[i]);
+#endif
+}
+
+/* output = input ^ keystream, msglen a multiple of 16; input and output
+ * need no alignment */
+static void xor_keystream(const u8* input, const u8* keystream, u8* output, u32 msglen)
+{
+  u32 i;
+
+#ifdef __SSE2__
+  for (i = 0; i < msglen; i += 16)
+      _mm_storeu_si128((__m128i*)(output + i),
+          _mm_xor_si128(_mm_loadu_si128((const __m128i*)(input + i)),
+                        _mm_load_si128((const __m128i*)(keystream + i))));
+#else
+  for (i = 0; i < msglen; i++) output[i] = input[i] ^ keystream[i];
+#endif
+}
+
 void ECRYPT_process_bytes(
   int action,                 /* 0 = encrypt; 1 = decrypt; */
   ECRYPT_ctx* ctx, 
@@ -193,39 +270,82 @@ void ECRYPT_process_bytes(
   u8* output, 
   u32 msglen)                /* Message length in bytes. */ 
 {
-  u32 i, keystream[16];
+  u32 i, blocks;
+  HC128_ALIGN u32 keystream[16 * HC128_BATCH];
 
-  for ( ; msglen >= 64; msglen -= 64, input += 64, output += 64)
+  (void)action;
+
+  /* whole blocks, a batch at a time */
+  for ( ; msglen >= 64; msglen -= 64 * blocks, input += 64 * blocks, output += 64 * blocks)
   {
-	  generate_keystream(ctx, keystream);
-
-      /*for (i = 0; i < 16; ++i)
-	      ((u32*)output)[i] = ((u32*)input)[i] ^ U32TO32_LITTLE(keystream[i]); */
-
-	  ((u32*)output)[0]  = ((u32*)input)[0]  ^ U32TO32_LITTLE(keystream[0]);
-	  ((u32*)output)[1]  = ((u32*)input)[1]  ^ U32TO32_LITTLE(keystream[1]);
-	  ((u32*)output)[2]  = ((u32*)input)[2]  ^ U32TO32_LITTLE(keystream[2]);
-	  ((u32*)output)[3]  = ((u32*)input)[3]  ^ U32TO32_LITTLE(keystream[3]);
-	  ((u32*)output)[4]  = ((u32*)input)[4]  ^ U32TO32_LITTLE(keystream[4]);
-	  ((u32*)output)[5]  = ((u32*)input)[5]  ^ U32TO32_LITTLE(keystream[5]);
-	  ((u32*)output)[6]  = ((u32*)input)[6]  ^ U32TO32_LITTLE(keystream[6]);
-	  ((u32*)output)[7]  = ((u32*)input)[7]  ^ U32TO32_LITTLE(keystream[7]);
-	  ((u32*)output)[8]  = ((u32*)input)[8]  ^ U32TO32_LITTLE(keystream[8]);
-	  ((u32*)output)[9]  = ((u32*)input)[9]  ^ U32TO32_LITTLE(keystream[9]);
-	  ((u32*)output)[10] = ((u32*)input)[10] ^ U32TO32_LITTLE(keystream[10]);
-	  ((u32*)output)[11] = ((u32*)input)[11] ^ U32TO32_LITTLE(keystream[11]);
-	  ((u32*)output)[12] = ((u32*)input)[12] ^ U32TO32_LITTLE(keystream[12]);
-	  ((u32*)output)[13] = ((u32*)input)[13] ^ U32TO32_LITTLE(keystream[13]);
-	  ((u32*)output)[14] = ((u32*)input)[14] ^ U32TO32_LITTLE(keystream[14]);
-	  ((u32*)output)[15] = ((u32*)input)[15] ^ U32TO32_LITTLE(keystream[15]);
+      blocks = msglen / 64 < HC128_BATCH ? msglen / 64 : HC128_BATCH;
+      keystream_words(ctx, keystream, blocks);
+      xor_keystream(input, (u8*)keystream, output, 64 * blocks);
   }
 
   if (msglen > 0)
   {
-      generate_keystream(ctx, keystream);
+      keystream_words(ctx, keystream, 1);
 
       for (i = 0; i < msglen; i ++)
 	      output[i] = input[i] ^ ((u8*)keystream)[i];
   }
 
 }
+
+/* keystream generated a batch at a time into an aligned buffer and copied
+ * out, so the caller's bytes are never accessed as words */
+void ECRYPT_keystream_bytes(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u32 length)                /* Length of keystream in bytes. */
+{
+  u32 blocks;
+  HC128_ALIGN u32 buffer[16 * HC128_BATCH];
+
+  for ( ; length >= 64; length -= 64 * blocks, keystream += 64 * blocks)
+  {
+      blocks = length / 64 < HC128_BATCH ? length / 64 : HC128_BATCH;
+      keystream_words(ctx, buffer, blocks);
+      memcpy(keystream, buffer, 64 * blocks);
+  }
+
+  if (length > 0)
+  {
+      keystream_words(ctx, buffer, 1);
+      memcpy(keystream, buffer, length);
+  }
+}
+
+/* messages of any length: whole chunks of blocks, then the rest */
+void ECRYPT_process_bytes64(
+  int action,                 /* 0 = encrypt; 1 = decrypt; */
+  ECRYPT_ctx* ctx, 
+  const u8* input, 
+  u8* output, 
+  u64 msglen)                /* Message length in bytes. */ 
+{
+  for ( ; msglen > ECRYPT_CHUNKLENGTH; msglen -= ECRYPT_CHUNKLENGTH)
+  {
+      ECRYPT_process_bytes(action, ctx, input, output, ECRYPT_CHUNKLENGTH);
+      input += ECRYPT_CHUNKLENGTH;
+      output += ECRYPT_CHUNKLENGTH;
+  }
+
+  ECRYPT_process_bytes(action, ctx, input, output, (u32)msglen);
+}
+
+/* keystream of any length: whole chunks of blocks, then the rest */
+void ECRYPT_keystream_bytes64(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u64 length)                /* Length of keystream in bytes. */
+{
+  for ( ; length > ECRYPT_CHUNKLENGTH; length -= ECRYPT_CHUNKLENGTH)
+  {
+      ECRYPT_keystream_bytes(ctx, keystream, ECRYPT_CHUNKLENGTH);
+      keystream += ECRYPT_CHUNKLENGTH;
+  }
+
+  ECRYPT_keystream_bytes(ctx, keystream, (u32)length);
+}
@@ -117,4 +117,21 @@ void ECRYPT_process_bytes(
   ECRYPT_ctx* ctx, 
   const u8* input, 
   u8* output, 
-  u32 msglen);               /* Message length in bytes. */ 
\ No newline at end of file
+  u32 msglen);               /* Message length in bytes. */ 
+
+void ECRYPT_process_bytes64(
+  int action,                 /* 0 = encrypt; 1 = decrypt; */
+  ECRYPT_ctx* ctx, 
+  const u8* input, 
+  u8* output, 
+  u64 msglen);               /* Message length in bytes. */
+
+void ECRYPT_keystream_bytes(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u32 length);               /* Length of keystream in bytes. */
+
+void ECRYPT_keystream_bytes64(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u64 length);               /* Length of keystream in bytes. */
\ No newline at end of file
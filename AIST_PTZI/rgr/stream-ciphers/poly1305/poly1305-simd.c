@@ -0,0 +1,238 @@
+/*
+ * AVX2 Poly1305: four Horner chains in the 64-bit lanes of 26-bit limb
+ * vectors. Lane j absorbs blocks j, j + 4, j + 8, ... and is multiplied by
+ * r^4 between groups; the last group is multiplied by r^4, r^3, r^2, r^1
+ * (lane 0..3) and the lanes are summed, which gives the same value as the
+ * scalar h = (h + m) * r per block. _mm256_mul_epu32 multiplies the low
+ * 32 bits of each lane, and 26-bit limbs keep the five-term sums of
+ * products below 2^64.
+ *
+ * The AVX-512 kernel is the same with eight chains, r^8 between groups and
+ * r^8..r^1 at the end; a last group of four blocks goes to the AVX2 kernel.
+ */
+
+#include "poly1305-simd.h"
+
+#define MASK26 0x3ffffffU
+#define MASK44 0xfffffffffffULL
+
+void poly1305_limbs26(uint32_t out[5],const uint64_t h[3])
+{
+  uint64_t h0 = h[0], h1 = h[1], h2 = h[2];
+
+  /* h1 may carry into h2; h0 is always below 2^44 */
+  h2 += h1 >> 44;
+  h1 &= MASK44;
+
+  out[0] = (uint32_t)(h0 & MASK26);
+  out[1] = (uint32_t)(((h0 >> 26) | (h1 << 18)) & MASK26);
+  out[2] = (uint32_t)((h1 >> 8) & MASK26);
+  out[3] = (uint32_t)(((h1 >> 34) | (h2 << 10)) & MASK26);
+  out[4] = (uint32_t)(h2 >> 16);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+#define MUL(a,b) _mm256_mul_epu32(a,b)
+#define ADD(a,b) _mm256_add_epi64(a,b)
+
+/* h = h * r mod p per lane, s[i] = 5 * r[i] */
+__attribute__((target("avx2")))
+static void poly1305_mul4(__m256i h[5],const __m256i r[5],const __m256i s[5])
+{
+  const __m256i mask = _mm256_set1_epi64x(MASK26);
+  __m256i d0, d1, d2, d3, d4, c;
+
+  d0 = ADD(ADD(ADD(ADD(MUL(h[0],r[0]),MUL(h[1],s[4])),MUL(h[2],s[3])),MUL(h[3],s[2])),MUL(h[4],s[1]));
+  d1 = ADD(ADD(ADD(ADD(MUL(h[0],r[1]),MUL(h[1],r[0])),MUL(h[2],s[4])),MUL(h[3],s[3])),MUL(h[4],s[2]));
+  d2 = ADD(ADD(ADD(ADD(MUL(h[0],r[2]),MUL(h[1],r[1])),MUL(h[2],r[0])),MUL(h[3],s[4])),MUL(h[4],s[3]));
+  d3 = ADD(ADD(ADD(ADD(MUL(h[0],r[3]),MUL(h[1],r[2])),MUL(h[2],r[1])),MUL(h[3],r[0])),MUL(h[4],s[4]));
+  d4 = ADD(ADD(ADD(ADD(MUL(h[0],r[4]),MUL(h[1],r[3])),MUL(h[2],r[2])),MUL(h[3],r[1])),MUL(h[4],r[0]));
+
+  c = _mm256_srli_epi64(d0,26); h[0] = _mm256_and_si256(d0,mask); d1 = ADD(d1,c);
+  c = _mm256_srli_epi64(d1,26); h[1] = _mm256_and_si256(d1,mask); d2 = ADD(d2,c);
+  c = _mm256_srli_epi64(d2,26); h[2] = _mm256_and_si256(d2,mask); d3 = ADD(d3,c);
+  c = _mm256_srli_epi64(d3,26); h[3] = _mm256_and_si256(d3,mask); d4 = ADD(d4,c);
+  c = _mm256_srli_epi64(d4,26); h[4] = _mm256_and_si256(d4,mask);
+  h[0] = ADD(h[0],ADD(c,_mm256_slli_epi64(c,2)));
+  c = _mm256_srli_epi64(h[0],26); h[0] = _mm256_and_si256(h[0],mask); h[1] = ADD(h[1],c);
+}
+
+/* h += blocks m[0..3], block j into lane j */
+__attribute__((target("avx2")))
+static void poly1305_add4(__m256i h[5],const uint8_t *m)
+{
+  const __m256i mask = _mm256_set1_epi64x(MASK26);
+  __m256i a = _mm256_loadu_si256((const __m256i *)m);
+  __m256i b = _mm256_loadu_si256((const __m256i *)(m + 32));
+  __m256i lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a,b),0xD8);
+  __m256i hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a,b),0xD8);
+
+  h[0] = ADD(h[0],_mm256_and_si256(lo,mask));
+  h[1] = ADD(h[1],_mm256_and_si256(_mm256_srli_epi64(lo,26),mask));
+  h[2] = ADD(h[2],_mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo,52),_mm256_slli_epi64(hi,12)),mask));
+  h[3] = ADD(h[3],_mm256_and_si256(_mm256_srli_epi64(hi,14),mask));
+  h[4] = ADD(h[4],_mm256_or_si256(_mm256_srli_epi64(hi,40),_mm256_set1_epi64x(1 << 24)));
+}
+
+__attribute__((target("avx2")))
+static void poly1305_blocks4(uint64_t h[3],const uint32_t *powers,const uint8_t *m,size_t groups)
+{
+  __m256i acc[5], r[5], s[5];
+  uint64_t lane[5][4], l[5], t;
+  uint32_t h26[5];
+  size_t g;
+  int i;
+
+  poly1305_limbs26(h26,h);
+  for (i = 0;i < 5;++i) {
+    acc[i] = _mm256_set_epi64x(0,0,0,h26[i]);
+    r[i] = _mm256_set1_epi64x(powers[15 + i]);
+    s[i] = _mm256_set1_epi64x(5 * (uint64_t)powers[15 + i]);
+  }
+
+  for (g = 0;g + 1 < groups;++g,m += 64) {
+    poly1305_add4(acc,m);
+    poly1305_mul4(acc,r,s);
+  }
+  poly1305_add4(acc,m);
+
+  /* lane j times r^(4 - j) */
+  for (i = 0;i < 5;++i) {
+    r[i] = _mm256_set_epi64x(powers[i],powers[5 + i],powers[10 + i],powers[15 + i]);
+    s[i] = _mm256_set_epi64x(5 * (uint64_t)powers[i],5 * (uint64_t)powers[5 + i],
+      5 * (uint64_t)powers[10 + i],5 * (uint64_t)powers[15 + i]);
+  }
+  poly1305_mul4(acc,r,s);
+
+  for (i = 0;i < 5;++i) {
+    _mm256_storeu_si256((__m256i *)lane[i],acc[i]);
+    l[i] = lane[i][0] + lane[i][1] + lane[i][2] + lane[i][3];
+  }
+
+  /* back to 44-bit limbs; adding instead of or-ing absorbs limbs over 26 bits */
+  t = l[0] + (l[1] << 26);
+  h[0] = t & MASK44; t >>= 44;
+  t += (l[2] << 8) + (l[3] << 34);
+  h[1] = t & MASK44; t >>= 44;
+  h[2] = t + (l[4] << 16);
+}
+
+#define MUL8(a,b) _mm512_mul_epu32(a,b)
+#define ADD8(a,b) _mm512_add_epi64(a,b)
+
+__attribute__((target("avx512f")))
+static void poly1305_mul8(__m512i h[5],const __m512i r[5],const __m512i s[5])
+{
+  const __m512i mask = _mm512_set1_epi64(MASK26);
+  __m512i d0, d1, d2, d3, d4, c;
+
+  d0 = ADD8(ADD8(ADD8(ADD8(MUL8(h[0],r[0]),MUL8(h[1],s[4])),MUL8(h[2],s[3])),MUL8(h[3],s[2])),MUL8(h[4],s[1]));
+  d1 = ADD8(ADD8(ADD8(ADD8(MUL8(h[0],r[1]),MUL8(h[1],r[0])),MUL8(h[2],s[4])),MUL8(h[3],s[3])),MUL8(h[4],s[2]));
+  d2 = ADD8(ADD8(ADD8(ADD8(MUL8(h[0],r[2]),MUL8(h[1],r[1])),MUL8(h[2],r[0])),MUL8(h[3],s[4])),MUL8(h[4],s[3]));
+  d3 = ADD8(ADD8(ADD8(ADD8(MUL8(h[0],r[3]),MUL8(h[1],r[2])),MUL8(h[2],r[1])),MUL8(h[3],r[0])),MUL8(h[4],s[4]));
+  d4 = ADD8(ADD8(ADD8(ADD8(MUL8(h[0],r[4]),MUL8(h[1],r[3])),MUL8(h[2],r[2])),MUL8(h[3],r[1])),MUL8(h[4],r[0]));
+
+  c = _mm512_srli_epi64(d0,26); h[0] = _mm512_and_si512(d0,mask); d1 = ADD8(d1,c);
+  c = _mm512_srli_epi64(d1,26); h[1] = _mm512_and_si512(d1,mask); d2 = ADD8(d2,c);
+  c = _mm512_srli_epi64(d2,26); h[2] = _mm512_and_si512(d2,mask); d3 = ADD8(d3,c);
+  c = _mm512_srli_epi64(d3,26); h[3] = _mm512_and_si512(d3,mask); d4 = ADD8(d4,c);
+  c = _mm512_srli_epi64(d4,26); h[4] = _mm512_and_si512(d4,mask);
+  h[0] = ADD8(h[0],ADD8(c,_mm512_slli_epi64(c,2)));
+  c = _mm512_srli_epi64(h[0],26); h[0] = _mm512_and_si512(h[0],mask); h[1] = ADD8(h[1],c);
+}
+
+/* h += blocks m[0..7], block j into lane j */
+__attribute__((target("avx512f")))
+static void poly1305_add8(__m512i h[5],const uint8_t *m)
+{
+  const __m512i mask = _mm512_set1_epi64(MASK26);
+  __m512i a = _mm512_loadu_si512((const void *)m);
+  __m512i b = _mm512_loadu_si512((const void *)(m + 64));
+  __m512i lo = _mm512_permutex2var_epi64(a,_mm512_set_epi64(14,12,10,8,6,4,2,0),b);
+  __m512i hi = _mm512_permutex2var_epi64(a,_mm512_set_epi64(15,13,11,9,7,5,3,1),b);
+
+  h[0] = ADD8(h[0],_mm512_and_si512(lo,mask));
+  h[1] = ADD8(h[1],_mm512_and_si512(_mm512_srli_epi64(lo,26),mask));
+  h[2] = ADD8(h[2],_mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(lo,52),_mm512_slli_epi64(hi,12)),mask));
+  h[3] = ADD8(h[3],_mm512_and_si512(_mm512_srli_epi64(hi,14),mask));
+  h[4] = ADD8(h[4],_mm512_or_si512(_mm512_srli_epi64(hi,40),_mm512_set1_epi64(1 << 24)));
+}
+
+__attribute__((target("avx512f")))
+static void poly1305_blocks8(uint64_t h[3],const uint32_t *powers,const uint8_t *m,size_t groups)
+{
+  __m512i acc[5], r[5], s[5];
+  uint64_t l[5], t;
+  uint32_t h26[5];
+  size_t g;
+  int i;
+
+  poly1305_limbs26(h26,h);
+  for (i = 0;i < 5;++i) {
+    acc[i] = _mm512_set_epi64(0,0,0,0,0,0,0,h26[i]);
+    r[i] = _mm512_set1_epi64(powers[35 + i]);
+    s[i] = _mm512_set1_epi64(5 * (uint64_t)powers[35 + i]);
+  }
+
+  for (g = 0;g + 1 < groups;++g,m += 128) {
+    poly1305_add8(acc,m);
+    poly1305_mul8(acc,r,s);
+  }
+  poly1305_add8(acc,m);
+
+  /* lane j times r^(8 - j) */
+  for (i = 0;i < 5;++i) {
+    r[i] = _mm512_set_epi64(powers[i],powers[5 + i],powers[10 + i],powers[15 + i],
+      powers[20 + i],powers[25 + i],powers[30 + i],powers[35 + i]);
+    s[i] = _mm512_slli_epi64(r[i],2);
+    s[i] = ADD8(s[i],r[i]);
+  }
+  poly1305_mul8(acc,r,s);
+
+  for (i = 0;i < 5;++i) l[i] = (uint64_t)_mm512_reduce_add_epi64(acc[i]);
+
+  t = l[0] + (l[1] << 26);
+  h[0] = t & MASK44; t >>= 44;
+  t += (l[2] << 8) + (l[3] << 34);
+  h[1] = t & MASK44; t >>= 44;
+  h[2] = t + (l[4] << 16);
+}
+
+int poly1305_simd_max_lanes(void)
+{
+  if (__builtin_cpu_supports("avx512f")) return 8;
+  return __builtin_cpu_supports("avx2") ? 4 : 0;
+}
+
+size_t poly1305_simd_blocks(uint64_t h[3],const uint32_t *powers,const uint8_t *m,size_t blocks,int lanes)
+{
+  size_t done = 0;
+
+  if (lanes > poly1305_simd_max_lanes()) lanes = poly1305_simd_max_lanes();
+  if (lanes >= 8 && blocks >= 8) {
+    done = blocks / 8 * 8;
+    poly1305_blocks8(h,powers,m,done / 8);
+  }
+  if (lanes >= 4 && blocks - done >= 4) {
+    poly1305_blocks4(h,powers,m + 16 * done,(blocks - done) / 4);
+    done += (blocks - done) / 4 * 4;
+  }
+  return done;
+}
+
+#else
+
+int poly1305_simd_max_lanes(void)
+{
+  return 0;
+}
+
+size_t poly1305_simd_blocks(uint64_t h[3],const uint32_t *powers,const uint8_t *m,size_t blocks,int lanes)
+{
+  (void)h; (void)powers; (void)m; (void)blocks; (void)lanes;
+  return 0;
+}
+
+#endif
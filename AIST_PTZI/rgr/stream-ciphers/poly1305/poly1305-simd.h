@@ -0,0 +1,22 @@
+#ifndef POLY1305_SIMD_H
+#define POLY1305_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Accumulator or key in 44-bit limbs -> 26-bit limbs, not fully reduced */
+void poly1305_limbs26(uint32_t out[5],const uint64_t h[3]);
+
+/* 8 if the CPU can run the AVX-512 kernel, 4 for AVX2, 0 otherwise */
+int poly1305_simd_max_lanes(void);
+
+/*
+ * Absorbs whole 16-byte blocks (with the 2^128 bit) into the accumulator h,
+ * given in 44-bit limbs, with kernels of at most lanes blocks per step.
+ * powers[5 * k .. 5 * k + 4] is r^(k+1) in 26-bit limbs, k < 8. Returns the
+ * number of blocks done, a multiple of 4; the rest is left to the scalar
+ * code.
+ */
+size_t poly1305_simd_blocks(uint64_t h[3],const uint32_t *powers,const uint8_t *m,size_t blocks,int lanes);
+
+#endif
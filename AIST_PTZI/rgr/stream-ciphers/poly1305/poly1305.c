@@ -0,0 +1,214 @@
+/*
+ * Poly1305 with 44-bit limbs: h and r are 130-bit numbers split at bits 44
+ * and 88, so limb products fit in 128 bits and the reduction by
+ * 2^130 = 5 (mod p) becomes a multiplication by 5 * 4 of the upper limbs.
+ */
+
+#include "poly1305.h"
+#include "poly1305-simd.h"
+
+__extension__ typedef unsigned __int128 u128;
+
+#define MASK44 0xfffffffffffULL
+#define MASK42 0x3ffffffffffULL
+
+/* runs shorter than this stay scalar: the kernel has a fixed setup cost */
+#define POLY1305_SIMD_MIN_BLOCKS 16
+
+/* widest SIMD kernel allowed, see poly1305_set_lanes */
+static int max_lanes = 8;
+
+static uint64_t load64(const uint8_t *p)
+{
+  return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24)
+    | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static void store64(uint8_t *p,uint64_t v)
+{
+  int i;
+  for (i = 0;i < 8;++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+/* h = h * r mod p, h partially reduced (h1 may exceed 44 bits by a carry) */
+static void poly1305_mulmod(uint64_t h[3],const uint64_t r[3])
+{
+  uint64_t s1 = r[1] * (5 << 2), s2 = r[2] * (5 << 2), c;
+  u128 d0, d1, d2;
+
+  d0 = (u128)h[0] * r[0] + (u128)h[1] * s2 + (u128)h[2] * s1;
+  d1 = (u128)h[0] * r[1] + (u128)h[1] * r[0] + (u128)h[2] * s2;
+  d2 = (u128)h[0] * r[2] + (u128)h[1] * r[1] + (u128)h[2] * r[0];
+
+  c = (uint64_t)(d0 >> 44); h[0] = (uint64_t)d0 & MASK44;
+  d1 += c; c = (uint64_t)(d1 >> 44); h[1] = (uint64_t)d1 & MASK44;
+  d2 += c; c = (uint64_t)(d2 >> 42); h[2] = (uint64_t)d2 & MASK42;
+  h[0] += c * 5; c = h[0] >> 44; h[0] &= MASK44;
+  h[1] += c;
+}
+
+static void poly1305_blocks(poly1305_ctx *ctx,const uint8_t *m,size_t blocks,uint64_t hibit)
+{
+  uint64_t t0, t1;
+
+  for (;blocks > 0;--blocks,m += 16) {
+    t0 = load64(m);
+    t1 = load64(m + 8);
+    ctx->h[0] += t0 & MASK44;
+    ctx->h[1] += ((t0 >> 44) | (t1 << 20)) & MASK44;
+    ctx->h[2] += ((t1 >> 24) & MASK42) | hibit;
+    poly1305_mulmod(ctx->h,ctx->r);
+  }
+}
+
+/* r^1..r^8 for the SIMD kernels */
+static void poly1305_powers(poly1305_ctx *ctx)
+{
+  uint64_t p[3];
+  int k;
+
+  p[0] = ctx->r[0]; p[1] = ctx->r[1]; p[2] = ctx->r[2];
+  poly1305_limbs26(ctx->powers[0],p);
+  for (k = 1;k < 8;++k) {
+    poly1305_mulmod(p,ctx->r);
+    poly1305_limbs26(ctx->powers[k],p);
+  }
+  ctx->have_powers = 1;
+}
+
+/* whole blocks with the 2^128 bit, through the kernel if it pays off */
+static void poly1305_full_blocks(poly1305_ctx *ctx,const uint8_t *m,size_t blocks)
+{
+  size_t done = 0;
+
+  if (blocks >= POLY1305_SIMD_MIN_BLOCKS && poly1305_lanes() >= 4) {
+    if (!ctx->have_powers) poly1305_powers(ctx);
+    done = poly1305_simd_blocks(ctx->h,&ctx->powers[0][0],m,blocks,poly1305_lanes());
+  }
+  poly1305_blocks(ctx,m + 16 * done,blocks - done,(uint64_t)1 << 40);
+}
+
+void poly1305_set_lanes(int lanes)
+{
+  max_lanes = lanes;
+}
+
+int poly1305_lanes(void)
+{
+  int lanes = poly1305_simd_max_lanes();
+  return max_lanes < lanes ? max_lanes : lanes;
+}
+
+void poly1305_init(poly1305_ctx *ctx,const uint8_t key[32])
+{
+  uint64_t t0 = load64(key), t1 = load64(key + 8);
+
+  /* r &= 0x0ffffffc0ffffffc0ffffffc0fffffff */
+  ctx->r[0] = t0 & 0xffc0fffffffULL;
+  ctx->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffULL;
+  ctx->r[2] = (t1 >> 24) & 0x00ffffffc0fULL;
+
+  ctx->h[0] = 0;
+  ctx->h[1] = 0;
+  ctx->h[2] = 0;
+
+  ctx->pad[0] = load64(key + 16);
+  ctx->pad[1] = load64(key + 24);
+
+  ctx->have_powers = 0;
+  ctx->leftover = 0;
+}
+
+void poly1305_update(poly1305_ctx *ctx,const uint8_t *m,size_t bytes)
+{
+  size_t i, n;
+
+  /* complete the buffered block */
+  if (ctx->leftover) {
+    n = 16 - ctx->leftover < bytes ? 16 - ctx->leftover : bytes;
+    for (i = 0;i < n;++i) ctx->buffer[ctx->leftover + i] = m[i];
+    ctx->leftover += n;
+    m += n;
+    bytes -= n;
+    if (ctx->leftover < 16) return;
+    poly1305_blocks(ctx,ctx->buffer,1,(uint64_t)1 << 40);
+    ctx->leftover = 0;
+  }
+
+  if (bytes >= 16) {
+    n = bytes / 16;
+    poly1305_full_blocks(ctx,m,n);
+    m += 16 * n;
+    bytes -= 16 * n;
+  }
+
+  for (i = 0;i < bytes;++i) ctx->buffer[i] = m[i];
+  ctx->leftover = bytes;
+}
+
+void poly1305_finish(poly1305_ctx *ctx,uint8_t mac[16])
+{
+  uint64_t h0, h1, h2, g0, g1, g2, c, t0, t1;
+  size_t i;
+
+  /* last partial block: a 1 byte after the message instead of the 2^128 bit */
+  if (ctx->leftover) {
+    i = ctx->leftover;
+    ctx->buffer[i++] = 1;
+    for (;i < 16;++i) ctx->buffer[i] = 0;
+    poly1305_blocks(ctx,ctx->buffer,1,0);
+  }
+
+  /* fully carry h */
+  h0 = ctx->h[0]; h1 = ctx->h[1]; h2 = ctx->h[2];
+  c = h1 >> 44; h1 &= MASK44;
+  h2 += c; c = h2 >> 42; h2 &= MASK42;
+  h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+  h1 += c; c = h1 >> 44; h1 &= MASK44;
+  h2 += c; c = h2 >> 42; h2 &= MASK42;
+  h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+  h1 += c;
+
+  /* g = h - p, kept if h >= p */
+  g0 = h0 + 5; c = g0 >> 44; g0 &= MASK44;
+  g1 = h1 + c; c = g1 >> 44; g1 &= MASK44;
+  g2 = h2 + c - ((uint64_t)1 << 42);
+
+  c = (g2 >> 63) - 1; /* all ones if h >= p */
+  h0 = (h0 & ~c) | (g0 & c);
+  h1 = (h1 & ~c) | (g1 & c);
+  h2 = (h2 & ~c) | (g2 & c);
+
+  /* mac = (h + pad) mod 2^128 */
+  t0 = ctx->pad[0];
+  t1 = ctx->pad[1];
+  h0 += t0 & MASK44; c = h0 >> 44; h0 &= MASK44;
+  h1 += (((t0 >> 44) | (t1 << 20)) & MASK44) + c; c = h1 >> 44; h1 &= MASK44;
+  h2 += ((t1 >> 24) & MASK42) + c; h2 &= MASK42;
+
+  store64(mac,h0 | (h1 << 44));
+  store64(mac + 8,(h1 >> 20) | (h2 << 24));
+
+  /* the key is single-use */
+  for (i = 0;i < 3;++i) ctx->r[i] = ctx->h[i] = 0;
+  ctx->pad[0] = ctx->pad[1] = 0;
+  ctx->have_powers = 0;
+}
+
+void poly1305_auth(uint8_t mac[16],const uint8_t *m,size_t bytes,const uint8_t key[32])
+{
+  poly1305_ctx ctx;
+
+  poly1305_init(&ctx,key);
+  poly1305_update(&ctx,m,bytes);
+  poly1305_finish(&ctx,mac);
+}
+
+int poly1305_verify(const uint8_t a[16],const uint8_t b[16])
+{
+  unsigned diff = 0;
+  int i;
+
+  for (i = 0;i < 16;++i) diff |= a[i] ^ b[i];
+  return (1 & ((diff - 1) >> 8));
+}
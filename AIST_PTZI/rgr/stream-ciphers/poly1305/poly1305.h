@@ -0,0 +1,52 @@
+#ifndef POLY1305_H
+#define POLY1305_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Poly1305 one-time authenticator (RFC 8439). A key must authenticate only
+ * one message; the AEAD code takes a fresh one from the cipher keystream of
+ * every nonce.
+ *
+ * The accumulator is kept in three 44-bit limbs of 64-bit words. Long runs
+ * of whole blocks go to an AVX-512 or AVX2 kernel (poly1305-simd.c) when
+ * the CPU has one; they need r^1..r^8, which are computed on first use.
+ */
+typedef struct {
+  uint64_t r[3];
+  uint64_t h[3];
+  uint64_t pad[2];
+  uint32_t powers[8][5]; /* r^1..r^8 in 26-bit limbs, valid if have_powers */
+  int have_powers;
+  size_t leftover;
+  uint8_t buffer[16];
+} poly1305_ctx;
+
+void poly1305_init(poly1305_ctx *ctx,const uint8_t key[32]);
+void poly1305_update(poly1305_ctx *ctx,const uint8_t *m,size_t bytes);
+void poly1305_finish(poly1305_ctx *ctx,uint8_t mac[16]);
+
+/* init + update + finish */
+void poly1305_auth(uint8_t mac[16],const uint8_t *m,size_t bytes,const uint8_t key[32]);
+
+/* 1 if the tags are equal, in time independent of their contents */
+int poly1305_verify(const uint8_t a[16],const uint8_t b[16]);
+
+/*
+ * Blocks processed per SIMD kernel step: 8 (AVX-512), 4 (AVX2) or 0
+ * (scalar only).
+ * poly1305_set_lanes(0) disables the kernel, e.g. to compare the paths.
+ */
+void poly1305_set_lanes(int lanes);
+int poly1305_lanes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,6 +14,28 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* Symbol names */
+
+/*
+ * All ciphers in stream-ciphers/ implement the same ECRYPT_* API. The
+ * names are given a per-cipher prefix here so that several ciphers can be
+ * linked into one program; code including this header keeps using the
+ * ECRYPT_* names.
+ */
+#define ECRYPT_ctx               rabbit_ECRYPT_ctx
+#define ECRYPT_init              rabbit_ECRYPT_init
+#define ECRYPT_keysetup          rabbit_ECRYPT_keysetup
+#define ECRYPT_ivsetup           rabbit_ECRYPT_ivsetup
+#define ECRYPT_process_bytes     rabbit_ECRYPT_process_bytes
+#define ECRYPT_process_bytes64   rabbit_ECRYPT_process_bytes64
+#define ECRYPT_keystream_bytes   rabbit_ECRYPT_keystream_bytes
+#define ECRYPT_keystream_bytes64 rabbit_ECRYPT_keystream_bytes64
+#define ECRYPT_process_packet    rabbit_ECRYPT_process_packet
+#define ECRYPT_process_blocks    rabbit_ECRYPT_process_blocks
+#define ECRYPT_keystream_blocks  rabbit_ECRYPT_keystream_blocks
+
+/* ------------------------------------------------------------------------- */
+
 /* Cipher parameters */
 
 /* 
@@ -200,6 +222,80 @@ void ECRYPT_keystream_bytes(
 
 /* ------------------------------------------------------------------------- */
 
+/* 64-bit lengths */
+
+/*
+ * The functions above take u32 lengths, so a single call handles less
+ * than 4 GiB. The *_bytes64 variants accept any length: they call the
+ * u32 functions on chunks of ECRYPT_CHUNKLENGTH bytes, a whole number of
+ * blocks, so the output and the final state are the same as one call
+ * with the full length would give.
+ */
+#define ECRYPT_CHUNKLENGTH \
+  (0xFFFFFFFFUL / ECRYPT_BLOCKLENGTH * ECRYPT_BLOCKLENGTH)
+
+#ifdef ECRYPT_HAS_SINGLE_BYTE_FUNCTION
+
+#define ECRYPT_encrypt_bytes64(ctx, plaintext, ciphertext, msglen) \
+  ECRYPT_process_bytes64(0, ctx, plaintext, ciphertext, msglen)
+
+#define ECRYPT_decrypt_bytes64(ctx, ciphertext, plaintext, msglen) \
+  ECRYPT_process_bytes64(1, ctx, ciphertext, plaintext, msglen)
+
+void ECRYPT_process_bytes64(
+  int action,                 /* 0 = encrypt; 1 = decrypt; */
+  ECRYPT_ctx* ctx, 
+  const u8* input, 
+  u8* output, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#else
+
+void ECRYPT_encrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* plaintext, 
+  u8* ciphertext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+void ECRYPT_decrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* ciphertext, 
+  u8* plaintext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#endif
+
+#ifdef ECRYPT_GENERATES_KEYSTREAM
+
+void ECRYPT_keystream_bytes64(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u64 length);                /* Length of keystream in bytes. */
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/* Multiple instances */
+
+/*
+ * rabbit_process_batch encrypts/decrypts count independent messages:
+ * input[i] of msglen[i] bytes with ctx[i] into output[i], the same as
+ * count calls of ECRYPT_process_bytes. The instances, e.g. one per
+ * connection or independently IV'd segments of one large buffer, run in
+ * the lanes of 4 (SSE2) or 8 (AVX2) wide vectors; a lane takes the next
+ * message as soon as its own runs out of full blocks. The contexts must
+ * be distinct.
+ */
+void rabbit_process_batch(
+  ECRYPT_ctx* const ctx[],
+  const u8* const input[],
+  u8* const output[],
+  const u32 msglen[],
+  u32 count);
+
+/* ------------------------------------------------------------------------- */
+
 /* Optional optimizations */
 
 /* 
@@ -0,0 +1,245 @@
+/******************************************************************************/
+/* File name: rabbit-simd.c                                                   */
+/*----------------------------------------------------------------------------*/
+/* Rabbit on 4 (SSE2) or 8 (AVX2) independent instances at once               */
+/*----------------------------------------------------------------------------*/
+/* Lane k of vector x[i] holds x[i] of instance k, likewise for the counters  */
+/* and the carry, so RABBIT_next_state runs on all instances in parallel.     */
+/* The squaring in the g-function uses the 32x32->64 bit multiply of the even */
+/* lanes, twice. The four keystream words of every lane are transposed into   */
+/* 16-byte blocks before the XOR with the instance's own message.             */
+/******************************************************************************/
+
+#include "rabbit-simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* P is the intrinsic prefix (_mm, _mm256), S the suffix of the bitwise */
+/* operations (si128, si256) */
+#define ADD(P,a,b) P##_add_epi32((a),(b))
+#define SUB(P,a,b) P##_sub_epi32((a),(b))
+#define XOR(P,S,a,b) P##_xor_##S((a),(b))
+#define ROTL(P,S,x,n) P##_or_##S(P##_slli_epi32((x),(n)),P##_srli_epi32((x),32-(n)))
+
+/* Lane-wise a < b, unsigned, as a mask of all ones */
+#define LESS(P,S,a,b) P##_cmpgt_epi32(XOR(P,S,(b),sign),XOR(P,S,(a),sign))
+
+/* g-function of every lane: square, then upper XOR lower 32 bits */
+#define G(P,S,y,x) { \
+   V t, even, odd; \
+   t = (x); \
+   even = P##_mul_epu32(t,t); \
+   odd = P##_srli_epi64(t,32); \
+   odd = P##_mul_epu32(odd,odd); \
+   even = P##_and_##S(XOR(P,S,even,P##_srli_epi64(even,32)),low); \
+   odd = P##_slli_epi64(XOR(P,S,odd,P##_srli_epi64(odd,32)),32); \
+   y = P##_or_##S(even,odd); \
+}
+
+/* RABBIT_next_state on all lanes; carry is a mask, so subtracting it adds 1 */
+#define NEXT_STATE(P,S,x,c,carry) { \
+   V g[8], c_old; \
+   int i; \
+   for (i=0; i<8; i++) \
+   { \
+      c_old = c[i]; \
+      c[i] = SUB(P,ADD(P,c[i],P##_set1_epi32((int)A[i])),carry); \
+      carry = LESS(P,S,c[i],c_old); \
+   } \
+   for (i=0; i<8; i++) \
+      G(P,S,g[i],ADD(P,x[i],c[i])); \
+   x[0] = ADD(P,g[0],ADD(P,ROTL(P,S,g[7],16),ROTL(P,S,g[6],16))); \
+   x[1] = ADD(P,g[1],ADD(P,ROTL(P,S,g[0], 8),g[7])); \
+   x[2] = ADD(P,g[2],ADD(P,ROTL(P,S,g[1],16),ROTL(P,S,g[0],16))); \
+   x[3] = ADD(P,g[3],ADD(P,ROTL(P,S,g[2], 8),g[1])); \
+   x[4] = ADD(P,g[4],ADD(P,ROTL(P,S,g[3],16),ROTL(P,S,g[2],16))); \
+   x[5] = ADD(P,g[5],ADD(P,ROTL(P,S,g[4], 8),g[3])); \
+   x[6] = ADD(P,g[6],ADD(P,ROTL(P,S,g[5],16),ROTL(P,S,g[4],16))); \
+   x[7] = ADD(P,g[7],ADD(P,ROTL(P,S,g[6], 8),g[5])); \
+}
+
+/* Keystream words of every lane, then 16-byte blocks of lanes 0-3 in */
+/* s[0..3], of lanes 4-7 in the upper halves */
+#define EXTRACT(P,S,s,x) { \
+   V t0, t1, t2, t3; \
+   s[0] = XOR(P,S,x[0],XOR(P,S,P##_srli_epi32(x[5],16),P##_slli_epi32(x[3],16))); \
+   s[1] = XOR(P,S,x[2],XOR(P,S,P##_srli_epi32(x[7],16),P##_slli_epi32(x[5],16))); \
+   s[2] = XOR(P,S,x[4],XOR(P,S,P##_srli_epi32(x[1],16),P##_slli_epi32(x[7],16))); \
+   s[3] = XOR(P,S,x[6],XOR(P,S,P##_srli_epi32(x[3],16),P##_slli_epi32(x[1],16))); \
+   t0 = P##_unpacklo_epi32(s[0],s[1]); \
+   t1 = P##_unpackhi_epi32(s[0],s[1]); \
+   t2 = P##_unpacklo_epi32(s[2],s[3]); \
+   t3 = P##_unpackhi_epi32(s[2],s[3]); \
+   s[0] = P##_unpacklo_epi64(t0,t2); \
+   s[1] = P##_unpackhi_epi64(t0,t2); \
+   s[2] = P##_unpacklo_epi64(t1,t3); \
+   s[3] = P##_unpackhi_epi64(t1,t3); \
+}
+
+/* Counter constants */
+static const u32 A[8] = {
+   0x4D34D34D, 0xD34D34D3, 0x34D34D34, 0x4D34D34D,
+   0xD34D34D3, 0x34D34D34, 0x4D34D34D, 0xD34D34D3
+};
+
+/* ------------------------------------------------------------------------- */
+
+/* Work states of the instances to lanes and back */
+static void load_lanes(ECRYPT_ctx* const ctx[], int lanes, u32 x[8][8],
+          u32 c[8][8], u32 carry[8])
+{
+   int i, k;
+
+   for (k=0; k<lanes; k++)
+   {
+      for (i=0; i<8; i++)
+      {
+         x[i][k] = ctx[k]->work_ctx.x[i];
+         c[i][k] = ctx[k]->work_ctx.c[i];
+      }
+      carry[k] = 0 - ctx[k]->work_ctx.carry;
+   }
+}
+
+static void store_lanes(ECRYPT_ctx* const ctx[], int lanes, u32 x[8][8],
+          u32 c[8][8], u32 carry[8])
+{
+   int i, k;
+
+   for (k=0; k<lanes; k++)
+   {
+      for (i=0; i<8; i++)
+      {
+         ctx[k]->work_ctx.x[i] = x[i][k];
+         ctx[k]->work_ctx.c[i] = c[i][k];
+      }
+      ctx[k]->work_ctx.carry = carry[k] & 1;
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+__attribute__((target("sse2")))
+static void rabbit_process4(ECRYPT_ctx* const ctx[], const u8* const input[],
+          u8* const output[], u32 blocks)
+{
+#define V __m128i
+   u32 xs[8][8], cs[8][8], carrys[8];
+   V x[8], c[8], s[4], carry;
+   const V sign = _mm_set1_epi32((int)0x80000000);
+   const V low = _mm_set1_epi64x(0xFFFFFFFF);
+   u32 b, i;
+   int k;
+
+   load_lanes(ctx, 4, xs, cs, carrys);
+   for (i=0; i<8; i++)
+   {
+      x[i] = _mm_loadu_si128((const V*)xs[i]);
+      c[i] = _mm_loadu_si128((const V*)cs[i]);
+   }
+   carry = _mm_loadu_si128((const V*)carrys);
+
+   for (b=0; b<blocks; b++)
+   {
+      NEXT_STATE(_mm,si128,x,c,carry);
+      EXTRACT(_mm,si128,s,x);
+
+      /* Encrypt/decrypt 16 bytes of data of every instance */
+      for (k=0; k<4; k++)
+         _mm_storeu_si128((V*)(output[k] + 16*b), _mm_xor_si128(s[k],
+                   _mm_loadu_si128((const V*)(input[k] + 16*b))));
+   }
+
+   for (i=0; i<8; i++)
+   {
+      _mm_storeu_si128((V*)xs[i], x[i]);
+      _mm_storeu_si128((V*)cs[i], c[i]);
+   }
+   _mm_storeu_si128((V*)carrys, carry);
+   store_lanes(ctx, 4, xs, cs, carrys);
+#undef V
+}
+
+__attribute__((target("avx2")))
+static void rabbit_process8(ECRYPT_ctx* const ctx[], const u8* const input[],
+          u8* const output[], u32 blocks)
+{
+#define V __m256i
+   u32 xs[8][8], cs[8][8], carrys[8];
+   V x[8], c[8], s[4], carry;
+   const V sign = _mm256_set1_epi32((int)0x80000000);
+   const V low = _mm256_set1_epi64x(0xFFFFFFFF);
+   __m128i block;
+   u32 b, i;
+   int k;
+
+   load_lanes(ctx, 8, xs, cs, carrys);
+   for (i=0; i<8; i++)
+   {
+      x[i] = _mm256_loadu_si256((const V*)xs[i]);
+      c[i] = _mm256_loadu_si256((const V*)cs[i]);
+   }
+   carry = _mm256_loadu_si256((const V*)carrys);
+
+   for (b=0; b<blocks; b++)
+   {
+      NEXT_STATE(_mm256,si256,x,c,carry);
+      EXTRACT(_mm256,si256,s,x);
+
+      /* Encrypt/decrypt 16 bytes of data of every instance */
+      for (k=0; k<4; k++)
+      {
+         block = _mm256_castsi256_si128(s[k]);
+         _mm_storeu_si128((__m128i*)(output[k] + 16*b), _mm_xor_si128(block,
+                   _mm_loadu_si128((const __m128i*)(input[k] + 16*b))));
+         block = _mm256_extracti128_si256(s[k], 1);
+         _mm_storeu_si128((__m128i*)(output[4+k] + 16*b), _mm_xor_si128(block,
+                   _mm_loadu_si128((const __m128i*)(input[4+k] + 16*b))));
+      }
+   }
+
+   for (i=0; i<8; i++)
+   {
+      _mm256_storeu_si256((V*)xs[i], x[i]);
+      _mm256_storeu_si256((V*)cs[i], c[i]);
+   }
+   _mm256_storeu_si256((V*)carrys, carry);
+   store_lanes(ctx, 8, xs, cs, carrys);
+#undef V
+}
+
+/* ------------------------------------------------------------------------- */
+
+int rabbit_simd_lanes(void)
+{
+   if (__builtin_cpu_supports("avx2")) return 8;
+   if (__builtin_cpu_supports("sse2")) return 4;
+   return 0;
+}
+
+void rabbit_process_lanes(ECRYPT_ctx* const ctx[], const u8* const input[],
+          u8* const output[], u32 blocks, int lanes)
+{
+   if (lanes == 8)
+      rabbit_process8(ctx, input, output, blocks);
+   else
+      rabbit_process4(ctx, input, output, blocks);
+}
+
+#else
+
+int rabbit_simd_lanes(void)
+{
+   return 0;
+}
+
+void rabbit_process_lanes(ECRYPT_ctx* const ctx[], const u8* const input[],
+          u8* const output[], u32 blocks, int lanes)
+{
+   (void)ctx; (void)input; (void)output; (void)blocks; (void)lanes;
+}
+
+#endif
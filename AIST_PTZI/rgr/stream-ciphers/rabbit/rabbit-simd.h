@@ -0,0 +1,20 @@
+#ifndef RABBIT_SIMD_H
+#define RABBIT_SIMD_H
+
+#include "ecrypt-sync.h"
+
+/*
+ * Widest SIMD kernel the CPU supports, in Rabbit instances per call:
+ * 8 (AVX2), 4 (SSE2) or 0 (scalar only).
+ */
+int rabbit_simd_lanes(void);
+
+/*
+ * output[i] = input[i] ^ keystream of ctx[i] for blocks 16-byte blocks of
+ * each of lanes (4 or 8) independent instances, advancing their work
+ * states as ECRYPT_process_bytes does.
+ */
+void rabbit_process_lanes(ECRYPT_ctx* const ctx[], const u8* const input[],
+          u8* const output[], u32 blocks, int lanes);
+
+#endif
@@ -28,6 +28,26 @@
 #include "rabbit.h"
 #include "ecrypt-sync.h"
 #include "ecrypt-portable.h"
+#include "rabbit-simd.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Number of 16-byte blocks of keystream generated at a time */
+#define RABBIT_BATCH 16
+
+#if defined(__GNUC__)
+#define RABBIT_ALIGN __attribute__((aligned(32)))
+#elif defined(_MSC_VER)
+#define RABBIT_ALIGN __declspec(align(32))
+#else
+#define RABBIT_ALIGN
+#endif
 
 /* -------------------------------------------------------------------------- */
 
@@ -90,6 +110,86 @@ static void RABBIT_next_state(RABBIT_ctx *p_instance)
 
 /* ------------------------------------------------------------------------- */
 
+/* Iterate the system and write 16 bytes of pseudo-random data per block, */
+/* as little-endian words */
+static void RABBIT_keystream(RABBIT_ctx *p_instance, u32 *keystream, u32 blocks)
+{
+   /* Temporary variables */
+   u32 i;
+
+   for (i=0; i<blocks; i++)
+   {
+      RABBIT_next_state(p_instance);
+
+      keystream[4*i+0] = U32TO32_LITTLE(p_instance->x[0] ^
+                (p_instance->x[5]>>16) ^ U32V(p_instance->x[3]<<16));
+      keystream[4*i+1] = U32TO32_LITTLE(p_instance->x[2] ^ 
+                (p_instance->x[7]>>16) ^ U32V(p_instance->x[5]<<16));
+      keystream[4*i+2] = U32TO32_LITTLE(p_instance->x[4] ^ 
+                (p_instance->x[1]>>16) ^ U32V(p_instance->x[7]<<16));
+      keystream[4*i+3] = U32TO32_LITTLE(p_instance->x[6] ^ 
+                (p_instance->x[3]>>16) ^ U32V(p_instance->x[1]<<16));
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* output = input ^ keystream for a multiple of 16 bytes; input and output */
+/* may have any alignment and may be the same buffer */
+static void RABBIT_xor(const u8* input, const u32* keystream, u8* output, 
+          u32 length)
+{
+   /* Temporary variables */
+   u32 i = 0;
+
+#if defined(__AVX2__)
+   for ( ; i+32<=length; i+=32)
+      _mm256_storeu_si256((__m256i*)(output+i), _mm256_xor_si256(
+                _mm256_loadu_si256((const __m256i*)(input+i)),
+                _mm256_load_si256((const __m256i*)(keystream+i/4))));
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+   for ( ; i<length; i+=16)
+      _mm_storeu_si128((__m128i*)(output+i), _mm_xor_si128(
+                _mm_loadu_si128((const __m128i*)(input+i)),
+                _mm_load_si128((const __m128i*)(keystream+i/4))));
+#else
+   for ( ; i<length; i+=4)
+   {
+      u32 word;
+      memcpy(&word, input+i, 4);
+      word ^= keystream[i/4];
+      memcpy(output+i, &word, 4);
+   }
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Encrypt/decrypt full blocks, RABBIT_BATCH blocks of keystream at a time */
+static void RABBIT_process(RABBIT_ctx *p_instance, const u8* input, 
+          u8* output, u32 blocks)
+{
+   /* Temporary variables */
+   u32 n;
+   RABBIT_ALIGN u32 keystream[4*RABBIT_BATCH];
+
+   while (blocks)
+   {
+      n = blocks < RABBIT_BATCH ? blocks : RABBIT_BATCH;
+
+      RABBIT_keystream(p_instance, keystream, n);
+      RABBIT_xor(input, keystream, output, 16*n);
+
+      /* Increment pointers and decrement length */
+      input += 16*n;
+      output += 16*n;
+      blocks -= n;
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+
 /* No initialization is needed for Rabbit */
 void ECRYPT_init(void)
 {
@@ -192,49 +292,23 @@ void ECRYPT_process_bytes(int action, ECRYPT_ctx* ctx, const u8* input,
 {
    /* Temporary variables */
    u32 i;
-   u8 buffer[16];
+   RABBIT_ALIGN u32 buffer[4];
 
    /* Encrypt/decrypt all full blocks */
-   while (msglen >= 16)
-   {
-      /* Iterate the system */
-      RABBIT_next_state(&(ctx->work_ctx));
-
-      /* Encrypt/decrypt 16 bytes of data */
-      *(u32*)(output+ 0) = *(u32*)(input+ 0) ^ U32TO32_LITTLE(ctx->work_ctx.x[0] ^
-                (ctx->work_ctx.x[5]>>16) ^ U32V(ctx->work_ctx.x[3]<<16));
-      *(u32*)(output+ 4) = *(u32*)(input+ 4) ^ U32TO32_LITTLE(ctx->work_ctx.x[2] ^ 
-                (ctx->work_ctx.x[7]>>16) ^ U32V(ctx->work_ctx.x[5]<<16));
-      *(u32*)(output+ 8) = *(u32*)(input+ 8) ^ U32TO32_LITTLE(ctx->work_ctx.x[4] ^ 
-                (ctx->work_ctx.x[1]>>16) ^ U32V(ctx->work_ctx.x[7]<<16));
-      *(u32*)(output+12) = *(u32*)(input+12) ^ U32TO32_LITTLE(ctx->work_ctx.x[6] ^ 
-                (ctx->work_ctx.x[3]>>16) ^ U32V(ctx->work_ctx.x[1]<<16));
-
-      /* Increment pointers and decrement length */
-      input += 16;
-      output += 16;
-      msglen -= 16;
-   }
+   RABBIT_process(&(ctx->work_ctx), input, output, msglen/16);
+   input += msglen & ~15U;
+   output += msglen & ~15U;
+   msglen &= 15;
 
    /* Encrypt/decrypt remaining data */
    if (msglen)
    {
-      /* Iterate the system */
-      RABBIT_next_state(&(ctx->work_ctx));
-
       /* Generate 16 bytes of pseudo-random data */
-      *(u32*)(buffer+ 0) = U32TO32_LITTLE(ctx->work_ctx.x[0] ^
-                (ctx->work_ctx.x[5]>>16) ^ U32V(ctx->work_ctx.x[3]<<16));
-      *(u32*)(buffer+ 4) = U32TO32_LITTLE(ctx->work_ctx.x[2] ^ 
-                (ctx->work_ctx.x[7]>>16) ^ U32V(ctx->work_ctx.x[5]<<16));
-      *(u32*)(buffer+ 8) = U32TO32_LITTLE(ctx->work_ctx.x[4] ^ 
-                (ctx->work_ctx.x[1]>>16) ^ U32V(ctx->work_ctx.x[7]<<16));
-      *(u32*)(buffer+12) = U32TO32_LITTLE(ctx->work_ctx.x[6] ^ 
-                (ctx->work_ctx.x[3]>>16) ^ U32V(ctx->work_ctx.x[1]<<16));
+      RABBIT_keystream(&(ctx->work_ctx), buffer, 1);
 
       /* Encrypt/decrypt the data */
       for (i=0; i<msglen; i++)
-         output[i] = input[i] ^ buffer[i];
+         output[i] = input[i] ^ ((u8*)buffer)[i];
    }
 }
 
@@ -244,50 +318,59 @@ void ECRYPT_process_bytes(int action, ECRYPT_ctx* ctx, const u8* input,
 void ECRYPT_keystream_bytes(ECRYPT_ctx* ctx, u8* keystream, u32 length)
 {
    /* Temporary variables */
-   u32 i;
-   u8 buffer[16];
+   RABBIT_ALIGN u32 buffer[4];
 
    /* Generate all full blocks */
-   while (length >= 16)
+   ECRYPT_keystream_blocks(ctx, keystream, length/16);
+   keystream += length & ~15U;
+   length &= 15;
+
+   /* Generate remaining pseudo-random data */
+   if (length)
    {
-      /* Iterate the system */
-      RABBIT_next_state(&(ctx->work_ctx));
+      RABBIT_keystream(&(ctx->work_ctx), buffer, 1);
+      memcpy(keystream, buffer, length);
+   }
+}
 
-      /* Generate 16 bytes of pseudo-random data */
-      *(u32*)(keystream+ 0) = U32TO32_LITTLE(ctx->work_ctx.x[0] ^
-                (ctx->work_ctx.x[5]>>16) ^ U32V(ctx->work_ctx.x[3]<<16));
-      *(u32*)(keystream+ 4) = U32TO32_LITTLE(ctx->work_ctx.x[2] ^ 
-                (ctx->work_ctx.x[7]>>16) ^ U32V(ctx->work_ctx.x[5]<<16));
-      *(u32*)(keystream+ 8) = U32TO32_LITTLE(ctx->work_ctx.x[4] ^ 
-                (ctx->work_ctx.x[1]>>16) ^ U32V(ctx->work_ctx.x[7]<<16));
-      *(u32*)(keystream+12) = U32TO32_LITTLE(ctx->work_ctx.x[6] ^ 
-                (ctx->work_ctx.x[3]>>16) ^ U32V(ctx->work_ctx.x[1]<<16));
+/* ------------------------------------------------------------------------- */
+
+/* Encrypt/decrypt a message of any size, 64-bit length */
+void ECRYPT_process_bytes64(int action, ECRYPT_ctx* ctx, const u8* input, 
+          u8* output, u64 msglen)
+{
+   /* Whole chunks keep the state at a block boundary */
+   while (msglen > ECRYPT_CHUNKLENGTH)
+   {
+      ECRYPT_process_bytes(action, ctx, input, output, ECRYPT_CHUNKLENGTH);
 
       /* Increment pointers and decrement length */
-      keystream += 16;
-      length -= 16;
+      input += ECRYPT_CHUNKLENGTH;
+      output += ECRYPT_CHUNKLENGTH;
+      msglen -= ECRYPT_CHUNKLENGTH;
    }
 
-   /* Generate remaining pseudo-random data */
-   if (length)
+   /* Encrypt/decrypt remaining data */
+   ECRYPT_process_bytes(action, ctx, input, output, (u32)msglen);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Generate keystream, 64-bit length */
+void ECRYPT_keystream_bytes64(ECRYPT_ctx* ctx, u8* keystream, u64 length)
+{
+   /* Whole chunks keep the state at a block boundary */
+   while (length > ECRYPT_CHUNKLENGTH)
    {
-      /* Iterate the system */
-      RABBIT_next_state(&(ctx->work_ctx));
+      ECRYPT_keystream_bytes(ctx, keystream, ECRYPT_CHUNKLENGTH);
 
-      /* Generate 16 bytes of pseudo-random data */
-      *(u32*)(buffer+ 0) = U32TO32_LITTLE(ctx->work_ctx.x[0] ^
-                (ctx->work_ctx.x[5]>>16) ^ U32V(ctx->work_ctx.x[3]<<16));
-      *(u32*)(buffer+ 4) = U32TO32_LITTLE(ctx->work_ctx.x[2] ^ 
-                (ctx->work_ctx.x[7]>>16) ^ U32V(ctx->work_ctx.x[5]<<16));
-      *(u32*)(buffer+ 8) = U32TO32_LITTLE(ctx->work_ctx.x[4] ^ 
-                (ctx->work_ctx.x[1]>>16) ^ U32V(ctx->work_ctx.x[7]<<16));
-      *(u32*)(buffer+12) = U32TO32_LITTLE(ctx->work_ctx.x[6] ^ 
-                (ctx->work_ctx.x[3]>>16) ^ U32V(ctx->work_ctx.x[1]<<16));
-
-      /* Copy remaining data */
-      for (i=0; i<length; i++)
-         keystream[i] = buffer[i];
+      /* Increment pointer and decrement length */
+      keystream += ECRYPT_CHUNKLENGTH;
+      length -= ECRYPT_CHUNKLENGTH;
    }
+
+   /* Generate remaining pseudo-random data */
+   ECRYPT_keystream_bytes(ctx, keystream, (u32)length);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -295,27 +378,98 @@ void ECRYPT_keystream_bytes(ECRYPT_ctx* ctx, u8* keystream, u32 length)
 /* Encrypt/decrypt a number of full blocks */
 void ECRYPT_process_blocks(int action, ECRYPT_ctx* ctx, const u8* input, 
           u8* output, u32 blocks)
+{
+   RABBIT_process(&(ctx->work_ctx), input, output, blocks);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Generate a number of full blocks of keystream */
+void ECRYPT_keystream_blocks(ECRYPT_ctx* ctx, u8* keystream, u32 blocks)
 {
    /* Temporary variables */
-   u32 i;
+   u32 n;
+   RABBIT_ALIGN u32 buffer[4*RABBIT_BATCH];
 
-   for (i=0; i<blocks; i++)
+   while (blocks)
    {
-      /* Iterate the system */
-      RABBIT_next_state(&(ctx->work_ctx));
+      n = blocks < RABBIT_BATCH ? blocks : RABBIT_BATCH;
+
+      /* Generate into the aligned buffer, the caller's bytes get a copy */
+      RABBIT_keystream(&(ctx->work_ctx), buffer, n);
+      memcpy(keystream, buffer, 16*n);
+
+      /* Increment pointer and decrement length */
+      keystream += 16*n;
+      blocks -= n;
+   }
+}
 
-      /* Encrypt/decrypt 16 bytes of data */
-      *(u32*)(output+ 0) = *(u32*)(input+ 0) ^ U32TO32_LITTLE(ctx->work_ctx.x[0] ^
-                (ctx->work_ctx.x[5]>>16) ^ U32V(ctx->work_ctx.x[3]<<16));
-      *(u32*)(output+ 4) = *(u32*)(input+ 4) ^ U32TO32_LITTLE(ctx->work_ctx.x[2] ^ 
-                (ctx->work_ctx.x[7]>>16) ^ U32V(ctx->work_ctx.x[5]<<16));
-      *(u32*)(output+ 8) = *(u32*)(input+ 8) ^ U32TO32_LITTLE(ctx->work_ctx.x[4] ^ 
-                (ctx->work_ctx.x[1]>>16) ^ U32V(ctx->work_ctx.x[7]<<16));
-      *(u32*)(output+12) = *(u32*)(input+12) ^ U32TO32_LITTLE(ctx->work_ctx.x[6] ^ 
-                (ctx->work_ctx.x[3]>>16) ^ U32V(ctx->work_ctx.x[1]<<16));
-
-      /* Increment pointers to input and output data */
-      input += 16;
-      output += 16;
+/* ------------------------------------------------------------------------- */
+
+/* Encrypt/decrypt messages of several independent instances */
+void rabbit_process_batch(ECRYPT_ctx* const ctx[], const u8* const input[], 
+          u8* const output[], const u32 msglen[], u32 count)
+{
+   /* Lane k: message job[k], its next full block at in[k] / out[k] */
+   ECRYPT_ctx* lane_ctx[8];
+   const u8* in[8];
+   u8* out[8];
+   u32 job[8], blocks[8];
+   u32 next = 0, run;
+   int lanes = rabbit_simd_lanes(), active = 0, k, n;
+
+   while (lanes >= 4)
+   {
+      /* Messages without a full block need no lane */
+      for ( ; active < lanes && next < count; next++)
+      {
+         if (msglen[next] < 16)
+         {
+            ECRYPT_process_bytes(0, ctx[next], input[next], output[next], 
+                      msglen[next]);
+            continue;
+         }
+         lane_ctx[active] = ctx[next];
+         in[active] = input[next];
+         out[active] = output[next];
+         job[active] = next;
+         blocks[active] = msglen[next] / 16;
+         active++;
+      }
+      if (active < 4)
+         break;
+
+      /* Widest kernel that fits, up to the end of its shortest message */
+      n = active >= 8 ? 8 : 4;
+      run = blocks[0];
+      for (k=1; k<n; k++)
+         if (blocks[k] < run)
+            run = blocks[k];
+      rabbit_process_lanes(lane_ctx, in, out, run, n);
+
+      /* Retire finished messages, the last lane takes the free place */
+      for (k=n; k-- > 0; )
+      {
+         in[k] += 16*run;
+         out[k] += 16*run;
+         blocks[k] -= run;
+         if (blocks[k])
+            continue;
+         ECRYPT_process_bytes(0, lane_ctx[k], in[k], out[k], msglen[job[k]] % 16);
+         active--;
+         lane_ctx[k] = lane_ctx[active];
+         in[k] = in[active];
+         out[k] = out[active];
+         job[k] = job[active];
+         blocks[k] = blocks[active];
+      }
    }
+
+   /* Too few messages left to fill a kernel (or no SIMD): one at a time */
+   for (k=0; k<active; k++)
+      ECRYPT_process_bytes(0, lane_ctx[k], in[k], out[k], 
+                16*blocks[k] + msglen[job[k]] % 16);
+   for ( ; next<count; next++)
+      ECRYPT_process_bytes(0, ctx[next], input[next], output[next], msglen[next]);
 }
@@ -51,6 +51,17 @@ void ECRYPT_process_bytes(int action, ECRYPT_ctx* ctx, const u8* input,
 /* Generate keystream */
 void ECRYPT_keystream_bytes(ECRYPT_ctx* ctx, u8* keystream, u32 length);
 
+/* Encrypt/decrypt a message of any size, 64-bit length */
+void ECRYPT_process_bytes64(int action, ECRYPT_ctx* ctx, const u8* input, 
+          u8* output, u64 msglen);
+
+/* Generate keystream, 64-bit length */
+void ECRYPT_keystream_bytes64(ECRYPT_ctx* ctx, u8* keystream, u64 length);
+
 /* Encrypt/decrypt a number of full blocks */
 void ECRYPT_process_blocks(int action, ECRYPT_ctx* ctx, const u8* input, 
-          u8* output, u32 blocks);
\ No newline at end of file
+          u8* output, u32 blocks);
+
+/* Encrypt/decrypt messages of several independent instances */
+void rabbit_process_batch(ECRYPT_ctx* const ctx[], const u8* const input[], 
+          u8* const output[], const u32 msglen[], u32 count);
\ No newline at end of file
@@ -14,6 +14,29 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* Symbol names */
+
+/*
+ * All ciphers in stream-ciphers/ implement the same ECRYPT_* API. The
+ * names are given a per-cipher prefix here so that several ciphers can be
+ * linked into one program; code including this header keeps using the
+ * ECRYPT_* names.
+ */
+#define ECRYPT_ctx               salsa20_ECRYPT_ctx
+#define ECRYPT_init              salsa20_ECRYPT_init
+#define ECRYPT_keysetup          salsa20_ECRYPT_keysetup
+#define ECRYPT_ivsetup           salsa20_ECRYPT_ivsetup
+#define ECRYPT_encrypt_bytes     salsa20_ECRYPT_encrypt_bytes
+#define ECRYPT_decrypt_bytes     salsa20_ECRYPT_decrypt_bytes
+#define ECRYPT_keystream_bytes   salsa20_ECRYPT_keystream_bytes
+#define ECRYPT_encrypt_bytes64   salsa20_ECRYPT_encrypt_bytes64
+#define ECRYPT_decrypt_bytes64   salsa20_ECRYPT_decrypt_bytes64
+#define ECRYPT_keystream_bytes64 salsa20_ECRYPT_keystream_bytes64
+#define ECRYPT_encrypt_packet    salsa20_ECRYPT_encrypt_packet
+#define ECRYPT_decrypt_packet    salsa20_ECRYPT_decrypt_packet
+
+/* ------------------------------------------------------------------------- */
+
 /* Cipher parameters */
 
 /* 
@@ -167,6 +190,41 @@ void ECRYPT_keystream_bytes(
 
 /* ------------------------------------------------------------------------- */
 
+/* 64-bit lengths */
+
+/*
+ * The functions above take u32 lengths, so a single call handles less
+ * than 4 GiB. The *_bytes64 variants accept any length: they call the
+ * u32 functions on chunks of ECRYPT_CHUNKLENGTH bytes, a whole number of
+ * blocks, so the output and the final state are the same as one call
+ * with the full length would give.
+ */
+#define ECRYPT_CHUNKLENGTH \
+  (0xFFFFFFFFUL / ECRYPT_BLOCKLENGTH * ECRYPT_BLOCKLENGTH)
+
+void ECRYPT_encrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* plaintext, 
+  u8* ciphertext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+void ECRYPT_decrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* ciphertext, 
+  u8* plaintext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#ifdef ECRYPT_GENERATES_KEYSTREAM
+
+void ECRYPT_keystream_bytes64(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u64 length);                /* Length of keystream in bytes. */
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
 /* Optional optimizations */
 
 /* 
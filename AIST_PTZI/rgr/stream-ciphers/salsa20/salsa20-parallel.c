@@ -0,0 +1,170 @@
+/*
+ * Multi-threaded Salsa20: a large buffer is cut into chunks of whole blocks,
+ * every chunk is encrypted with its own copy of the state starting at the
+ * chunk's block counter. Worker threads are created on demand and reused.
+ * The pool runs one call at a time; a call that finds it busy encrypts on
+ * its own thread instead of waiting. Without POSIX threads (e.g. Windows
+ * builds) every call stays on the calling thread.
+ */
+
+#include "salsa20.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SALSA20_CHUNK (64 * 1024)
+#define SALSA20_MAX_THREADS 64
+
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+  pthread_cond_t done;
+  pthread_mutex_t call; /* held by the call that owns the pool */
+  int workers;
+  int limit;
+
+  /* current job */
+  unsigned generation;
+  u32 input[16];
+  const u8 *m;
+  u8 *c;
+  size_t bytes;
+  size_t next;
+  int allowed; /* helpers that may still join */
+  int active;
+} pool = {
+  PTHREAD_MUTEX_INITIALIZER,
+  PTHREAD_COND_INITIALIZER,
+  PTHREAD_COND_INITIALIZER,
+  PTHREAD_MUTEX_INITIALIZER,
+  0, 0, 0, { 0 }, 0, 0, 0, 0, 0, 0
+};
+
+static int salsa20_cpus(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1) return 1;
+  if (n > SALSA20_MAX_THREADS) return SALSA20_MAX_THREADS;
+  return (int)n;
+}
+
+/* take chunks of the current job until none are left; called with pool.lock held */
+static void salsa20_run_chunks(void)
+{
+  ECRYPT_ctx ctx;
+  size_t start, length;
+
+  while (pool.next < pool.bytes) {
+    start = pool.next;
+    length = pool.bytes - start < SALSA20_CHUNK ? pool.bytes - start : SALSA20_CHUNK;
+    pool.next += length;
+    pthread_mutex_unlock(&pool.lock);
+
+    memcpy(ctx.input,pool.input,sizeof(ctx.input));
+    salsa20_set_counter(&ctx,salsa20_counter(&ctx) + start / 64);
+    ECRYPT_encrypt_bytes(&ctx,pool.m + start,pool.c + start,(u32)length);
+
+    pthread_mutex_lock(&pool.lock);
+  }
+}
+
+static void *salsa20_worker(void *arg)
+{
+  unsigned seen = 0;
+  (void)arg;
+
+  pthread_mutex_lock(&pool.lock);
+  for (;;) {
+    while (pool.generation == seen) pthread_cond_wait(&pool.work,&pool.lock);
+    seen = pool.generation;
+    if (pool.allowed == 0) continue;
+    --pool.allowed;
+    ++pool.active;
+    salsa20_run_chunks();
+    if (--pool.active == 0) pthread_cond_signal(&pool.done);
+  }
+  return NULL;
+}
+
+/* grow the pool to n workers, fewer if threads cannot be created */
+static void salsa20_start_workers(int n)
+{
+  pthread_t thread;
+
+  while (pool.workers < n) {
+    if (pthread_create(&thread,NULL,salsa20_worker,NULL) != 0) break;
+    pthread_detach(thread);
+    ++pool.workers;
+  }
+}
+
+void salsa20_set_threads(int threads)
+{
+  pool.limit = threads > SALSA20_MAX_THREADS ? SALSA20_MAX_THREADS : threads;
+}
+
+int salsa20_threads(void)
+{
+  return pool.limit > 0 ? pool.limit : salsa20_cpus();
+}
+
+void salsa20_encrypt_parallel(ECRYPT_ctx *x,const u8 *m,u8 *c,size_t bytes)
+{
+  u64 blocks = (bytes + 63) / 64;
+  int threads = salsa20_threads();
+
+  /* small buffers: threads cost more than they save */
+  if (bytes < SALSA20_PARALLEL_THRESHOLD || threads < 2) {
+    ECRYPT_encrypt_bytes64(x,m,c,bytes);
+    return;
+  }
+
+  /* the pool is busy with another buffer: this one stays on its thread */
+  if (pthread_mutex_trylock(&pool.call) != 0) {
+    ECRYPT_encrypt_bytes64(x,m,c,bytes);
+    return;
+  }
+  pthread_mutex_lock(&pool.lock);
+  salsa20_start_workers(threads - 1);
+
+  memcpy(pool.input,x->input,sizeof(pool.input));
+  pool.m = m;
+  pool.c = c;
+  pool.bytes = bytes;
+  pool.next = 0;
+  pool.allowed = threads - 1 < pool.workers ? threads - 1 : pool.workers;
+  ++pool.generation;
+  pthread_cond_broadcast(&pool.work);
+
+  ++pool.active;
+  salsa20_run_chunks();
+  --pool.active;
+  while (pool.active > 0) pthread_cond_wait(&pool.done,&pool.lock);
+
+  pthread_mutex_unlock(&pool.lock);
+  pthread_mutex_unlock(&pool.call);
+
+  salsa20_set_counter(x,salsa20_counter(x) + blocks);
+}
+
+#else
+
+void salsa20_set_threads(int threads)
+{
+  (void)threads;
+}
+
+int salsa20_threads(void)
+{
+  return 1;
+}
+
+void salsa20_encrypt_parallel(ECRYPT_ctx *x,const u8 *m,u8 *c,size_t bytes)
+{
+  ECRYPT_encrypt_bytes64(x,m,c,bytes);
+}
+
+#endif
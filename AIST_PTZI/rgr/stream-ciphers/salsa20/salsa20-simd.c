@@ -0,0 +1,412 @@
+/*
+ * SIMD Salsa20 kernels: 4, 8 or 16 blocks at once.
+ *
+ * Lane k of vector x[i] holds word i of block (counter + k), so the rounds
+ * run on all blocks in parallel exactly like salsa20_wordtobyte. The words
+ * are transposed back into blocks before the XOR with the message. The
+ * lanes may as well hold blocks of different states (salsa20_simd_multi),
+ * one per message of a batch. The kernels are inlined into one function per
+ * round count (Salsa20/8, Salsa20/12, Salsa20/20), where the number of
+ * rounds is a constant and the double rounds are unrolled completely.
+ */
+
+#include "salsa20-simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+/* rounds is a constant wherever this is expanded */
+#define SALSA20_ROUNDS(x,rounds,ADD,XOR,ROTL) \
+  _Pragma("GCC unroll 10") \
+  for (r = rounds;r > 0;r -= 2) { \
+    x[ 4] = XOR(x[ 4],ROTL(ADD(x[ 0],x[12]), 7)); \
+    x[ 8] = XOR(x[ 8],ROTL(ADD(x[ 4],x[ 0]), 9)); \
+    x[12] = XOR(x[12],ROTL(ADD(x[ 8],x[ 4]),13)); \
+    x[ 0] = XOR(x[ 0],ROTL(ADD(x[12],x[ 8]),18)); \
+    x[ 9] = XOR(x[ 9],ROTL(ADD(x[ 5],x[ 1]), 7)); \
+    x[13] = XOR(x[13],ROTL(ADD(x[ 9],x[ 5]), 9)); \
+    x[ 1] = XOR(x[ 1],ROTL(ADD(x[13],x[ 9]),13)); \
+    x[ 5] = XOR(x[ 5],ROTL(ADD(x[ 1],x[13]),18)); \
+    x[14] = XOR(x[14],ROTL(ADD(x[10],x[ 6]), 7)); \
+    x[ 2] = XOR(x[ 2],ROTL(ADD(x[14],x[10]), 9)); \
+    x[ 6] = XOR(x[ 6],ROTL(ADD(x[ 2],x[14]),13)); \
+    x[10] = XOR(x[10],ROTL(ADD(x[ 6],x[ 2]),18)); \
+    x[ 3] = XOR(x[ 3],ROTL(ADD(x[15],x[11]), 7)); \
+    x[ 7] = XOR(x[ 7],ROTL(ADD(x[ 3],x[15]), 9)); \
+    x[11] = XOR(x[11],ROTL(ADD(x[ 7],x[ 3]),13)); \
+    x[15] = XOR(x[15],ROTL(ADD(x[11],x[ 7]),18)); \
+    x[ 1] = XOR(x[ 1],ROTL(ADD(x[ 0],x[ 3]), 7)); \
+    x[ 2] = XOR(x[ 2],ROTL(ADD(x[ 1],x[ 0]), 9)); \
+    x[ 3] = XOR(x[ 3],ROTL(ADD(x[ 2],x[ 1]),13)); \
+    x[ 0] = XOR(x[ 0],ROTL(ADD(x[ 3],x[ 2]),18)); \
+    x[ 6] = XOR(x[ 6],ROTL(ADD(x[ 5],x[ 4]), 7)); \
+    x[ 7] = XOR(x[ 7],ROTL(ADD(x[ 6],x[ 5]), 9)); \
+    x[ 4] = XOR(x[ 4],ROTL(ADD(x[ 7],x[ 6]),13)); \
+    x[ 5] = XOR(x[ 5],ROTL(ADD(x[ 4],x[ 7]),18)); \
+    x[11] = XOR(x[11],ROTL(ADD(x[10],x[ 9]), 7)); \
+    x[ 8] = XOR(x[ 8],ROTL(ADD(x[11],x[10]), 9)); \
+    x[ 9] = XOR(x[ 9],ROTL(ADD(x[ 8],x[11]),13)); \
+    x[10] = XOR(x[10],ROTL(ADD(x[ 9],x[ 8]),18)); \
+    x[12] = XOR(x[12],ROTL(ADD(x[15],x[14]), 7)); \
+    x[13] = XOR(x[13],ROTL(ADD(x[12],x[15]), 9)); \
+    x[14] = XOR(x[14],ROTL(ADD(x[13],x[12]),13)); \
+    x[15] = XOR(x[15],ROTL(ADD(x[14],x[13]),18)); \
+  }
+
+/* 64-bit block counters of the lanes, split into input[8] and input[9] words */
+static void salsa20_lane_counters(const u32 input[16],u32 *lo,u32 *hi,int lanes)
+{
+  u64 counter = ((u64)input[9] << 32) | input[8];
+  int k;
+
+  for (k = 0;k < lanes;++k) {
+    lo[k] = (u32)(counter + k);
+    hi[k] = (u32)((counter + k) >> 32);
+  }
+}
+
+static void salsa20_advance(u32 input[16],size_t blocks)
+{
+  u64 counter = (((u64)input[9] << 32) | input[8]) + blocks;
+
+  input[8] = (u32)counter;
+  input[9] = (u32)(counter >> 32);
+}
+
+/* consecutive blocks of one message */
+static void salsa20_block_pointers(const u8 *m,u8 *c,const u8 **ms,u8 **cs,int lanes)
+{
+  int k;
+
+  for (k = 0;k < lanes;++k) {
+    ms[k] = m + 64 * k;
+    cs[k] = c + 64 * k;
+  }
+}
+
+/* words[lanes * i + k] = word i of state k, one row per vector */
+static void salsa20_gather(u32 *const input[],u32 *words,int lanes)
+{
+  int i, k;
+
+  for (i = 0;i < 16;++i)
+    for (k = 0;k < lanes;++k) words[lanes * i + k] = input[k][i];
+}
+
+#define ADD_SSE2(a,b) _mm_add_epi32(a,b)
+#define XOR_SSE2(a,b) _mm_xor_si128(a,b)
+#define ROTL_SSE2(a,n) _mm_or_si128(_mm_slli_epi32(a,n),_mm_srli_epi32(a,32 - (n)))
+
+/* block j of the kernels comes from m[j] and goes to c[j] */
+__attribute__((target("sse2"),always_inline))
+static inline void salsa20_core4(const __m128i in[16],const u8 *const m[],u8 *const c[],int rounds)
+{
+  __m128i x[16], t[4], u[4];
+  int i, j, g, r;
+
+  for (i = 0;i < 16;++i) x[i] = in[i];
+  SALSA20_ROUNDS(x,rounds,ADD_SSE2,XOR_SSE2,ROTL_SSE2)
+  for (i = 0;i < 16;++i) x[i] = ADD_SSE2(x[i],in[i]);
+
+  /* u[j] = words 4g..4g+3 of block j */
+  for (g = 0;g < 4;++g) {
+    t[0] = _mm_unpacklo_epi32(x[4 * g],x[4 * g + 1]);
+    t[1] = _mm_unpackhi_epi32(x[4 * g],x[4 * g + 1]);
+    t[2] = _mm_unpacklo_epi32(x[4 * g + 2],x[4 * g + 3]);
+    t[3] = _mm_unpackhi_epi32(x[4 * g + 2],x[4 * g + 3]);
+    u[0] = _mm_unpacklo_epi64(t[0],t[2]);
+    u[1] = _mm_unpackhi_epi64(t[0],t[2]);
+    u[2] = _mm_unpacklo_epi64(t[1],t[3]);
+    u[3] = _mm_unpackhi_epi64(t[1],t[3]);
+    for (j = 0;j < 4;++j) {
+      const u8 *src = m[j] + 16 * g;
+      _mm_storeu_si128((__m128i *)(c[j] + 16 * g),
+        _mm_xor_si128(u[j],_mm_loadu_si128((const __m128i *)src)));
+    }
+  }
+}
+
+__attribute__((target("sse2"),always_inline))
+static inline void salsa20_blocks4(const u32 input[16],const u8 *m,u8 *c,int rounds)
+{
+  __m128i in[16];
+  const u8 *ms[4];
+  u8 *cs[4];
+  u32 lo[4], hi[4];
+  int i;
+
+  salsa20_lane_counters(input,lo,hi,4);
+  for (i = 0;i < 16;++i) in[i] = _mm_set1_epi32((int)input[i]);
+  in[8] = _mm_loadu_si128((const __m128i *)lo);
+  in[9] = _mm_loadu_si128((const __m128i *)hi);
+  salsa20_block_pointers(m,c,ms,cs,4);
+  salsa20_core4(in,ms,cs,rounds);
+}
+
+__attribute__((target("sse2")))
+static void salsa20_multi4(u32 *const input[],const u8 *const m[],u8 *const c[])
+{
+  __m128i in[16];
+  u32 words[16 * 4];
+  int i;
+
+  salsa20_gather(input,words,4);
+  for (i = 0;i < 16;++i) in[i] = _mm_loadu_si128((const __m128i *)(words + 4 * i));
+  salsa20_core4(in,m,c,20);
+}
+
+#define ADD_AVX2(a,b) _mm256_add_epi32(a,b)
+#define XOR_AVX2(a,b) _mm256_xor_si256(a,b)
+#define ROTL_AVX2(a,n) _mm256_or_si256(_mm256_slli_epi32(a,n),_mm256_srli_epi32(a,32 - (n)))
+
+__attribute__((target("avx2")))
+static void salsa20_xor32(u8 *c,const u8 *m,__m256i keystream)
+{
+  _mm256_storeu_si256((__m256i *)c,_mm256_xor_si256(keystream,_mm256_loadu_si256((const __m256i *)m)));
+}
+
+__attribute__((target("avx2"),always_inline))
+static inline void salsa20_core8(const __m256i in[16],const u8 *const m[],u8 *const c[],int rounds)
+{
+  __m256i x[16], t[4], u[16];
+  int i, j, g, r;
+
+  for (i = 0;i < 16;++i) x[i] = in[i];
+  SALSA20_ROUNDS(x,rounds,ADD_AVX2,XOR_AVX2,ROTL_AVX2)
+  for (i = 0;i < 16;++i) x[i] = ADD_AVX2(x[i],in[i]);
+
+  /* 128-bit lane L of u[4g + j] = words 4g..4g+3 of block 4L + j */
+  for (g = 0;g < 4;++g) {
+    t[0] = _mm256_unpacklo_epi32(x[4 * g],x[4 * g + 1]);
+    t[1] = _mm256_unpackhi_epi32(x[4 * g],x[4 * g + 1]);
+    t[2] = _mm256_unpacklo_epi32(x[4 * g + 2],x[4 * g + 3]);
+    t[3] = _mm256_unpackhi_epi32(x[4 * g + 2],x[4 * g + 3]);
+    u[4 * g + 0] = _mm256_unpacklo_epi64(t[0],t[2]);
+    u[4 * g + 1] = _mm256_unpackhi_epi64(t[0],t[2]);
+    u[4 * g + 2] = _mm256_unpacklo_epi64(t[1],t[3]);
+    u[4 * g + 3] = _mm256_unpackhi_epi64(t[1],t[3]);
+  }
+
+  for (j = 0;j < 4;++j) {
+    salsa20_xor32(c[j],m[j],_mm256_permute2x128_si256(u[j],u[4 + j],0x20));
+    salsa20_xor32(c[j] + 32,m[j] + 32,_mm256_permute2x128_si256(u[8 + j],u[12 + j],0x20));
+    salsa20_xor32(c[4 + j],m[4 + j],_mm256_permute2x128_si256(u[j],u[4 + j],0x31));
+    salsa20_xor32(c[4 + j] + 32,m[4 + j] + 32,_mm256_permute2x128_si256(u[8 + j],u[12 + j],0x31));
+  }
+}
+
+__attribute__((target("avx2"),always_inline))
+static inline void salsa20_blocks8(const u32 input[16],const u8 *m,u8 *c,int rounds)
+{
+  __m256i in[16];
+  const u8 *ms[8];
+  u8 *cs[8];
+  u32 lo[8], hi[8];
+  int i;
+
+  salsa20_lane_counters(input,lo,hi,8);
+  for (i = 0;i < 16;++i) in[i] = _mm256_set1_epi32((int)input[i]);
+  in[8] = _mm256_loadu_si256((const __m256i *)lo);
+  in[9] = _mm256_loadu_si256((const __m256i *)hi);
+  salsa20_block_pointers(m,c,ms,cs,8);
+  salsa20_core8(in,ms,cs,rounds);
+}
+
+__attribute__((target("avx2")))
+static void salsa20_multi8(u32 *const input[],const u8 *const m[],u8 *const c[])
+{
+  __m256i in[16];
+  u32 words[16 * 8];
+  int i;
+
+  salsa20_gather(input,words,8);
+  for (i = 0;i < 16;++i) in[i] = _mm256_loadu_si256((const __m256i *)(words + 8 * i));
+  salsa20_core8(in,m,c,20);
+}
+
+#define ADD_AVX512(a,b) _mm512_add_epi32(a,b)
+#define XOR_AVX512(a,b) _mm512_xor_si512(a,b)
+#define ROTL_AVX512(a,n) _mm512_rol_epi32(a,n)
+
+__attribute__((target("avx512f")))
+static void salsa20_xor64(u8 *c,const u8 *m,__m512i keystream)
+{
+  _mm512_storeu_si512((void *)c,_mm512_xor_si512(keystream,_mm512_loadu_si512((const void *)m)));
+}
+
+__attribute__((target("avx512f"),always_inline))
+static inline void salsa20_core16(const __m512i in[16],const u8 *const m[],u8 *const c[],int rounds)
+{
+  __m512i x[16], t[4], u[16], p, q, s, w;
+  int i, j, g, r;
+
+  for (i = 0;i < 16;++i) x[i] = in[i];
+  SALSA20_ROUNDS(x,rounds,ADD_AVX512,XOR_AVX512,ROTL_AVX512)
+  for (i = 0;i < 16;++i) x[i] = ADD_AVX512(x[i],in[i]);
+
+  /* 128-bit lane L of u[4g + j] = words 4g..4g+3 of block 4L + j */
+  for (g = 0;g < 4;++g) {
+    t[0] = _mm512_unpacklo_epi32(x[4 * g],x[4 * g + 1]);
+    t[1] = _mm512_unpackhi_epi32(x[4 * g],x[4 * g + 1]);
+    t[2] = _mm512_unpacklo_epi32(x[4 * g + 2],x[4 * g + 3]);
+    t[3] = _mm512_unpackhi_epi32(x[4 * g + 2],x[4 * g + 3]);
+    u[4 * g + 0] = _mm512_unpacklo_epi64(t[0],t[2]);
+    u[4 * g + 1] = _mm512_unpackhi_epi64(t[0],t[2]);
+    u[4 * g + 2] = _mm512_unpacklo_epi64(t[1],t[3]);
+    u[4 * g + 3] = _mm512_unpackhi_epi64(t[1],t[3]);
+  }
+
+  /* 4x4 transpose of 128-bit lanes gives whole blocks */
+  for (j = 0;j < 4;++j) {
+    p = _mm512_shuffle_i32x4(u[j],u[4 + j],0x44);
+    q = _mm512_shuffle_i32x4(u[8 + j],u[12 + j],0x44);
+    s = _mm512_shuffle_i32x4(u[j],u[4 + j],0xEE);
+    w = _mm512_shuffle_i32x4(u[8 + j],u[12 + j],0xEE);
+    salsa20_xor64(c[j],m[j],_mm512_shuffle_i32x4(p,q,0x88));
+    salsa20_xor64(c[4 + j],m[4 + j],_mm512_shuffle_i32x4(p,q,0xDD));
+    salsa20_xor64(c[8 + j],m[8 + j],_mm512_shuffle_i32x4(s,w,0x88));
+    salsa20_xor64(c[12 + j],m[12 + j],_mm512_shuffle_i32x4(s,w,0xDD));
+  }
+}
+
+__attribute__((target("avx512f"),always_inline))
+static inline void salsa20_blocks16(const u32 input[16],const u8 *m,u8 *c,int rounds)
+{
+  __m512i in[16];
+  const u8 *ms[16];
+  u8 *cs[16];
+  u32 lo[16], hi[16];
+  int i;
+
+  salsa20_lane_counters(input,lo,hi,16);
+  for (i = 0;i < 16;++i) in[i] = _mm512_set1_epi32((int)input[i]);
+  in[8] = _mm512_loadu_si512((const void *)lo);
+  in[9] = _mm512_loadu_si512((const void *)hi);
+  salsa20_block_pointers(m,c,ms,cs,16);
+  salsa20_core16(in,ms,cs,rounds);
+}
+
+__attribute__((target("avx512f")))
+static void salsa20_multi16(u32 *const input[],const u8 *const m[],u8 *const c[])
+{
+  __m512i in[16];
+  u32 words[16 * 16];
+  int i;
+
+  salsa20_gather(input,words,16);
+  for (i = 0;i < 16;++i) in[i] = _mm512_loadu_si512((const void *)(words + 16 * i));
+  salsa20_core16(in,m,c,20);
+}
+
+/*
+ * One set of kernels per round count: salsa20_blocks{4,8,16}_R and
+ * salsa20_simd_blocks_R, the widest kernel for the bulk and narrower ones
+ * for what is left.
+ */
+#define SALSA20_KERNELS(R) \
+__attribute__((target("sse2"))) \
+static void salsa20_blocks4_##R(const u32 input[16],const u8 *m,u8 *c) \
+{ \
+  salsa20_blocks4(input,m,c,R); \
+} \
+\
+__attribute__((target("avx2"))) \
+static void salsa20_blocks8_##R(const u32 input[16],const u8 *m,u8 *c) \
+{ \
+  salsa20_blocks8(input,m,c,R); \
+} \
+\
+__attribute__((target("avx512f"))) \
+static void salsa20_blocks16_##R(const u32 input[16],const u8 *m,u8 *c) \
+{ \
+  salsa20_blocks16(input,m,c,R); \
+} \
+\
+static size_t salsa20_simd_blocks_##R(u32 input[16],const u8 *m,u8 *c,size_t blocks,int lanes) \
+{ \
+  size_t done = 0; \
+\
+  if (lanes >= 16) \
+    for (;blocks - done >= 16;done += 16) { \
+      salsa20_blocks16_##R(input,m + 64 * done,c + 64 * done); \
+      salsa20_advance(input,16); \
+    } \
+  if (lanes >= 8) \
+    for (;blocks - done >= 8;done += 8) { \
+      salsa20_blocks8_##R(input,m + 64 * done,c + 64 * done); \
+      salsa20_advance(input,8); \
+    } \
+  if (lanes >= 4) \
+    for (;blocks - done >= 4;done += 4) { \
+      salsa20_blocks4_##R(input,m + 64 * done,c + 64 * done); \
+      salsa20_advance(input,4); \
+    } \
+  return done; \
+}
+
+SALSA20_KERNELS(8)
+SALSA20_KERNELS(12)
+SALSA20_KERNELS(20)
+
+int salsa20_simd_max_lanes(void)
+{
+  if (__builtin_cpu_supports("avx512f")) return 16;
+  if (__builtin_cpu_supports("avx2")) return 8;
+  if (__builtin_cpu_supports("sse2")) return 4;
+  return 0;
+}
+
+size_t salsa20_simd_blocks(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes)
+{
+  return salsa20_simd_blocks_rounds(input,m,c,blocks,max_lanes,20);
+}
+
+size_t salsa20_simd_blocks_rounds(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes,int rounds)
+{
+  int lanes = salsa20_simd_max_lanes();
+
+  if (max_lanes < lanes) lanes = max_lanes;
+
+  switch (rounds) {
+  case 8: return salsa20_simd_blocks_8(input,m,c,blocks,lanes);
+  case 12: return salsa20_simd_blocks_12(input,m,c,blocks,lanes);
+  case 20: return salsa20_simd_blocks_20(input,m,c,blocks,lanes);
+  default: return 0;
+  }
+}
+
+void salsa20_simd_multi(u32 *const input[],const u8 *const m[],u8 *const c[],int lanes)
+{
+  int k;
+
+  if (lanes == 16) salsa20_multi16(input,m,c);
+  else if (lanes == 8) salsa20_multi8(input,m,c);
+  else salsa20_multi4(input,m,c);
+  for (k = 0;k < lanes;++k) salsa20_advance(input[k],1);
+}
+
+#else
+
+int salsa20_simd_max_lanes(void)
+{
+  return 0;
+}
+
+size_t salsa20_simd_blocks(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes)
+{
+  (void)input; (void)m; (void)c; (void)blocks; (void)max_lanes;
+  return 0;
+}
+
+size_t salsa20_simd_blocks_rounds(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes,int rounds)
+{
+  (void)input; (void)m; (void)c; (void)blocks; (void)max_lanes; (void)rounds;
+  return 0;
+}
+
+void salsa20_simd_multi(u32 *const input[],const u8 *const m[],u8 *const c[],int lanes)
+{
+  (void)input; (void)m; (void)c; (void)lanes;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SALSA20_SIMD_H
+#define SALSA20_SIMD_H
+
+#include "ecrypt-portable.h"
+#include <stddef.h>
+
+/*
+ * Widest SIMD kernel the CPU supports, in 64-byte blocks per call:
+ * 16 (AVX-512), 8 (AVX2), 4 (SSE2) or 0 (scalar only).
+ */
+int salsa20_simd_max_lanes(void);
+
+/*
+ * c = m ^ keystream for whole 64-byte blocks, at most max_lanes blocks per
+ * kernel call, advancing the block counter in input[8..9]. Returns the
+ * number of blocks done; the last (blocks % 4) are left to the scalar code.
+ */
+size_t salsa20_simd_blocks(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes);
+
+/*
+ * The same for Salsa20/rounds. There are kernels for 8, 12 and 20 rounds,
+ * each with its rounds unrolled; for any other count no block is done.
+ */
+size_t salsa20_simd_blocks_rounds(u32 input[16],const u8 *m,u8 *c,size_t blocks,int max_lanes,int rounds);
+
+/*
+ * One 64-byte block of each of lanes independent states (4, 8 or 16, at
+ * most salsa20_simd_max_lanes()): c[k] = m[k] ^ keystream of input[k],
+ * whose block counter is advanced by one.
+ */
+void salsa20_simd_multi(u32 *const input[],const u8 *const m[],u8 *const c[],int lanes);
+
+#endif
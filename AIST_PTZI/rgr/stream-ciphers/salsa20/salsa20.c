@@ -1,5 +1,16 @@
 #include "salsa20.h"
-#include "ecrypt-sync.h"
+#include "salsa20-simd.h"
+
+#define ROTATE(v,c) (ROTL32(v,c))
+#define XOR(v,w) ((v) ^ (w))
+#define PLUS(v,w) (U32V((v) + (w)))
+#define PLUSONE(v) (PLUS((v),1))
+
+static const char sigma[17] = "expand 32-byte k";
+static const char tau[17] = "expand 16-byte k";
+
+/* widest SIMD kernel allowed, see salsa20_set_lanes */
+static int max_lanes = 16;
 
 static void salsa20_wordtobyte(u8 output[64],const u32 input[16])
 {
@@ -50,6 +61,17 @@ void ECRYPT_init(void)
   return;
 }
 
+void salsa20_set_lanes(int lanes)
+{
+  max_lanes = lanes;
+}
+
+int salsa20_lanes(void)
+{
+  int lanes = salsa20_simd_max_lanes();
+  return max_lanes < lanes ? max_lanes : lanes;
+}
+
 void ECRYPT_keysetup(ECRYPT_ctx *x,const u8 *k,u32 kbits,u32 ivbits)
 {
   int i;
@@ -86,9 +108,18 @@ void ECRYPT_ivsetup(ECRYPT_ctx *x,const u8 *iv)
 void ECRYPT_encrypt_bytes(ECRYPT_ctx *x,const u8 *m,u8 *c,u32 bytes)
 {
   u8 output[64];
+  u32 done;
   int i;
 
   if (!bytes) return;
+
+  /* whole blocks go to the SIMD kernels */
+  done = (u32)salsa20_simd_blocks(x->input,m,c,bytes / 64,max_lanes) * 64;
+  bytes -= done;
+  c += done;
+  m += done;
+  if (!bytes) return;
+
   for (;;) {
     salsa20_wordtobyte(output,x->input);
     x->input[8] = PLUSONE(x->input[8]);
@@ -112,9 +143,126 @@ void ECRYPT_decrypt_bytes(ECRYPT_ctx *x,const u8 *c,u8 *m,u32 bytes)
   ECRYPT_encrypt_bytes(x,c,m,bytes);
 }
 
+void salsa20_encrypt_batch(ECRYPT_ctx *const x[],const u8 *const m[],u8 *const c[],
+  const u32 bytes[],u32 count)
+{
+  /* lane k: message job[k], its next whole block at in[k] / out[k] */
+  u32 *state[16];
+  const u8 *in[16];
+  u8 *out[16];
+  u32 job[16], blocks[16];
+  int lanes = salsa20_lanes(), active = 0, k, n;
+  u32 next = 0, done;
+
+  if (lanes > 16) lanes = 16;
+  while (lanes >= 4) {
+    /* whole kernels of one message at a time are as fast as it gets, only
+       the blocks left over go to the lanes; messages without any need none */
+    for (;active < lanes && next < count;++next) {
+      done = bytes[next] / 64 / lanes * lanes;
+      if (done) done = (u32)salsa20_simd_blocks(x[next]->input,m[next],c[next],done,lanes);
+      if (bytes[next] / 64 == done) {
+        ECRYPT_encrypt_bytes(x[next],m[next] + 64 * done,c[next] + 64 * done,bytes[next] % 64);
+        continue;
+      }
+      state[active] = x[next]->input;
+      in[active] = m[next] + 64 * done;
+      out[active] = c[next] + 64 * done;
+      job[active] = next;
+      blocks[active] = bytes[next] / 64 - done;
+      ++active;
+    }
+    if (active < 4) break;
+
+    /* widest kernels that fit, the last (active % 4) lanes wait */
+    for (k = 0;active - k >= 4;k += n) {
+      n = active - k >= 16 && lanes >= 16 ? 16 : active - k >= 8 && lanes >= 8 ? 8 : 4;
+      salsa20_simd_multi(state + k,in + k,out + k,n);
+    }
+
+    /* retire finished messages, the last lane takes the free place */
+    for (k = active - active % 4;k-- > 0;) {
+      in[k] += 64;
+      out[k] += 64;
+      if (--blocks[k]) continue;
+      ECRYPT_encrypt_bytes(x[job[k]],in[k],out[k],bytes[job[k]] % 64);
+      --active;
+      state[k] = state[active];
+      in[k] = in[active];
+      out[k] = out[active];
+      job[k] = job[active];
+      blocks[k] = blocks[active];
+    }
+  }
+
+  /* too few messages left to fill a kernel (or no SIMD): one at a time */
+  for (k = 0;k < active;++k)
+    ECRYPT_encrypt_bytes(x[job[k]],in[k],out[k],blocks[k] * 64 + bytes[job[k]] % 64);
+  for (;next < count;++next)
+    ECRYPT_encrypt_bytes(x[next],m[next],c[next],bytes[next]);
+}
+
+void salsa20_set_counter(ECRYPT_ctx *x,u64 block)
+{
+  x->input[8] = U32V(block);
+  x->input[9] = U32V(block >> 32);
+}
+
+u64 salsa20_counter(const ECRYPT_ctx *x)
+{
+  return ((u64)x->input[9] << 32) | x->input[8];
+}
+
+void salsa20_encrypt_range(ECRYPT_ctx *x,u64 offset,const u8 *m,u8 *c,u32 bytes)
+{
+  u8 output[64];
+  u32 skip = (u32)(offset % 64);
+  u32 i, n;
+
+  salsa20_set_counter(x,offset / 64);
+  if (!bytes) return;
+
+  /* range starts inside a block: use the tail of its keystream */
+  if (skip) {
+    salsa20_wordtobyte(output,x->input);
+    salsa20_set_counter(x,offset / 64 + 1);
+    n = 64 - skip < bytes ? 64 - skip : bytes;
+    for (i = 0;i < n;++i) c[i] = m[i] ^ output[skip + i];
+    bytes -= n;
+    c += n;
+    m += n;
+  }
+
+  ECRYPT_encrypt_bytes(x,m,c,bytes);
+}
+
 void ECRYPT_keystream_bytes(ECRYPT_ctx *x,u8 *stream,u32 bytes)
 {
   u32 i;
   for (i = 0;i < bytes;++i) stream[i] = 0;
   ECRYPT_encrypt_bytes(x,stream,stream,bytes);
 }
+
+void ECRYPT_encrypt_bytes64(ECRYPT_ctx *x,const u8 *m,u8 *c,u64 bytes)
+{
+  for (;bytes > ECRYPT_CHUNKLENGTH;bytes -= ECRYPT_CHUNKLENGTH) {
+    ECRYPT_encrypt_bytes(x,m,c,ECRYPT_CHUNKLENGTH);
+    m += ECRYPT_CHUNKLENGTH;
+    c += ECRYPT_CHUNKLENGTH;
+  }
+  ECRYPT_encrypt_bytes(x,m,c,(u32)bytes);
+}
+
+void ECRYPT_decrypt_bytes64(ECRYPT_ctx *x,const u8 *c,u8 *m,u64 bytes)
+{
+  ECRYPT_encrypt_bytes64(x,c,m,bytes);
+}
+
+void ECRYPT_keystream_bytes64(ECRYPT_ctx *x,u8 *stream,u64 bytes)
+{
+  for (;bytes > ECRYPT_CHUNKLENGTH;bytes -= ECRYPT_CHUNKLENGTH) {
+    ECRYPT_keystream_bytes(x,stream,ECRYPT_CHUNKLENGTH);
+    stream += ECRYPT_CHUNKLENGTH;
+  }
+  ECRYPT_keystream_bytes(x,stream,(u32)bytes);
+}
@@ -1,17 +1,15 @@
-#include "ecrypt-sync.h"
+#ifndef SALSA20_H
+#define SALSA20_H
 
-#define ROTATE(v,c) (ROTL32(v,c))
-#define XOR(v,w) ((v) ^ (w))
-#define PLUS(v,w) (U32V((v) + (w)))
-#define PLUSONE(v) (PLUS((v),1))
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-static void salsa20_wordtobyte(u8 output[64],const u32 input[16]);
+#include "ecrypt-sync.h"
+#include <stddef.h>
 
 void ECRYPT_init(void);
 
-static const char sigma[17] = "expand 32-byte k";
-static const char tau[17] = "expand 16-byte k";
-
 void ECRYPT_keysetup(ECRYPT_ctx *x,const u8 *k,u32 kbits,u32 ivbits);
 
 void ECRYPT_ivsetup(ECRYPT_ctx *x,const u8 *iv);
@@ -20,3 +18,60 @@ void ECRYPT_encrypt_bytes(ECRYPT_ctx *x,const u8 *m,u8 *c,u32 bytes);
 void ECRYPT_decrypt_bytes(ECRYPT_ctx *x,const u8 *c,u8 *m,u32 bytes);
 
 void ECRYPT_keystream_bytes(ECRYPT_ctx *x,u8 *stream,u32 bytes);
+
+/* any length, in chunks of ECRYPT_CHUNKLENGTH bytes */
+void ECRYPT_encrypt_bytes64(ECRYPT_ctx *x,const u8 *m,u8 *c,u64 bytes);
+void ECRYPT_decrypt_bytes64(ECRYPT_ctx *x,const u8 *c,u8 *m,u64 bytes);
+void ECRYPT_keystream_bytes64(ECRYPT_ctx *x,u8 *stream,u64 bytes);
+
+/*
+ * Random access. The keystream of a key/IV pair is a sequence of 64-byte
+ * blocks numbered from 0; the counter is the number of the next block.
+ * salsa20_encrypt_range encrypts (or decrypts) bytes that sit at the given
+ * offset of the stream and leaves the counter after the last touched block.
+ */
+void salsa20_set_counter(ECRYPT_ctx *x,u64 block);
+u64 salsa20_counter(const ECRYPT_ctx *x);
+void salsa20_encrypt_range(ECRYPT_ctx *x,u64 offset,const u8 *m,u8 *c,u32 bytes);
+
+/*
+ * Multi-threaded encryption of large buffers. The buffer is split into
+ * counter ranges that a pool of worker threads (one per CPU by default,
+ * see salsa20_set_threads) encrypts in parallel. Buffers smaller than
+ * SALSA20_PARALLEL_THRESHOLD stay on the calling thread. The pool is
+ * shared by the process and serves one call at a time: a call made while
+ * another one is using it runs on its own thread instead of waiting.
+ * Without POSIX threads salsa20_threads() is 1 and every call runs on the
+ * calling thread. The result and the counter update are the same as for
+ * ECRYPT_encrypt_bytes.
+ */
+#define SALSA20_PARALLEL_THRESHOLD (256 * 1024)
+
+void salsa20_encrypt_parallel(ECRYPT_ctx *x,const u8 *m,u8 *c,size_t bytes);
+void salsa20_set_threads(int threads);
+int salsa20_threads(void);
+
+/*
+ * Many messages at once, e.g. one per connection of a server:
+ * c[i] = m[i] ^ keystream of x[i] for bytes[i] bytes, the same as count
+ * calls of ECRYPT_encrypt_bytes. The contexts must be distinct. Blocks of
+ * different messages share the SIMD lanes, a lane is refilled with the
+ * next message as soon as its own runs out of whole blocks, so short
+ * messages get the throughput of long ones.
+ */
+void salsa20_encrypt_batch(ECRYPT_ctx *const x[],const u8 *const m[],u8 *const c[],
+  const u32 bytes[],u32 count);
+
+/*
+ * Whole blocks are processed 16, 8 or 4 at a time by AVX-512, AVX2 or SSE2
+ * kernels, chosen at run time. salsa20_set_lanes limits the width
+ * (0 = scalar only), e.g. to compare kernels; the CPU may allow less.
+ */
+void salsa20_set_lanes(int lanes);
+int salsa20_lanes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,6 +11,29 @@
 #define ECRYPT_SYNC
 
 #include "ecrypt-portable.h"
+#include <stddef.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Symbol names */
+
+/*
+ * All ciphers in stream-ciphers/ implement the same ECRYPT_* API. The
+ * names are given a per-cipher prefix here so that several ciphers can be
+ * linked into one program; code including this header keeps using the
+ * ECRYPT_* names.
+ */
+#define ECRYPT_ctx               sosemanuk_ECRYPT_ctx
+#define ECRYPT_init              sosemanuk_ECRYPT_init
+#define ECRYPT_keysetup          sosemanuk_ECRYPT_keysetup
+#define ECRYPT_ivsetup           sosemanuk_ECRYPT_ivsetup
+#define ECRYPT_process_bytes     sosemanuk_ECRYPT_process_bytes
+#define ECRYPT_process_bytes64   sosemanuk_ECRYPT_process_bytes64
+#define ECRYPT_keystream_bytes   sosemanuk_ECRYPT_keystream_bytes
+#define ECRYPT_keystream_bytes64 sosemanuk_ECRYPT_keystream_bytes64
+#define ECRYPT_process_packet    sosemanuk_ECRYPT_process_packet
+#define ECRYPT_process_blocks    sosemanuk_ECRYPT_process_blocks
+#define ECRYPT_keystream_blocks  sosemanuk_ECRYPT_keystream_blocks
 
 /* ------------------------------------------------------------------------- */
 
@@ -210,6 +233,60 @@ void ECRYPT_keystream_bytes(
 
 /* ------------------------------------------------------------------------- */
 
+/* 64-bit lengths */
+
+/*
+ * The functions above take u32 lengths, so a single call handles less
+ * than 4 GiB. The *_bytes64 variants accept any length: they call the
+ * u32 functions on chunks of ECRYPT_CHUNKLENGTH bytes, a whole number of
+ * blocks, so the output and the final state are the same as one call
+ * with the full length would give.
+ */
+#define ECRYPT_CHUNKLENGTH \
+  (0xFFFFFFFFUL / ECRYPT_BLOCKLENGTH * ECRYPT_BLOCKLENGTH)
+
+#ifdef ECRYPT_HAS_SINGLE_BYTE_FUNCTION
+
+#define ECRYPT_encrypt_bytes64(ctx, plaintext, ciphertext, msglen) \
+  ECRYPT_process_bytes64(0, ctx, plaintext, ciphertext, msglen)
+
+#define ECRYPT_decrypt_bytes64(ctx, ciphertext, plaintext, msglen) \
+  ECRYPT_process_bytes64(1, ctx, ciphertext, plaintext, msglen)
+
+void ECRYPT_process_bytes64(
+  int action,                 /* 0 = encrypt; 1 = decrypt; */
+  ECRYPT_ctx* ctx, 
+  const u8* input, 
+  u8* output, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#else
+
+void ECRYPT_encrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* plaintext, 
+  u8* ciphertext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+void ECRYPT_decrypt_bytes64(
+  ECRYPT_ctx* ctx, 
+  const u8* ciphertext, 
+  u8* plaintext, 
+  u64 msglen);                /* Message length in bytes. */ 
+
+#endif
+
+#ifdef ECRYPT_GENERATES_KEYSTREAM
+
+void ECRYPT_keystream_bytes64(
+  ECRYPT_ctx* ctx,
+  u8* keystream,
+  u64 length);                /* Length of keystream in bytes. */
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
 /* Optional optimizations */
 
 /* 
@@ -28,6 +28,10 @@
 
 #include "sosemanuk.h"
 
+#if defined SOSEMANUK_ECRYPT && defined __SSE2__
+#include <emmintrin.h>
+#endif
+
 /* ======================================================================== */
 
 #ifdef SOSEMANUK_ECRYPT
@@ -984,6 +988,140 @@ sosemanuk_internal(sosemanuk_run_context *rc)
 #endif
 }
 
+#if defined SOSEMANUK_ECRYPT && defined __SSE2__
+
+/*
+ * Number of 80-byte blocks produced by one sosemanuk_batch() call.
+ */
+#define SOSEMANUK_BATCH   4
+
+/*
+ * Same output as SOSEMANUK_BATCH calls to sosemanuk_internal(). The
+ * LFSR and FSM steps are a sequential chain and remain scalar; they
+ * only record the Serpent1 inputs ("u") and the dropped LFSR words
+ * ("v") of all 20 output groups. The Serpent1 layer then evaluates the
+ * same bitsliced S2 circuit on SSE2 registers, four groups per
+ * register, and a 4x4 transpose puts the words back in output order.
+ */
+static void
+sosemanuk_batch(ECRYPT_ctx *rc, u8 *dst)
+{
+#define NG   (5 * SOSEMANUK_BATCH)
+
+	/*
+	 * SRB() replaces SRD(): the words of group "g" are stored, one
+	 * array per word index, for the vector S-box layer.
+	 */
+#define SRB(g)   do { \
+		uu[0][g] = u0; \
+		uu[1][g] = u1; \
+		uu[2][g] = u2; \
+		uu[3][g] = u3; \
+		vv[0][g] = v0; \
+		vv[1][g] = v1; \
+		vv[2][g] = v2; \
+		vv[3][g] = v3; \
+	} while (0)
+
+	unum32 uu[4][NG] __attribute__((aligned(16)));
+	unum32 vv[4][NG] __attribute__((aligned(16)));
+	unum32 s00 = rc->s00;
+	unum32 s01 = rc->s01;
+	unum32 s02 = rc->s02;
+	unum32 s03 = rc->s03;
+	unum32 s04 = rc->s04;
+	unum32 s05 = rc->s05;
+	unum32 s06 = rc->s06;
+	unum32 s07 = rc->s07;
+	unum32 s08 = rc->s08;
+	unum32 s09 = rc->s09;
+	unum32 r1 = rc->r1;
+	unum32 r2 = rc->r2;
+	unum32 u0, u1, u2, u3;
+	unum32 v0, v1, v2, v3;
+	int g;
+
+	for (g = 0; g < NG; g += 5) {
+		STEP(00, 01, 02, 03, 04, 05, 06, 07, 08, 09, v0, u0);
+		STEP(01, 02, 03, 04, 05, 06, 07, 08, 09, 00, v1, u1);
+		STEP(02, 03, 04, 05, 06, 07, 08, 09, 00, 01, v2, u2);
+		STEP(03, 04, 05, 06, 07, 08, 09, 00, 01, 02, v3, u3);
+		SRB(g + 0);
+		STEP(04, 05, 06, 07, 08, 09, 00, 01, 02, 03, v0, u0);
+		STEP(05, 06, 07, 08, 09, 00, 01, 02, 03, 04, v1, u1);
+		STEP(06, 07, 08, 09, 00, 01, 02, 03, 04, 05, v2, u2);
+		STEP(07, 08, 09, 00, 01, 02, 03, 04, 05, 06, v3, u3);
+		SRB(g + 1);
+		STEP(08, 09, 00, 01, 02, 03, 04, 05, 06, 07, v0, u0);
+		STEP(09, 00, 01, 02, 03, 04, 05, 06, 07, 08, v1, u1);
+		STEP(00, 01, 02, 03, 04, 05, 06, 07, 08, 09, v2, u2);
+		STEP(01, 02, 03, 04, 05, 06, 07, 08, 09, 00, v3, u3);
+		SRB(g + 2);
+		STEP(02, 03, 04, 05, 06, 07, 08, 09, 00, 01, v0, u0);
+		STEP(03, 04, 05, 06, 07, 08, 09, 00, 01, 02, v1, u1);
+		STEP(04, 05, 06, 07, 08, 09, 00, 01, 02, 03, v2, u2);
+		STEP(05, 06, 07, 08, 09, 00, 01, 02, 03, 04, v3, u3);
+		SRB(g + 3);
+		STEP(06, 07, 08, 09, 00, 01, 02, 03, 04, 05, v0, u0);
+		STEP(07, 08, 09, 00, 01, 02, 03, 04, 05, 06, v1, u1);
+		STEP(08, 09, 00, 01, 02, 03, 04, 05, 06, 07, v2, u2);
+		STEP(09, 00, 01, 02, 03, 04, 05, 06, 07, 08, v3, u3);
+		SRB(g + 4);
+	}
+
+	rc->s00 = s00;
+	rc->s01 = s01;
+	rc->s02 = s02;
+	rc->s03 = s03;
+	rc->s04 = s04;
+	rc->s05 = s05;
+	rc->s06 = s06;
+	rc->s07 = s07;
+	rc->s08 = s08;
+	rc->s09 = s09;
+	rc->r1 = r1;
+	rc->r2 = r2;
+
+	for (g = 0; g < NG; g += 4) {
+		__m128i x0, x1, x2, x3, x4, t0, t1, t2, t3;
+
+		x0 = _mm_load_si128((const __m128i *)(uu[0] + g));
+		x1 = _mm_load_si128((const __m128i *)(uu[1] + g));
+		x2 = _mm_load_si128((const __m128i *)(uu[2] + g));
+		x3 = _mm_load_si128((const __m128i *)(uu[3] + g));
+		S2(x0, x1, x2, x3, x4);
+
+		/* S2 output order is x2, x3, x1, x4 */
+		x2 = _mm_xor_si128(x2, _mm_load_si128((const __m128i *)(vv[0] + g)));
+		x3 = _mm_xor_si128(x3, _mm_load_si128((const __m128i *)(vv[1] + g)));
+		x1 = _mm_xor_si128(x1, _mm_load_si128((const __m128i *)(vv[2] + g)));
+		x4 = _mm_xor_si128(x4, _mm_load_si128((const __m128i *)(vv[3] + g)));
+
+		t0 = _mm_unpacklo_epi32(x2, x3);
+		t1 = _mm_unpackhi_epi32(x2, x3);
+		t2 = _mm_unpacklo_epi32(x1, x4);
+		t3 = _mm_unpackhi_epi32(x1, x4);
+		_mm_storeu_si128((__m128i *)(dst + 16 * g),
+			_mm_unpacklo_epi64(t0, t2));
+		_mm_storeu_si128((__m128i *)(dst + 16 * g + 16),
+			_mm_unpackhi_epi64(t0, t2));
+		_mm_storeu_si128((__m128i *)(dst + 16 * g + 32),
+			_mm_unpacklo_epi64(t1, t3));
+		_mm_storeu_si128((__m128i *)(dst + 16 * g + 48),
+			_mm_unpackhi_epi64(t1, t3));
+	}
+
+#undef SRB
+#undef NG
+}
+
+#else
+
+#define SOSEMANUK_BATCH   1
+#define sosemanuk_batch   sosemanuk_internal
+
+#endif
+
 /*
  * Combine buffers in1[] and in2[] by XOR, result in out[]. The length
  * is "data_len" (in bytes). Partial overlap of out[] with either in1[]
@@ -994,6 +1132,17 @@ static INLINE void
 xorbuf(const unsigned char *in1, const unsigned char *in2,
 	unsigned char *out, size_t data_len)
 {
+#if defined SOSEMANUK_ECRYPT && defined __SSE2__
+	while (data_len >= 16) {
+		_mm_storeu_si128((__m128i *)out, _mm_xor_si128(
+			_mm_loadu_si128((const __m128i *)in1),
+			_mm_loadu_si128((const __m128i *)in2)));
+		in1 += 16;
+		in2 += 16;
+		out += 16;
+		data_len -= 16;
+	}
+#endif
 	while (data_len -- > 0)
 		*out ++ = *in1 ++ ^ *in2 ++;
 }
@@ -1010,6 +1159,15 @@ ECRYPT_process_bytes(int action, ECRYPT_ctx *ctx,
 {
 	(void)action;
 
+	while (msglen >= SOSEMANUK_BATCH * ECRYPT_BLOCKLENGTH) {
+		unsigned char tbuf[SOSEMANUK_BATCH * ECRYPT_BLOCKLENGTH];
+
+		sosemanuk_batch(ctx, tbuf);
+		xorbuf(input, tbuf, output, sizeof tbuf);
+		input += sizeof tbuf;
+		output += sizeof tbuf;
+		msglen -= sizeof tbuf;
+	}
 	while (msglen > 0) {
 		unsigned char tbuf[ECRYPT_BLOCKLENGTH];
 		size_t len;
@@ -1029,6 +1187,11 @@ ECRYPT_process_bytes(int action, ECRYPT_ctx *ctx,
 void
 ECRYPT_keystream_bytes(ECRYPT_ctx *ctx, u8 *keystream, u32 length)
 {
+	while (length >= SOSEMANUK_BATCH * ECRYPT_BLOCKLENGTH) {
+		sosemanuk_batch(ctx, keystream);
+		keystream += SOSEMANUK_BATCH * ECRYPT_BLOCKLENGTH;
+		length -= SOSEMANUK_BATCH * ECRYPT_BLOCKLENGTH;
+	}
 	while (length > 0) {
 		if (length >= ECRYPT_BLOCKLENGTH) {
 			sosemanuk_internal(ctx, keystream);
@@ -1044,6 +1207,33 @@ ECRYPT_keystream_bytes(ECRYPT_ctx *ctx, u8 *keystream, u32 length)
 	}
 }
 
+/* see ecrypt-sync.h */
+void
+ECRYPT_process_bytes64(int action, ECRYPT_ctx *ctx,
+	const u8 *input, u8 *output, u64 msglen)
+{
+	while (msglen > ECRYPT_CHUNKLENGTH) {
+		ECRYPT_process_bytes(action, ctx,
+			input, output, ECRYPT_CHUNKLENGTH);
+		input += ECRYPT_CHUNKLENGTH;
+		output += ECRYPT_CHUNKLENGTH;
+		msglen -= ECRYPT_CHUNKLENGTH;
+	}
+	ECRYPT_process_bytes(action, ctx, input, output, (u32)msglen);
+}
+
+/* see ecrypt-sync.h */
+void
+ECRYPT_keystream_bytes64(ECRYPT_ctx *ctx, u8 *keystream, u64 length)
+{
+	while (length > ECRYPT_CHUNKLENGTH) {
+		ECRYPT_keystream_bytes(ctx, keystream, ECRYPT_CHUNKLENGTH);
+		keystream += ECRYPT_CHUNKLENGTH;
+		length -= ECRYPT_CHUNKLENGTH;
+	}
+	ECRYPT_keystream_bytes(ctx, keystream, (u32)length);
+}
+
 /* see ecrypt-sync.h */
 void
 ECRYPT_process_blocks(int action, ECRYPT_ctx *ctx,
@@ -1051,6 +1241,14 @@ ECRYPT_process_blocks(int action, ECRYPT_ctx *ctx,
 {
 	(void)action;
 
+	for (; blocks >= SOSEMANUK_BATCH; blocks -= SOSEMANUK_BATCH) {
+		unsigned char tbuf[SOSEMANUK_BATCH * ECRYPT_BLOCKLENGTH];
+
+		sosemanuk_batch(ctx, tbuf);
+		xorbuf(input, tbuf, output, sizeof tbuf);
+		input += sizeof tbuf;
+		output += sizeof tbuf;
+	}
 	while (blocks -- > 0) {
 		unsigned char tbuf[ECRYPT_BLOCKLENGTH];
 
@@ -1065,6 +1263,10 @@ ECRYPT_process_blocks(int action, ECRYPT_ctx *ctx,
 void
 ECRYPT_keystream_blocks(ECRYPT_ctx *ctx, u8 *keystream, u32 blocks)
 {
+	for (; blocks >= SOSEMANUK_BATCH; blocks -= SOSEMANUK_BATCH) {
+		sosemanuk_batch(ctx, keystream);
+		keystream += SOSEMANUK_BATCH * ECRYPT_BLOCKLENGTH;
+	}
 	while (blocks -- > 0) {
 		sosemanuk_internal(ctx, keystream);
 		keystream += ECRYPT_BLOCKLENGTH;